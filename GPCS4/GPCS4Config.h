@@ -26,3 +26,17 @@
 // useful when developing non-graphics parts of GPCS4
 // #define GPCS4_NO_GRAPHICS
 
+
+// Skip draws until ready
+// Shaders and pipelines are compiled by background workers.
+// Define this to skip draws whose shaders or pipeline are
+// still being compiled, instead of waiting for them.
+// Trades missing geometry on first use for less stutter.
+// #define GPCS4_SKIP_DRAW_UNTIL_READY
+
+
+// Allocation counting
+// Define this to count heap allocations per thread,
+// reported by the offline shader benchmark.
+// Replaces the global operator new, so keep it off in normal builds.
+// #define GPCS4_COUNT_ALLOCATIONS
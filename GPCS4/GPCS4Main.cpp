@@ -2,6 +2,13 @@
 #include "Emulator/SceModuleSystem.h"
 #include "Emulator/TLSHandler.h"
 #include "Loader/ModuleLoader.h"
+#include "Graphic/Gnm/GnmCmdCapture.h"
+#include "Graphic/Gnm/GnmMemoryTracker.h"
+#include "Graphic/Gnm/GnmResourceFactory.h"
+#include "Graphic/Pssl/PsslShaderArchive.h"
+#include "Graphic/Sce/SceGnmReplay.h"
+#include "Graphic/SpirV/SpirvOptimizer.h"
+#include "Graphic/Violet/VltPipelineManager.h"
 
 #include <cxxopts/cxxopts.hpp>
 #include <memory>
@@ -16,6 +23,17 @@ cxxopts::ParseResult processCommandLine(int argc, char* argv[])
 		("E,eboot", "Set main executable. The folder where GPCS4.exe located will be mapped to /app0.", cxxopts::value<std::string>())
 		("D,debug-channel", "Enable debug channel. 'ALL' for all channels.", cxxopts::value<std::vector<std::string>>())
 		("L,list-channels", "List debug channels.")
+		("shader-cache", "Set shader cache archive file.", cxxopts::value<std::string>()->default_value("GPCS4.shader"))
+		("shader-cache-prewarm", "Load all shaders in the shader cache archive at startup.")
+		("shader-cache-validate", "Validate the shader cache archive and exit.")
+		("pipeline-cache", "Set pipeline cache file, the pipeline state log is kept next to it. Empty to disable.", cxxopts::value<std::string>()->default_value("GPCS4.pipeline"))
+		("pipeline-prewarm-budget", "Set time budget in milliseconds to create pipelines from the pipeline state log at startup. 0 to disable.", cxxopts::value<uint32_t>()->default_value("5000"))
+		("spirv-opt", "Set SPIR-V optimizer passes, 'all', 'none' or a list of forward,dse,bitcast,const.", cxxopts::value<std::string>()->default_value("none"))
+		("memory-budget", "Set device memory budget in MB, unused guest buffers and textures are evicted above it. 0 for the driver's budget.", cxxopts::value<uint32_t>()->default_value("0"))
+		("track-gpu-writes", "Write-protect guest GPU resources to upload only written pages. File reads into GPU resources will fail.")
+		("pm4-capture", "Capture submitted command buffers and the guest memory they use to a file, for --pm4-replay.", cxxopts::value<std::string>())
+		("pm4-replay", "Replay a command buffer capture without the game, print per-frame CPU timings and exit.", cxxopts::value<std::string>())
+		("pm4-replay-backend", "Set replay backend, 'parse' parses command buffers only, 'null' runs the graphics frontend without a GPU, 'vulkan' runs the graphics driver.", cxxopts::value<std::string>()->default_value("null"))
 		("H,help", "Print help message.")
 		;
 
@@ -35,6 +53,52 @@ cxxopts::ParseResult processCommandLine(int argc, char* argv[])
 	return optResult;
 }
 
+bool initShaderOptimizer(const cxxopts::ParseResult& optResult)
+{
+	bool ret = false;
+	do
+	{
+		auto passList = optResult["spirv-opt"].as<std::string>();
+
+		pssl::SpirvOptimizerPasses passes;
+		if (!pssl::SpirvOptimizer::parsePasses(passList, passes))
+		{
+			LOG_ERR("unknown SPIR-V optimizer pass in %s.", passList.c_str());
+			break;
+		}
+
+		pssl::SpirvOptimizer::setDefaultPasses(passes);
+
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+void initShaderCache(const cxxopts::ParseResult& optResult)
+{
+	auto archive = pssl::PsslShaderArchive::GetInstance();
+	auto path    = optResult["shader-cache"].as<std::string>();
+
+	if (!archive->open(path))
+	{
+		// Not fatal, shaders are just compiled every run.
+		LOG_WARN("shader cache %s not available.", path.c_str());
+		return;
+	}
+
+	if (optResult.count("shader-cache-validate"))
+	{
+		auto report = archive->validate();
+		printf("shader cache %s: %u entries, %u invalid, %u duplicated.\n",
+			   path.c_str(), report.entryCount, report.invalidCount, report.duplicateCount);
+	}
+
+	if (optResult.count("shader-cache-prewarm"))
+	{
+		archive->prewarm();
+	}
+}
+
 
 int main(int argc, char *argv[])
 {
@@ -48,6 +112,47 @@ int main(int argc, char *argv[])
 		// Initialize log system.
 		logsys::init(optResult);
 
+		if (!initShaderOptimizer(optResult))
+		{
+			break;
+		}
+
+		// Must come after the optimizer passes are set,
+		// the archive is only valid for the same passes.
+		initShaderCache(optResult);
+
+		// Loaded when the Vulkan device is created.
+		vlt::VltPipelineCache::setDefaultPath(optResult["pipeline-cache"].as<std::string>());
+		vlt::VltPipelineManager::setPrewarmBudget(
+			std::chrono::milliseconds(optResult["pipeline-prewarm-budget"].as<uint32_t>()));
+		GnmResourceFactory::setMemoryBudget(
+			VkDeviceSize(optResult["memory-budget"].as<uint32_t>()) << 20);
+
+		if (optResult.count("pm4-replay"))
+		{
+			// Offline replay only, after the settings
+			// above since it may run the whole driver.
+			sce::SceReplayBackend backend = sce::SceReplayBackend::Null;
+			if (sce::parseReplayBackend(optResult["pm4-replay-backend"].as<std::string>(), backend))
+			{
+				nRet = sce::runCmdReplay(optResult["pm4-replay"].as<std::string>(), backend) ? 0 : 1;
+			}
+			break;
+		}
+
+		if (optResult.count("pm4-capture"))
+		{
+			// Opened when the graphics queue is created.
+			GnmCmdCapture::setCapturePath(optResult["pm4-capture"].as<std::string>());
+		}
+
+		if (optResult.count("shader-cache-validate"))
+		{
+			// Offline validation only.
+			nRet = 0;
+			break;
+		}
+
 		if (!optResult["E"].count())
 		{
 			break;
@@ -67,6 +172,14 @@ int main(int argc, char *argv[])
 			break;
 		}
 
+		// After the TLS manager, so write faults
+		// are handled before they reach its handler.
+		if (optResult.count("track-gpu-writes") &&
+			!GnmMemoryTracker::GetInstance()->install())
+		{
+			break;
+		}
+
 		CLinker linker      = {*CSceModuleSystem::GetInstance()};
 		ModuleLoader loader = { *CSceModuleSystem::GetInstance(), linker };
 
@@ -82,6 +195,7 @@ int main(int argc, char *argv[])
 			break;
 		}
 
+		GnmMemoryTracker::GetInstance()->uninstall();
 		uninstallTLSManager();
 		pEmulator->Unit();
 		
@@ -0,0 +1,279 @@
+#include "GnmCmdCapture.h"
+
+#include "Algorithm/MurmurHash2.h"
+
+#include <cstring>
+#include <mutex>
+
+LOG_CHANNEL(Graphic.Gnm.GnmCmdCapture);
+
+constexpr char     GnmCaptureMagic[4] = { 'G', 'P', 'M', 'C' };
+constexpr uint32_t GnmCaptureVersion  = 1;
+
+static std::mutex  g_pathMutex;
+static std::string g_capturePath;
+
+GnmCmdCapture::GnmCmdCapture()
+{
+}
+
+GnmCmdCapture::~GnmCmdCapture()
+{
+	if (m_file)
+	{
+		LOG_DEBUG("capture: %u command buffers, %llu memory records, %llu bytes, %llu bytes unchanged.",
+				  m_stats.commandBufferCount, m_stats.memoryCount,
+				  m_stats.memorySize, m_stats.unchangedSize);
+	}
+}
+
+void GnmCmdCapture::setCapturePath(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(g_pathMutex);
+	g_capturePath = path;
+}
+
+std::string GnmCmdCapture::getCapturePath()
+{
+	std::lock_guard<std::mutex> lock(g_pathMutex);
+	return g_capturePath;
+}
+
+bool GnmCmdCapture::open(
+	const std::string&                          path,
+	const std::vector<GnmCaptureDisplayBuffer>& displayBuffers)
+{
+	bool ret = false;
+	do
+	{
+		m_file.reset(fopen(path.c_str(), "wb"));
+		if (!m_file)
+		{
+			LOG_ERR("failed to create capture %s.", path.c_str());
+			break;
+		}
+
+		GnmCaptureHeader header = {};
+		std::memcpy(header.magic, GnmCaptureMagic, sizeof(header.magic));
+		header.version            = GnmCaptureVersion;
+		header.displayBufferCount = uint32_t(displayBuffers.size());
+
+		if (fwrite(&header, sizeof(header), 1, m_file.get()) != 1 ||
+			fwrite(displayBuffers.data(), sizeof(GnmCaptureDisplayBuffer), displayBuffers.size(), m_file.get()) != displayBuffers.size())
+		{
+			LOG_ERR("failed to write capture %s.", path.c_str());
+			m_file.reset();
+			break;
+		}
+
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+void GnmCmdCapture::addMemory(const void* address, size_t size)
+{
+	do
+	{
+		if (!m_file || !address || !size)
+		{
+			break;
+		}
+
+		const uint8_t* begin = reinterpret_cast<const uint8_t*>(address);
+
+		auto iter = m_ranges.find(address);
+		if (iter != m_ranges.end())
+		{
+			// The part added before may have been written by
+			// commands since, only the rest is taken now.
+			size_t takenSize = iter->second.size;
+			if (size > takenSize)
+			{
+				addMemory(begin + takenSize, size - takenSize);
+			}
+			break;
+		}
+
+		GnmCaptureRange range = {};
+		range.size            = size;
+		range.hash            = algo::MurmurHash(begin, int(size));
+		range.snapshot        = kUnchanged;
+
+		auto written = m_written.find(address);
+		if (written != m_written.end() &&
+			written->second.size == size && written->second.hash == range.hash)
+		{
+			m_stats.unchangedSize += size;
+		}
+		else
+		{
+			range.snapshot = m_snapshots.size();
+			m_snapshots.insert(m_snapshots.end(), begin, begin + size);
+		}
+
+		m_ranges.emplace(address, range);
+	} while (false);
+}
+
+void GnmCmdCapture::writeCommandBuffer(
+	const void* buffer,
+	uint32_t    size,
+	uint32_t    displayBufferIndex)
+{
+	do
+	{
+		if (!m_file)
+		{
+			break;
+		}
+
+		const uint8_t* bufferBegin = reinterpret_cast<const uint8_t*>(buffer);
+		const uint8_t* bufferEnd   = bufferBegin + size;
+
+		bool success = true;
+		for (const auto& pair : m_ranges)
+		{
+			const uint8_t* begin = reinterpret_cast<const uint8_t*>(pair.first);
+			const auto&    range = pair.second;
+
+			// The replayer keeps unchanged ranges, and descriptors
+			// embedded in the command buffer are written along with it.
+			if (range.snapshot == kUnchanged ||
+				(begin >= bufferBegin && begin + range.size <= bufferEnd))
+			{
+				continue;
+			}
+
+			m_written[pair.first] = GnmCapturedMemory{ range.size, range.hash };
+
+			success &= writeRecord(GnmCaptureRecordType::Memory, 0,
+								   begin, m_snapshots.data() + range.snapshot, range.size);
+
+			++m_stats.memoryCount;
+			m_stats.memorySize += range.size;
+		}
+		m_ranges.clear();
+		m_snapshots.clear();
+
+		success &= writeRecord(GnmCaptureRecordType::CommandBuffer, displayBufferIndex, buffer, buffer, size);
+		++m_stats.commandBufferCount;
+
+		if (!success)
+		{
+			// A partial record would break the whole capture,
+			// stop here and keep what was written so far.
+			LOG_ERR("failed to write capture, capturing stopped.");
+			m_file.reset();
+			break;
+		}
+
+		fflush(m_file.get());
+	} while (false);
+}
+
+const GnmCaptureStats& GnmCmdCapture::getStats() const
+{
+	return m_stats;
+}
+
+bool GnmCmdCapture::writeRecord(
+	GnmCaptureRecordType type,
+	uint32_t             displayBufferIndex,
+	const void*          address,
+	const void*          data,
+	size_t               size)
+{
+	GnmCaptureRecord record   = {};
+	record.type               = type;
+	record.displayBufferIndex = displayBufferIndex;
+	record.address            = reinterpret_cast<uint64_t>(address);
+	record.size               = size;
+
+	return fwrite(&record, sizeof(record), 1, m_file.get()) == 1 &&
+		   fwrite(data, 1, size, m_file.get()) == size;
+}
+
+GnmCmdCaptureReader::GnmCmdCaptureReader()
+{
+}
+
+GnmCmdCaptureReader::~GnmCmdCaptureReader()
+{
+	UtilFile::UnmapFile(m_data, m_size);
+}
+
+bool GnmCmdCaptureReader::open(const std::string& path)
+{
+	bool ret = false;
+	do
+	{
+		m_data = reinterpret_cast<const uint8_t*>(UtilFile::MapFile(path, &m_size));
+		if (!m_data)
+		{
+			LOG_ERR("failed to load capture %s.", path.c_str());
+			break;
+		}
+
+		GnmCaptureHeader header = {};
+		if (m_size < sizeof(header))
+		{
+			LOG_ERR("invalid capture %s.", path.c_str());
+			break;
+		}
+
+		std::memcpy(&header, m_data, sizeof(header));
+		if (std::memcmp(header.magic, GnmCaptureMagic, sizeof(header.magic)) ||
+			header.version != GnmCaptureVersion ||
+			m_size < sizeof(header) + header.displayBufferCount * sizeof(GnmCaptureDisplayBuffer))
+		{
+			LOG_ERR("invalid capture %s.", path.c_str());
+			break;
+		}
+
+		m_displayBuffers.resize(header.displayBufferCount);
+		std::memcpy(m_displayBuffers.data(), m_data + sizeof(header),
+					m_displayBuffers.size() * sizeof(GnmCaptureDisplayBuffer));
+
+		m_begin  = sizeof(header) + m_displayBuffers.size() * sizeof(GnmCaptureDisplayBuffer);
+		m_offset = m_begin;
+
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+const std::vector<GnmCaptureDisplayBuffer>& GnmCmdCaptureReader::displayBuffers() const
+{
+	return m_displayBuffers;
+}
+
+bool GnmCmdCaptureReader::next(GnmCaptureRecord& record, const void*& data)
+{
+	bool ret = false;
+	do
+	{
+		if (m_size - m_offset < sizeof(record))
+		{
+			break;
+		}
+
+		std::memcpy(&record, m_data + m_offset, sizeof(record));
+		if (m_size - m_offset - sizeof(record) < record.size)
+		{
+			LOG_WARN("capture truncated at offset %zu.", m_offset);
+			break;
+		}
+
+		data = m_data + m_offset + sizeof(record);
+		m_offset += sizeof(record) + record.size;
+
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+void GnmCmdCaptureReader::rewind()
+{
+	m_offset = m_begin;
+}
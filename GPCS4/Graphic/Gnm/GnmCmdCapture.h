@@ -0,0 +1,235 @@
+#pragma once
+
+#include "GnmCommon.h"
+
+#include "Platform/UtilFile.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * \brief Capture file header
+ *
+ * Followed by displayBufferCount display buffers,
+ * then records up to the end of the file.
+ */
+struct GnmCaptureHeader
+{
+	char     magic[4];
+	uint32_t version;
+	uint32_t displayBufferCount;
+	uint32_t reserved;
+};
+
+/**
+ * \brief Captured display buffer
+ *
+ * Only the description, the content
+ * is written by the command buffers.
+ */
+struct GnmCaptureDisplayBuffer
+{
+	uint64_t address;
+	int32_t  tile;
+	int32_t  format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t size;
+	uint32_t reserved;
+};
+
+enum class GnmCaptureRecordType : uint32_t
+{
+	Memory        = 0,  // Guest memory used by the next command buffer
+	CommandBuffer = 1,  // Command buffer submitted with a flip
+};
+
+/**
+ * \brief Capture record
+ *
+ * Followed by size bytes, the content
+ * of the guest memory at address.
+ */
+struct GnmCaptureRecord
+{
+	GnmCaptureRecordType type;
+	uint32_t             displayBufferIndex;  // Command buffers only
+	uint64_t             address;
+	uint64_t             size;
+};
+
+/**
+ * \brief Capture statistics
+ */
+struct GnmCaptureStats
+{
+	uint32_t commandBufferCount = 0;
+	uint64_t memoryCount        = 0;  // Memory records written
+	uint64_t memorySize         = 0;
+	uint64_t unchangedSize      = 0;  // Not written, same content as last written
+};
+
+/**
+ * \brief Command buffer capture
+ *
+ * Writes submitted command buffers and the guest memory
+ * they use to a single file, which the replayer feeds
+ * through the graphics frontend without the game.
+ *
+ * Memory is added while a command buffer is processed:
+ * shader code, resource descriptors, the buffers, textures
+ * and index data they point to, and labels. Its content is
+ * taken when it is first added, before later commands of
+ * the same buffer can write it, and is written ahead of the
+ * command buffer once that is done. Ranges whose content
+ * didn't change since they were last written are skipped,
+ * the replayer keeps them.
+ *
+ * Only used from the graphics queue's frontend thread.
+ */
+class GnmCmdCapture
+{
+public:
+	GnmCmdCapture();
+	~GnmCmdCapture();
+
+	/**
+	 * \brief Sets the capture file
+	 *
+	 * Must be called before the graphics queue is
+	 * created. An empty path disables capturing.
+	 * \param [in] path Capture file path
+	 */
+	static void setCapturePath(const std::string& path);
+
+	/**
+	 * \brief Capture file path
+	 * \returns Path set with \c setCapturePath
+	 */
+	static std::string getCapturePath();
+
+	/**
+	 * \brief Creates the capture file
+	 *
+	 * \param [in] path Capture file path
+	 * \param [in] displayBuffers Registered display buffers
+	 * \returns \c true on success
+	 */
+	bool open(
+		const std::string&                          path,
+		const std::vector<GnmCaptureDisplayBuffer>& displayBuffers);
+
+	/**
+	 * \brief Adds memory used by the current command buffer
+	 *
+	 * Hashes the range, and copies it if it changed since it
+	 * was last written. A range already added is only taken
+	 * again for the part past its previous size.
+	 * \param [in] address Guest address
+	 * \param [in] size Size in bytes
+	 */
+	void addMemory(const void* address, size_t size);
+
+	/**
+	 * \brief Writes a processed command buffer
+	 *
+	 * Writes the memory added since the last command
+	 * buffer, then the command buffer itself.
+	 * \param [in] buffer Command buffer address
+	 * \param [in] size Command buffer size in bytes
+	 * \param [in] displayBufferIndex Display buffer of the flip
+	 */
+	void writeCommandBuffer(
+		const void* buffer,
+		uint32_t    size,
+		uint32_t    displayBufferIndex);
+
+	/**
+	 * \brief Capture statistics
+	 * \returns Counters since the file was created
+	 */
+	const GnmCaptureStats& getStats() const;
+
+private:
+	struct GnmCapturedMemory
+	{
+		size_t   size;
+		uint64_t hash;
+	};
+
+	struct GnmCaptureRange
+	{
+		size_t   size;
+		uint64_t hash;
+		size_t   snapshot;  // Offset in m_snapshots, kUnchanged if not copied
+	};
+
+	static constexpr size_t kUnchanged = ~size_t(0);
+
+	bool writeRecord(
+		GnmCaptureRecordType type,
+		uint32_t             displayBufferIndex,
+		const void*          address,
+		const void*          data,
+		size_t               size);
+
+private:
+	UtilFile::file_uptr m_file;
+
+	// Added since the last command buffer by address, and
+	// the content of changed ones as of when they were added
+	std::unordered_map<const void*, GnmCaptureRange> m_ranges;
+	std::vector<uint8_t>                             m_snapshots;
+	// Last written content by address
+	std::unordered_map<const void*, GnmCapturedMemory> m_written;
+
+	GnmCaptureStats m_stats;
+};
+
+/**
+ * \brief Capture file reader
+ *
+ * Maps the whole file, records point into the mapping.
+ */
+class GnmCmdCaptureReader
+{
+public:
+	GnmCmdCaptureReader();
+	~GnmCmdCaptureReader();
+
+	/**
+	 * \brief Opens a capture file
+	 *
+	 * \param [in] path Capture file path
+	 * \returns \c false if the file is missing or invalid
+	 */
+	bool open(const std::string& path);
+
+	/**
+	 * \brief Display buffers of the capture
+	 */
+	const std::vector<GnmCaptureDisplayBuffer>& displayBuffers() const;
+
+	/**
+	 * \brief Reads the next record
+	 *
+	 * \param [out] record The record
+	 * \param [out] data Content of the record
+	 * \returns \c false at the end of the file or on a truncated record
+	 */
+	bool next(GnmCaptureRecord& record, const void*& data);
+
+	/**
+	 * \brief Goes back to the first record
+	 */
+	void rewind();
+
+private:
+	const uint8_t* m_data   = nullptr;
+	size_t         m_size   = 0;
+	size_t         m_begin  = 0;  // First record
+	size_t         m_offset = 0;
+
+	std::vector<GnmCaptureDisplayBuffer> m_displayBuffers;
+};
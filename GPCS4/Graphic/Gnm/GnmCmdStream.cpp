@@ -50,174 +50,252 @@ bool GnmCmdStream::processCommandBuffer(const void* commandBuffer, uint32_t comm
 		// it's likely because there are some GnmDriver functions not implemented,
 		// so no proper private packets being inserted into the command buffer.
 
-		const PM4_HEADER* pm4Hdr           = reinterpret_cast<const PM4_HEADER*>(commandBuffer);
-		uint32_t          processedCmdSize = 0;
-		
-		while (processedCmdSize < commandSize)
+		if (!commandBuffer || !commandSize)
 		{
-			uint32_t pm4Type = pm4Hdr->type;
-
-			switch (pm4Type)
-			{
-			case PM4_TYPE_0:
-				processPM4Type0((PPM4_TYPE_0_HEADER)pm4Hdr, (uint32_t*)(pm4Hdr + 1));
-				break;
-			case PM4_TYPE_2:
-			{
-				// opcode should be 0x80000000, this is an 1 dword NOP
-				++pm4Hdr;
-				processedCmdSize += sizeof(PPM4_HEADER);
-				continue;
-			}
-				break;
-			case PM4_TYPE_3:
-				processPM4Type3((PPM4_TYPE_3_HEADER)pm4Hdr, (uint32_t*)(pm4Hdr + 1));
-				break;
-			default:
-				LOG_ERR("Invalid pm4 type %d", pm4Type);
-				break;
-			}
-
-			if (m_flipPacketDone)
-			{
-				break;
-			}
+			break;
+		}
 
-			uint32_t processedPm4Count = 1;
+		m_records.clear();
+		decodeCommandBuffer(commandBuffer, commandSize, m_records);
+		++m_stats.decodeCount;
 
-			if (m_skipPm4Count != 0)
-			{
-				processedPm4Count += m_skipPm4Count;
-				m_skipPm4Count = 0;
-			}
-
-			const PM4_HEADER* nextPm4Hdr = getNextNPm4(pm4Hdr, processedPm4Count);
-			uint32_t processedLength = reinterpret_cast<uintptr_t>(nextPm4Hdr) - reinterpret_cast<uintptr_t>(pm4Hdr);
-			pm4Hdr = nextPm4Hdr;
-			processedCmdSize += processedLength;
-		}
+		executeRecords(m_records);
 
 		bRet = true;
 	} while (false);
 
 	// Clear works for this command buffer.
 	m_flipPacketDone = false;
+	m_skipPm4Count   = 0;
 
 	return bRet;
 }
 
-void GnmCmdStream::processPM4Type0(PPM4_TYPE_0_HEADER pm4Hdr, uint32_t* regDataX)
+GnmCmdStreamStats GnmCmdStream::getStats() const
 {
-	LOG_FIXME("Type 0 PM4 packet is not supported.");
+	return m_stats;
 }
 
-void GnmCmdStream::processPM4Type3(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody)
+void GnmCmdStream::decodeCommandBuffer(
+	const void*                commandBuffer,
+	uint32_t                   commandSize,
+	std::vector<GnmCmdRecord>& records)
 {
-	IT_OpCodeType opcode = (IT_OpCodeType)pm4Hdr->opcode;
+	const auto& type3Handlers   = getType3Handlers();
+	const auto& privateHandlers = getPrivateHandlers();
 
-	LOG_DEBUG("OpCode Name %s", opcodeName(*(uint32_t*)pm4Hdr));
+	const uint32_t* pm4Hdr = reinterpret_cast<const uint32_t*>(commandBuffer);
+	const uint32_t* pm4End = pm4Hdr + commandSize / sizeof(uint32_t);
+
+	while (pm4Hdr < pm4End)
+	{
+		uint32_t token   = *pm4Hdr;
+		uint32_t pm4Type = PM4_TYPE(token);
+		uint32_t length  = PM4_LENGTH_DW(token);
+
+		GnmCmdRecord record;
+		record.packet = reinterpret_cast<PPM4_TYPE_3_HEADER>(const_cast<uint32_t*>(pm4Hdr));
+
+		switch (pm4Type)
+		{
+		case PM4_TYPE_2:
+			// opcode should be 0x80000000, this is an 1 dword NOP,
+			// recorded so that skipped packets are counted right.
+			record.handler = nullptr;
+			length         = 1;
+			break;
+		case PM4_TYPE_0:
+			record.handler = &GnmCmdStream::onType0;
+			break;
+		case PM4_TYPE_3:
+		{
+			IT_OpCodeType opcode = (IT_OpCodeType)record.packet->opcode;
+			LOG_DEBUG("OpCode Name %s", opcodeName(token));
+
+			record.handler = opcode == IT_GNM_PRIVATE
+								 ? privateHandlers[PM4_PRIV(token)]
+								 : type3Handlers[opcode];
+		}
+			break;
+		default:
+			LOG_ERR("Invalid pm4 type %d", pm4Type);
+			record.handler = nullptr;
+			break;
+		}
+
+		// Records map one to one to packets, handlers
+		// skip the packets they consumed by count.
+		records.push_back(record);
+		pm4Hdr += length;
+	}
+}
+
+void GnmCmdStream::executeRecords(const std::vector<GnmCmdRecord>& records)
+{
+	size_t index = 0;
+	while (index < records.size())
+	{
+		const GnmCmdRecord& record = records[index];
+		if (record.handler)
+		{
+			(this->*record.handler)(record.packet, reinterpret_cast<uint32_t*>(record.packet + 1));
+		}
+
+		++m_stats.packetCount;
+
+		if (m_flipPacketDone)
+		{
+			break;
+		}
+
+		// Some Gnm calls are formed with several packets,
+		// skip the ones the handler consumed, 1 dword NOPs aside.
+		++index;
+		while (m_skipPm4Count != 0 && index < records.size())
+		{
+			if (PM4_TYPE(records[index].packet->u32All) != PM4_TYPE_2)
+			{
+				--m_skipPm4Count;
+			}
+			++index;
+		}
+		m_skipPm4Count = 0;
+	}
+}
+
+const std::array<GnmCmdStream::PacketHandler, 256>& GnmCmdStream::getType3Handlers()
+{
+	static const std::array<PacketHandler, 256> s_handlers = []()
+	{
+		std::array<PacketHandler, 256> handlers;
+		for (uint32_t opcode = 0; opcode != handlers.size(); ++opcode)
+		{
+			handlers[opcode] = type3Handler((IT_OpCodeType)opcode);
+		}
+		return handlers;
+	}();
+	return s_handlers;
+}
+
+const std::array<GnmCmdStream::PacketHandler, 256>& GnmCmdStream::getPrivateHandlers()
+{
+	static const std::array<PacketHandler, 256> s_handlers = []()
+	{
+		std::array<PacketHandler, 256> handlers;
+		for (uint32_t priv = 0; priv != handlers.size(); ++priv)
+		{
+			handlers[priv] = privateHandler((IT_OpCodePriv)priv);
+		}
+		return handlers;
+	}();
+	return s_handlers;
+}
+
+GnmCmdStream::PacketHandler GnmCmdStream::type3Handler(IT_OpCodeType opcode)
+{
+	PacketHandler handler = nullptr;
 
 	switch (opcode)
 	{
 	case IT_NOP:
-		onNop(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onNop;
 		break;
 	case IT_SET_BASE:
-		onSetBase(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onSetBase;
 		break;
 	case IT_INDEX_BUFFER_SIZE:
-		onIndexBufferSize(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onIndexBufferSize;
 		break;
 	case IT_SET_PREDICATION:
-		onSetPredication(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onSetPredication;
 		break;
 	case IT_COND_EXEC:
-		onCondExec(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onCondExec;
 		break;
 	case IT_INDEX_BASE:
-		onIndexBase(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onIndexBase;
 		break;
 	case IT_INDEX_TYPE:
-		onIndexType(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onIndexType;
 		break;
 	case IT_NUM_INSTANCES:
-		onNumInstances(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onNumInstances;
 		break;
 	case IT_STRMOUT_BUFFER_UPDATE:
-		onStrmoutBufferUpdate(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onStrmoutBufferUpdate;
 		break;
 	case IT_WRITE_DATA:
-		onWriteData(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onWriteData;
 		break;
 	case IT_MEM_SEMAPHORE:
-		onMemSemaphore(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onMemSemaphore;
 		break;
 	case IT_WAIT_REG_MEM:
-		onWaitRegMem(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onWaitRegMem;
 		break;
 	case IT_INDIRECT_BUFFER:
-		onIndirectBuffer(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onIndirectBuffer;
 		break;
 	case IT_PFP_SYNC_ME:
-		onPfpSyncMe(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onPfpSyncMe;
 		break;
 	case IT_EVENT_WRITE:
-		onEventWrite(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onEventWrite;
 		break;
 	case IT_EVENT_WRITE_EOP:
-		onEventWriteEop(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onEventWriteEop;
 		break;
 	case IT_EVENT_WRITE_EOS:
-		onEventWriteEos(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onEventWriteEos;
 		break;
 	case IT_DMA_DATA:
-		onDmaData(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onDmaData;
 		break;
 	case IT_ACQUIRE_MEM:
-		onAcquireMem(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onAcquireMem;
 		break;
 	case IT_REWIND:
-		onRewind(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onRewind;
 		break;
 	case IT_SET_CONFIG_REG:
-		onSetConfigReg(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onSetConfigReg;
 		break;
 	case IT_SET_CONTEXT_REG:  // 0x69
-		onSetContextReg(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onSetContextReg;
 		break;
 	case IT_SET_SH_REG:
-		onSetShReg(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onSetShReg;
 		break;
 	case IT_SET_UCONFIG_REG:  // 0x79
-		onSetUconfigReg(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onSetUconfigReg;
 		break;
 	case IT_INCREMENT_DE_COUNTER:
-		onIncrementDeCounter(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onIncrementDeCounter;
 		break;
 	case IT_WAIT_ON_CE_COUNTER:
-		onWaitOnCeCounter(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onWaitOnCeCounter;
 		break;
 	case IT_DISPATCH_DRAW_PREAMBLE__GFX09:
-		onDispatchDrawPreambleGfx09(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onDispatchDrawPreambleGfx09;
 		break;
 	case IT_DISPATCH_DRAW__GFX09:
-		onDispatchDrawGfx09(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onDispatchDrawGfx09;
 		break;
 	case IT_GET_LOD_STATS__GFX09:
-		onGetLodStatsGfx09(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onGetLodStatsGfx09;
 		break;
 	case IT_RELEASE_MEM:
-		onReleaseMem(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onReleaseMem;
 		break;
-	// Private handler
+
+	// Private packets are looked up in their own table.
 	case IT_GNM_PRIVATE:
-		onGnmPrivate(pm4Hdr, itBody);
 		break;
 
 	// Legacy packets used in old SDKs.
 	case IT_DRAW_INDEX_AUTO:
 	case IT_DISPATCH_DIRECT:
-		onGnmLegacy(pm4Hdr, itBody);
+		handler = &GnmCmdStream::onGnmLegacy;
 		break;
 
 	// The following opcode types are not used by Gnm
@@ -310,13 +388,83 @@ void GnmCmdStream::processPM4Type3(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody)
 	case IT_MAP_PROCESS_VM:
 	case IT_DRAW_MULTI_PREAMBLE__GFX09:
 	case IT_AQL_PACKET__GFX09:
-		LOG_ERR("Opcode not supported %X", opcode);
+		handler = &GnmCmdStream::onUnsupported;
+		break;
+	default:
+		handler = &GnmCmdStream::onInvalid;
+		break;
+	}
+
+	return handler;
+}
+
+GnmCmdStream::PacketHandler GnmCmdStream::privateHandler(IT_OpCodePriv priv)
+{
+	// Note:
+	// Most private opcode handlers are not much complicated,
+	// just cast pm4Hdr to proper GnmCmdxxx and call the graphic function.
+	// Private opcodes without a handler are skipped.
+
+	PacketHandler handler = nullptr;
+
+	switch (priv)
+	{
+	case OP_PRIV_INITIALIZE_DEFAULT_HARDWARE_STATE:
+		handler = &GnmCmdStream::onInitializeDefaultHardwareState;
+		break;
+	case OP_PRIV_SET_EMBEDDED_VS_SHADER:
+		handler = &GnmCmdStream::onSetEmbeddedVsShader;
+		break;
+	case OP_PRIV_SET_VS_SHADER:
+		handler = &GnmCmdStream::onSetVsShader;
+		break;
+	case OP_PRIV_SET_PS_SHADER:
+		handler = &GnmCmdStream::onSetPsShader;
+		break;
+	case OP_PRIV_SET_CS_SHADER:
+		handler = &GnmCmdStream::onSetCsShader;
+		break;
+	case OP_PRIV_UPDATE_PS_SHADER:
+		handler = &GnmCmdStream::onUpdatePsShader;
+		break;
+	case OP_PRIV_UPDATE_VS_SHADER:
+		handler = &GnmCmdStream::onUpdateVsShader;
+		break;
+	case OP_PRIV_SET_VGT_CONTROL:
+		handler = &GnmCmdStream::onSetVgtControl;
+		break;
+	case OP_PRIV_DRAW_INDEX:
+		handler = &GnmCmdStream::onDrawIndex;
+		break;
+	case OP_PRIV_DRAW_INDEX_AUTO:
+		handler = &GnmCmdStream::onDrawIndexAuto;
+		break;
+	case OP_PRIV_WAIT_UNTIL_SAFE_FOR_RENDERING:
+		handler = &GnmCmdStream::onWaitUntilSafeForRendering;
+		break;
+	case OP_PRIV_DISPATCH_DIRECT:
+		handler = &GnmCmdStream::onDispatchDirect;
 		break;
 	default:
-		LOG_ERR("Invalid opcode %X", opcode);
 		break;
 	}
 
+	return handler;
+}
+
+void GnmCmdStream::onType0(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* regDataX)
+{
+	LOG_FIXME("Type 0 PM4 packet is not supported.");
+}
+
+void GnmCmdStream::onUnsupported(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody)
+{
+	LOG_ERR("Opcode not supported %X", pm4Hdr->opcode);
+}
+
+void GnmCmdStream::onInvalid(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody)
+{
+	LOG_ERR("Invalid opcode %X", pm4Hdr->opcode);
 }
 
 // NOP packet usually used for providing a hint for the following packet,
@@ -463,7 +611,10 @@ void GnmCmdStream::onEventWrite(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody)
 void GnmCmdStream::onEventWriteEop(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody)
 {
 
-	PPM4_ME_EVENT_WRITE_EOP eopPacket = (PPM4_ME_EVENT_WRITE_EOP)pm4Hdr;
+	// Work on a copy, the command buffer must stay unchanged
+	// so it executes the same when submitted again.
+	PM4_ME_EVENT_WRITE_EOP  eopCopy   = *(PPM4_ME_EVENT_WRITE_EOP)pm4Hdr;
+	PPM4_ME_EVENT_WRITE_EOP eopPacket = &eopCopy;
 
 	// From IDA
 	eopPacket->ordinal2 -= 0x500;
@@ -818,135 +969,72 @@ void GnmCmdStream::onReleaseMem(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody)
 	}
 }
 
-void GnmCmdStream::onGnmPrivate(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody)
+void GnmCmdStream::onInitializeDefaultHardwareState(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody)
 {
-	// Note:
-	// Most private opcode handle cases are not much complicated,
-	// just cast pm4Hdr to proper GnmCmdxxx and call the graphic function.
-	// But if it's going to be complicated (eg. contains 'if' statement), 
-	// please write a new function to handle it,
-	// like onDrawIndex
+	m_cb->initializeDefaultHardwareState();
+}
 
-	IT_OpCodePriv priv = PM4_PRIV(*(uint32_t*)pm4Hdr);
-	switch (priv)
-	{
-	case OP_PRIV_INITIALIZE_DEFAULT_HARDWARE_STATE:
-		m_cb->initializeDefaultHardwareState();
-		break;
-	case OP_PRIV_INITIALIZE_TO_DEFAULT_CONTEXT_STATE:
-		break;
-	case OP_PRIV_SET_EMBEDDED_VS_SHADER:
-	{
-		GnmCmdVSShader* param = (GnmCmdVSShader*)pm4Hdr;
-		m_cb->setEmbeddedVsShader(param->shaderId, param->modifier);
-	}
-		break;
-	case OP_PRIV_SET_EMBEDDED_PS_SHADER:
-		break;
-	case OP_PRIV_SET_VS_SHADER:
-	{
-		GnmCmdVSShader* param = (GnmCmdVSShader*)pm4Hdr;
-		m_cb->setVsShader(&param->vsRegs, param->modifier);
-	}
-		break;
-	case OP_PRIV_SET_PS_SHADER:
-	{
-		GnmCmdPSShader* param = (GnmCmdPSShader*)pm4Hdr;
-		m_cb->setPsShader(&param->psRegs);
-	}
-		break;
-	case OP_PRIV_SET_CS_SHADER:
-	{
-		GnmCmdCSShader* param = (GnmCmdCSShader*)pm4Hdr;
-		m_cb->setCsShader(&param->csRegs, param->modifier);
-	}
-		break;
-	case OP_PRIV_SET_ES_SHADER:
-		break;
-	case OP_PRIV_SET_GS_SHADER:
-		break;
-	case OP_PRIV_SET_HS_SHADER:
-		break;
-	case OP_PRIV_SET_LS_SHADER:
-		break;
-	case OP_PRIV_UPDATE_GS_SHADER:
-		break;
-	case OP_PRIV_UPDATE_HS_SHADER:
-		break;
-	case OP_PRIV_UPDATE_PS_SHADER:
-	{
-		GnmCmdPSShader* param = (GnmCmdPSShader*)pm4Hdr;
-		m_cb->updatePsShader(&param->psRegs);
-	}
-		break;
-	case OP_PRIV_UPDATE_VS_SHADER:
-	{
-		GnmCmdVSShader* param = (GnmCmdVSShader*)pm4Hdr;
-		m_cb->updateVsShader(&param->vsRegs, param->modifier);
-	}
-		break;
-	case OP_PRIV_SET_VGT_CONTROL:
-	{
-		GnmCmdVgtControl* param = (GnmCmdVgtControl*)pm4Hdr;
-		m_cb->setVgtControlForNeo(param->primGroupSizeMinusOne, 
-			(WdSwitchOnlyOnEopMode)param->wdSwitchOnlyOnEopMode, 
-			(VgtPartialVsWaveMode)param->partialVsWaveMode);
-	}
-		break;
-	case OP_PRIV_RESET_VGT_CONTROL:
-		break;
-	case OP_PRIV_DRAW_INDEX:
-		onDrawIndex(pm4Hdr, itBody);
-		break;
-	case OP_PRIV_DRAW_INDEX_AUTO:
-		onDrawIndexAuto(pm4Hdr, itBody);
-		break;
-	case OP_PRIV_DRAW_INDEX_INDIRECT:
-		break;
-	case OP_PRIV_DRAW_INDEX_INDIRECT_COUNT_MULTI:
-		break;
-	case OP_PRIV_DRAW_INDEX_MULTI_INSTANCED:
-		break;
-	case OP_PRIV_DRAW_INDEX_OFFSET:
-		break;
-	case OP_PRIV_DRAW_INDIRECT:
-		break;
-	case OP_PRIV_DRAW_INDIRECT_COUNT_MULTI:
-		break;
-	case OP_PRIV_DRAW_OPAQUE_AUTO:
-		break;
-	case OP_PRIV_WAIT_UNTIL_SAFE_FOR_RENDERING:
+void GnmCmdStream::onSetEmbeddedVsShader(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody)
+{
+	GnmCmdVSShader* param = (GnmCmdVSShader*)pm4Hdr;
+	m_cb->setEmbeddedVsShader(param->shaderId, param->modifier);
+}
+
+void GnmCmdStream::onSetVsShader(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody)
+{
+	GnmCmdVSShader* param = (GnmCmdVSShader*)pm4Hdr;
+	m_cb->setVsShader(&param->vsRegs, param->modifier);
+}
+
+void GnmCmdStream::onSetPsShader(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody)
+{
+	GnmCmdPSShader* param = (GnmCmdPSShader*)pm4Hdr;
+	m_cb->setPsShader(&param->psRegs);
+}
+
+void GnmCmdStream::onSetCsShader(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody)
+{
+	GnmCmdCSShader* param = (GnmCmdCSShader*)pm4Hdr;
+	m_cb->setCsShader(&param->csRegs, param->modifier);
+}
+
+void GnmCmdStream::onUpdatePsShader(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody)
+{
+	GnmCmdPSShader* param = (GnmCmdPSShader*)pm4Hdr;
+	m_cb->updatePsShader(&param->psRegs);
+}
+
+void GnmCmdStream::onUpdateVsShader(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody)
+{
+	GnmCmdVSShader* param = (GnmCmdVSShader*)pm4Hdr;
+	m_cb->updateVsShader(&param->vsRegs, param->modifier);
+}
+
+void GnmCmdStream::onSetVgtControl(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody)
+{
+	GnmCmdVgtControl* param = (GnmCmdVgtControl*)pm4Hdr;
+	m_cb->setVgtControlForNeo(param->primGroupSizeMinusOne,
+		(WdSwitchOnlyOnEopMode)param->wdSwitchOnlyOnEopMode,
+		(VgtPartialVsWaveMode)param->partialVsWaveMode);
+}
+
+void GnmCmdStream::onWaitUntilSafeForRendering(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody)
+{
+	GnmCmdWaitFlipDone* param = (GnmCmdWaitFlipDone*)pm4Hdr;
+	m_cb->waitUntilSafeForRendering(param->videoOutHandle, param->displayBufferIndex);
+}
+
+void GnmCmdStream::onDispatchDirect(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody)
+{
+	GnmCmdDispatchDirect*     param = (GnmCmdDispatchDirect*)pm4Hdr;
+	DispatchOrderedAppendMode mode  = (DispatchOrderedAppendMode)bit::extract(param->pred, 3, 4);
+	if (mode == kDispatchOrderedAppendModeDisabled)
 	{
-		GnmCmdWaitFlipDone* param = (GnmCmdWaitFlipDone*)pm4Hdr;
-		m_cb->waitUntilSafeForRendering(param->videoOutHandle, param->displayBufferIndex);
+		m_cb->dispatch(param->threadGroupX, param->threadGroupY, param->threadGroupZ);
 	}
-		break;
-	case OP_PRIV_PUSH_MARKER:
-		break;
-	case OP_PRIV_PUSH_COLOR_MARKER:
-		break;
-	case OP_PRIV_POP_MARKER:
-		break;
-	case OP_PRIV_SET_MARKER:
-		break;
-	case OP_PRIV_DISPATCH_DIRECT:
+	else
 	{
-		GnmCmdDispatchDirect*     param = (GnmCmdDispatchDirect*)pm4Hdr;
-		DispatchOrderedAppendMode mode  = (DispatchOrderedAppendMode)bit::extract(param->pred, 3, 4);
-		if (mode == kDispatchOrderedAppendModeDisabled)
-		{
-			m_cb->dispatch(param->threadGroupX, param->threadGroupY, param->threadGroupZ);
-		}
-		else
-		{
-			m_cb->dispatchWithOrderedAppend(param->threadGroupX, param->threadGroupY, param->threadGroupZ, mode);
-		}
-	}
-		break;
-	case OP_PRIV_DISPATCH_INDIRECT:
-		break;
-	default:
-		break;
+		m_cb->dispatchWithOrderedAppend(param->threadGroupX, param->threadGroupY, param->threadGroupZ, mode);
 	}
 }
 
@@ -4,6 +4,9 @@
 #include "GnmOpCode.h"
 #include "GnmCommandBuffer.h"
 
+#include <array>
+#include <vector>
+
 // This class takes all the reverse engining work, parsing PM4 packets (aka command buffer),
 // restore the original high level Gnm API calls, and the forward to CnmCommandBufferXXX class,
 // we handle graphic staffs there.
@@ -15,9 +18,27 @@
 // The parsing process takes references from:
 // AMD manual: Radeon Southern Islands Acceleration
 // PAL: https://github.com/GPUOpen-Drivers/pal
+//
+// A command buffer is first decoded into an array of (handler, packet) records,
+// looking up each opcode in a 256 entry table, then the records are executed in order.
+// Records are not kept across submissions, decoding is cheap next to the handlers.
+
+struct GnmCmdStreamStats
+{
+	uint64_t decodeCount = 0;  // Command buffers decoded
+	uint64_t packetCount = 0;  // Packets executed
+};
 
 class GnmCmdStream
 {
+	using PacketHandler = void (GnmCmdStream::*)(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody);
+
+	struct GnmCmdRecord
+	{
+		PacketHandler      handler;  // Null for packets without effect
+		PPM4_TYPE_3_HEADER packet;
+	};
+
 public:
 	GnmCmdStream();
 	~GnmCmdStream();
@@ -26,10 +47,25 @@ public:
 
 	bool processCommandBuffer(const void* commandBuffer, uint32_t commandSize);
 
+	GnmCmdStreamStats getStats() const;
+
 private:
-	
-	void processPM4Type0(PPM4_TYPE_0_HEADER pm4Hdr, uint32_t* regDataX);
-	void processPM4Type3(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody);
+	void decodeCommandBuffer(
+		const void*                commandBuffer,
+		uint32_t                   commandSize,
+		std::vector<GnmCmdRecord>& records);
+
+	void executeRecords(const std::vector<GnmCmdRecord>& records);
+
+	static const std::array<PacketHandler, 256>& getType3Handlers();
+	static const std::array<PacketHandler, 256>& getPrivateHandlers();
+
+	static PacketHandler type3Handler(IT_OpCodeType opcode);
+	static PacketHandler privateHandler(IT_OpCodePriv priv);
+
+	void onType0(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* regDataX);
+	void onUnsupported(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody);
+	void onInvalid(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody);
 
 	// Type 3 pm4 packet handlers
 	void onNop(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody);
@@ -63,8 +99,17 @@ private:
 	void onGetLodStatsGfx09(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody);
 	void onReleaseMem(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody);
 
-	// Private
-	void onGnmPrivate(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody);
+	// Private packet handlers
+	void onInitializeDefaultHardwareState(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody);
+	void onSetEmbeddedVsShader(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody);
+	void onSetVsShader(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody);
+	void onSetPsShader(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody);
+	void onSetCsShader(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody);
+	void onUpdatePsShader(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody);
+	void onUpdateVsShader(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody);
+	void onSetVgtControl(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody);
+	void onWaitUntilSafeForRendering(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody);
+	void onDispatchDirect(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody);
 	// Legacy packets used in old SDKs.
 	void onGnmLegacy(PPM4_TYPE_3_HEADER pm4Hdr, uint32_t* itBody);
 
@@ -113,6 +158,11 @@ private:
 	// e.g. 2 packets makes gnm call, m_skipPm4Count = 1
 	uint32_t m_skipPm4Count = 0;
 
+	// Records of the command buffer being executed,
+	// kept to reuse their storage.
+	std::vector<GnmCmdRecord> m_records;
+
+	GnmCmdStreamStats m_stats;
 };
 
 
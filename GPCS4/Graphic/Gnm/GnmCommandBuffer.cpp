@@ -1,4 +1,5 @@
 #include "GnmCommandBuffer.h"
+#include "GnmCmdCapture.h"
 
 #include "../Violet/VltDevice.h"
 #include "../Violet/VltContext.h"
@@ -10,6 +11,15 @@
 
 #include "Platform/PlatformUtils.h"
 
+#include <chrono>
+#include <thread>
+
+LOG_CHANNEL(Graphic.Gnm.GnmCommandBuffer);
+
+// A game thread writing a label is usually done well within this,
+// labels we don't emulate yet are never written at all.
+constexpr std::chrono::milliseconds WaitOnAddressTimeout(4);
+
 GnmCommandBuffer::GnmCommandBuffer(
 	const sce::SceGpuQueueDevice& device,
 	const RcPtr<vlt::VltContext>& context) :
@@ -35,6 +45,11 @@ RcPtr<vlt::VltCmdList> GnmCommandBuffer::recordEnd()
 	return std::exchange(m_cmdList, nullptr);
 }
 
+void GnmCommandBuffer::setCapture(GnmCmdCapture* capture)
+{
+	m_capture = capture;
+}
+
 void GnmCommandBuffer::emuWriteGpuLabel(EventWriteSource selector, void* label, uint64_t value)
 {
 	do 
@@ -44,6 +59,8 @@ void GnmCommandBuffer::emuWriteGpuLabel(EventWriteSource selector, void* label,
 			break;
 		}
 
+		captureMemory(label, selector == kEventWriteSource32BitsImmediate ? sizeof(uint32_t) : sizeof(uint64_t));
+
 		if (selector == kEventWriteSource32BitsImmediate)
 		{
 			*(uint32_t*)label = value;
@@ -59,3 +76,69 @@ void GnmCommandBuffer::emuWriteGpuLabel(EventWriteSource selector, void* label,
 
 	} while (false);
 }
+
+void GnmCommandBuffer::emuWaitOnAddress(void* gpuAddr, uint32_t mask, WaitCompareFunc compareFunc, uint32_t refValue)
+{
+	do
+	{
+		if (!gpuAddr)
+		{
+			break;
+		}
+
+		auto compare = [=](uint32_t value)
+		{
+			value &= mask;
+			switch (compareFunc)
+			{
+			case kWaitCompareFuncAlways: return true;
+			case kWaitCompareFuncLess: return value < refValue;
+			case kWaitCompareFuncLessEqual: return value <= refValue;
+			case kWaitCompareFuncEqual: return value == refValue;
+			case kWaitCompareFuncNotEqual: return value != refValue;
+			case kWaitCompareFuncGreaterEqual: return value >= refValue;
+			case kWaitCompareFuncGreater: return value > refValue;
+			default: return true;
+			}
+		};
+
+		captureMemory(gpuAddr, sizeof(uint32_t));
+
+		auto label    = reinterpret_cast<volatile uint32_t*>(gpuAddr);
+		auto deadline = std::chrono::steady_clock::now() + WaitOnAddressTimeout;
+		while (!compare(*label))
+		{
+			if (std::chrono::steady_clock::now() > deadline)
+			{
+				LOG_WARN("wait on address %p timed out, value %X mask %X ref %X.",
+						 gpuAddr, *label, mask, refValue);
+				break;
+			}
+			std::this_thread::yield();
+		}
+	} while (false);
+}
+
+void GnmCommandBuffer::captureMemory(const void* address, size_t size)
+{
+	if (m_capture)
+	{
+		m_capture->addMemory(address, size);
+	}
+}
+
+const void* GnmCommandBuffer::getEmbeddedVsShaderCode(EmbeddedVsShader shaderId)
+{
+	LOG_ASSERT(shaderId == kEmbeddedVsShaderFullScreen, "invalid shader id %d", shaderId);
+
+	const static uint8_t embeddedVsShaderFullScreen[] = {
+		0xFF, 0x03, 0xEB, 0xBE, 0x07, 0x00, 0x00, 0x00, 0x81, 0x00, 0x02, 0x36, 0x81, 0x02, 0x02, 0x34,
+		0xC2, 0x00, 0x00, 0x36, 0xC1, 0x02, 0x02, 0x4A, 0xC1, 0x00, 0x00, 0x4A, 0x01, 0x0B, 0x02, 0x7E,
+		0x00, 0x0B, 0x00, 0x7E, 0x80, 0x02, 0x04, 0x7E, 0xF2, 0x02, 0x06, 0x7E, 0xCF, 0x08, 0x00, 0xF8,
+		0x01, 0x00, 0x02, 0x03, 0x0F, 0x02, 0x00, 0xF8, 0x03, 0x03, 0x03, 0x03, 0x00, 0x00, 0x81, 0xBF,
+		0x4F, 0x72, 0x62, 0x53, 0x68, 0x64, 0x72, 0x07, 0x47, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x9F, 0xC2, 0xF8, 0x47, 0xCF, 0xA5, 0x2D, 0x9B, 0x7D, 0x5B, 0x7C, 0xFF, 0x17, 0x00, 0x00, 0x00
+	};
+
+	return embeddedVsShaderFullScreen;
+}
@@ -26,6 +26,7 @@ class SceVideoOut;
 class GnmBuffer;
 class GnmTexture;
 class GnmSampler;
+class GnmCmdCapture;
 
 
 class GnmCommandBuffer
@@ -41,6 +42,13 @@ public:
 
 	virtual RcPtr<vlt::VltCmdList> recordEnd();
 
+	/**
+	 * \brief Sets the capture guest memory is added to
+	 *
+	 * \param [in] capture The capture, \c nullptr to stop capturing
+	 */
+	void setCapture(GnmCmdCapture* capture);
+
 	// Implement these one by one...
 
 	// Note:
@@ -411,6 +419,20 @@ public:
 protected:
 	void emuWriteGpuLabel(EventWriteSource selector, void* label, uint64_t value);
 
+	// Command buffers are parsed on the queue's frontend thread,
+	// so the value may be written by a game thread meanwhile.
+	// Labels written by GPU commands are written in order by the
+	// frontend itself, so the wait only orders the frontend after
+	// game threads, and is bounded to a few milliseconds.
+	void emuWaitOnAddress(void* gpuAddr, uint32_t mask, WaitCompareFunc compareFunc, uint32_t refValue);
+
+	// Adds guest memory the command buffer reads or writes
+	// to the capture, if any.
+	void captureMemory(const void* address, size_t size);
+
+	// GCN code of a shader embedded in the Gnm library.
+	static const void* getEmbeddedVsShaderCode(EmbeddedVsShader shaderId);
+
 protected:
 	RcPtr<vlt::VltDevice>             m_device;
 	RcPtr<vlt::VltContext>            m_context;
@@ -421,8 +443,7 @@ protected:
 
 	RcPtr<vlt::VltCmdList> m_cmdList;
 
-private:
-
+	GnmCmdCapture* m_capture = nullptr;
 };
 
 
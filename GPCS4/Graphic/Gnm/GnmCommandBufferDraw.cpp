@@ -1,4 +1,5 @@
 #include "GnmCommandBufferDraw.h"
+#include "GnmCommandSinkViolet.h"
 
 #include "GnmBuffer.h"
 #include "GnmConvertor.h"
@@ -7,13 +8,11 @@
 #include "GnmTexture.h"
 #include "GpuAddress/GnmGpuAddress.h"
 
+#include "../Pssl/PsslShaderCache.h"
 #include "../Pssl/PsslShaderModule.h"
-#include "../Violet/VltBuffer.h"
+#include "../Sce/SceGpuQueue.h"
 #include "../Violet/VltCmdList.h"
 #include "../Violet/VltContext.h"
-#include "../Violet/VltImage.h"
-#include "../Violet/VltPresenter.h"
-#include "../Violet/VltSampler.h"
 #include "../Violet/VltShader.h"
 
 #include <algorithm>
@@ -31,7 +30,17 @@ GnmCommandBufferDraw::GnmCommandBufferDraw(
 	const SceGpuQueueDevice& device,
 	const RcPtr<VltContext>& context) :
 	GnmCommandBuffer(device, context),
-	m_factory(&device)
+	m_sink(new GnmCommandSinkViolet(device, context)),
+	m_shaderCache(device.shaderCache)
+{
+}
+
+GnmCommandBufferDraw::GnmCommandBufferDraw(
+	const SceGpuQueueDevice&     device,
+	const RcPtr<GnmCommandSink>& sink) :
+	GnmCommandBuffer(device, nullptr),
+	m_sink(sink),
+	m_shaderCache(device.shaderCache)
 {
 }
 
@@ -41,8 +50,7 @@ GnmCommandBufferDraw::~GnmCommandBufferDraw()
 
 void GnmCommandBufferDraw::initializeDefaultHardwareState()
 {
-	m_context->beginRecording(
-		m_device->createCmdList(VltPipelineType::Graphics));
+	m_sink->beginRecording();
 
 	clearRenderState();
 }
@@ -65,7 +73,7 @@ void GnmCommandBufferDraw::setPrimitiveSetup(PrimitiveSetup reg)
 		frontFace,
 		VK_SAMPLE_COUNT_1_BIT);
 
-	m_context->setRasterizerState(rsInfo);
+	m_sink->setRasterizerState(rsInfo);
 }
 
 void GnmCommandBufferDraw::setScreenScissor(int32_t left, int32_t top, int32_t right, int32_t bottom)
@@ -103,7 +111,7 @@ void GnmCommandBufferDraw::setViewport(uint32_t viewportId, float dmin, float dm
 	scissor.extent.width  = width;
 	scissor.extent.height = height;
 
-	m_context->setViewports(1, &viewport, &scissor);
+	m_sink->setViewports(1, &viewport, &scissor);
 }
 
 void GnmCommandBufferDraw::setHardwareScreenOffset(uint32_t offsetX, uint32_t offsetY)
@@ -139,18 +147,7 @@ void GnmCommandBufferDraw::setVsShader(const VsStageRegisters* vsRegs, uint32_t
 
 void GnmCommandBufferDraw::setEmbeddedVsShader(EmbeddedVsShader shaderId, uint32_t shaderModifier)
 {
-	LOG_ASSERT(shaderId == kEmbeddedVsShaderFullScreen, "invalid shader id %d", shaderId);
-
-	const static uint8_t embeddedVsShaderFullScreen[] = {
-		0xFF, 0x03, 0xEB, 0xBE, 0x07, 0x00, 0x00, 0x00, 0x81, 0x00, 0x02, 0x36, 0x81, 0x02, 0x02, 0x34,
-		0xC2, 0x00, 0x00, 0x36, 0xC1, 0x02, 0x02, 0x4A, 0xC1, 0x00, 0x00, 0x4A, 0x01, 0x0B, 0x02, 0x7E,
-		0x00, 0x0B, 0x00, 0x7E, 0x80, 0x02, 0x04, 0x7E, 0xF2, 0x02, 0x06, 0x7E, 0xCF, 0x08, 0x00, 0xF8,
-		0x01, 0x00, 0x02, 0x03, 0x0F, 0x02, 0x00, 0xF8, 0x03, 0x03, 0x03, 0x03, 0x00, 0x00, 0x81, 0xBF,
-		0x4F, 0x72, 0x62, 0x53, 0x68, 0x64, 0x72, 0x07, 0x47, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-		0x9F, 0xC2, 0xF8, 0x47, 0xCF, 0xA5, 0x2D, 0x9B, 0x7D, 0x5B, 0x7C, 0xFF, 0x17, 0x00, 0x00, 0x00
-	};
-
-	m_shaders.vs.code = reinterpret_cast<const void*>(embeddedVsShaderFullScreen);
+	m_shaders.vs.code = getEmbeddedVsShaderCode(shaderId);
 }
 
 void GnmCommandBufferDraw::updateVsShader(const VsStageRegisters* vsRegs, uint32_t shaderModifier)
@@ -187,12 +184,7 @@ void GnmCommandBufferDraw::setRenderTarget(uint32_t rtSlot, GnmRenderTarget cons
 {
 	LOG_ASSERT(rtSlot == 0, "only support one render target at 0");
 
-	auto image = m_factory.grabRenderTarget(*target);
-
-	VltAttachment colorTarget                 = {};
-	colorTarget.view                          = image.view;
-	colorTarget.layout                        = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-	m_state.gp.om.renderTargets.color[rtSlot] = colorTarget;
+	m_sink->setRenderTarget(rtSlot, *target);
 
 	m_state.gp.om.colorTargets[rtSlot] = *target;
 	m_flags.set(GnmContexFlag::GpDirtyRenderTarget);
@@ -200,12 +192,7 @@ void GnmCommandBufferDraw::setRenderTarget(uint32_t rtSlot, GnmRenderTarget cons
 
 void GnmCommandBufferDraw::setDepthRenderTarget(GnmDepthRenderTarget const* depthTarget)
 {
-	auto depthImage = m_factory.grabDepthRenderTarget(*depthTarget);
-
-	VltAttachment depthAttachment     = {};
-	depthAttachment.view              = depthImage.view;
-	depthAttachment.layout            = depthImage.view->imageInfo().layout;
-	m_state.gp.om.renderTargets.depth = depthAttachment;
+	m_sink->setDepthRenderTarget(*depthTarget);
 
 	m_state.gp.om.depthTarget = *depthTarget;
 	m_flags.set(GnmContexFlag::GpDirtyRenderTarget);
@@ -226,7 +213,7 @@ void GnmCommandBufferDraw::setRenderTargetMask(uint32_t mask)
 	auto writeMasks = cvt::convertRrenderTargetMask(mask);
 	for (uint32_t attachment = 0; attachment != writeMasks.size(); ++attachment)
 	{
-		m_context->setBlendMask(attachment, writeMasks[attachment]);
+		m_sink->setBlendMask(attachment, writeMasks[attachment]);
 	}
 }
 
@@ -251,7 +238,7 @@ void GnmCommandBufferDraw::setBlendControl(uint32_t rtSlot, BlendControl blendCo
 		alphaDstFactor,
 		alphaBlendOp);
 		
-	m_context->setBlendMode(rtSlot, colorBlendMode);
+	m_sink->setBlendMode(rtSlot, colorBlendMode);
 }
 
 void GnmCommandBufferDraw::setDepthStencilControl(DepthStencilControl depthControl)
@@ -272,7 +259,7 @@ void GnmCommandBufferDraw::setDepthStencilControl(DepthStencilControl depthContr
 		frontOp,
 		backOp);
 
-	m_context->setDepthStencilState(dsInfo);
+	m_sink->setDepthStencilState(dsInfo);
 }
 
 void GnmCommandBufferDraw::setDbRenderControl(DbRenderControl reg)
@@ -309,7 +296,7 @@ void GnmCommandBufferDraw::setPrimitiveType(PrimitiveType primType)
 		VK_FALSE,
 		0);
 
-	m_context->setInputAssemblyState(isInfo);
+	m_sink->setInputAssemblyState(isInfo);
 }
 
 void GnmCommandBufferDraw::setIndexSize(IndexSize indexSize, CachePolicy cachePolicy)
@@ -322,13 +309,16 @@ void GnmCommandBufferDraw::drawIndexAuto(uint32_t indexCount, DrawModifier modif
 	// Clear index buffer
 	m_state.gp.ia.indexBuffer = GnmIndexBuffer();
 
-	commitGraphicsStages<false, false>();
+	if (!commitGraphicsStages<false, false>())
+	{
+		return;
+	}
 
 	// TODO:
 	// Is indexCount == vertexCount ?
 	uint32_t vertexCount = indexCount;
 
-	m_context->draw(vertexCount, 1, 0, 0);
+	m_sink->draw(vertexCount);
 }
 
 void GnmCommandBufferDraw::drawIndexAuto(uint32_t indexCount)
@@ -344,9 +334,12 @@ void GnmCommandBufferDraw::drawIndex(uint32_t indexCount, const void* indexAddr,
 	uint32_t elementSize             = m_state.gp.ia.indexBuffer.type == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
 	m_state.gp.ia.indexBuffer.size   = elementSize * indexCount;
 
-	commitGraphicsStages<true, false>();
+	if (!commitGraphicsStages<true, false>())
+	{
+		return;
+	}
 
-	m_context->drawIndexed(indexCount, 1, 0, 0, 0);
+	m_sink->drawIndexed(indexCount);
 }
 
 void GnmCommandBufferDraw::drawIndex(uint32_t indexCount, const void* indexAddr)
@@ -362,6 +355,7 @@ void GnmCommandBufferDraw::dispatch(uint32_t threadGroupX, uint32_t threadGroupY
 
 void GnmCommandBufferDraw::dispatchWithOrderedAppend(uint32_t threadGroupX, uint32_t threadGroupY, uint32_t threadGroupZ, DispatchOrderedAppendMode orderedAppendMode)
 {
+	m_sink->dispatch(threadGroupX, threadGroupY, threadGroupZ);
 }
 
 void GnmCommandBufferDraw::writeDataInline(void* dstGpuAddr, const void* data, uint32_t sizeInDwords, WriteDataConfirmMode writeConfirm)
@@ -388,10 +382,12 @@ void GnmCommandBufferDraw::writeAtEndOfShader(EndOfShaderEventType eventType, vo
 
 void GnmCommandBufferDraw::waitOnAddress(void* gpuAddr, uint32_t mask, WaitCompareFunc compareFunc, uint32_t refValue)
 {
+	emuWaitOnAddress(gpuAddr, mask, compareFunc, refValue);
 }
 
 void GnmCommandBufferDraw::waitOnAddressAndStallCommandBufferParser(void* gpuAddr, uint32_t mask, uint32_t refValue)
 {
+	emuWaitOnAddress(gpuAddr, mask, kWaitCompareFuncEqual, refValue);
 }
 
 void GnmCommandBufferDraw::waitForGraphicsWrites(uint32_t baseAddr256, uint32_t sizeIn256ByteBlocks, uint32_t targetMask, CacheAction cacheAction, uint32_t extendedCacheMask, StallCommandBufferParserMode commandBufferStallMode)
@@ -408,24 +404,36 @@ void GnmCommandBufferDraw::waitUntilSafeForRendering(uint32_t videoOutHandle, ui
 
 void GnmCommandBufferDraw::prepareFlip()
 {
-	m_cmdList = m_context->endRecording();
+	endFrame();
 }
 
 void GnmCommandBufferDraw::prepareFlip(void* labelAddr, uint32_t value)
 {
-	m_cmdList             = m_context->endRecording();
+	endFrame();
 	*(uint32_t*)labelAddr = value;
+	captureMemory(labelAddr, sizeof(uint32_t));
 }
 
 void GnmCommandBufferDraw::prepareFlipWithEopInterrupt(EndOfPipeEventType eventType, CacheAction cacheAction)
 {
-	m_cmdList = m_context->endRecording();
+	endFrame();
 }
 
 void GnmCommandBufferDraw::prepareFlipWithEopInterrupt(EndOfPipeEventType eventType, void* labelAddr, uint32_t value, CacheAction cacheAction)
 {
-	m_cmdList             = m_context->endRecording();
+	endFrame();
 	*(uint32_t*)labelAddr = value;
+	captureMemory(labelAddr, sizeof(uint32_t));
+}
+
+void GnmCommandBufferDraw::endFrame()
+{
+	m_cmdList = m_sink->endRecording();
+
+	for (const void* memory : m_sink->getEvictedTextures())
+	{
+		m_textureUploads.forget(memory);
+	}
 }
 
 void GnmCommandBufferDraw::setCsShader(const CsStageRegisters* computeData, uint32_t shaderModifier)
@@ -455,7 +463,7 @@ void GnmCommandBufferDraw::bindRenderTargets()
 			break;
 		}
 
-		m_context->bindRenderTargets(m_state.gp.om.renderTargets);
+		m_sink->bindRenderTargets();
 
 		m_flags.clr(GnmContexFlag::GpDirtyRenderTarget);
 	} while (false);
@@ -490,7 +498,7 @@ void GnmCommandBufferDraw::setVertexInputLayout(const std::vector<PsslShaderReso
 		vertexAttributes.emplace_back(attr);
 	}
 
-	m_context->setInputLayout(
+	m_sink->setInputLayout(
 		vertexBindings.size(),
 		vertexBindings.data(),
 		vertexAttributes.size(),
@@ -499,12 +507,11 @@ void GnmCommandBufferDraw::setVertexInputLayout(const std::vector<PsslShaderReso
 
 void GnmCommandBufferDraw::bindIndexBuffer()
 {
-	const auto& indexDesc   = m_state.gp.ia.indexBuffer;
-	auto        indexBuffer = m_factory.grabIndex(indexDesc);
+	const auto& indexDesc = m_state.gp.ia.indexBuffer;
 
-	m_context->updateBuffer(indexBuffer, 0, indexDesc.size, indexDesc.buffer);
+	captureMemory(indexDesc.buffer, indexDesc.size);
 
-	m_context->bindIndexBuffer(indexBuffer, indexDesc.type);
+	m_sink->bindIndexBuffer(indexDesc);
 }
 
 void GnmCommandBufferDraw::bindVertexBuffer(const PsslShaderResource& res)
@@ -519,7 +526,8 @@ void GnmCommandBufferDraw::bindVertexBuffer(const PsslShaderResource& res)
 	// That makes us impossible to detect buffer update and release.
 	//
 	// We may need to develop some heuristic strategies to deal with this problem.
-	// Currently I just update GPU buffer every time it gets bound and don't release any of them.
+	// Unless guest writes are tracked, I just update GPU buffer every time it gets bound
+	// and don't release any of them.
 
 	const GnmBuffer* vsharp  = reinterpret_cast<const GnmBuffer*>(res.resource);
 	void*            vtxData = vsharp->getBaseAddress();
@@ -527,20 +535,11 @@ void GnmCommandBufferDraw::bindVertexBuffer(const PsslShaderResource& res)
 	bool isSwizzled = vsharp->isSwizzled();
 	LOG_ASSERT(isSwizzled == false, "do not support swizzled buffer currently.");
 
-	VkDeviceSize bufferSize = vsharp->getSize();
-
-	GnmBufferCreateInfo info = {};
-	info.buffer              = vsharp;
-	info.stages              = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
-	info.usageType           = kShaderInputUsageImmVertexBuffer;
-	auto vertexBuffer        = m_factory.grabBuffer(info);
-
-	m_context->updateBuffer(vertexBuffer, 0, bufferSize, vtxData);
+	captureMemory(vtxData, vsharp->getSize());
 
-	uint32_t stride = vsharp->getStride();
 	// startRegister act as binding id for vertex buffers,
 	// it is set in PsslShaderModule::parseResPtrTable
-	m_context->bindVertexBuffer(res.startRegister, VltBufferSlice(vertexBuffer, 0, bufferSize), stride);
+	m_sink->bindVertexBuffer(res.startRegister, *vsharp);
 }
 
 void GnmCommandBufferDraw::bindImmConstBuffer(pssl::PsslProgramType shaderType, const PsslShaderResource& res)
@@ -564,80 +563,54 @@ void GnmCommandBufferDraw::bindImmConstBuffer(pssl::PsslProgramType shaderType,
 		break;
 	}
 
-	GnmBufferCreateInfo info = {};
-	info.buffer              = vsharp;
-	info.stages              = stage;
-	info.usageType           = kShaderInputUsageImmConstBuffer;
-	auto constBuffer         = m_factory.grabBuffer(info);
-
-	VkDeviceSize bufferSize = vsharp->getSize();
-	m_context->updateBuffer(constBuffer, 0, bufferSize, vsharp->getBaseAddress());
+	captureMemory(vsharp->getBaseAddress(), vsharp->getSize());
 
 	uint32_t regSlot = computeConstantBufferBinding(shaderType, res.startRegister);
-	m_context->bindResourceBuffer(regSlot, constBuffer);
+	m_sink->bindConstantBuffer(regSlot, stage, *vsharp);
 }
 
 void GnmCommandBufferDraw::bindImmResource(const PsslShaderResource& res)
 {
 	const GnmTexture* tsharp = reinterpret_cast<const GnmTexture*>(res.resource);
 
-	GnmTextureCreateInfo info = {};
-	info.texture              = tsharp;
-	info.stages               = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-	info.usageType            = kShaderInputUsageImmResource;
-	auto image                = m_factory.grabImage(info);
-
-	auto     imgInfo       = image.image->info();
-	uint32_t pitchPerRow   = tsharp->getPitch();
-	uint32_t pitchPerLayer = pitchPerRow * tsharp->getHeight();
+	uint32_t regSlot = computeResBinding(PsslProgramType::PixelShader, res.startRegister);
+	bool     create  = m_sink->bindTexture(regSlot, *tsharp);
 
-	VkDeviceSize imageBufferSize = tsharp->getSizeAlign().m_size;
-	void*        data            = tsharp->getBaseAddress();
+	captureMemory(tsharp->getBaseAddress(), tsharp->getSizeAlign().m_size);
 
-	auto tileMode = tsharp->getTileMode();
-	if (tileMode == kTileModeDisplay_LinearAligned)
-	{
-		VkImageSubresourceLayers subRes = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
-		VkOffset3D               offset = { 0, 0, 0 };
-		m_context->updateImage(
-			image.image, subRes,
-			offset, imgInfo.extent,
-			data,
-			pitchPerRow, pitchPerLayer);
-	}
-	else
+	// Skip detiling and uploading if the content
+	// didn't change since the last bind.
+	if (m_textureUploads.checkUpload(*tsharp, 0, 0, create))
 	{
-		// TODO:
-		// Untiling textures on CPU is not effective, we should do this using compute shader.
-		// But that would be a challenging job.
-		void* untiledData = malloc(imageBufferSize);
-
-		GpuAddress::TilingParameters tp;
-		tp.initFromTexture(tsharp, 0, 0);
-		GpuAddress::detileSurface(untiledData, data, &tp);
-
-		VkImageSubresourceLayers subRes = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
-		VkOffset3D               offset = { 0, 0, 0 };
-		m_context->updateImage(
-			image.image, subRes,
-			offset, imgInfo.extent,
-			data,
-			pitchPerRow, pitchPerLayer);
-
-		free(untiledData);
-	}
+		VkDeviceSize imageBufferSize = tsharp->getSizeAlign().m_size;
+		void*        data            = tsharp->getBaseAddress();
 
-	uint32_t regSlot = computeResBinding(PsslProgramType::PixelShader, res.startRegister);
-	m_context->bindResourceView(regSlot, image.view, nullptr);
+		auto tileMode = tsharp->getTileMode();
+		if (tileMode != kTileModeDisplay_LinearAligned)
+		{
+			// TODO:
+			// Untiling textures on CPU is not effective, we should do this using compute shader.
+			// But that would be a challenging job.
+			// Until then, detiling is spread over the detile engine's workers.
+			void* untiledData = m_staging.alloc(imageBufferSize);
+
+			GpuAddress::TilingParameters tp;
+			tp.initFromTexture(tsharp, 0, 0);
+			GpuAddress::detileSurface(untiledData, data, &tp);
+
+			data = untiledData;
+		}
+
+		m_sink->updateTexture(*tsharp, data);
+	}
 }
 
 void GnmCommandBufferDraw::bindSampler(const PsslShaderResource& res)
 {
-	const GnmSampler* ssharp  = reinterpret_cast<const GnmSampler*>(res.resource);
-	auto              sampler = m_factory.grabSampler(*ssharp);
+	const GnmSampler* ssharp = reinterpret_cast<const GnmSampler*>(res.resource);
 
 	uint32_t regSlot = computeSamplerBinding(PsslProgramType::PixelShader, res.startRegister);
-	m_context->bindSampler(regSlot, sampler);
+	m_sink->bindSampler(regSlot, *ssharp);
 }
 
 void GnmCommandBufferDraw::bindShaderResources(
@@ -669,7 +642,7 @@ void GnmCommandBufferDraw::bindShaderResources(
 	}
 }
 
-void GnmCommandBufferDraw::commitVsStage()
+pssl::PsslShaderFuture GnmCommandBufferDraw::commitVsStage()
 {
 	m_shaders.vs.shader = new PsslShaderModule((const uint32_t*)m_shaders.vs.code);
 
@@ -685,6 +658,7 @@ void GnmCommandBufferDraw::commitVsStage()
 
 	auto nestedResources = m_shaders.vs.shader->getShaderResources();
 	auto shaderResources = PsslShaderModule::flattenShaderResources(nestedResources);
+	captureShaderInput(m_shaders.vs, shaderResources);
 
 	// Set vertex input layout
 	auto vertexAttributes = extractVertexAttributes(shaderResources);
@@ -697,12 +671,10 @@ void GnmCommandBufferDraw::commitVsStage()
 	// Bind all resources which the shader uses.
 	bindShaderResources(PsslProgramType::VertexShader, shaderResources);
 
-	m_context->bindShader(
-		VK_SHADER_STAGE_VERTEX_BIT,
-		m_shaders.vs.shader->compile());
+	return m_shaderCache->getShaderAsync(m_shaders.vs.shader);
 }
 
-void GnmCommandBufferDraw::commitPsStage()
+pssl::PsslShaderFuture GnmCommandBufferDraw::commitPsStage()
 {
 	m_shaders.ps.shader = new PsslShaderModule((const uint32_t*)m_shaders.ps.code);
 
@@ -711,17 +683,16 @@ void GnmCommandBufferDraw::commitPsStage()
 
 	auto nestedResources = m_shaders.ps.shader->getShaderResources();
 	auto shaderResources = PsslShaderModule::flattenShaderResources(nestedResources);
+	captureShaderInput(m_shaders.ps, shaderResources);
 
 	// Bind all resources which the shader uses.
 	bindShaderResources(PsslProgramType::PixelShader, shaderResources);
 
-	m_context->bindShader(
-		VK_SHADER_STAGE_FRAGMENT_BIT,
-		m_shaders.ps.shader->compile());
+	return m_shaderCache->getShaderAsync(m_shaders.ps.shader);
 }
 
 template <bool Indexed, bool Indirect>
-void GnmCommandBufferDraw::commitGraphicsStages()
+bool GnmCommandBufferDraw::commitGraphicsStages()
 {
 	if (m_flags.test(GnmContexFlag::GpDirtyRenderTarget))
 	{
@@ -738,9 +709,51 @@ void GnmCommandBufferDraw::commitGraphicsStages()
 		bindIndexBuffer();
 	}
 
-	commitVsStage();
-	commitPsStage();
+	// Detiled data of the last draw has been
+	// copied to Vulkan staging buffers.
+	m_staging.reset();
+
+	// Both stages are compiled by the shader cache workers
+	// in parallel, we only wait after submitting both.
+	auto vsFuture = commitVsStage();
+	auto psFuture = commitPsStage();
 	commitCsStage();
+
+	bool ready = false;
+	do
+	{
+		auto vs = waitShader(vsFuture);
+		auto ps = waitShader(psFuture);
+		if (vs == nullptr || ps == nullptr)
+		{
+			break;
+		}
+
+		m_sink->bindShader(VK_SHADER_STAGE_VERTEX_BIT, vs);
+		m_sink->bindShader(VK_SHADER_STAGE_FRAGMENT_BIT, ps);
+
+		ready = true;
+	} while (false);
+
+	return ready;
+}
+
+RcPtr<vlt::VltShader> GnmCommandBufferDraw::waitShader(const pssl::PsslShaderFuture& future)
+{
+	RcPtr<vlt::VltShader> shader = nullptr;
+	do
+	{
+#ifdef GPCS4_SKIP_DRAW_UNTIL_READY
+		if (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			// Still compiling, the draw will be skipped.
+			break;
+		}
+#endif  // GPCS4_SKIP_DRAW_UNTIL_READY
+
+		shader = future.get();
+	} while (false);
+	return shader;
 }
 
 void GnmCommandBufferDraw::clearColorTargetHack(GnmShaderResourceList& shaderResources)
@@ -763,6 +776,7 @@ void GnmCommandBufferDraw::clearColorTargetHack(GnmShaderResourceList& shaderRes
 	const GnmBuffer* sourceBuffer = reinterpret_cast<const GnmBuffer*>(sourceRes.resource);
 	void*            sourceMemory = sourceBuffer->getBaseAddress();
 	uint32_t         sourceSize   = sourceBuffer->getSize();
+	captureMemory(sourceMemory, sourceSize);
 	// Extract the resource which re-represents the color target.
 	auto             destRes    = findShaderResource(shaderResources, kShaderInputUsageImmRwResource);
 	const GnmBuffer* destBuffer = reinterpret_cast<const GnmBuffer*>(destRes.resource);
@@ -787,25 +801,31 @@ void GnmCommandBufferDraw::clearColorTargetHack(GnmShaderResourceList& shaderRes
 	GpuAddress::dataFormatDecoder(reg, encodeValues, target->getDataFormat());
 
 	// Do the clear
-	auto targetImage = m_factory.grabRenderTarget(*target);
-	m_context->clearRenderTarget(
-		targetImage.view,
-		VK_IMAGE_ASPECT_COLOR_BIT,
-		*reinterpret_cast<VkClearValue*>(reg));
+	m_sink->clearRenderTarget(*target, *reinterpret_cast<VkClearValue*>(reg));
 }
 
 void GnmCommandBufferDraw::commitCsStage()
 {
-	m_shaders.cs.shader = new PsslShaderModule((const uint32_t*)m_shaders.cs.code);
-	m_shaders.cs.shader->defineShaderInput(m_shaders.cs.userDataSlotTable);
-	auto nestedResources = m_shaders.cs.shader->getShaderResources();
-	auto shaderResources = PsslShaderModule::flattenShaderResources(nestedResources);
-
-	// Hack
-	if (m_shaders.cs.shader->key().toUint64() == ShaderHashClearRT)
+	do
 	{
-		clearColorTargetHack(shaderResources);
-	}
+		// No compute shader was set since the last reset.
+		if (!m_shaders.cs.code)
+		{
+			break;
+		}
+
+		m_shaders.cs.shader = new PsslShaderModule((const uint32_t*)m_shaders.cs.code);
+		m_shaders.cs.shader->defineShaderInput(m_shaders.cs.userDataSlotTable);
+		auto nestedResources = m_shaders.cs.shader->getShaderResources();
+		auto shaderResources = PsslShaderModule::flattenShaderResources(nestedResources);
+		captureShaderInput(m_shaders.cs, shaderResources);
+
+		// Hack
+		if (m_shaders.cs.shader->key().toUint64() == ShaderHashClearRT)
+		{
+			clearColorTargetHack(shaderResources);
+		}
+	} while (false);
 }
 
 void GnmCommandBufferDraw::commitComputeStages()
@@ -814,8 +834,7 @@ void GnmCommandBufferDraw::commitComputeStages()
 
 void GnmCommandBufferDraw::clearDepthTarget()
 {
-	auto depthImage = m_factory.grabDepthRenderTarget(m_state.gp.om.depthTarget);
-	m_context->clearRenderTarget(depthImage.view, VK_IMAGE_ASPECT_DEPTH_BIT, m_state.gp.om.depthClearValue);
+	m_sink->clearDepthRenderTarget(m_state.gp.om.depthTarget, m_state.gp.om.depthClearValue);
 	m_flags.clr(GnmContexFlag::GpClearDepthTarget);
 }
 
@@ -919,6 +938,30 @@ const uint32_t* GnmCommandBufferDraw::findFetchShaderCode(const GnmShaderContext
 	return fsCode;
 }
 
+void GnmCommandBufferDraw::captureShaderInput(
+	const GnmShaderContext&      shdrCtx,
+	const GnmShaderResourceList& resources)
+{
+	do
+	{
+		if (!m_capture)
+		{
+			break;
+		}
+
+		const auto& shader = shdrCtx.shader;
+		captureMemory(shdrCtx.code, shader->programInfo().binarySizeBytes());
+		captureMemory(shader->fetchShaderCode(), shader->fetchShaderSizeDwords() * sizeof(uint32_t));
+
+		// Descriptors are either embedded in the command buffer
+		// or in tables in guest memory, both are captured.
+		for (const auto& res : resources)
+		{
+			captureMemory(res.res.resource, res.res.sizeDwords * sizeof(uint32_t));
+		}
+	} while (false);
+}
+
 const PsslShaderResource GnmCommandBufferDraw::findShaderResource(
 	const GnmShaderResourceList& resources,
 	ShaderInputUsageType         type)
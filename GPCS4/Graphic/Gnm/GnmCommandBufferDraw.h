@@ -2,10 +2,14 @@
 
 #include "GnmCommon.h"
 #include "GnmCommandBuffer.h"
+#include "GnmCommandSink.h"
 #include "GnmConstant.h"
 #include "GnmContextState.h"
 #include "GnmResourceFactory.h"
 
+#include "../Pssl/PsslShaderCache.h"
+
+#include <memory>
 #include <vector>
 
 //
@@ -15,7 +19,8 @@ class GnmBuffer;
 // This class is designed for graphics development,
 // no reverse engining knowledge should be required.
 // It's responsible for mapping Gnm input/structures to Violet input/structures,
-// and convert Gnm calls into Violet calls.
+// and convert Gnm calls into calls to a command sink,
+// which records them into Violet, or only counts them.
 
 class GnmCommandBufferDraw : public GnmCommandBuffer
 {
@@ -30,6 +35,19 @@ public:
 		const RcPtr<vlt::VltContext>& context
 	);
 
+	/**
+	 * \brief Creates a command buffer for a given sink
+	 *
+	 * Shaders are translated by the shader cache
+	 * of the device, all other work goes to the sink.
+	 * \param [in] device Queue device
+	 * \param [in] sink Sink receiving the decoded work
+	 */
+	GnmCommandBufferDraw(
+		const sce::SceGpuQueueDevice& device,
+		const RcPtr<GnmCommandSink>&  sink
+	);
+
 	virtual ~GnmCommandBufferDraw();
 
 	virtual void initializeDefaultHardwareState() override;
@@ -143,10 +161,12 @@ public:
 private:
 	
 	// Stage setup methods
-	void commitVsStage();
-	void commitPsStage();
+	pssl::PsslShaderFuture commitVsStage();
+	pssl::PsslShaderFuture commitPsStage();
 	template <bool Indexed, bool Indirect>
-	void commitGraphicsStages();
+	bool commitGraphicsStages();
+
+	RcPtr<vlt::VltShader> waitShader(const pssl::PsslShaderFuture& future);
 
 	void commitCsStage();
 	void commitComputeStages();
@@ -158,6 +178,8 @@ private:
 	void clearDepthTarget();
 
 	
+	void endFrame();
+
 	// Resource binding methods
 	void bindRenderTargets();
 
@@ -196,6 +218,11 @@ private:
 	const uint32_t* findFetchShaderCode(
 		const GnmShaderContext& shdrCtx);
 
+	// Adds shader code and resource descriptors to the capture.
+	void captureShaderInput(
+		const GnmShaderContext&      shdrCtx,
+		const GnmShaderResourceList& resources);
+
 	// Find resource from flat shader resources.
 	const PsslShaderResource findShaderResource(
 		const GnmShaderResourceList&  resources,
@@ -210,8 +237,15 @@ private:
 
 	GnmContextState               m_state;
 	GnmShaderContextGroup         m_shaders;
-	GnmResourceFactory            m_factory;
+	RcPtr<GnmCommandSink>         m_sink;
 	GnmContexFlags                m_flags;
+
+	// Shared by all sinks, so they
+	// upload the same textures.
+	GnmTextureUploadCache         m_textureUploads;
+	GnmStagingArena               m_staging;
+
+	std::shared_ptr<pssl::PsslShaderCache> m_shaderCache;
 };
 
 
@@ -253,6 +253,7 @@ void GnmCommandBufferDummy::prepareFlip()
 void GnmCommandBufferDummy::prepareFlip(void* labelAddr, uint32_t value)
 {
 	*(uint32_t*)labelAddr = value;
+	captureMemory(labelAddr, sizeof(uint32_t));
 }
 
 void GnmCommandBufferDummy::prepareFlipWithEopInterrupt(EndOfPipeEventType eventType, CacheAction cacheAction)
@@ -263,6 +264,7 @@ void GnmCommandBufferDummy::prepareFlipWithEopInterrupt(EndOfPipeEventType event
 void GnmCommandBufferDummy::prepareFlipWithEopInterrupt(EndOfPipeEventType eventType, void* labelAddr, uint32_t value, CacheAction cacheAction)
 {
 	*(uint32_t*)labelAddr = value;
+	captureMemory(labelAddr, sizeof(uint32_t));
 }
 
 void GnmCommandBufferDummy::setCsShader(const pssl::CsStageRegisters* computeData, uint32_t shaderModifier)
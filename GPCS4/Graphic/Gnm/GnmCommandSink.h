@@ -0,0 +1,182 @@
+#pragma once
+
+#include "GnmCommon.h"
+
+#include "../Violet/VltPipelineState.h"
+
+#include <vector>
+
+namespace vlt
+{;
+class VltCmdList;
+class VltShader;
+}  // namespace vlt
+
+struct GnmIndexBuffer;
+class GnmBuffer;
+class GnmTexture;
+class GnmSampler;
+class GnmRenderTarget;
+class GnmDepthRenderTarget;
+
+/**
+ * \brief Command sink
+ *
+ * Receives the work GnmCommandBufferDraw decoded from Gnm
+ * commands. Resources are passed as Gnm descriptors, it's
+ * up to the sink to map them to its own objects.
+ *
+ * GnmCommandSinkViolet records the work into a Violet context,
+ * GnmCommandSinkNull only counts it, so the frontend can be
+ * profiled without a Vulkan device.
+ */
+class GnmCommandSink : public RcObject
+{
+public:
+	virtual ~GnmCommandSink()
+	{
+	}
+
+	/**
+	 * \brief Begins recording a command list
+	 */
+	virtual void beginRecording() = 0;
+
+	/**
+	 * \brief Ends recording
+	 * \returns The recorded command list, may be \c nullptr
+	 */
+	virtual RcPtr<vlt::VltCmdList> endRecording() = 0;
+
+	/**
+	 * \brief Textures evicted by the last endRecording
+	 *
+	 * Their images are gone, so the frontend can stop
+	 * tracking writes to their memory.
+	 * \returns Base addresses, valid until the next endRecording
+	 */
+	virtual const std::vector<const void*>& getEvictedTextures() = 0;
+
+	///< Pipeline state setting methods.
+
+	virtual void setViewports(
+		uint32_t          viewportCount,
+		const VkViewport* viewports,
+		const VkRect2D*   scissorRects) = 0;
+
+	virtual void setInputLayout(
+		uint32_t                       bindingCount,
+		const vlt::VltVertexBinding*   bindings,
+		uint32_t                       attributeCount,
+		const vlt::VltVertexAttribute* attributes) = 0;
+
+	virtual void setInputAssemblyState(
+		const vlt::VltInputAssemblyInfo& iaState) = 0;
+
+	virtual void setRasterizerState(
+		const vlt::VltRasterizationInfo& rsState) = 0;
+
+	virtual void setDepthStencilState(
+		const vlt::VltDepthStencilInfo& dsState) = 0;
+
+	virtual void setBlendMode(
+		uint32_t                            attachment,
+		const vlt::VltColorBlendAttachment& blendMode) = 0;
+
+	virtual void setBlendMask(
+		uint32_t                     attachment,
+		const VkColorComponentFlags& colorMask) = 0;
+
+	///< Resource binding methods.
+
+	/**
+	 * \brief Sets a color target
+	 *
+	 * Takes effect with the next \c bindRenderTargets.
+	 * \param [in] slot Render target slot
+	 * \param [in] target The color target
+	 */
+	virtual void setRenderTarget(
+		uint32_t               slot,
+		const GnmRenderTarget& target) = 0;
+
+	/**
+	 * \brief Sets the depth target
+	 *
+	 * Takes effect with the next \c bindRenderTargets.
+	 * \param [in] target The depth target
+	 */
+	virtual void setDepthRenderTarget(
+		const GnmDepthRenderTarget& target) = 0;
+
+	/**
+	 * \brief Binds the color and depth targets set so far
+	 */
+	virtual void bindRenderTargets() = 0;
+
+	virtual void bindShader(
+		VkShaderStageFlagBits         stage,
+		const RcPtr<vlt::VltShader>& shader) = 0;
+
+	virtual void bindIndexBuffer(
+		const GnmIndexBuffer& indexBuffer) = 0;
+
+	virtual void bindVertexBuffer(
+		uint32_t         binding,
+		const GnmBuffer& buffer) = 0;
+
+	virtual void bindConstantBuffer(
+		uint32_t             regSlot,
+		VkPipelineStageFlags stages,
+		const GnmBuffer&     buffer) = 0;
+
+	/**
+	 * \brief Binds a texture
+	 *
+	 * \param [in] regSlot Resource binding slot
+	 * \param [in] texture The T#
+	 * \returns \c true if the image behind the T# was
+	 *          just created and has undefined content
+	 */
+	virtual bool bindTexture(
+		uint32_t          regSlot,
+		const GnmTexture& texture) = 0;
+
+	/**
+	 * \brief Uploads the content of a texture
+	 *
+	 * \param [in] texture The T#
+	 * \param [in] data Linear texture data, valid until
+	 *             the frontend's next draw
+	 */
+	virtual void updateTexture(
+		const GnmTexture& texture,
+		const void*       data) = 0;
+
+	virtual void bindSampler(
+		uint32_t          regSlot,
+		const GnmSampler& sampler) = 0;
+
+	///< Draw calls
+
+	virtual void draw(
+		uint32_t vertexCount) = 0;
+
+	virtual void drawIndexed(
+		uint32_t indexCount) = 0;
+
+	virtual void dispatch(
+		uint32_t threadGroupX,
+		uint32_t threadGroupY,
+		uint32_t threadGroupZ) = 0;
+
+	///< Resource updating methods.
+
+	virtual void clearRenderTarget(
+		const GnmRenderTarget& target,
+		const VkClearValue&    clearValue) = 0;
+
+	virtual void clearDepthRenderTarget(
+		const GnmDepthRenderTarget& target,
+		const VkClearValue&         clearValue) = 0;
+};
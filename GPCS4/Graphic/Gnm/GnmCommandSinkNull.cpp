@@ -0,0 +1,210 @@
+#include "GnmCommandSinkNull.h"
+
+#include "GnmBuffer.h"
+#include "GnmSampler.h"
+#include "GnmTexture.h"
+
+#include "../Violet/VltCmdList.h"
+#include "Algorithm/MurmurHash2.h"
+
+LOG_CHANNEL(Graphic.Gnm.GnmCommandSinkNull);
+
+using namespace vlt;
+
+GnmCommandSinkNull::GnmCommandSinkNull()
+{
+}
+
+GnmCommandSinkNull::~GnmCommandSinkNull()
+{
+	if (m_stats.frameCount)
+	{
+		LOG_DEBUG("null sink: %u frames, %u draws, %u shaders, %u buffers with %llu bytes, "
+				  "%u textures, %u uploaded with %llu bytes.",
+				  m_stats.frameCount, m_stats.drawCount, m_stats.shaderCount,
+				  m_stats.bufferCount, m_stats.bufferBytes,
+				  m_stats.textureCount, m_stats.textureUploadCount, m_stats.textureUploadBytes);
+	}
+}
+
+void GnmCommandSinkNull::beginRecording()
+{
+}
+
+RcPtr<VltCmdList> GnmCommandSinkNull::endRecording()
+{
+	++m_stats.frameCount;
+	return nullptr;
+}
+
+const std::vector<const void*>& GnmCommandSinkNull::getEvictedTextures()
+{
+	return m_evictedTextures;
+}
+
+void GnmCommandSinkNull::setViewports(
+	uint32_t          viewportCount,
+	const VkViewport* viewports,
+	const VkRect2D*   scissorRects)
+{
+	m_viewport = viewports[0];
+	++m_stats.stateCount;
+}
+
+void GnmCommandSinkNull::setInputLayout(
+	uint32_t                  bindingCount,
+	const VltVertexBinding*   bindings,
+	uint32_t                  attributeCount,
+	const VltVertexAttribute* attributes)
+{
+	m_vertexBindings.assign(bindings, bindings + bindingCount);
+	m_vertexAttributes.assign(attributes, attributes + attributeCount);
+	++m_stats.stateCount;
+}
+
+void GnmCommandSinkNull::setInputAssemblyState(const VltInputAssemblyInfo& iaState)
+{
+	m_pipelineState.ia = iaState;
+	++m_stats.stateCount;
+}
+
+void GnmCommandSinkNull::setRasterizerState(const VltRasterizationInfo& rsState)
+{
+	m_pipelineState.rs = rsState;
+	++m_stats.stateCount;
+}
+
+void GnmCommandSinkNull::setDepthStencilState(const VltDepthStencilInfo& dsState)
+{
+	m_pipelineState.ds = dsState;
+	++m_stats.stateCount;
+}
+
+void GnmCommandSinkNull::setBlendMode(
+	uint32_t                       attachment,
+	const VltColorBlendAttachment& blendMode)
+{
+	m_pipelineState.cb.setBlendMode(attachment, blendMode);
+	++m_stats.stateCount;
+}
+
+void GnmCommandSinkNull::setBlendMask(
+	uint32_t                     attachment,
+	const VkColorComponentFlags& colorMask)
+{
+	m_pipelineState.cb.setColorWriteMask(attachment, colorMask);
+	++m_stats.stateCount;
+}
+
+void GnmCommandSinkNull::setRenderTarget(
+	uint32_t               slot,
+	const GnmRenderTarget& target)
+{
+	++m_stats.renderTargetCount;
+}
+
+void GnmCommandSinkNull::setDepthRenderTarget(const GnmDepthRenderTarget& target)
+{
+	++m_stats.renderTargetCount;
+}
+
+void GnmCommandSinkNull::bindRenderTargets()
+{
+}
+
+void GnmCommandSinkNull::bindShader(
+	VkShaderStageFlagBits    stage,
+	const RcPtr<VltShader>& shader)
+{
+	++m_stats.shaderCount;
+}
+
+void GnmCommandSinkNull::bindIndexBuffer(const GnmIndexBuffer& indexBuffer)
+{
+	++m_stats.bufferCount;
+	m_stats.bufferBytes += indexBuffer.size;
+}
+
+void GnmCommandSinkNull::bindVertexBuffer(
+	uint32_t         binding,
+	const GnmBuffer& buffer)
+{
+	++m_stats.bufferCount;
+	m_stats.bufferBytes += buffer.getSize();
+}
+
+void GnmCommandSinkNull::bindConstantBuffer(
+	uint32_t             regSlot,
+	VkPipelineStageFlags stages,
+	const GnmBuffer&     buffer)
+{
+	++m_stats.bufferCount;
+	m_stats.bufferBytes += buffer.getSize();
+}
+
+bool GnmCommandSinkNull::bindTexture(
+	uint32_t          regSlot,
+	const GnmTexture& texture)
+{
+	GnmResourceEntry entry = {};
+	entry.memory           = texture.getBaseAddress();
+	entry.size             = texture.getSizeAlign().m_size;
+
+	++m_stats.textureCount;
+	return m_images.insert(entry).second;
+}
+
+void GnmCommandSinkNull::updateTexture(
+	const GnmTexture& texture,
+	const void*       data)
+{
+	++m_stats.textureUploadCount;
+	m_stats.textureUploadBytes += texture.getSizeAlign().m_size;
+}
+
+void GnmCommandSinkNull::bindSampler(
+	uint32_t          regSlot,
+	const GnmSampler& sampler)
+{
+	// Samplers are looked up by a hash of
+	// the S#, like GnmResourceFactory does.
+	m_samplers.insert(algo::MurmurHash(sampler.m_regs, sizeof(sampler.m_regs)));
+	++m_stats.samplerCount;
+}
+
+void GnmCommandSinkNull::draw(uint32_t vertexCount)
+{
+	++m_stats.drawCount;
+}
+
+void GnmCommandSinkNull::drawIndexed(uint32_t indexCount)
+{
+	++m_stats.drawCount;
+}
+
+void GnmCommandSinkNull::dispatch(
+	uint32_t threadGroupX,
+	uint32_t threadGroupY,
+	uint32_t threadGroupZ)
+{
+	++m_stats.dispatchCount;
+}
+
+void GnmCommandSinkNull::clearRenderTarget(
+	const GnmRenderTarget& target,
+	const VkClearValue&    clearValue)
+{
+	++m_stats.clearCount;
+}
+
+void GnmCommandSinkNull::clearDepthRenderTarget(
+	const GnmDepthRenderTarget& target,
+	const VkClearValue&         clearValue)
+{
+	++m_stats.clearCount;
+}
+
+const GnmNullSinkStats& GnmCommandSinkNull::getStats() const
+{
+	return m_stats;
+}
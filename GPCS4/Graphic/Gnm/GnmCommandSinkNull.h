@@ -0,0 +1,157 @@
+#pragma once
+
+#include "GnmCommon.h"
+#include "GnmCommandSink.h"
+#include "GnmResourceFactory.h"
+
+#include <unordered_set>
+#include <vector>
+
+/**
+ * \brief Null sink statistics
+ *
+ * What the frontend would have handed
+ * to Violet, counted instead of recorded.
+ */
+struct GnmNullSinkStats
+{
+	uint32_t frameCount         = 0;
+	uint32_t drawCount          = 0;
+	uint32_t dispatchCount      = 0;
+	uint32_t clearCount         = 0;  // Color and depth target clears
+	uint32_t stateCount         = 0;  // Fixed function states set
+	uint32_t renderTargetCount  = 0;  // Color and depth targets set
+	uint32_t shaderCount        = 0;  // Translated shaders bound
+	uint32_t bufferCount        = 0;  // Index, vertex and constant buffers bound
+	uint64_t bufferBytes        = 0;
+	uint32_t textureCount       = 0;  // Textures bound
+	uint32_t textureUploadCount = 0;  // Textures changed since the last upload
+	uint64_t textureUploadBytes = 0;
+	uint32_t samplerCount       = 0;
+};
+
+// Counts the work of GnmCommandBufferDraw instead of recording it.
+// Everything up to the sink runs as it would with Violet: state is converted,
+// shaders are translated by the shader cache, changed textures are detiled,
+// so the frontend can be profiled on machines without a GPU.
+
+class GnmCommandSinkNull : public GnmCommandSink
+{
+public:
+	GnmCommandSinkNull();
+
+	virtual ~GnmCommandSinkNull();
+
+	virtual void beginRecording() override;
+
+	virtual RcPtr<vlt::VltCmdList> endRecording() override;
+
+	virtual const std::vector<const void*>& getEvictedTextures() override;
+
+	virtual void setViewports(
+		uint32_t          viewportCount,
+		const VkViewport* viewports,
+		const VkRect2D*   scissorRects) override;
+
+	virtual void setInputLayout(
+		uint32_t                       bindingCount,
+		const vlt::VltVertexBinding*   bindings,
+		uint32_t                       attributeCount,
+		const vlt::VltVertexAttribute* attributes) override;
+
+	virtual void setInputAssemblyState(
+		const vlt::VltInputAssemblyInfo& iaState) override;
+
+	virtual void setRasterizerState(
+		const vlt::VltRasterizationInfo& rsState) override;
+
+	virtual void setDepthStencilState(
+		const vlt::VltDepthStencilInfo& dsState) override;
+
+	virtual void setBlendMode(
+		uint32_t                            attachment,
+		const vlt::VltColorBlendAttachment& blendMode) override;
+
+	virtual void setBlendMask(
+		uint32_t                     attachment,
+		const VkColorComponentFlags& colorMask) override;
+
+	virtual void setRenderTarget(
+		uint32_t               slot,
+		const GnmRenderTarget& target) override;
+
+	virtual void setDepthRenderTarget(
+		const GnmDepthRenderTarget& target) override;
+
+	virtual void bindRenderTargets() override;
+
+	virtual void bindShader(
+		VkShaderStageFlagBits         stage,
+		const RcPtr<vlt::VltShader>& shader) override;
+
+	virtual void bindIndexBuffer(
+		const GnmIndexBuffer& indexBuffer) override;
+
+	virtual void bindVertexBuffer(
+		uint32_t         binding,
+		const GnmBuffer& buffer) override;
+
+	virtual void bindConstantBuffer(
+		uint32_t             regSlot,
+		VkPipelineStageFlags stages,
+		const GnmBuffer&     buffer) override;
+
+	virtual bool bindTexture(
+		uint32_t          regSlot,
+		const GnmTexture& texture) override;
+
+	virtual void updateTexture(
+		const GnmTexture& texture,
+		const void*       data) override;
+
+	virtual void bindSampler(
+		uint32_t          regSlot,
+		const GnmSampler& sampler) override;
+
+	virtual void draw(
+		uint32_t vertexCount) override;
+
+	virtual void drawIndexed(
+		uint32_t indexCount) override;
+
+	virtual void dispatch(
+		uint32_t threadGroupX,
+		uint32_t threadGroupY,
+		uint32_t threadGroupZ) override;
+
+	virtual void clearRenderTarget(
+		const GnmRenderTarget& target,
+		const VkClearValue&    clearValue) override;
+
+	virtual void clearDepthRenderTarget(
+		const GnmDepthRenderTarget& target,
+		const VkClearValue&         clearValue) override;
+
+	/**
+	 * \brief Sink statistics
+	 * \returns Counters since creation
+	 */
+	const GnmNullSinkStats& getStats() const;
+
+private:
+	// What would have been set on the Violet context
+	vlt::VltGraphicsPipelineStateInfo    m_pipelineState;
+	VkViewport                           m_viewport = {};
+	std::vector<vlt::VltVertexBinding>   m_vertexBindings;
+	std::vector<vlt::VltVertexAttribute> m_vertexAttributes;
+
+	// Nothing is ever evicted
+	std::vector<const void*> m_evictedTextures;
+
+	// Images the resource factory would have created,
+	// keyed the same way, and sampler descriptor hashes
+	std::unordered_set<GnmResourceEntry, GnmResourceHash> m_images;
+	std::unordered_set<uint64_t>                          m_samplers;
+
+	GnmNullSinkStats m_stats;
+};
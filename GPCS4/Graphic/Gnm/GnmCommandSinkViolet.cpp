@@ -0,0 +1,301 @@
+#include "GnmCommandSinkViolet.h"
+
+#include "GnmBuffer.h"
+#include "GnmDepthRenderTarget.h"
+#include "GnmRenderTarget.h"
+#include "GnmSampler.h"
+#include "GnmTexture.h"
+
+#include "../Pssl/PsslShaderFileBinary.h"
+#include "../Sce/SceGpuQueue.h"
+#include "../Violet/VltBuffer.h"
+#include "../Violet/VltCmdList.h"
+#include "../Violet/VltContext.h"
+#include "../Violet/VltDevice.h"
+#include "../Violet/VltImage.h"
+#include "../Violet/VltSampler.h"
+#include "../Violet/VltShader.h"
+
+LOG_CHANNEL(Graphic.Gnm.GnmCommandSinkViolet);
+
+using namespace sce;
+using namespace vlt;
+using namespace pssl;
+
+GnmCommandSinkViolet::GnmCommandSinkViolet(
+	const SceGpuQueueDevice& device,
+	const RcPtr<VltContext>& context) :
+	m_device(device.device),
+	m_context(context),
+	m_factory(&device)
+{
+}
+
+GnmCommandSinkViolet::~GnmCommandSinkViolet()
+{
+}
+
+void GnmCommandSinkViolet::beginRecording()
+{
+	m_context->beginRecording(
+		m_device->createCmdList(VltPipelineType::Graphics));
+
+	m_renderTargets = VltRenderTargets();
+}
+
+RcPtr<VltCmdList> GnmCommandSinkViolet::endRecording()
+{
+	auto cmdList = m_context->endRecording();
+	traceFrameStats();
+
+	// Resources of older frames may be evicted now.
+	m_factory.endFrame();
+	return cmdList;
+}
+
+const std::vector<const void*>& GnmCommandSinkViolet::getEvictedTextures()
+{
+	return m_factory.getEvictedTextures();
+}
+
+void GnmCommandSinkViolet::setViewports(
+	uint32_t          viewportCount,
+	const VkViewport* viewports,
+	const VkRect2D*   scissorRects)
+{
+	m_context->setViewports(viewportCount, viewports, scissorRects);
+}
+
+void GnmCommandSinkViolet::setInputLayout(
+	uint32_t                  bindingCount,
+	const VltVertexBinding*   bindings,
+	uint32_t                  attributeCount,
+	const VltVertexAttribute* attributes)
+{
+	m_context->setInputLayout(bindingCount, bindings, attributeCount, attributes);
+}
+
+void GnmCommandSinkViolet::setInputAssemblyState(const VltInputAssemblyInfo& iaState)
+{
+	m_context->setInputAssemblyState(iaState);
+}
+
+void GnmCommandSinkViolet::setRasterizerState(const VltRasterizationInfo& rsState)
+{
+	m_context->setRasterizerState(rsState);
+}
+
+void GnmCommandSinkViolet::setDepthStencilState(const VltDepthStencilInfo& dsState)
+{
+	m_context->setDepthStencilState(dsState);
+}
+
+void GnmCommandSinkViolet::setBlendMode(
+	uint32_t                       attachment,
+	const VltColorBlendAttachment& blendMode)
+{
+	m_context->setBlendMode(attachment, blendMode);
+}
+
+void GnmCommandSinkViolet::setBlendMask(
+	uint32_t                     attachment,
+	const VkColorComponentFlags& colorMask)
+{
+	m_context->setBlendMask(attachment, colorMask);
+}
+
+void GnmCommandSinkViolet::setRenderTarget(
+	uint32_t               slot,
+	const GnmRenderTarget& target)
+{
+	auto image = m_factory.grabRenderTarget(target);
+
+	VltAttachment colorTarget   = {};
+	colorTarget.view            = image.view;
+	colorTarget.layout          = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	m_renderTargets.color[slot] = colorTarget;
+}
+
+void GnmCommandSinkViolet::setDepthRenderTarget(const GnmDepthRenderTarget& target)
+{
+	auto depthImage = m_factory.grabDepthRenderTarget(target);
+
+	VltAttachment depthAttachment = {};
+	depthAttachment.view          = depthImage.view;
+	depthAttachment.layout        = depthImage.view->imageInfo().layout;
+	m_renderTargets.depth         = depthAttachment;
+}
+
+void GnmCommandSinkViolet::bindRenderTargets()
+{
+	m_context->bindRenderTargets(m_renderTargets);
+}
+
+void GnmCommandSinkViolet::bindShader(
+	VkShaderStageFlagBits    stage,
+	const RcPtr<VltShader>& shader)
+{
+	m_context->bindShader(stage, shader);
+}
+
+void GnmCommandSinkViolet::bindIndexBuffer(const GnmIndexBuffer& indexBuffer)
+{
+	auto slice = uploadBuffer(m_factory.grabIndex(indexBuffer), indexBuffer.buffer);
+
+	m_context->bindIndexBuffer(slice, indexBuffer.type);
+}
+
+void GnmCommandSinkViolet::bindVertexBuffer(
+	uint32_t         binding,
+	const GnmBuffer& buffer)
+{
+	GnmBufferCreateInfo info = {};
+	info.buffer              = &buffer;
+	info.stages              = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+	info.usageType           = kShaderInputUsageImmVertexBuffer;
+
+	auto slice = uploadBuffer(m_factory.grabBuffer(info), buffer.getBaseAddress());
+
+	m_context->bindVertexBuffer(binding, slice, buffer.getStride());
+}
+
+void GnmCommandSinkViolet::bindConstantBuffer(
+	uint32_t             regSlot,
+	VkPipelineStageFlags stages,
+	const GnmBuffer&     buffer)
+{
+	GnmBufferCreateInfo info = {};
+	info.buffer              = &buffer;
+	info.stages              = stages;
+	info.usageType           = kShaderInputUsageImmConstBuffer;
+
+	auto slice = uploadBuffer(m_factory.grabBuffer(info), buffer.getBaseAddress());
+
+	m_context->bindResourceBuffer(regSlot, slice);
+}
+
+bool GnmCommandSinkViolet::bindTexture(
+	uint32_t          regSlot,
+	const GnmTexture& texture)
+{
+	GnmTextureCreateInfo info = {};
+	info.texture              = &texture;
+	info.stages               = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	info.usageType            = kShaderInputUsageImmResource;
+
+	bool create = false;
+	auto image  = m_factory.grabImage(info, &create);
+
+	m_context->bindResourceView(regSlot, image.view, nullptr);
+	return create;
+}
+
+void GnmCommandSinkViolet::updateTexture(
+	const GnmTexture& texture,
+	const void*       data)
+{
+	GnmTextureCreateInfo info = {};
+	info.texture              = &texture;
+	info.stages               = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	info.usageType            = kShaderInputUsageImmResource;
+
+	// Bound just before, so this is a lookup.
+	auto image = m_factory.grabImage(info);
+
+	uint32_t pitchPerRow   = texture.getPitch();
+	uint32_t pitchPerLayer = pitchPerRow * texture.getHeight();
+
+	VkImageSubresourceLayers subRes = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	VkOffset3D               offset = { 0, 0, 0 };
+	m_context->updateImage(
+		image.image, subRes,
+		offset, image.image->info().extent,
+		data,
+		pitchPerRow, pitchPerLayer);
+}
+
+void GnmCommandSinkViolet::bindSampler(
+	uint32_t          regSlot,
+	const GnmSampler& sampler)
+{
+	m_context->bindSampler(regSlot, m_factory.grabSampler(sampler));
+}
+
+void GnmCommandSinkViolet::draw(uint32_t vertexCount)
+{
+	m_context->draw(vertexCount, 1, 0, 0);
+}
+
+void GnmCommandSinkViolet::drawIndexed(uint32_t indexCount)
+{
+	m_context->drawIndexed(indexCount, 1, 0, 0, 0);
+}
+
+void GnmCommandSinkViolet::dispatch(
+	uint32_t threadGroupX,
+	uint32_t threadGroupY,
+	uint32_t threadGroupZ)
+{
+	LOG_FIXME("Not implemented.");
+}
+
+void GnmCommandSinkViolet::clearRenderTarget(
+	const GnmRenderTarget& target,
+	const VkClearValue&    clearValue)
+{
+	auto targetImage = m_factory.grabRenderTarget(target);
+	m_context->clearRenderTarget(targetImage.view, VK_IMAGE_ASPECT_COLOR_BIT, clearValue);
+}
+
+void GnmCommandSinkViolet::clearDepthRenderTarget(
+	const GnmDepthRenderTarget& target,
+	const VkClearValue&         clearValue)
+{
+	auto depthImage = m_factory.grabDepthRenderTarget(target);
+	m_context->clearRenderTarget(depthImage.view, VK_IMAGE_ASPECT_DEPTH_BIT, clearValue);
+}
+
+VltBufferSlice GnmCommandSinkViolet::uploadBuffer(
+	const VltBufferSlice& slice,
+	const void*           data)
+{
+	VltBufferSlice result = slice;
+	do
+	{
+		bool        renamable = false;
+		const auto& ranges    = m_factory.getBufferUploadRanges(data, slice, &renamable);
+		if (renamable)
+		{
+			// Per-draw updates of a buffer earlier draws read
+			// get fresh memory instead of ending the render pass.
+			result = m_context->updateBufferSlice(slice, data);
+			break;
+		}
+
+		// Ranges are relative to the backing buffer,
+		// which may start before the slice.
+		const uint8_t* base = reinterpret_cast<const uint8_t*>(data) - slice.offset();
+		for (const auto& range : ranges)
+		{
+			m_context->updateBuffer(slice.buffer(), range.offset, range.size, base + range.offset);
+		}
+	} while (false);
+	return result;
+}
+
+void GnmCommandSinkViolet::traceFrameStats()
+{
+	const auto& stats = m_context->getFrameStats();
+	LOG_TRACE("frame: %u draws, %u render passes, %u init uploads, %u renamed, %u batched uploads in %u flushes.",
+			  stats.drawCount, stats.renderPassCount,
+			  stats.initUploadCount, stats.renamedUploadCount,
+			  stats.batchedUploadCount, stats.uploadFlushCount);
+	LOG_TRACE("frame: %llu bytes staged, %u dedicated staging buffers, %u staging stalls.",
+			  stats.stagedBytes, stats.dedicatedStagingCount, stats.stagingStallCount);
+	LOG_TRACE("frame: %u descriptor sets written, %u reused.",
+			  stats.descriptorSetCount, stats.descriptorSetReuseCount);
+
+	const auto& residency = m_factory.getResidencyStats();
+	LOG_TRACE("frame: %u resident resources with %llu bytes, %u evicted so far.",
+			  residency.residentCount, residency.residentSize, residency.evictedCount);
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "GnmCommon.h"
+#include "GnmCommandSink.h"
+#include "GnmResourceFactory.h"
+
+#include "../Violet/VltFrameBuffer.h"
+
+namespace sce
+{;
+struct SceGpuQueueDevice;
+}  // namespace sce
+
+namespace vlt
+{;
+class VltContext;
+class VltDevice;
+}  // namespace vlt
+
+// Records the work of GnmCommandBufferDraw into a Violet context,
+// Gnm descriptors are mapped to Violet resources by the resource factory.
+
+class GnmCommandSinkViolet : public GnmCommandSink
+{
+public:
+	GnmCommandSinkViolet(
+		const sce::SceGpuQueueDevice& device,
+		const RcPtr<vlt::VltContext>& context);
+
+	virtual ~GnmCommandSinkViolet();
+
+	virtual void beginRecording() override;
+
+	virtual RcPtr<vlt::VltCmdList> endRecording() override;
+
+	virtual const std::vector<const void*>& getEvictedTextures() override;
+
+	virtual void setViewports(
+		uint32_t          viewportCount,
+		const VkViewport* viewports,
+		const VkRect2D*   scissorRects) override;
+
+	virtual void setInputLayout(
+		uint32_t                       bindingCount,
+		const vlt::VltVertexBinding*   bindings,
+		uint32_t                       attributeCount,
+		const vlt::VltVertexAttribute* attributes) override;
+
+	virtual void setInputAssemblyState(
+		const vlt::VltInputAssemblyInfo& iaState) override;
+
+	virtual void setRasterizerState(
+		const vlt::VltRasterizationInfo& rsState) override;
+
+	virtual void setDepthStencilState(
+		const vlt::VltDepthStencilInfo& dsState) override;
+
+	virtual void setBlendMode(
+		uint32_t                            attachment,
+		const vlt::VltColorBlendAttachment& blendMode) override;
+
+	virtual void setBlendMask(
+		uint32_t                     attachment,
+		const VkColorComponentFlags& colorMask) override;
+
+	virtual void setRenderTarget(
+		uint32_t               slot,
+		const GnmRenderTarget& target) override;
+
+	virtual void setDepthRenderTarget(
+		const GnmDepthRenderTarget& target) override;
+
+	virtual void bindRenderTargets() override;
+
+	virtual void bindShader(
+		VkShaderStageFlagBits         stage,
+		const RcPtr<vlt::VltShader>& shader) override;
+
+	virtual void bindIndexBuffer(
+		const GnmIndexBuffer& indexBuffer) override;
+
+	virtual void bindVertexBuffer(
+		uint32_t         binding,
+		const GnmBuffer& buffer) override;
+
+	virtual void bindConstantBuffer(
+		uint32_t             regSlot,
+		VkPipelineStageFlags stages,
+		const GnmBuffer&     buffer) override;
+
+	virtual bool bindTexture(
+		uint32_t          regSlot,
+		const GnmTexture& texture) override;
+
+	virtual void updateTexture(
+		const GnmTexture& texture,
+		const void*       data) override;
+
+	virtual void bindSampler(
+		uint32_t          regSlot,
+		const GnmSampler& sampler) override;
+
+	virtual void draw(
+		uint32_t vertexCount) override;
+
+	virtual void drawIndexed(
+		uint32_t indexCount) override;
+
+	virtual void dispatch(
+		uint32_t threadGroupX,
+		uint32_t threadGroupY,
+		uint32_t threadGroupZ) override;
+
+	virtual void clearRenderTarget(
+		const GnmRenderTarget& target,
+		const VkClearValue&    clearValue) override;
+
+	virtual void clearDepthRenderTarget(
+		const GnmDepthRenderTarget& target,
+		const VkClearValue&         clearValue) override;
+
+private:
+	// Returns the slice to bind, which differs from
+	// the given one if the slice had to be renamed.
+	vlt::VltBufferSlice uploadBuffer(
+		const vlt::VltBufferSlice& slice,
+		const void*                data);
+
+	void traceFrameStats();
+
+private:
+	RcPtr<vlt::VltDevice>  m_device;
+	RcPtr<vlt::VltContext> m_context;
+	GnmResourceFactory     m_factory;
+
+	vlt::VltRenderTargets m_renderTargets;
+};
@@ -116,8 +116,7 @@ struct GnmPixelShaderState
 
 struct GnmOutputMergerState
 {
-	vlt::VltRenderTargets                                 renderTargets = {};
-	std::array<GnmRenderTarget, vlt::MaxNumRenderTargets> colorTargets  = {};
+	std::array<GnmRenderTarget, vlt::MaxNumRenderTargets> colorTargets = {};
 
 	GnmDepthRenderTarget depthTarget     = {};
 	VkClearValue         depthClearValue = {};
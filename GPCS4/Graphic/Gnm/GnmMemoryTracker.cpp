@@ -0,0 +1,373 @@
+#include "GnmMemoryTracker.h"
+
+#include "Platform/UtilMemory.h"
+
+#include <algorithm>
+
+#ifdef GPCS4_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#undef WIN32_LEAN_AND_MEAN
+#else
+#include <signal.h>
+#endif  // GPCS4_WINDOWS
+
+LOG_CHANNEL(Graphic.Gnm.GnmMemoryTracker);
+
+using UtilMemory::VM_PAGE_SIZE;
+
+static inline uintptr_t alignPageDown(uintptr_t address)
+{
+	return address & ~uintptr_t(VM_PAGE_SIZE - 1);
+}
+
+static inline uintptr_t alignPageUp(uintptr_t address)
+{
+	return alignPageDown(address + VM_PAGE_SIZE - 1);
+}
+
+#ifndef GPCS4_WINDOWS
+static struct sigaction g_oldAction = {};
+#endif  // GPCS4_WINDOWS
+
+GnmMemoryTracker::GnmMemoryTracker()
+{
+}
+
+GnmMemoryTracker::~GnmMemoryTracker()
+{
+	uninstall();
+}
+
+bool GnmMemoryTracker::install()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	bool ret = false;
+	do
+	{
+		if (m_installed)
+		{
+			ret = true;
+			break;
+		}
+
+#ifdef GPCS4_WINDOWS
+		// Called first, the TLS handler treats
+		// any fault it doesn't know as an error.
+		m_handler = AddVectoredExceptionHandler(TRUE,
+												(PVECTORED_EXCEPTION_HANDLER)GnmMemoryTracker::VEHExceptionHandler);
+		if (!m_handler)
+		{
+			LOG_ERR("failed to add exception handler.");
+			break;
+		}
+#else
+		struct sigaction action = {};
+		action.sa_sigaction     = reinterpret_cast<void (*)(int, siginfo_t*, void*)>(GnmMemoryTracker::signalHandler);
+		action.sa_flags         = SA_SIGINFO | SA_NODEFER;
+		sigemptyset(&action.sa_mask);
+		if (sigaction(SIGSEGV, &action, &g_oldAction) != 0)
+		{
+			LOG_ERR("failed to install signal handler.");
+			break;
+		}
+#endif  // GPCS4_WINDOWS
+
+		m_installed = true;
+		ret         = true;
+	} while (false);
+	return ret;
+}
+
+void GnmMemoryTracker::uninstall()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (!m_installed)
+	{
+		return;
+	}
+
+	for (auto& page : m_pages)
+	{
+		if (!page.second.writable)
+		{
+			protectPages(page.first, page.first + VM_PAGE_SIZE, true);
+		}
+	}
+
+	m_pages.clear();
+	m_watches.clear();
+
+#ifdef GPCS4_WINDOWS
+	RemoveVectoredExceptionHandler(m_handler);
+	m_handler = nullptr;
+#else
+	sigaction(SIGSEGV, &g_oldAction, nullptr);
+#endif  // GPCS4_WINDOWS
+
+	m_installed = false;
+}
+
+bool GnmMemoryTracker::isInstalled() const
+{
+	return m_installed;
+}
+
+uint32_t GnmMemoryTracker::watch(const void* address, size_t size)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	uint32_t watchId = InvalidWatch;
+	do
+	{
+		if (!m_installed || !size)
+		{
+			break;
+		}
+
+		Watch watch   = {};
+		watch.address = reinterpret_cast<uintptr_t>(address);
+		watch.size    = size;
+		watch.syncSeq = m_writeSeq;
+
+		uintptr_t begin = alignPageDown(watch.address);
+		uintptr_t end   = alignPageUp(watch.address + size);
+
+		// Pages made writable for another watch must be protected
+		// again, or writes to them would go unnoticed by this one.
+		for (uintptr_t page = begin; page != end; page += VM_PAGE_SIZE)
+		{
+			auto& tracked = m_pages[page];
+			++tracked.watchCount;
+			tracked.writable = false;
+		}
+
+		protectPages(begin, end, false);
+
+		watchId = m_nextWatch++;
+		m_watches.emplace(watchId, watch);
+	} while (false);
+	return watchId;
+}
+
+void GnmMemoryTracker::unwatch(uint32_t watchId)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	do
+	{
+		auto iter = m_watches.find(watchId);
+		if (iter == m_watches.end())
+		{
+			break;
+		}
+
+		uintptr_t begin = alignPageDown(iter->second.address);
+		uintptr_t end   = alignPageUp(iter->second.address + iter->second.size);
+
+		for (uintptr_t page = begin; page != end; page += VM_PAGE_SIZE)
+		{
+			auto tracked = m_pages.find(page);
+			if (--tracked->second.watchCount)
+			{
+				continue;
+			}
+
+			if (!tracked->second.writable)
+			{
+				protectPages(page, page + VM_PAGE_SIZE, true);
+			}
+
+			m_pages.erase(tracked);
+		}
+
+		m_watches.erase(iter);
+	} while (false);
+}
+
+bool GnmMemoryTracker::sync(uint32_t watchId, std::vector<GnmMemoryRange>& ranges)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	ranges.clear();
+
+	bool ret = false;
+	do
+	{
+		auto iter = m_watches.find(watchId);
+		if (iter == m_watches.end())
+		{
+			break;
+		}
+
+		auto& watch = iter->second;
+
+		uintptr_t watchEnd = watch.address + watch.size;
+		uintptr_t begin    = alignPageDown(watch.address);
+		uintptr_t end      = alignPageUp(watchEnd);
+
+		// Adjacent dirty pages are merged into one range,
+		// and adjacent writable pages protected in one call.
+		uintptr_t dirtyBegin   = 0;
+		uintptr_t dirtyEnd     = 0;
+		uintptr_t protectBegin = 0;
+		uintptr_t protectEnd   = 0;
+		for (uintptr_t page = begin; page != end; page += VM_PAGE_SIZE)
+		{
+			auto& tracked = m_pages.find(page)->second;
+			if (tracked.writeSeq <= watch.syncSeq)
+			{
+				continue;
+			}
+
+			if (tracked.writable)
+			{
+				if (page != protectEnd)
+				{
+					if (protectEnd)
+					{
+						protectPages(protectBegin, protectEnd, false);
+					}
+					protectBegin = page;
+				}
+				protectEnd       = page + VM_PAGE_SIZE;
+				tracked.writable = false;
+			}
+
+			if (page != alignPageUp(dirtyEnd))
+			{
+				if (dirtyEnd)
+				{
+					ranges.push_back({ dirtyBegin - watch.address, dirtyEnd - dirtyBegin });
+				}
+				dirtyBegin = std::max(page, watch.address);
+			}
+			dirtyEnd = std::min(page + VM_PAGE_SIZE, watchEnd);
+		}
+
+		if (protectEnd)
+		{
+			protectPages(protectBegin, protectEnd, false);
+		}
+
+		if (dirtyEnd)
+		{
+			ranges.push_back({ dirtyBegin - watch.address, dirtyEnd - dirtyBegin });
+		}
+
+		watch.syncSeq = m_writeSeq;
+
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+uint64_t GnmMemoryTracker::getFaultCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_faultCount;
+}
+
+bool GnmMemoryTracker::handleWriteFault(void* address)
+{
+	// Guest code never runs with the lock held,
+	// so taking it in the handler can't deadlock.
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	bool handled = false;
+	do
+	{
+		uintptr_t page    = alignPageDown(reinterpret_cast<uintptr_t>(address));
+		auto      tracked = m_pages.find(page);
+		if (tracked == m_pages.end())
+		{
+			break;
+		}
+
+		// Another thread may have faulted on the same
+		// page first, then the write just needs a retry.
+		if (!tracked->second.writable)
+		{
+			tracked->second.writeSeq = ++m_writeSeq;
+			tracked->second.writable = true;
+			protectPages(page, page + VM_PAGE_SIZE, true);
+			++m_faultCount;
+		}
+
+		handled = true;
+	} while (false);
+	return handled;
+}
+
+void GnmMemoryTracker::protectPages(uintptr_t begin, uintptr_t end, bool writable)
+{
+	uint32_t flags = writable ? UtilMemory::VMPF_READ_WRITE : UtilMemory::VMPF_CPU_READ;
+	if (!UtilMemory::VMProtect(reinterpret_cast<void*>(begin), end - begin, flags))
+	{
+		LOG_ERR("failed to protect %p-%p.", reinterpret_cast<void*>(begin), reinterpret_cast<void*>(end));
+	}
+}
+
+#ifdef GPCS4_WINDOWS
+
+long __stdcall GnmMemoryTracker::VEHExceptionHandler(void* exceptionArg)
+{
+	PEXCEPTION_POINTERS pExceptionInfo = (PEXCEPTION_POINTERS)exceptionArg;
+	long                nRet           = EXCEPTION_CONTINUE_SEARCH;
+	do
+	{
+		auto record = pExceptionInfo->ExceptionRecord;
+		if (record->ExceptionCode != EXCEPTION_ACCESS_VIOLATION)
+		{
+			break;
+		}
+
+		// The first parameter is 1 for writes,
+		// the second one the faulting address.
+		if (record->ExceptionInformation[0] != 1)
+		{
+			break;
+		}
+
+		void* address = reinterpret_cast<void*>(record->ExceptionInformation[1]);
+		if (!GetInstance()->handleWriteFault(address))
+		{
+			break;
+		}
+
+		nRet = EXCEPTION_CONTINUE_EXECUTION;
+	} while (false);
+	return nRet;
+}
+
+#else
+
+void GnmMemoryTracker::signalHandler(int signal, void* info, void* context)
+{
+	siginfo_t* sigInfo = reinterpret_cast<siginfo_t*>(info);
+
+	// Watched pages stay readable,
+	// so a fault on them is a write.
+	if (GetInstance()->handleWriteFault(sigInfo->si_addr))
+	{
+		return;
+	}
+
+	if (g_oldAction.sa_flags & SA_SIGINFO)
+	{
+		g_oldAction.sa_sigaction(signal, sigInfo, context);
+	}
+	else if (g_oldAction.sa_handler != SIG_DFL && g_oldAction.sa_handler != SIG_IGN)
+	{
+		g_oldAction.sa_handler(signal);
+	}
+	else
+	{
+		// Let the fault happen again without us.
+		sigaction(SIGSEGV, &g_oldAction, nullptr);
+	}
+}
+
+#endif  // GPCS4_WINDOWS
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "GnmCommon.h"
+#include "UtilSingleton.h"
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * \brief Dirty memory range
+ *
+ * Offset and size are relative to the
+ * start of the watched memory.
+ */
+struct GnmMemoryRange
+{
+	size_t offset;
+	size_t size;
+};
+
+/**
+ * \brief Guest memory write tracker
+ *
+ * PS4 games write GPU resources like normal memory,
+ * so we can't tell when a resource changed. The tracker
+ * write-protects the pages of watched memory, and the
+ * first write to a page since the last sync raises an
+ * access violation, which marks the page dirty and makes
+ * it writable again.
+ *
+ * Every watch remembers the write sequence number of its
+ * last sync instead of keeping its own dirty bits, so
+ * watches sharing a page don't steal each other's writes.
+ *
+ * Writes from the OS, e.g. a file read into a watched
+ * buffer, fail instead of faulting, so tracking is only
+ * enabled on request.
+ */
+class GnmMemoryTracker : public Singleton<GnmMemoryTracker>
+{
+	friend class Singleton<GnmMemoryTracker>;
+
+public:
+	constexpr static uint32_t InvalidWatch = 0;
+
+	/**
+	 * \brief Installs the access violation handler
+	 *
+	 * Must be called after the TLS manager is installed,
+	 * so write faults don't pass through its handler.
+	 * \returns \c true on success
+	 */
+	bool install();
+
+	/**
+	 * \brief Removes the handler and all protections
+	 */
+	void uninstall();
+
+	/**
+	 * \brief Checks whether writes are tracked
+	 * \returns \c true if the handler is installed
+	 */
+	bool isInstalled() const;
+
+	/**
+	 * \brief Starts tracking writes to memory
+	 *
+	 * The memory starts clean, the caller is expected
+	 * to have uploaded it entirely.
+	 * \param [in] address Start of the memory
+	 * \param [in] size Size in bytes
+	 * \returns Watch id, \c InvalidWatch on failure
+	 */
+	uint32_t watch(const void* address, size_t size);
+
+	/**
+	 * \brief Stops tracking writes
+	 *
+	 * Pages not covered by other watches
+	 * become writable without faulting.
+	 * \param [in] watchId Watch to remove
+	 */
+	void unwatch(uint32_t watchId);
+
+	/**
+	 * \brief Collects memory written since the last sync
+	 *
+	 * Protection is restored before returning, so the
+	 * caller must read the memory after this call for
+	 * writes racing with it to be caught by the next sync.
+	 * \param [in] watchId The watch
+	 * \param [out] ranges Dirty ranges, adjacent pages merged
+	 * \returns \c false if the watch doesn't exist
+	 */
+	bool sync(uint32_t watchId, std::vector<GnmMemoryRange>& ranges);
+
+	/**
+	 * \brief Number of write faults handled
+	 * \returns Fault count since install
+	 */
+	uint64_t getFaultCount() const;
+
+private:
+	// A page covered by at least one watch
+	struct TrackedPage
+	{
+		uint64_t writeSeq;
+		uint32_t watchCount;
+		bool     writable;
+	};
+
+	struct Watch
+	{
+		uintptr_t address;
+		size_t    size;
+		uint64_t  syncSeq;
+	};
+
+	bool handleWriteFault(void* address);
+
+	void protectPages(uintptr_t begin, uintptr_t end, bool writable);
+
+#ifdef GPCS4_WINDOWS
+	static long __stdcall VEHExceptionHandler(void* exceptionArg);
+#else
+	static void signalHandler(int signal, void* info, void* context);
+#endif  // GPCS4_WINDOWS
+
+private:
+	GnmMemoryTracker();
+	virtual ~GnmMemoryTracker();
+	GnmMemoryTracker(const GnmMemoryTracker&) = delete;
+	GnmMemoryTracker& operator=(const GnmMemoryTracker&) = delete;
+
+private:
+	mutable std::mutex m_mutex;
+	bool               m_installed = false;
+	void*              m_handler   = nullptr;
+
+	uint64_t m_writeSeq   = 0;
+	uint64_t m_faultCount = 0;
+	uint32_t m_nextWatch  = 1;
+
+	std::unordered_map<uintptr_t, TrackedPage> m_pages;
+	std::unordered_map<uint32_t, Watch>        m_watches;
+};
@@ -0,0 +1,120 @@
+#include "GnmResidencyManager.h"
+
+#include "../Violet/VltGpuResource.h"
+
+LOG_CHANNEL(Graphic.Gnm.GnmResidencyManager);
+
+GnmResidencyManager::GnmResidencyManager()
+{
+}
+
+GnmResidencyManager::~GnmResidencyManager()
+{
+}
+
+void GnmResidencyManager::track(
+	const vlt::VltGpuResource* resource,
+	const GnmResident&         resident,
+	VkDeviceSize               size)
+{
+	do
+	{
+		if (m_entries.count(resource))
+		{
+			LOG_WARN("resource %p is tracked already.", resource);
+			break;
+		}
+
+		m_lru.push_front(Entry{ resource, resident, size, m_frame });
+		m_entries.emplace(resource, m_lru.begin());
+
+		m_stats.residentSize += size;
+		++m_stats.residentCount;
+	} while (false);
+}
+
+void GnmResidencyManager::touch(const vlt::VltGpuResource* resource)
+{
+	do
+	{
+		auto iter = m_entries.find(resource);
+		if (iter == m_entries.end())
+		{
+			break;
+		}
+
+		auto entry = iter->second;
+		if (entry->lastFrame == m_frame)
+		{
+			break;
+		}
+
+		entry->lastFrame = m_frame;
+		m_lru.splice(m_lru.begin(), m_lru, entry);
+	} while (false);
+}
+
+void GnmResidencyManager::forget(const vlt::VltGpuResource* resource)
+{
+	auto iter = m_entries.find(resource);
+	if (iter != m_entries.end())
+	{
+		erase(iter->second);
+	}
+}
+
+void GnmResidencyManager::endFrame()
+{
+	++m_frame;
+}
+
+VkDeviceSize GnmResidencyManager::evict(
+	VkDeviceSize              size,
+	uint32_t                  minAge,
+	std::vector<GnmResident>& evicted)
+{
+	VkDeviceSize evictedSize = 0;
+
+	auto iter = m_lru.end();
+	while (iter != m_lru.begin() && evictedSize < size)
+	{
+		auto entry = std::prev(iter);
+
+		// Everything closer to the front is newer.
+		if (entry->lastFrame + minAge > m_frame)
+		{
+			break;
+		}
+
+		// Still used by a command list which hasn't executed.
+		if (entry->resource->busy())
+		{
+			iter = entry;
+			continue;
+		}
+
+		evicted.push_back(entry->resident);
+		evictedSize += entry->size;
+
+		m_stats.evictedSize += entry->size;
+		++m_stats.evictedCount;
+
+		erase(entry);
+	}
+
+	return evictedSize;
+}
+
+const GnmResidencyStats& GnmResidencyManager::getStats() const
+{
+	return m_stats;
+}
+
+void GnmResidencyManager::erase(std::list<Entry>::iterator iter)
+{
+	m_stats.residentSize -= iter->size;
+	--m_stats.residentCount;
+
+	m_entries.erase(iter->resource);
+	m_lru.erase(iter);
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "GnmCommon.h"
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace vlt
+{;
+class VltGpuResource;
+}  // namespace vlt
+
+/**
+ * \brief Resident resource type
+ *
+ * Tells which resource factory map
+ * an evicted resource must be removed from.
+ */
+enum class GnmResidentType : uint32_t
+{
+	BufferRange,
+	Buffer,
+	Image,
+};
+
+/**
+ * \brief Resident resource
+ *
+ * Key of the resource in its resource factory map,
+ * buffer ranges are keyed by their start address only.
+ */
+struct GnmResident
+{
+	GnmResidentType type;
+	const void*     memory;
+	uint32_t        size;
+};
+
+/**
+ * \brief Residency statistics
+ */
+struct GnmResidencyStats
+{
+	uint64_t residentSize  = 0;
+	uint32_t residentCount = 0;
+	uint64_t evictedSize   = 0;
+	uint32_t evictedCount  = 0;
+};
+
+/**
+ * \brief Residency manager
+ *
+ * Keeps the resources of a resource factory which can be
+ * recreated from guest memory in least recently used order,
+ * along with the frame they were last used in.
+ *
+ * Eviction only picks resources which weren't used for a
+ * number of frames and no pending command list uses any
+ * more, i.e. whose fences have passed. Dropping the last
+ * reference then destroys them and frees their memory.
+ * This is not thread-safe.
+ */
+class GnmResidencyManager
+{
+public:
+	GnmResidencyManager();
+	~GnmResidencyManager();
+
+	/**
+	 * \brief Starts tracking a resource
+	 *
+	 * \param [in] resource The new resource
+	 * \param [in] resident Key of the resource
+	 * \param [in] size Memory size of the resource
+	 */
+	void track(
+		const vlt::VltGpuResource* resource,
+		const GnmResident&         resident,
+		VkDeviceSize               size);
+
+	/**
+	 * \brief Marks a resource used in the current frame
+	 *
+	 * Does nothing for resources which aren't tracked,
+	 * like render targets, which are never evicted.
+	 * \param [in] resource The resource
+	 */
+	void touch(const vlt::VltGpuResource* resource);
+
+	/**
+	 * \brief Stops tracking a resource
+	 *
+	 * For resources the factory drops by itself.
+	 * \param [in] resource The resource
+	 */
+	void forget(const vlt::VltGpuResource* resource);
+
+	/**
+	 * \brief Advances the frame counter
+	 */
+	void endFrame();
+
+	/**
+	 * \brief Picks resources to evict
+	 *
+	 * Goes from the least recently used resource until
+	 * \c size bytes are picked or the resources left were
+	 * used within the last \c minAge frames. Picked
+	 * resources are no longer tracked.
+	 * \param [in] size Number of bytes to evict
+	 * \param [in] minAge Frames a resource must have been unused
+	 * \param [out] evicted Keys of the picked resources
+	 * \returns Number of bytes picked
+	 */
+	VkDeviceSize evict(
+		VkDeviceSize              size,
+		uint32_t                  minAge,
+		std::vector<GnmResident>& evicted);
+
+	/**
+	 * \brief Residency statistics
+	 * \returns Current statistics
+	 */
+	const GnmResidencyStats& getStats() const;
+
+private:
+	struct Entry
+	{
+		const vlt::VltGpuResource* resource;
+		GnmResident                resident;
+		VkDeviceSize               size;
+		uint64_t                   lastFrame;
+	};
+
+	void erase(std::list<Entry>::iterator iter);
+
+private:
+	uint64_t m_frame = 0;
+
+	// Most recently used first
+	std::list<Entry>                                                           m_lru;
+	std::unordered_map<const vlt::VltGpuResource*, std::list<Entry>::iterator> m_entries;
+
+	GnmResidencyStats m_stats;
+};
@@ -7,10 +7,12 @@
 #include "GnmSampler.h"
 #include "GnmTexture.h"
 #include "UtilBit.h"
+#include "UtilMath.h"
 
 #include "../Violet/VltBuffer.h"
 #include "../Violet/VltDevice.h"
 #include "../Violet/VltImage.h"
+#include "../Violet/VltPhysicalDevice.h"
 #include "../Violet/VltPresenter.h"
 #include "../Violet/VltSampler.h"
 #include "../Pssl/PsslShaderFileBinary.h"
@@ -18,38 +20,349 @@
 #include "../Sce/SceVideoOut.h"
 #include "Algorithm/MurmurHash2.h"
 
+#include <algorithm>
+#include <atomic>
+
 LOG_CHANNEL(Graphic.Gnm.GnmResourceFactory);
 
 using namespace vlt;
 using namespace sce;
 using namespace pssl;
 
+// Textures up to this size are hashed entirely.
+constexpr size_t kTextureFullHashSize = 64 * 1024;
+// Larger textures are sampled at this many spots.
+constexpr size_t kTextureSampleCount  = 64;
+constexpr size_t kTextureSampleBytes  = 256;
+constexpr size_t kStagingBlockSize    = 16 * 1024 * 1024;
+constexpr size_t kStagingAlignment    = 64;
+// Backing buffers start at this alignment, which is at least
+// every offset alignment Vulkan may require for buffer bindings.
+constexpr uintptr_t kBufferRangeAlignment = 256;
+// Eviction starts once device-local usage is above the high
+// mark of the budget, and evicts down to the low mark.
+constexpr double kBudgetHighMark = 0.9;
+constexpr double kBudgetLowMark  = 0.8;
+// Resources used within this many frames are never evicted,
+// so resources used every few frames don't thrash.
+constexpr uint32_t kEvictMinAge = 8;
+
+static std::atomic<VkDeviceSize> g_memoryBudget = { 0 };
+
+static void logMemoryBudget(const VltMemoryBudget& budget)
+{
+	for (uint32_t i = 0; i != budget.heapCount; ++i)
+	{
+		const auto& heap = budget.heaps[i];
+		LOG_DEBUG("heap %u%s: %llu MB used of %llu MB budget%s, %llu MB allocated, %llu MB in use.",
+				  i, (heap.heapFlags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? " (device local)" : "",
+				  heap.memoryUsage >> 20, heap.memoryBudget >> 20,
+				  budget.fromDriver ? " (driver)" : "",
+				  heap.stats.memoryAllocated >> 20, heap.stats.memoryUsed >> 20);
+	}
+}
+
+GnmStagingArena::GnmStagingArena()
+{
+}
+
+GnmStagingArena::~GnmStagingArena()
+{
+}
+
+void* GnmStagingArena::alloc(size_t size)
+{
+	size = ::util::align(size, kStagingAlignment);
+
+	while (m_blockIndex < m_blocks.size() &&
+		   m_offset + size > m_blocks[m_blockIndex].size)
+	{
+		++m_blockIndex;
+		m_offset = 0;
+	}
+
+	if (m_blockIndex == m_blocks.size())
+	{
+		Block block  = {};
+		block.size   = std::max(size, kStagingBlockSize);
+		block.memory = std::make_unique<uint8_t[]>(block.size + kStagingAlignment);
+		m_blocks.push_back(std::move(block));
+	}
+
+	uint8_t* base = m_blocks[m_blockIndex].memory.get();
+	uint8_t* ptr  = reinterpret_cast<uint8_t*>(::util::align(reinterpret_cast<uintptr_t>(base), kStagingAlignment)) + m_offset;
+	m_offset += size;
+	return ptr;
+}
+
+void GnmStagingArena::reset()
+{
+	m_blockIndex = 0;
+	m_offset     = 0;
+}
+
+GnmTextureUploadCache::GnmTextureUploadCache()
+{
+	auto tracker = GnmMemoryTracker::GetInstance();
+	if (tracker->isInstalled())
+	{
+		m_tracker = tracker;
+	}
+}
+
+GnmTextureUploadCache::~GnmTextureUploadCache()
+{
+	for (const auto& watch : m_watches)
+	{
+		m_tracker->unwatch(watch.second);
+	}
+
+	uint64_t bindCount = m_stats.hitCount + m_stats.missCount;
+	if (bindCount)
+	{
+		LOG_DEBUG("texture upload cache: %llu binds, %.1f%% hits, %llu bytes uploaded, %llu bytes skipped.",
+				  bindCount, 100.0 * double(m_stats.hitCount) / double(bindCount),
+				  m_stats.uploadBytes, m_stats.skippedBytes);
+	}
+}
+
+bool GnmTextureUploadCache::checkUpload(
+	const GnmTexture& texture,
+	uint32_t          mipLevel,
+	uint32_t          arraySlice,
+	bool              create)
+{
+	const uint8_t* data = reinterpret_cast<const uint8_t*>(texture.getBaseAddress());
+	size_t         size = texture.getSizeAlign().m_size;
+
+	GnmTextureUploadEntry entry = {};
+	entry.memory                = data;
+	entry.mipLevel              = mipLevel;
+	entry.arraySlice            = arraySlice;
+
+	// Every subresource lives in the range of the whole texture,
+	// so any write to it invalidates all of them.
+	// A new image has undefined content even
+	// if the memory is unchanged.
+	bool upload = true;
+	if (m_tracker)
+	{
+		auto iter = m_watches.find(entry);
+		if (iter == m_watches.end())
+		{
+			m_watches.emplace(entry, m_tracker->watch(data, size));
+		}
+		else if (m_tracker->sync(iter->second, m_syncRanges))
+		{
+			upload = create || !m_syncRanges.empty();
+		}
+	}
+	else
+	{
+		uint64_t fingerprint = computeFingerprint(texture);
+
+		auto iter = m_fingerprints.find(entry);
+		if (iter == m_fingerprints.end())
+		{
+			m_fingerprints.emplace(entry, fingerprint);
+		}
+		else
+		{
+			upload       = create || iter->second != fingerprint;
+			iter->second = fingerprint;
+		}
+	}
+
+	if (upload)
+	{
+		++m_stats.missCount;
+		m_stats.uploadBytes += size;
+	}
+	else
+	{
+		++m_stats.hitCount;
+		m_stats.skippedBytes += size;
+	}
+
+	return upload;
+}
+
+void GnmTextureUploadCache::forget(const void* memory)
+{
+	for (auto iter = m_watches.begin(); iter != m_watches.end();)
+	{
+		if (iter->first.memory == memory)
+		{
+			m_tracker->unwatch(iter->second);
+			iter = m_watches.erase(iter);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+
+	for (auto iter = m_fingerprints.begin(); iter != m_fingerprints.end();)
+	{
+		if (iter->first.memory == memory)
+		{
+			iter = m_fingerprints.erase(iter);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+}
+
+uint64_t GnmTextureUploadCache::computeFingerprint(const GnmTexture& texture)
+{
+	const uint8_t* data = reinterpret_cast<const uint8_t*>(texture.getBaseAddress());
+	size_t         size = texture.getSizeAlign().m_size;
+
+	// The descriptor is part of the fingerprint, so a T# reusing
+	// the memory with another format or size is uploaded again.
+	uint64_t hash = algo::MurmurHash64A(texture.m_regs, sizeof(texture.m_regs), 0);
+
+	if (size <= kTextureFullHashSize)
+	{
+		hash = algo::MurmurHash64A(data, int(size), hash);
+	}
+	else
+	{
+		// First and last samples are at the ends of the texture.
+		size_t stride = (size - kTextureSampleBytes) / (kTextureSampleCount - 1);
+		for (size_t i = 0; i != kTextureSampleCount; ++i)
+		{
+			hash = algo::MurmurHash64A(data + i * stride, int(kTextureSampleBytes), hash);
+		}
+	}
+
+	return hash;
+}
+
+const GnmTextureUploadStats& GnmTextureUploadCache::getStats() const
+{
+	return m_stats;
+}
+
 GnmResourceFactory::GnmResourceFactory(const sce::SceGpuQueueDevice* device) :
-	m_device(device)
+	m_device(device),
+	m_memoryBudget(g_memoryBudget.load())
 {
 	collectRenderTargets();
+
+	auto& limits       = m_device->device->physicalDevice()->deviceProperties().limits;
+	m_uniformAlignment = limits.minUniformBufferOffsetAlignment;
+
+	auto tracker = GnmMemoryTracker::GetInstance();
+	if (tracker->isInstalled())
+	{
+		m_tracker = tracker;
+	}
 }
 
 GnmResourceFactory::~GnmResourceFactory()
 {
+	for (const auto& watch : m_bufferWatches)
+	{
+		m_tracker->unwatch(watch.second);
+	}
+
+	if (!m_bufferRanges.empty())
+	{
+		LOG_DEBUG("guest buffers: %zu backing ranges, %llu merges.",
+				  m_bufferRanges.size(), m_bufferMergeCount);
+	}
+
+	const auto& residency = m_residency.getStats();
+	if (residency.evictedCount)
+	{
+		LOG_DEBUG("residency: %u resources with %llu bytes resident, %u with %llu bytes evicted.",
+				  residency.residentCount, residency.residentSize,
+				  residency.evictedCount, residency.evictedSize);
+		logMemoryBudget(m_device->device->getMemoryBudget());
+	}
 }
 
-RcPtr<VltBuffer> GnmResourceFactory::grabIndex(const GnmIndexBuffer& desc, bool* create /*= nullptr*/)
+VltBufferSlice GnmResourceFactory::grabIndex(const GnmIndexBuffer& desc, bool* create /*= nullptr*/)
 {
-	GnmResourceEntry entry = {};
-	entry.memory           = desc.buffer;
-	entry.size             = desc.size;
-	auto createFunc        = [this, &desc]() { return createIndex(desc); };
-	return grabResource(entry, m_bufferMap, createFunc, create);
+	return grabBufferRange(
+		desc.buffer,
+		desc.size,
+		VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		VK_ACCESS_INDEX_READ_BIT,
+		create);
 }
 
-RcPtr<VltBuffer> GnmResourceFactory::grabBuffer(const GnmBufferCreateInfo& desc, bool* create /*= nullptr*/)
+VltBufferSlice GnmResourceFactory::grabBuffer(const GnmBufferCreateInfo& desc, bool* create /*= nullptr*/)
 {
-	GnmResourceEntry entry = {};
-	entry.memory           = desc.buffer->getBaseAddress();
-	entry.size             = desc.buffer->getSize();
-	auto createFunc        = [this, &desc]() { return createBuffer(desc); };
-	return grabResource(entry, m_bufferMap, createFunc, create);
+	VltBufferSlice slice = {};
+	do
+	{
+		const void* memory = desc.buffer->getBaseAddress();
+		uint32_t    size   = desc.buffer->getSize();
+
+		ShaderInputUsageType inputUsageType = static_cast<ShaderInputUsageType>(desc.usageType);
+
+		// A constant buffer can only be bound at an offset which is a
+		// multiple of the uniform alignment, so one the game placed
+		// at a smaller alignment gets a buffer of its own.
+		if (inputUsageType == pssl::kShaderInputUsageImmConstBuffer &&
+			reinterpret_cast<uintptr_t>(memory) % m_uniformAlignment)
+		{
+			GnmResourceEntry entry = {};
+			entry.memory           = memory;
+			entry.size             = size;
+			auto createFunc        = [this, &desc]() { return createBuffer(desc); };
+
+			bool isNew  = false;
+			auto buffer = grabResource(entry, m_bufferMap, createFunc, &isNew);
+			if (isNew)
+			{
+				m_residency.track(buffer.ptr(), { GnmResidentType::Buffer, memory, size }, buffer->info().size);
+			}
+			else
+			{
+				m_residency.touch(buffer.ptr());
+			}
+
+			if (create)
+			{
+				*create = isNew;
+			}
+
+			slice = VltBufferSlice(buffer);
+			break;
+		}
+
+		VkBufferUsageFlags usage  = {};
+		VkAccessFlags      access = {};
+		switch (inputUsageType)
+		{
+		case pssl::kShaderInputUsageImmConstBuffer:
+		{
+			usage  = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+			access = VK_ACCESS_UNIFORM_READ_BIT;
+		}
+		break;
+		case pssl::kShaderInputUsageImmVertexBuffer:
+		{
+			usage  = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+			access = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+		}
+		break;
+		case pssl::kShaderInputUsageImmRwResource:
+		case pssl::kShaderInputUsageImmResource:
+		default:
+			LOG_ASSERT(false, "unsupported buffer usage type %d", inputUsageType);
+			break;
+		}
+
+		slice = grabBufferRange(memory, size, usage, desc.stages, access, create);
+	} while (false);
+	return slice;
 }
 
 GnmCombinedImageView GnmResourceFactory::grabImage(const GnmTextureCreateInfo& desc, bool* create /*= nullptr*/)
@@ -58,7 +371,23 @@ GnmCombinedImageView GnmResourceFactory::grabImage(const GnmTextureCreateInfo& d
 	entry.memory           = desc.texture->getBaseAddress();
 	entry.size             = desc.texture->getSizeAlign().m_size;
 	auto createFunc        = [this, &desc]() { return createImage(desc); };
-	return grabResource(entry, m_imageMap, createFunc, create);
+
+	bool isNew     = false;
+	auto imageView = grabResource(entry, m_imageMap, createFunc, &isNew);
+	if (isNew)
+	{
+		m_residency.track(imageView.image.ptr(), { GnmResidentType::Image, entry.memory, entry.size }, entry.size);
+	}
+	else
+	{
+		m_residency.touch(imageView.image.ptr());
+	}
+
+	if (create)
+	{
+		*create = isNew;
+	}
+	return imageView;
 }
 
 GnmCombinedImageView GnmResourceFactory::grabRenderTarget(const GnmRenderTarget& desc, bool* create /*= nullptr*/)
@@ -89,6 +418,90 @@ RcPtr<VltSampler> GnmResourceFactory::grabSampler(const GnmSampler& desc, bool*
 	return grabResource(entry, m_samplerMap, createFunc, create);
 }
 
+const std::vector<GnmMemoryRange>& GnmResourceFactory::getBufferUploadRanges(
+	const void*           memory,
+	const VltBufferSlice& slice,
+	bool*                 renamable)
+{
+	m_uploadRanges.clear();
+	*renamable = false;
+
+	// Without tracking we can't tell what else in
+	// the backing buffer changed, only the slice is
+	// uploaded and other slices when they are bound.
+	if (!m_tracker)
+	{
+		m_uploadRanges.push_back({ slice.offset(), slice.length() });
+		*renamable = true;
+		return m_uploadRanges;
+	}
+
+	auto   buffer = slice.buffer();
+	auto   base   = reinterpret_cast<const uint8_t*>(memory) - slice.offset();
+	size_t length = buffer->info().size;
+
+	auto iter = m_bufferWatches.find(buffer.ptr());
+	if (iter == m_bufferWatches.end())
+	{
+		// Upload the whole backing buffer once,
+		// only written pages after that.
+		m_bufferWatches.emplace(buffer.ptr(), m_tracker->watch(base, length));
+		m_uploadRanges.push_back({ 0, length });
+	}
+	else if (!m_tracker->sync(iter->second, m_uploadRanges))
+	{
+		// The buffer couldn't be watched, or isn't any more.
+		m_uploadRanges.push_back({ slice.offset(), slice.length() });
+		*renamable = true;
+	}
+	else
+	{
+		size_t dirtySize = 0;
+		for (const auto& range : m_uploadRanges)
+		{
+			dirtySize += range.size;
+		}
+
+		// A write fault costs more than copying a page, so buffers
+		// mostly rewritten between draws, like per-draw constants,
+		// are cheaper to upload slice by slice every time.
+		if (dirtySize * 2 >= length)
+		{
+			m_tracker->unwatch(iter->second);
+			iter->second = GnmMemoryTracker::InvalidWatch;
+		}
+	}
+
+	return m_uploadRanges;
+}
+
+void GnmResourceFactory::endFrame()
+{
+	m_evictedTextures.clear();
+	m_residency.endFrame();
+	enforceMemoryBudget();
+}
+
+const std::vector<const void*>& GnmResourceFactory::getEvictedTextures() const
+{
+	return m_evictedTextures;
+}
+
+const GnmResidencyStats& GnmResourceFactory::getResidencyStats() const
+{
+	return m_residency.getStats();
+}
+
+void GnmResourceFactory::setMemoryBudget(VkDeviceSize budget)
+{
+	g_memoryBudget.store(budget);
+}
+
+VkDeviceSize GnmResourceFactory::getMemoryBudget()
+{
+	return g_memoryBudget.load();
+}
+
 template <typename MapType>
 typename MapType::mapped_type GnmResourceFactory::grabResource(
 	const GnmResourceEntry&                        entry,
@@ -140,17 +553,94 @@ void GnmResourceFactory::collectRenderTargets()
 	}
 }
 
-RcPtr<VltBuffer> GnmResourceFactory::createIndex(const GnmIndexBuffer& desc)
+VltBufferSlice GnmResourceFactory::grabBufferRange(
+	const void*          memory,
+	uint32_t             size,
+	VkBufferUsageFlags   usage,
+	VkPipelineStageFlags stages,
+	VkAccessFlags        access,
+	bool*                create)
 {
-	VltBufferCreateInfo info = {};
-	info.size                = desc.size;
-	info.usage               = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-	info.stages              = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
-	info.access              = VK_ACCESS_INDEX_READ_BIT;
+	uintptr_t address = reinterpret_cast<uintptr_t>(memory);
+	uintptr_t begin   = address & ~(kBufferRangeAlignment - 1);
+	uintptr_t end     = address + size;
+
+	usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+	// First range which could overlap, ranges are
+	// disjoint so only the one before the first range
+	// starting after begin can reach into the request.
+	auto first = m_bufferRanges.upper_bound(begin);
+	if (first != m_bufferRanges.begin() && std::prev(first)->second.end > begin)
+	{
+		--first;
+	}
+
+	auto last = first;
+	while (last != m_bufferRanges.end() && last->first < end)
+	{
+		++last;
+	}
+
+	VltBufferSlice slice = {};
+	bool           isNew = false;
+	do
+	{
+		// Contained in a range created for the same use.
+		if (first != last && std::next(first) == last &&
+			first->first <= begin && first->second.end >= end)
+		{
+			const auto& range = first->second;
+			if ((range.usage & usage) == usage &&
+				(range.stages & stages) == stages &&
+				(range.access & access) == access)
+			{
+				slice = VltBufferSlice(range.buffer, address - first->first, size);
+				m_residency.touch(range.buffer.ptr());
+				break;
+			}
+		}
+
+		// Otherwise replace all overlapping ranges with one covering
+		// their union. Ranges are never split, bound slices of the old
+		// buffers stay valid and keep them alive until no longer used.
+		GnmBufferRange merged = {};
+		merged.end            = end;
+		merged.usage          = usage;
+		merged.stages         = stages;
+		merged.access         = access;
+		for (auto iter = first; iter != last; ++iter)
+		{
+			begin         = std::min(begin, iter->first);
+			merged.end    = std::max(merged.end, iter->second.end);
+			merged.usage |= iter->second.usage;
+			merged.stages |= iter->second.stages;
+			merged.access |= iter->second.access;
+
+			unwatchBuffer(iter->second.buffer.ptr());
+			m_residency.forget(iter->second.buffer.ptr());
+			++m_bufferMergeCount;
+		}
+		m_bufferRanges.erase(first, last);
+
+		VltBufferCreateInfo info = {};
+		info.size                = merged.end - begin;
+		info.usage               = merged.usage;
+		info.stages              = merged.stages;
+		info.access              = merged.access;
+		merged.buffer            = m_device->device->createBuffer(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		slice = VltBufferSlice(merged.buffer, address - begin, size);
+		m_residency.track(merged.buffer.ptr(), { GnmResidentType::BufferRange, reinterpret_cast<const void*>(begin), 0 }, info.size);
+		m_bufferRanges.emplace(begin, std::move(merged));
+		isNew = true;
+	} while (false);
 
-	return m_device->device->createBuffer(
-		info,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	if (create)
+	{
+		*create = isNew;
+	}
+	return slice;
 }
 
 RcPtr<VltBuffer> GnmResourceFactory::createBuffer(const GnmBufferCreateInfo& desc)
@@ -346,3 +836,103 @@ RcPtr<VltSampler> GnmResourceFactory::createSampler(const GnmSampler& desc)
 	info.usePixelCoord        = VK_FALSE;
 	return m_device->device->createSampler(info);
 }
+
+void GnmResourceFactory::enforceMemoryBudget()
+{
+	do
+	{
+		auto budget = m_device->device->getMemoryBudget();
+
+		VkDeviceSize usage = 0;
+		VkDeviceSize limit = 0;
+		for (uint32_t i = 0; i != budget.heapCount; ++i)
+		{
+			const auto& heap = budget.heaps[i];
+			if (heap.heapFlags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+			{
+				usage += heap.memoryUsage;
+				limit += heap.memoryBudget;
+			}
+		}
+
+		if (m_memoryBudget != 0)
+		{
+			limit = std::min(limit, m_memoryBudget);
+		}
+
+		if (usage <= VkDeviceSize(double(limit) * kBudgetHighMark))
+		{
+			break;
+		}
+
+		// Memory only goes back to the driver once a chunk is
+		// empty, so usage may stay high for a few frames.
+		VkDeviceSize target = VkDeviceSize(double(limit) * kBudgetLowMark);
+
+		m_evicted.clear();
+		VkDeviceSize evictedSize = m_residency.evict(usage - target, kEvictMinAge, m_evicted);
+		if (m_evicted.empty())
+		{
+			LOG_TRACE("%llu bytes of device memory used, budget %llu bytes, nothing to evict.", usage, limit);
+			break;
+		}
+
+		for (const auto& resident : m_evicted)
+		{
+			evictResource(resident);
+		}
+
+		LOG_DEBUG("%llu bytes of device memory used, budget %llu bytes, evicted %zu resources with %llu bytes.",
+				  usage, limit, m_evicted.size(), evictedSize);
+		logMemoryBudget(budget);
+	} while (false);
+}
+
+void GnmResourceFactory::evictResource(const GnmResident& resident)
+{
+	GnmResourceEntry entry = {};
+	entry.memory           = resident.memory;
+	entry.size             = resident.size;
+
+	switch (resident.type)
+	{
+	case GnmResidentType::BufferRange:
+	{
+		auto iter = m_bufferRanges.find(reinterpret_cast<uintptr_t>(resident.memory));
+		if (iter != m_bufferRanges.end())
+		{
+			unwatchBuffer(iter->second.buffer.ptr());
+			m_bufferRanges.erase(iter);
+		}
+	}
+		break;
+	case GnmResidentType::Buffer:
+	{
+		auto iter = m_bufferMap.find(entry);
+		if (iter != m_bufferMap.end())
+		{
+			unwatchBuffer(iter->second.ptr());
+			m_bufferMap.erase(iter);
+		}
+	}
+		break;
+	case GnmResidentType::Image:
+	{
+		// The frontend stops watching the texture, the
+		// recreated image is uploaded on its next bind.
+		m_imageMap.erase(entry);
+		m_evictedTextures.push_back(resident.memory);
+	}
+		break;
+	}
+}
+
+void GnmResourceFactory::unwatchBuffer(const VltBuffer* buffer)
+{
+	auto watch = m_bufferWatches.find(buffer);
+	if (watch != m_bufferWatches.end())
+	{
+		m_tracker->unwatch(watch->second);
+		m_bufferWatches.erase(watch);
+	}
+}
@@ -1,9 +1,14 @@
 #pragma once
 
 #include "GnmCommon.h"
+#include "GnmMemoryTracker.h"
+#include "GnmResidencyManager.h"
 
+#include <map>
 #include <unordered_map>
 #include <functional>
+#include <memory>
+#include <vector>
 
 namespace sce
 {;
@@ -13,6 +18,7 @@ struct SceGpuQueueDevice;
 namespace vlt
 {;
 class VltBuffer;
+class VltBufferSlice;
 class VltImage;
 class VltImageView;
 class VltSampler;
@@ -92,6 +98,95 @@ struct GnmResourceEntry
 	}
 };
 
+/**
+ * \brief Texture upload entry
+ *
+ * Identifies a single subresource of a T#.
+ */
+struct GnmTextureUploadEntry
+{
+	const void* memory;
+	uint32_t    mipLevel;
+	uint32_t    arraySlice;
+
+	bool operator==(const GnmTextureUploadEntry& other) const
+	{
+		return memory == other.memory && mipLevel == other.mipLevel && arraySlice == other.arraySlice;
+	}
+};
+
+/**
+ * \brief Texture upload statistics
+ *
+ * A hit is a bind which skipped detiling
+ * and uploading because the texture content
+ * didn't change since the last upload.
+ */
+struct GnmTextureUploadStats
+{
+	uint64_t hitCount;
+	uint64_t missCount;
+	uint64_t uploadBytes;
+	uint64_t skippedBytes;
+};
+
+/**
+ * \brief Staging arena
+ *
+ * Hands out CPU memory for detiled texture data
+ * before it is copied into a Vulkan staging buffer.
+ * Blocks are kept across resets, so steady state
+ * binds don't allocate.
+ */
+class GnmStagingArena
+{
+public:
+	GnmStagingArena();
+	~GnmStagingArena();
+
+	/**
+	 * \brief Allocates memory
+	 *
+	 * The memory stays valid until the next reset.
+	 * \param [in] size Size in bytes
+	 * \returns Pointer aligned to 64 bytes
+	 */
+	void* alloc(size_t size);
+
+	/**
+	 * \brief Releases all allocations
+	 */
+	void reset();
+
+private:
+	struct Block
+	{
+		std::unique_ptr<uint8_t[]> memory;
+		size_t                     size;
+	};
+
+	std::vector<Block> m_blocks;
+	size_t             m_blockIndex = 0;
+	size_t             m_offset     = 0;
+};
+
+/**
+ * \brief Guest buffer range
+ *
+ * A Vulkan buffer backing a range of guest memory. All
+ * V#s and index buffers inside the range are slices of
+ * it, so a pool the game sub-allocates from is created
+ * and uploaded once instead of once per slice.
+ */
+struct GnmBufferRange
+{
+	uintptr_t             end;
+	RcPtr<vlt::VltBuffer> buffer;
+	VkBufferUsageFlags    usage;
+	VkPipelineStageFlags  stages;
+	VkAccessFlags         access;
+};
+
 struct GnmResourceHash
 {
 	std::size_t operator()(GnmResourceEntry const& entry) const noexcept
@@ -99,6 +194,82 @@ struct GnmResourceHash
 		static_assert(sizeof(size_t) == sizeof(uint64_t), "size_t not 64 bit.");
 		return reinterpret_cast<size_t>(entry.memory) << 32 | static_cast<size_t>(entry.size);
 	}
+
+	std::size_t operator()(GnmTextureUploadEntry const& entry) const noexcept
+	{
+		return reinterpret_cast<size_t>(entry.memory) ^ (static_cast<size_t>(entry.mipLevel) << 48) ^ (static_cast<size_t>(entry.arraySlice) << 32);
+	}
+};
+
+
+/**
+ * \brief Texture upload cache
+ *
+ * Decides whether a bound texture must be detiled and
+ * uploaded again. Doesn't need a device, so every command
+ * buffer backend runs the same check.
+ */
+class GnmTextureUploadCache
+{
+public:
+	GnmTextureUploadCache();
+	~GnmTextureUploadCache();
+
+	/**
+	 * \brief Checks whether a texture needs uploading
+	 *
+	 * If guest writes are tracked, the texture needs uploading
+	 * when any of its pages was written since the last upload
+	 * of the subresource. Otherwise a content fingerprint of
+	 * the texture memory is compared with the one taken at the
+	 * last upload. Small textures are hashed entirely, larger
+	 * ones only at evenly spaced samples, so a write which
+	 * misses every sample goes unnoticed.
+	 * \param [in] texture The T#
+	 * \param [in] mipLevel Uploaded mip level
+	 * \param [in] arraySlice Uploaded array slice
+	 * \param [in] create The image was just created
+	 * \returns \c true if the subresource must be uploaded
+	 */
+	bool checkUpload(
+		const GnmTexture& texture,
+		uint32_t          mipLevel,
+		uint32_t          arraySlice,
+		bool              create);
+
+	/**
+	 * \brief Forgets a texture
+	 *
+	 * Stops watching the memory of all its subresources,
+	 * called once the texture's image is evicted.
+	 * \param [in] memory Base address of the texture
+	 */
+	void forget(const void* memory);
+
+	/**
+	 * \brief Content fingerprint of a texture
+	 *
+	 * Hashes the T# and the texture memory, entirely for
+	 * small textures, at evenly spaced samples otherwise.
+	 * \param [in] texture The T#
+	 * \returns Fingerprint compared by checkUpload
+	 */
+	static uint64_t computeFingerprint(const GnmTexture& texture);
+
+	/**
+	 * \brief Texture upload statistics
+	 * \returns Counters since creation
+	 */
+	const GnmTextureUploadStats& getStats() const;
+
+private:
+	std::unordered_map<GnmTextureUploadEntry, uint64_t, GnmResourceHash> m_fingerprints;
+	GnmTextureUploadStats                                                m_stats = {};
+
+	// Write tracker watches, if tracking is enabled
+	GnmMemoryTracker*                                                    m_tracker = nullptr;
+	std::unordered_map<GnmTextureUploadEntry, uint32_t, GnmResourceHash> m_watches;
+	std::vector<GnmMemoryRange>                                          m_syncRanges;
 };
 
 
@@ -110,11 +281,14 @@ public:
 
 	/// Get or create resources.
 
-	RcPtr<vlt::VltBuffer> grabIndex(
+	/// Buffers are slices of a buffer backing the guest range
+	/// they live in, create is set if the backing buffer is new.
+
+	vlt::VltBufferSlice grabIndex(
 		const GnmIndexBuffer& desc,
 		bool*                 create = nullptr);
 
-	RcPtr<vlt::VltBuffer> grabBuffer(
+	vlt::VltBufferSlice grabBuffer(
 		const GnmBufferCreateInfo& desc,
 		bool*                      create = nullptr);
 
@@ -134,6 +308,65 @@ public:
 		const GnmSampler& desc,
 		bool*             create = nullptr);
 
+	/**
+	 * \brief Gets the parts of a buffer to upload
+	 *
+	 * Ranges are relative to the start of the backing buffer.
+	 * This is the slice unless guest writes are tracked, then
+	 * it is the whole backing buffer when it is new, and only
+	 * the pages written since the last call for the same
+	 * backing buffer after that.
+	 * \param [in] memory Guest memory of the slice
+	 * \param [in] slice Slice returned by grabBuffer or grabIndex
+	 * \param [out] renamable Set if the only range is the slice,
+	 *        and it is uploaded again on every bind, so the data
+	 *        may go to a slice of another buffer instead
+	 * \returns Ranges valid until the next call
+	 */
+	const std::vector<GnmMemoryRange>& getBufferUploadRanges(
+		const void*                memory,
+		const vlt::VltBufferSlice& slice,
+		bool*                      renamable);
+
+	/**
+	 * \brief Ends the frame
+	 *
+	 * Called once the command list of the frame is recorded.
+	 * If device memory usage is over budget, evicts buffers
+	 * and textures which weren't used for a while and whose
+	 * command lists have executed, least recently used first.
+	 * They are recreated and uploaded again when bound.
+	 */
+	void endFrame();
+
+	/**
+	 * \brief Textures evicted by the last endFrame
+	 * \returns Base addresses of their guest memory
+	 */
+	const std::vector<const void*>& getEvictedTextures() const;
+
+	/**
+	 * \brief Residency statistics
+	 * \returns Resident and evicted resources
+	 */
+	const GnmResidencyStats& getResidencyStats() const;
+
+	/**
+	 * \brief Sets the device memory budget
+	 *
+	 * Applies to factories created afterwards. The driver's
+	 * budget from VK_EXT_memory_budget, or the heap size,
+	 * still applies if it is lower.
+	 * \param [in] budget Budget in bytes, 0 for no own budget
+	 */
+	static void setMemoryBudget(VkDeviceSize budget);
+
+	/**
+	 * \brief Gets the device memory budget
+	 * \returns Budget set with \c setMemoryBudget
+	 */
+	static VkDeviceSize getMemoryBudget();
+
 private:
 	
 	template <typename MapType>
@@ -145,7 +378,13 @@ private:
 
 	void collectRenderTargets();
 
-	RcPtr<vlt::VltBuffer> createIndex(const GnmIndexBuffer& desc);
+	vlt::VltBufferSlice grabBufferRange(
+		const void*          memory,
+		uint32_t             size,
+		VkBufferUsageFlags   usage,
+		VkPipelineStageFlags stages,
+		VkAccessFlags        access,
+		bool*                create);
 
 	RcPtr<vlt::VltBuffer> createBuffer(const GnmBufferCreateInfo& desc);
 
@@ -157,12 +396,36 @@ private:
 
 	RcPtr<vlt::VltSampler> createSampler(const GnmSampler& desc);
 
+	void enforceMemoryBudget();
+
+	void evictResource(const GnmResident& resident);
+
+	void unwatchBuffer(const vlt::VltBuffer* buffer);
+
 private:
 	const sce::SceGpuQueueDevice* m_device;
 
+	// Disjoint guest ranges keyed by their start address,
+	// m_bufferMap only holds constant buffers whose offset
+	// in a backing buffer would be misaligned.
+	std::map<uintptr_t, GnmBufferRange>                                           m_bufferRanges;
 	std::unordered_map<GnmResourceEntry, RcPtr<vlt::VltBuffer>, GnmResourceHash>  m_bufferMap;
+	VkDeviceSize                                                                  m_uniformAlignment;
+	uint64_t                                                                      m_bufferMergeCount = 0;
 	std::unordered_map<GnmResourceEntry, GnmCombinedImageView, GnmResourceHash>   m_imageMap;
 	std::unordered_map<GnmResourceEntry, RcPtr<vlt::VltSampler>, GnmResourceHash> m_samplerMap;
+
+	// Write tracker watches, if tracking is enabled
+	GnmMemoryTracker*                                   m_tracker = nullptr;
+	std::unordered_map<const vlt::VltBuffer*, uint32_t> m_bufferWatches;
+	std::vector<GnmMemoryRange>                         m_uploadRanges;
+
+	// Only resources which can be recreated from guest memory
+	// are tracked, render targets and samplers stay resident.
+	GnmResidencyManager      m_residency;
+	VkDeviceSize             m_memoryBudget;
+	std::vector<GnmResident> m_evicted;
+	std::vector<const void*> m_evictedTextures;
 };
 
 
@@ -0,0 +1,77 @@
+#include "GnmDetileEngine.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace GpuAddress
+{;
+
+// Surfaces smaller than this are detiled on the calling thread.
+constexpr uint64_t kMinParallelDetileBytes = 512 * 1024;
+
+// Keep bands large enough to amortize the job overhead.
+constexpr uint64_t kMinDetileBandBytes = 128 * 1024;
+
+DetileEngine::DetileEngine() :
+	m_workerCount(std::max(1u, std::thread::hardware_concurrency() / 2)),
+	m_threadCount(0),
+	m_workers(m_workerCount)
+{
+}
+
+DetileEngine::~DetileEngine()
+{
+}
+
+void DetileEngine::setThreadCount(uint32_t count)
+{
+	m_threadCount = count;
+}
+
+uint32_t DetileEngine::getThreadCount() const
+{
+	uint32_t count = m_threadCount;
+	return count ? std::min(count, m_workerCount + 1) : m_workerCount + 1;
+}
+
+std::vector<SurfaceRegion> DetileEngine::splitRegion(
+	const SurfaceRegion& region,
+	uint32_t             bitsPerElement) const
+{
+	std::vector<SurfaceRegion> bands;
+
+	uint64_t regionBytes = uint64_t(region.m_right - region.m_left) *
+						   (region.m_bottom - region.m_top) *
+						   (region.m_back - region.m_front) * bitsPerElement / 8;
+
+	uint32_t firstTileRow = region.m_top / kMicroTileHeight;
+	uint32_t endTileRow   = (region.m_bottom + kMicroTileHeight - 1) / kMicroTileHeight;
+	uint32_t tileRows     = endTileRow - firstTileRow;
+
+	uint32_t bandCount = getThreadCount();
+	bandCount          = std::min<uint64_t>(bandCount, std::max<uint64_t>(regionBytes / kMinDetileBandBytes, 1));
+	bandCount          = std::min(bandCount, tileRows);
+
+	if (regionBytes < kMinParallelDetileBytes || bandCount <= 1)
+	{
+		bands.push_back(region);
+		return bands;
+	}
+
+	// Band edges stay on tile row boundaries,
+	// so every band can still use the tile kernels.
+	for (uint32_t i = 0; i != bandCount; ++i)
+	{
+		uint32_t bandFirst = firstTileRow + uint32_t(uint64_t(tileRows) * i / bandCount);
+		uint32_t bandEnd   = firstTileRow + uint32_t(uint64_t(tileRows) * (i + 1) / bandCount);
+
+		SurfaceRegion band = region;
+		band.m_top         = std::max(region.m_top, bandFirst * kMicroTileHeight);
+		band.m_bottom      = std::min(region.m_bottom, bandEnd * kMicroTileHeight);
+		bands.push_back(band);
+	}
+
+	return bands;
+}
+
+}  // namespace GpuAddress
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "GnmGpuAddress.h"
+
+#include "../../Violet/VltWorkerPool.h"
+#include "UtilSingleton.h"
+
+#include <atomic>
+#include <vector>
+
+namespace GpuAddress
+{;
+
+/**
+ * \brief Parallel surface detiler
+ *
+ * Splits a surface into bands of whole micro tile rows,
+ * which are detiled by the workers and the calling thread
+ * at the same time. Small surfaces are detiled in place,
+ * waking up workers would cost more than it saves.
+ */
+class DetileEngine : public Singleton<DetileEngine>
+{
+	friend class Singleton<DetileEngine>;
+
+public:
+	/**
+	 * \brief Detiles a region of a surface
+	 *
+	 * Same as the tiler's detileSurfaceRegion.
+	 * \param [in] tiler Tiler of the surface, shared by all bands
+	 */
+	template <typename T>
+	int32_t detileSurfaceRegion(
+		T&                   tiler,
+		void*                outUntiledPixels,
+		const void*          tiledPixels,
+		const SurfaceRegion* srcRegion,
+		uint32_t             destPitch,
+		uint32_t             destSlicePitch);
+
+	/**
+	 * \brief Limits the threads used per surface
+	 *
+	 * \param [in] count Thread count including the caller,
+	 *        1 to detile on the calling thread only,
+	 *        0 to use all workers
+	 */
+	void setThreadCount(uint32_t count);
+
+	uint32_t getThreadCount() const;
+
+private:
+	DetileEngine();
+	~DetileEngine();
+
+	std::vector<SurfaceRegion> splitRegion(
+		const SurfaceRegion& region,
+		uint32_t             bitsPerElement) const;
+
+private:
+	uint32_t              m_workerCount;
+	std::atomic<uint32_t> m_threadCount;
+
+	vlt::VltWorkerPool m_workers;
+};
+
+template <typename T>
+int32_t DetileEngine::detileSurfaceRegion(
+	T&                   tiler,
+	void*                outUntiledPixels,
+	const void*          tiledPixels,
+	const SurfaceRegion* srcRegion,
+	uint32_t             destPitch,
+	uint32_t             destSlicePitch)
+{
+	int32_t status = kStatusSuccess;
+	do
+	{
+		if (!outUntiledPixels || !srcRegion)
+		{
+			status = tiler.detileSurfaceRegion(outUntiledPixels, tiledPixels, srcRegion, destPitch, destSlicePitch);
+			break;
+		}
+
+		auto bands = splitRegion(*srcRegion, tiler.getBitsPerElement());
+		if (bands.size() <= 1)
+		{
+			status = tiler.detileSurfaceRegion(outUntiledPixels, tiledPixels, srcRegion, destPitch, destSlicePitch);
+			break;
+		}
+
+		// Bands cover every slice of the region, so only
+		// the row offset of the output differs between them.
+		uint8_t* outBytes      = static_cast<uint8_t*>(outUntiledPixels);
+		uint64_t destRowBytes  = uint64_t(destPitch) * tiler.getBitsPerElement() / 8;
+
+		std::vector<std::shared_future<int32_t>> futures;
+		for (size_t i = 1; i != bands.size(); ++i)
+		{
+			SurfaceRegion band    = bands[i];
+			uint8_t*      bandOut = outBytes + (band.m_top - srcRegion->m_top) * destRowBytes;
+
+			futures.push_back(m_workers.submit([&tiler, band, bandOut, tiledPixels, destPitch, destSlicePitch]()
+			{
+				return tiler.detileSurfaceRegion(bandOut, tiledPixels, &band, destPitch, destSlicePitch);
+			}));
+		}
+
+		status = tiler.detileSurfaceRegion(outBytes, tiledPixels, &bands[0], destPitch, destSlicePitch);
+
+		for (auto& future : futures)
+		{
+			int32_t bandStatus = future.get();
+			if (bandStatus != kStatusSuccess)
+			{
+				status = bandStatus;
+			}
+		}
+	} while (false);
+	return status;
+}
+
+}  // namespace GpuAddress
@@ -973,6 +973,13 @@ LABEL_MACRO_TILE:
 		infoOut->m_depth       = outDepth;
 		infoOut->m_surfaceSize = bytesPerSlice * outDepth;
 		infoOut->m_arrayMode   = arrayMode;
+
+		infoOut->m_numPipes        = numPipes;
+		infoOut->m_numBanks        = numBanks;
+		infoOut->m_bankWidth       = bankWidth;
+		infoOut->m_bankHeight      = bankHeight;
+		infoOut->m_macroTileAspect = macroAspect;
+		infoOut->m_tileSplitBytes  = tileSplitC;
 	}
 		break;
 	default:
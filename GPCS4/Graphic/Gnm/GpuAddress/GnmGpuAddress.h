@@ -71,6 +71,14 @@ int32_t getMicroTileMode(
 	MicroTileMode* outMicroTileMode, 
 	TileMode tileMode);
 
+int32_t getPipeConfig(
+	PipeConfig* outPipeConfig, 
+	TileMode tileMode);
+
+int32_t getAltPipeConfig(
+	PipeConfig* outAltPipeConfig, 
+	TileMode tileMode);
+
 int32_t computeSurfaceMacroTileMode(
 	MacroTileMode* outMacroTileMode, 
 	TileMode tileMode,					
@@ -92,6 +100,24 @@ int32_t adjustTileMode(
 	TileMode oldTileMode, 
 	ArrayMode newArrayMode);
 
+/**
+ * \brief Micro tile kernels used to detile surfaces
+ */
+enum class DetileKernel
+{
+	Auto,    // Fastest kernel the CPU supports
+	Scalar,  // Element by element, no micro tile kernel
+	Sse2,
+	Avx2,
+};
+
+// Selects the micro tile kernels, Auto by default.
+// Kernels the CPU doesn't support fall back to the next slower one.
+void setDetileKernel(DetileKernel kernel);
+
+// The kernels which are actually used.
+DetileKernel getDetileKernel();
+
 int32_t detileSurface(
 	void* outUntiledPixels, 
 	const void* tiledPixels, 
@@ -2,11 +2,16 @@
 #include "GnmGpuAddress.h"
 #include "GnmGpuAddressTool.h"
 #include "GnmTilerSSE2.h"
+#include "GnmTilerAVX2.h"
+#include "GnmDetileEngine.h"
 
 #include "../GnmDataFormat.h"
 #include "../GnmTexture.h"
 
 #include <algorithm>
+#include <atomic>
+#include <intrin.h>
+#include <vector>
 
 LOG_CHANNEL(Graphic.Gnm.GpuAddress);
 
@@ -1267,6 +1272,136 @@ static inline int32_t getTiledElementByteOffset(const Tiler1d* tiler, uint64_t*
 	return tiler->getTiledElementByteOffset(outTiledByteOffset, x, y, z);
 }
 
+static inline int32_t getTiledElementByteOffset(const Tiler2d* tiler, uint64_t* outTiledByteOffset, uint32_t x, uint32_t y, uint32_t z, uint32_t fragmentIndex)
+{
+	return tiler->getTiledElementByteOffset(outTiledByteOffset, x, y, z, fragmentIndex);
+}
+
+// AddrLib ComputePipeFromCoord(), without the slice rotation.
+static uint32_t getPipeIndex(uint32_t x, uint32_t y, PipeConfig pipeConfig)
+{
+	uint32_t pipe = 0;
+	switch (pipeConfig)
+	{
+	case kPipeConfigP8_32x32_8x16:
+		pipe |= (((x >> 4) ^ (y >> 3) ^ (x >> 5)) & 0x1) << 0;
+		pipe |= (((x >> 3) ^ (y >> 4)) & 0x1) << 1;
+		pipe |= (((x >> 5) ^ (y >> 5)) & 0x1) << 2;
+		break;
+	case kPipeConfigP8_32x32_16x16:
+		pipe |= (((x >> 3) ^ (y >> 3) ^ (x >> 4)) & 0x1) << 0;
+		pipe |= (((x >> 4) ^ (y >> 4)) & 0x1) << 1;
+		pipe |= (((x >> 5) ^ (y >> 5)) & 0x1) << 2;
+		break;
+	case kPipeConfigP16:
+		pipe |= (((x >> 3) ^ (y >> 3) ^ (x >> 4)) & 0x1) << 0;
+		pipe |= (((x >> 4) ^ (y >> 4)) & 0x1) << 1;
+		pipe |= (((x >> 5) ^ (y >> 6)) & 0x1) << 2;
+		pipe |= (((x >> 6) ^ (y >> 5)) & 0x1) << 3;
+		break;
+	default:
+		LOG_ERR("Unknown PipeConfig %d", pipeConfig);
+		break;
+	}
+	return pipe;
+}
+
+// AddrLib ComputeBankFromCoord(), without the slice rotation.
+static uint32_t getBankIndex(uint32_t x, uint32_t y, uint32_t bankWidth, uint32_t bankHeight, uint32_t numBanks, uint32_t numPipes)
+{
+	const uint32_t xs = x >> fastIntLog2(bankWidth * numPipes);
+	const uint32_t ys = y >> fastIntLog2(bankHeight);
+
+	uint32_t bank = 0;
+	switch (numBanks)
+	{
+	case 2:
+		bank |= (((xs >> 3) ^ (ys >> 3)) & 0x1) << 0;
+		break;
+	case 4:
+		bank |= (((xs >> 3) ^ (ys >> 4)) & 0x1) << 0;
+		bank |= (((xs >> 4) ^ (ys >> 3)) & 0x1) << 1;
+		break;
+	case 8:
+		bank |= (((xs >> 3) ^ (ys >> 5)) & 0x1) << 0;
+		bank |= (((xs >> 4) ^ (ys >> 4) ^ (ys >> 5)) & 0x1) << 1;
+		bank |= (((xs >> 5) ^ (ys >> 3)) & 0x1) << 2;
+		break;
+	case 16:
+		bank |= (((xs >> 3) ^ (ys >> 6)) & 0x1) << 0;
+		bank |= (((xs >> 4) ^ (ys >> 5) ^ (ys >> 6)) & 0x1) << 1;
+		bank |= (((xs >> 5) ^ (ys >> 4)) & 0x1) << 2;
+		bank |= (((xs >> 6) ^ (ys >> 3)) & 0x1) << 3;
+		break;
+	default:
+		LOG_ERR("Invalid numBanks (%u).", numBanks);
+		break;
+	}
+	return bank;
+}
+
+// Pipe rotation between slices, only 3D modes rotate pipes.
+static uint32_t getPipeSliceRotation(ArrayMode arrayMode, uint32_t numPipes, uint32_t slice, uint32_t tileThickness)
+{
+	uint32_t rotation = 0;
+	switch (arrayMode)
+	{
+	case kArrayMode3dTiledThin:
+	case kArrayMode3dTiledThick:
+	case kArrayMode3dTiledXThick:
+	case kArrayMode3dTiledThinPrt:
+	case kArrayMode3dTiledThickPrt:
+		rotation = std::max(1U, (numPipes / 2) - 1) * (slice / tileThickness);
+		break;
+	default:
+		break;
+	}
+	return rotation;
+}
+
+static uint32_t getBankSliceRotation(ArrayMode arrayMode, uint32_t numBanks, uint32_t numPipes, uint32_t slice, uint32_t tileThickness)
+{
+	uint32_t rotation = 0;
+	switch (arrayMode)
+	{
+	case kArrayMode2dTiledThin:
+	case kArrayMode2dTiledThick:
+	case kArrayMode2dTiledXThick:
+	case kArrayMode2dTiledThinPrt:
+	case kArrayMode2dTiledThickPrt:
+		rotation = ((numBanks / 2) - 1) * (slice / tileThickness);
+		break;
+	case kArrayMode3dTiledThin:
+	case kArrayMode3dTiledThick:
+	case kArrayMode3dTiledXThick:
+	case kArrayMode3dTiledThinPrt:
+	case kArrayMode3dTiledThickPrt:
+		rotation = std::max(1U, (numPipes / 2) - 1) * (slice / tileThickness) / numPipes;
+		break;
+	default:
+		break;
+	}
+	return rotation;
+}
+
+// Bank rotation between the slices of a split tile, per slice.
+static uint32_t getTileSplitRotation(ArrayMode arrayMode, uint32_t numBanks)
+{
+	uint32_t rotation = 0;
+	switch (arrayMode)
+	{
+	case kArrayMode2dTiledThin:
+	case kArrayMode3dTiledThin:
+	case kArrayMode2dTiledThinPrt:
+	case kArrayMode3dTiledThinPrt:
+		rotation = (numBanks / 2) + 1;
+		break;
+	default:
+		break;
+	}
+	return rotation;
+}
+
 static uint32_t getElementIndex(uint32_t x, uint32_t y, uint32_t z, uint32_t bitsPerElement, MicroTileMode microTileMode, ArrayMode arrayMode)
 {
 	uint32_t elem = 0;
@@ -1599,6 +1734,87 @@ static MicroTileFunc getDetileFuncSse2(const MicroTileMode microTileMode, const
 	}
 }
 
+static bool isAvx2Supported()
+{
+	int32_t info[4] = {};
+	__cpuid(info, 0);
+	if (info[0] < 7)
+	{
+		return false;
+	}
+
+	// The OS must save the YMM registers on context switches.
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx     = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+	{
+		return false;
+	}
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+}
+
+static std::atomic<DetileKernel> g_detileKernel = DetileKernel::Auto;
+
+void setDetileKernel(DetileKernel kernel)
+{
+	g_detileKernel = kernel;
+}
+
+DetileKernel getDetileKernel()
+{
+	static const bool hasAvx2 = isAvx2Supported();
+
+	DetileKernel kernel = g_detileKernel;
+	if (kernel == DetileKernel::Auto || (kernel == DetileKernel::Avx2 && !hasAvx2))
+	{
+		kernel = hasAvx2 ? DetileKernel::Avx2 : DetileKernel::Sse2;
+	}
+	return kernel;
+}
+
+static MicroTileFunc getDetileFuncAvx2(const MicroTileMode microTileMode, const uint32_t bitsPerElement)
+{
+	switch (microTileMode)
+	{
+	case kMicroTileModeDepth:
+	case kMicroTileModeThin:
+		if (bitsPerElement == 8)
+			return detile8bppThinAvx2;
+		if (bitsPerElement == 16)
+			return detile16bppThinAvx2;
+		if (bitsPerElement == 32)
+			return detile32bppThinAvx2;
+		if (bitsPerElement == 64)
+			return detile64bppThinAvx2;
+		if (bitsPerElement == 128)
+			return detile128bppThinAvx2;
+		return NULL;
+	default:
+		// Same modes as SSE2, which logs the error.
+		return getDetileFuncSse2(microTileMode, bitsPerElement);
+	}
+}
+
+static MicroTileFunc getDetileFunc(const MicroTileMode microTileMode, const uint32_t bitsPerElement)
+{
+	MicroTileFunc func = NULL;
+	switch (getDetileKernel())
+	{
+	case DetileKernel::Avx2:
+		func = getDetileFuncAvx2(microTileMode, bitsPerElement);
+		break;
+	case DetileKernel::Sse2:
+		func = getDetileFuncSse2(microTileMode, bitsPerElement);
+		break;
+	default:
+		break;
+	}
+	return func;
+}
+
 struct Regions
 {
 	SurfaceRegion m_aligned;
@@ -1868,10 +2084,8 @@ int32_t detileSurfaceRegion(void* outUntiledPixels, const void* tiledPixels, con
 	case kArrayMode1dTiledThick:
 	{
 		Tiler1d tiler(&correctedTP);
-		return tiler.detileSurfaceRegion(outUntiledPixels, tiledPixels, srcRegion, destPitch, destSlicePitchElems);
+		return DetileEngine::GetInstance()->detileSurfaceRegion(tiler, outUntiledPixels, tiledPixels, srcRegion, destPitch, destSlicePitchElems);
 	}
-	case kArrayModeLinearGeneral:
-	case kArrayModeLinearAligned:
 	case kArrayMode2dTiledThin:
 	case kArrayMode2dTiledThick:
 	case kArrayMode2dTiledXThick:
@@ -1884,6 +2098,12 @@ int32_t detileSurfaceRegion(void* outUntiledPixels, const void* tiledPixels, con
 	case kArrayMode2dTiledThickPrt:
 	case kArrayMode3dTiledThinPrt:
 	case kArrayMode3dTiledThickPrt:
+	{
+		Tiler2d tiler(&correctedTP);
+		return DetileEngine::GetInstance()->detileSurfaceRegion(tiler, outUntiledPixels, tiledPixels, srcRegion, destPitch, destSlicePitchElems);
+	}
+	case kArrayModeLinearGeneral:
+	case kArrayModeLinearAligned:
 	default:
 		// Unsupported
 		LOG_FIXME("Invalid corrected tile mode (0x%02X).", correctedTP.m_tileMode);
@@ -2002,7 +2222,7 @@ int32_t Tiler1d::detileSurfaceRegion(void* outUntiledPixels, const void* inTiled
 	const auto out_bytes       = static_cast<uint8_t*>(outUntiledPixels);
 	const auto bytesPerElement = m_bitsPerElement / 8;
 
-	const auto detileFunc = getDetileFuncSse2(m_microTileMode, m_bitsPerElement);
+	const auto detileFunc = getDetileFunc(m_microTileMode, m_bitsPerElement);
 	if (nullptr != detileFunc && (intptr_t(in_bytes) % 16) == 0)
 	{
 		Regions regions;
@@ -2027,6 +2247,7 @@ int32_t Tiler1d::detileSurfaceRegion(void* outUntiledPixels, const void* inTiled
 				}
 			for (auto i = 0; i < regions.m_unaligneds; ++i)
 				slowDetileOneFragment<Tiler1d>(this, region, regions.m_unaligned[i], 0, destPitch, destSlicePitch, out_bytes, in_bytes, bytesPerElement);
+			return kStatusSuccess;
 		}
 	}
 	slowDetileOneFragment<Tiler1d>(this, region, region, 0, destPitch, destSlicePitch, out_bytes, in_bytes, bytesPerElement);
@@ -2059,4 +2280,370 @@ int32_t Tiler1d::getTiledElementBitOffset(uint64_t* outTiledBitOffset, uint32_t
 	return kStatusSuccess;
 }
 
+
+Tiler2d::Tiler2d()
+{
+}
+
+Tiler2d::Tiler2d(const TilingParameters* tp)
+{
+	int32_t status = init(tp);
+	LOG_ASSERT(status == kStatusSuccess, "Tiler2d initialization failed with error code %d", status);
+}
+
+Tiler2d::~Tiler2d()
+{
+}
+
+int32_t Tiler2d::init(const TilingParameters* tp)
+{
+	LOG_ASSERT_RETURN(tp != 0, kStatusInvalidArgument, "tp must not be NULL.");
+
+	SurfaceInfo surfInfoOut = { 0 };
+	int32_t status          = computeSurfaceInfo(&surfInfoOut, tp);
+	LOG_ASSERT_RETURN(status == kStatusSuccess, status, "computeSurfaceInfo() failed: %d", status);
+	LOG_ASSERT_RETURN(isMacroTiled(surfInfoOut.m_arrayMode), kStatusInvalidArgument,
+		"tp->m_tileMode (0x%02X) must be macro-tiled for 2D-tiled surfaces.", tp->m_tileMode);
+
+	m_minGpuMode = tp->m_minGpuMode;
+	MicroTileMode microTileMode;
+	getMicroTileMode(&microTileMode, tp->m_tileMode);
+	PipeConfig pipeConfig;
+	if (m_minGpuMode == kGpuModeNeo)
+	{
+		getAltPipeConfig(&pipeConfig, tp->m_tileMode);
+	}
+	else
+	{
+		getPipeConfig(&pipeConfig, tp->m_tileMode);
+	}
+	m_tileMode             = tp->m_tileMode;
+	m_arrayMode            = surfInfoOut.m_arrayMode;
+	m_microTileMode        = microTileMode;
+	m_pipeConfig           = pipeConfig;
+	m_arraySlice           = tp->m_arraySlice;
+	m_numFragmentsPerPixel = tp->m_numFragmentsPerPixel;
+	m_linearWidth          = tp->m_linearWidth;
+	m_linearHeight         = tp->m_linearHeight;
+	m_linearDepth          = tp->m_linearDepth;
+	m_bitsPerElement       = tp->m_bitsPerFragment;
+	m_paddedWidth          = surfInfoOut.m_pitch;
+	m_paddedHeight         = surfInfoOut.m_height;
+	m_paddedDepth          = surfInfoOut.m_depth;
+
+	if (tp->m_isBlockCompressed)
+	{
+		switch (tp->m_bitsPerFragment)
+		{
+		case 1:
+			LOG_ASSERT_RETURN(m_microTileMode == kMicroTileModeDisplay, kStatusInvalidArgument, 
+				"1bpp surfaces must use kMicroTileModeDisplay");
+			m_bitsPerElement *= 8;
+			m_linearWidth = std::max((m_linearWidth + 7) / 8, 1U);
+			m_paddedWidth = std::max((m_paddedWidth + 7) / 8, 1U);
+			break;
+		case 4:
+		case 8:
+			m_bitsPerElement *= 16;
+			m_linearWidth  = std::max((m_linearWidth + 3) / 4, 1U);
+			m_linearHeight = std::max((m_linearHeight + 3) / 4, 1U);
+			m_paddedWidth  = std::max((m_paddedWidth + 3) / 4, 1U);
+			m_paddedHeight = std::max((m_paddedHeight + 3) / 4, 1U);
+			break;
+		case 16:
+			// TODO
+			break;
+		default:
+			LOG_ASSERT_RETURN(!tp->m_isBlockCompressed, kStatusInvalidArgument,
+				"Unknown bit depth %u for block-compressed format", m_bitsPerElement);
+			break;
+		}
+	}
+	m_linearSizeBytes = (uint64_t(m_linearWidth) * m_linearHeight * m_linearDepth * m_bitsPerElement + 7) / 8;
+	m_tiledSizeBytes  = surfInfoOut.m_surfaceSize;
+
+	m_tileThickness  = getMicroTileThickness(m_arrayMode);
+	m_tileBytes      = (kNumMicroTilePixels * m_tileThickness * m_bitsPerElement * m_numFragmentsPerPixel + 7) / 8;
+	m_tileSplitBytes = surfInfoOut.m_tileSplitBytes;
+	m_numPipes       = surfInfoOut.m_numPipes;
+	m_pipeBits       = fastIntLog2(m_numPipes);
+	m_numBanks       = surfInfoOut.m_numBanks;
+	m_bankBits       = fastIntLog2(m_numBanks);
+	m_bankWidth      = surfInfoOut.m_bankWidth;
+	m_bankHeight     = surfInfoOut.m_bankHeight;
+
+	m_macroTileWidth     = kMicroTileWidth * m_bankWidth * m_numPipes * surfInfoOut.m_macroTileAspect;
+	m_macroTileHeight    = kMicroTileHeight * m_bankHeight * m_numBanks / surfInfoOut.m_macroTileAspect;
+	m_macroTilesPerRow   = m_paddedWidth / m_macroTileWidth;
+	m_macroTilesPerSlice = m_macroTilesPerRow * (m_paddedHeight / m_macroTileHeight);
+
+	// The tile swizzle holds the pipe and bank bits
+	// of the surface's base address, in 256 byte units.
+	m_pipeSwizzle = tp->m_tileSwizzleMask & (m_numPipes - 1);
+	m_bankSwizzle = (tp->m_tileSwizzleMask >> m_pipeBits) & (m_numBanks - 1);
+
+	m_splitTileBytes    = (m_tileBytes > m_tileSplitBytes && m_tileThickness == 1) ? m_tileSplitBytes : m_tileBytes;
+	m_splitSliceCount   = m_tileBytes / m_splitTileBytes;
+	m_tileSplitRotation = getTileSplitRotation(m_arrayMode, m_numBanks);
+	m_macroTileBytes    = uint64_t(m_bankWidth) * m_bankHeight * m_splitTileBytes;
+	m_sliceBytes        = m_macroTilesPerSlice * m_macroTileBytes;
+
+	// Each chunk of a micro tile is a run of consecutive elements. Only
+	// thin single-fragment tiles have the element order of the kernels.
+	m_chunkBytes = std::min(kPipeInterleaveBytes, m_splitTileBytes);
+	m_chunkCount = (m_tileThickness == 1 && m_numFragmentsPerPixel == 1) ? m_tileBytes / m_chunkBytes : 0;
+
+	// If any of these asserts failed, then computeSurfaceInfo() is not correct.
+	LOG_ASSERT_RETURN(m_numPipes != 0 && m_numBanks != 0, kStatusInternalTilingError, "internal consistency check failed.");
+	LOG_ASSERT_RETURN(m_paddedWidth % m_macroTileWidth == 0, kStatusInternalTilingError, "internal consistency check failed.");
+	LOG_ASSERT_RETURN(m_paddedHeight % m_macroTileHeight == 0, kStatusInternalTilingError, "internal consistency check failed.");
+	LOG_ASSERT_RETURN(m_paddedDepth % m_tileThickness == 0, kStatusInternalTilingError, "internal consistency check failed.");
+	return kStatusSuccess;
+}
+
+int32_t Tiler2d::detileSurface(void* outUntiledPixels, const void* tiledPixels)
+{
+	SurfaceRegion srcRegion;
+	srcRegion.m_left = srcRegion.m_top = srcRegion.m_front = 0;
+	srcRegion.m_right                                      = m_linearWidth;
+	srcRegion.m_bottom                                     = m_linearHeight;
+	srcRegion.m_back                                       = m_linearDepth;
+	return detileSurfaceRegion(outUntiledPixels, tiledPixels, &srcRegion, m_linearWidth, m_linearWidth * m_linearHeight);
+}
+
+int32_t Tiler2d::detileSurfaceRegion(void* outUntiledPixels, const void* inTiledPixels, const SurfaceRegion* srcRegion, uint32_t destPitch, uint32_t destSlicePitch)
+{
+	LOG_ASSERT_RETURN(outUntiledPixels != 0, kStatusInvalidArgument, "outUntiledPixels must not be NULL.");
+	LOG_ASSERT_RETURN(inTiledPixels != 0, kStatusInvalidArgument, "inTiledPixels must not be NULL.");
+	LOG_ASSERT_RETURN(srcRegion != 0, kStatusInvalidArgument, "srcRegion must not be NULL.");
+	const auto region = *srcRegion;
+	if (!hasTexels(region))
+		return kStatusSuccess;  // Zero-area region; nothing to do.
+	LOG_ASSERT_RETURN(region.m_right <= m_linearWidth, kStatusInvalidArgument, "srcRegion m_right (%u) must not exceed destination surface's width (%u).", region.m_right, m_linearWidth);
+	LOG_ASSERT_RETURN(region.m_bottom <= m_linearHeight, kStatusInvalidArgument, "srcRegion m_bottom (%u) must not exceed destination surface's height (%u).", region.m_bottom, m_linearHeight);
+	LOG_ASSERT_RETURN(region.m_back <= m_linearDepth, kStatusInvalidArgument, "srcRegion m_back (%u) must not exceed destination surface's depth (%u).", region.m_back, m_linearDepth);
+	LOG_ASSERT_RETURN(width(region) <= int(destPitch), kStatusInvalidArgument, "srcRegion width (%u) must not exceed destPitch (%u).", width(region), destPitch);
+	LOG_ASSERT_RETURN(width(region) * height(region) <= int(destSlicePitch), kStatusInvalidArgument, "srcRegion X*Y dimensions (%ux%u) must not exceed destSlicePitch (%u).", width(region), height(region), destSlicePitch);
+
+	const auto in_bytes        = static_cast<const uint8_t*>(inTiledPixels);
+	const auto out_bytes       = static_cast<uint8_t*>(outUntiledPixels);
+	const auto bytesPerElement = m_bitsPerElement / 8;
+
+	const auto detileFunc = m_chunkCount ? getDetileFunc(m_microTileMode, m_bitsPerElement) : nullptr;
+	if (nullptr != detileFunc && (intptr_t(in_bytes) % 16) == 0)
+	{
+		Regions regions;
+		regions.Init(region, m_tileThickness);
+		if (hasTexels(regions.m_aligned))
+		{
+			// Large enough for a thin 128bpp micro tile
+			alignas(16) uint8_t tileBuffer[kNumMicroTilePixels * 16];
+
+			// Address terms of each tile column are shared by all tile rows.
+			std::vector<TileTerm> columns;
+			for (auto x = 0; x < width(regions.m_aligned); x += kMicroTileWidth)
+				columns.push_back(getColumnTerm(regions.m_aligned.m_left + x));
+
+			const auto dx = regions.m_aligned.m_left - srcRegion->m_left;
+			const auto dy = regions.m_aligned.m_top - srcRegion->m_top;
+			const auto dz = regions.m_aligned.m_front - srcRegion->m_front;
+			for (auto z = 0; z < depth(regions.m_aligned); ++z)
+			{
+				const TileTerm slice = getSliceTerm(regions.m_aligned.m_front + z);
+				for (auto y = 0; y < height(regions.m_aligned); y += kMicroTileHeight)
+				{
+					const TileTerm row = getRowTerm(regions.m_aligned.m_top + y);
+
+					uint64_t outBaseOffset = 0;
+					computeLinearElementByteOffset(&outBaseOffset, dx + 0, dy + y, dz + z, 0, destPitch, destSlicePitch, m_bitsPerElement, 1);
+					for (const auto& column : columns)
+					{
+						const uint8_t* tile = gatherMicroTile(in_bytes, column, row, slice, tileBuffer);
+						detileFunc(out_bytes + outBaseOffset, tile, destPitch, destSlicePitch);
+						outBaseOffset += kMicroTileWidth * bytesPerElement;
+					}
+				}
+			}
+			for (auto i = 0; i < regions.m_unaligneds; ++i)
+				slowDetileOneFragment<Tiler2d>(this, region, regions.m_unaligned[i], 0, destPitch, destSlicePitch, out_bytes, in_bytes, bytesPerElement);
+			return kStatusSuccess;
+		}
+	}
+	slowDetileOneFragment<Tiler2d>(this, region, region, 0, destPitch, destSlicePitch, out_bytes, in_bytes, bytesPerElement);
+	return kStatusSuccess;
+}
+
+Tiler2d::TileTerm Tiler2d::getColumnTerm(uint32_t x) const
+{
+	uint32_t xh = x;
+	if (m_arrayMode == kArrayModeTiledThinPrt || m_arrayMode == kArrayModeTiledThickPrt)
+	{
+		xh %= m_macroTileWidth;
+	}
+
+	uint64_t macro_tile_column_index = x / m_macroTileWidth;
+	uint64_t tile_column_index       = ((x / kMicroTileWidth) / m_numPipes) % m_bankWidth;
+
+	TileTerm term;
+	term.m_offset = macro_tile_column_index * m_macroTileBytes + tile_column_index * m_splitTileBytes;
+	term.m_pipe   = getPipeIndex(xh, 0, m_pipeConfig);
+	term.m_bank   = getBankIndex(xh, 0, m_bankWidth, m_bankHeight, m_numBanks, m_numPipes);
+	return term;
+}
+
+Tiler2d::TileTerm Tiler2d::getRowTerm(uint32_t y) const
+{
+	uint32_t yh = y;
+	if (m_arrayMode == kArrayModeTiledThinPrt || m_arrayMode == kArrayModeTiledThickPrt)
+	{
+		yh %= m_macroTileHeight;
+	}
+
+	uint64_t macro_tile_row_index = y / m_macroTileHeight;
+	uint64_t tile_row_index       = (y / kMicroTileHeight) % m_bankHeight;
+
+	TileTerm term;
+	term.m_offset = macro_tile_row_index * m_macroTilesPerRow * m_macroTileBytes + tile_row_index * m_bankWidth * m_splitTileBytes;
+	term.m_pipe   = getPipeIndex(0, yh, m_pipeConfig);
+	term.m_bank   = getBankIndex(0, yh, m_bankWidth, m_bankHeight, m_numBanks, m_numPipes);
+	return term;
+}
+
+Tiler2d::TileTerm Tiler2d::getSliceTerm(uint32_t z) const
+{
+	uint32_t slice = z + m_arraySlice;
+
+	TileTerm term;
+	term.m_offset = uint64_t(m_splitSliceCount) * (z / m_tileThickness) * m_sliceBytes;
+	term.m_pipe   = m_pipeSwizzle + getPipeSliceRotation(m_arrayMode, m_numPipes, slice, m_tileThickness);
+	term.m_bank   = m_bankSwizzle + getBankSliceRotation(m_arrayMode, m_numBanks, m_numPipes, slice, m_tileThickness);
+	return term;
+}
+
+const uint8_t* Tiler2d::gatherMicroTile(const uint8_t* tiledBytes, const TileTerm& column, const TileTerm& row, const TileTerm& slice, uint8_t* tileBuffer) const
+{
+	const uint32_t pipeInterleaveBits = fastIntLog2(kPipeInterleaveBytes);
+
+	const uint64_t tileOffset = column.m_offset + row.m_offset + slice.m_offset;
+	const uint32_t pipe       = (column.m_pipe ^ row.m_pipe ^ slice.m_pipe) & (m_numPipes - 1);
+	const uint32_t bank       = column.m_bank ^ row.m_bank ^ slice.m_bank;
+
+	for (uint32_t i = 0; i < m_chunkCount; ++i)
+	{
+		// Chunks never cross the tile split, nor the pipe interleave.
+		uint32_t chunkOffset = i * m_chunkBytes;
+		uint32_t splitSlice  = chunkOffset / m_splitTileBytes;
+
+		uint64_t offset    = tileOffset + splitSlice * m_sliceBytes + chunkOffset % m_splitTileBytes;
+		uint64_t chunkBank = (bank ^ (splitSlice * m_tileSplitRotation)) & (m_numBanks - 1);
+
+		uint64_t byteOffset = (offset % kPipeInterleaveBytes) |
+							  (uint64_t(pipe) << pipeInterleaveBits) |
+							  (chunkBank << (pipeInterleaveBits + m_pipeBits)) |
+							  ((offset / kPipeInterleaveBytes) << (pipeInterleaveBits + m_pipeBits + m_bankBits));
+
+		if (m_chunkCount == 1)
+		{
+			// The whole micro tile is contiguous, detile it in place.
+			return tiledBytes + byteOffset;
+		}
+
+		memcpy(tileBuffer + chunkOffset, tiledBytes + byteOffset, m_chunkBytes);
+	}
+	return tileBuffer;
+}
+
+int32_t Tiler2d::getTiledElementByteOffset(uint64_t* outTiledByteOffset, uint32_t x, uint32_t y, uint32_t z, uint32_t fragmentIndex) const
+{
+	uint64_t bitOffset  = 0;
+	int32_t status      = getTiledElementBitOffset(&bitOffset, x, y, z, fragmentIndex);
+	*outTiledByteOffset = bitOffset / 8;
+	return status;
+}
+
+int32_t Tiler2d::getTiledElementBitOffset(uint64_t* outTiledBitOffset, uint32_t x, uint32_t y, uint32_t z, uint32_t fragmentIndex) const
+{
+	uint64_t element_index = getElementIndex(x, y, z, m_bitsPerElement, m_microTileMode, m_arrayMode);
+
+	uint32_t xh = x, yh = y;
+	if (m_arrayMode == kArrayModeTiledThinPrt || m_arrayMode == kArrayModeTiledThickPrt)
+	{
+		xh %= m_macroTileWidth;
+		yh %= m_macroTileHeight;
+	}
+	uint64_t pipe = getPipeIndex(xh, yh, m_pipeConfig);
+	uint64_t bank = getBankIndex(xh, yh, m_bankWidth, m_bankHeight, m_numBanks, m_numPipes);
+
+	uint64_t tile_bytes     = m_tileBytes;
+	uint64_t element_offset = 0;
+	if (m_microTileMode == kMicroTileModeDepth)
+	{
+		// Fragments of a pixel are stored next to each other
+		uint64_t pixel_offset = element_index * m_bitsPerElement * m_numFragmentsPerPixel;
+		element_offset        = pixel_offset + (fragmentIndex * m_bitsPerElement);
+	}
+	else
+	{
+		// Each fragment is a plane of its own
+		uint64_t fragment_offset = fragmentIndex * (tile_bytes / m_numFragmentsPerPixel) * 8;
+		element_offset           = fragment_offset + (element_index * m_bitsPerElement);
+	}
+
+	// Tiles larger than the tile split are spread over several slices.
+	uint64_t slices_per_tile  = 1;
+	uint64_t tile_split_slice = 0;
+	if (tile_bytes > m_tileSplitBytes && m_tileThickness == 1)
+	{
+		slices_per_tile  = tile_bytes / m_tileSplitBytes;
+		tile_split_slice = element_offset / (m_tileSplitBytes * 8);
+		element_offset %= (m_tileSplitBytes * 8);
+		tile_bytes = m_tileSplitBytes;
+	}
+
+	// Offsets below are within a single pipe and bank.
+	uint64_t macro_tile_bytes        = (m_macroTileWidth / kMicroTileWidth) * (m_macroTileHeight / kMicroTileHeight) * tile_bytes / (m_numPipes * m_numBanks);
+	uint64_t macro_tile_row_index    = y / m_macroTileHeight;
+	uint64_t macro_tile_column_index = x / m_macroTileWidth;
+	uint64_t macro_tile_index        = (macro_tile_row_index * m_macroTilesPerRow) + macro_tile_column_index;
+	uint64_t macro_tile_offset       = macro_tile_index * macro_tile_bytes;
+
+	uint64_t slice_bytes  = m_macroTilesPerSlice * macro_tile_bytes;
+	uint64_t slice_offset = (tile_split_slice + slices_per_tile * (z / m_tileThickness)) * slice_bytes;
+
+	uint64_t tile_row_index    = (y / kMicroTileHeight) % m_bankHeight;
+	uint64_t tile_column_index = ((x / kMicroTileWidth) / m_numPipes) % m_bankWidth;
+	uint64_t tile_index        = (tile_row_index * m_bankWidth) + tile_column_index;
+	uint64_t tile_offset       = tile_index * tile_bytes;
+
+	// Slices of array surfaces are detiled one by one,
+	// the rotation depends on the slice index in the array.
+	uint32_t slice = z + m_arraySlice;
+
+	uint64_t pipe_slice_rotation = getPipeSliceRotation(m_arrayMode, m_numPipes, slice, m_tileThickness);
+	pipe ^= (m_pipeSwizzle + pipe_slice_rotation) & (m_numPipes - 1);
+
+	uint64_t bank_slice_rotation       = getBankSliceRotation(m_arrayMode, m_numBanks, m_numPipes, slice, m_tileThickness);
+	uint64_t tile_split_slice_rotation = getTileSplitRotation(m_arrayMode, m_numBanks) * tile_split_slice;
+	bank ^= m_bankSwizzle + bank_slice_rotation;
+	bank ^= tile_split_slice_rotation;
+	bank &= (m_numBanks - 1);
+
+	// Put the pipe and bank bits between the pipe interleave
+	// offset and the rest of the offset.
+	uint64_t total_offset    = (slice_offset + macro_tile_offset + tile_offset) * 8 + element_offset;
+	uint64_t bit_offset      = total_offset & 0x7;
+	total_offset /= 8;
+	uint64_t pipe_interleave_offset = total_offset % kPipeInterleaveBytes;
+	uint64_t offset                 = total_offset / kPipeInterleaveBytes;
+	uint32_t pipe_interleave_bits   = fastIntLog2(kPipeInterleaveBytes);
+
+	uint64_t final_byte_offset = pipe_interleave_offset |
+								 (pipe << pipe_interleave_bits) |
+								 (bank << (pipe_interleave_bits + m_pipeBits)) |
+								 (offset << (pipe_interleave_bits + m_pipeBits + m_bankBits));
+
+	*outTiledBitOffset = (final_byte_offset * 8) | bit_offset;
+	return kStatusSuccess;
+}
+
 }  // namespace GpuAddress
\ No newline at end of file
@@ -56,6 +56,15 @@ public:
 		uint16_t m_unused : 15;
 	};
 	TileMode m_tileMode;
+
+	// Macro tile layout after alignment,
+	// only set for macro tiled array modes.
+	uint32_t m_numPipes;
+	uint32_t m_numBanks;
+	uint32_t m_bankWidth;
+	uint32_t m_bankHeight;
+	uint32_t m_macroTileAspect;
+	uint32_t m_tileSplitBytes;
 };
 
 class TilingParameters
@@ -84,6 +93,12 @@ public:
 
 class Tiler
 {
+public:
+	uint32_t getBitsPerElement() const
+	{
+		return m_bitsPerElement;
+	}
+
 protected:
 	GpuMode m_minGpuMode;
 	TileMode m_tileMode;
@@ -125,4 +140,74 @@ private:
 	uint32_t m_tilesPerSlice;
 };
 
+
+class Tiler2d : public Tiler
+{
+public:
+	Tiler2d();
+	explicit Tiler2d(const TilingParameters* tp);
+	~Tiler2d();
+
+	int32_t init(const TilingParameters* tp);
+
+	int32_t detileSurface(void* outUntiledPixels, const void* tiledPixels);
+
+	// Only fragment 0 is detiled from multi-sampled surfaces.
+	int32_t detileSurfaceRegion(void* outUntiledPixels, const void* tiledPixels, const SurfaceRegion* srcRegion, uint32_t destPitch, uint32_t destSlicePitch);
+
+	int32_t getTiledElementByteOffset(uint64_t* outTiledByteOffset, uint32_t x, uint32_t y, uint32_t z, uint32_t fragmentIndex) const;
+
+	int32_t getTiledElementBitOffset(uint64_t* outTiledBitOffset, uint32_t x, uint32_t y, uint32_t z, uint32_t fragmentIndex) const;
+
+private:
+	// Parts of a micro tile address which depend on only one of x, y or z.
+	// Pipe and bank bits combine by XOR, offsets by addition.
+	struct TileTerm
+	{
+		uint64_t m_offset;  // within a single pipe and bank
+		uint32_t m_pipe;
+		uint32_t m_bank;
+	};
+
+	TileTerm getColumnTerm(uint32_t x) const;
+	TileTerm getRowTerm(uint32_t y) const;
+	TileTerm getSliceTerm(uint32_t z) const;
+
+	const uint8_t* gatherMicroTile(const uint8_t* tiledBytes, const TileTerm& column, const TileTerm& row, const TileTerm& slice, uint8_t* tileBuffer) const;
+
+private:
+	MicroTileMode m_microTileMode;
+	PipeConfig m_pipeConfig;
+	uint32_t m_arraySlice;
+	uint32_t m_numFragmentsPerPixel;
+	uint32_t m_tileThickness;
+	uint32_t m_tileBytes;
+	uint32_t m_tileSplitBytes;
+	uint32_t m_numPipes;
+	uint32_t m_pipeBits;
+	uint32_t m_numBanks;
+	uint32_t m_bankBits;
+	uint32_t m_bankWidth;
+	uint32_t m_bankHeight;
+	uint32_t m_macroTileWidth;   // in elements
+	uint32_t m_macroTileHeight;  // in elements
+	uint32_t m_macroTilesPerRow;
+	uint32_t m_macroTilesPerSlice;
+	uint32_t m_pipeSwizzle;
+	uint32_t m_bankSwizzle;
+
+	// Micro tile layout after the tile split, per pipe and bank
+	uint32_t m_splitTileBytes;
+	uint32_t m_splitSliceCount;
+	uint32_t m_tileSplitRotation;
+	uint64_t m_macroTileBytes;
+	uint64_t m_sliceBytes;
+
+	// Pipe interleaving and tile splitting store a thin micro
+	// tile in m_chunkCount runs of m_chunkBytes, 0 if the
+	// micro tile kernels can't be used for the surface.
+	uint32_t m_chunkBytes;
+	uint32_t m_chunkCount;
+};
+
 }  // namespace GpuAddress
\ No newline at end of file
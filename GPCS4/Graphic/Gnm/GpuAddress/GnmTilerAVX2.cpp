@@ -0,0 +1,137 @@
+#include "GnmTilerAVX2.h"
+
+#include <immintrin.h>
+
+namespace GpuAddress
+{;
+
+// Thin micro tile element index bits, from low to high:
+// x0 y0 x1 y1 x2 y2
+// Each kernel moves whole groups of elements which are
+// contiguous in both the tiled and the linear layout.
+
+void detile8bppThinAvx2(void* __restrict destTileBase, const void* __restrict srcTileBase, const uint32_t destPitch, const uint32_t destSlicePitch)
+{
+	const __m256i* src32s         = (const __m256i*)srcTileBase;
+	uint8_t* destBytes            = (uint8_t*)destTileBase;
+	const uint32_t destPitchBytes = destPitch * sizeof(uint8_t);
+
+	// Gather the 4 bytes of each row within a 16 byte (x2, y2) block,
+	// then pair up the left and right halves of each row.
+	const __m256i rowShuffle = _mm256_setr_epi8(
+		0, 1, 4, 5, 2, 3, 6, 7, 8, 9, 12, 13, 10, 11, 14, 15,
+		0, 1, 4, 5, 2, 3, 6, 7, 8, 9, 12, 13, 10, 11, 14, 15);
+	const __m256i rowPermute = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+	for (uint32_t half = 0; half != 2; ++half)
+	{
+		__m256i rows = _mm256_loadu_si256(src32s + half);
+		rows         = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(rows, rowShuffle), rowPermute);
+
+		__m128i rows01 = _mm256_castsi256_si128(rows);
+		__m128i rows23 = _mm256_extracti128_si256(rows, 1);
+
+		uint8_t* dest = destBytes + half * 4 * destPitchBytes;
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dest + 0 * destPitchBytes), rows01);
+		_mm_storeh_pd(reinterpret_cast<double*>(dest + 1 * destPitchBytes), _mm_castsi128_pd(rows01));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dest + 2 * destPitchBytes), rows23);
+		_mm_storeh_pd(reinterpret_cast<double*>(dest + 3 * destPitchBytes), _mm_castsi128_pd(rows23));
+	}
+}
+
+void detile16bppThinAvx2(void* __restrict destTileBase, const void* __restrict srcTileBase, const uint32_t destPitch, const uint32_t destSlicePitch)
+{
+	const __m256i* src32s         = (const __m256i*)srcTileBase;
+	uint8_t* destBytes            = (uint8_t*)destTileBase;
+	const uint32_t destPitchBytes = destPitch * sizeof(uint16_t);
+
+	for (uint32_t half = 0; half != 2; ++half)
+	{
+		// Low 8 bytes of each lane hold y0 = 0, high 8 bytes y0 = 1.
+		__m256i left  = _mm256_shuffle_epi32(_mm256_loadu_si256(src32s + half * 2 + 0), _MM_SHUFFLE(3, 1, 2, 0));
+		__m256i right = _mm256_shuffle_epi32(_mm256_loadu_si256(src32s + half * 2 + 1), _MM_SHUFFLE(3, 1, 2, 0));
+
+		__m256i rows02 = _mm256_unpacklo_epi64(left, right);
+		__m256i rows13 = _mm256_unpackhi_epi64(left, right);
+
+		uint8_t* dest = destBytes + half * 4 * destPitchBytes;
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 0 * destPitchBytes), _mm256_castsi256_si128(rows02));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 1 * destPitchBytes), _mm256_castsi256_si128(rows13));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 2 * destPitchBytes), _mm256_extracti128_si256(rows02, 1));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 3 * destPitchBytes), _mm256_extracti128_si256(rows13, 1));
+	}
+}
+
+void detile32bppThinAvx2(void* __restrict destTileBase, const void* __restrict srcTileBase, const uint32_t destPitch, const uint32_t destSlicePitch)
+{
+	const __m128i* src16s         = (const __m128i*)srcTileBase;
+	uint8_t* destBytes            = (uint8_t*)destTileBase;
+	const uint32_t destPitchBytes = destPitch * sizeof(uint32_t);
+
+	// 16 byte blocks are indexed by x1 y1 x2 y2,
+	// with 2 elements of y0 = 0 in the low half and y0 = 1 in the high half.
+	for (uint32_t y2 = 0; y2 != 2; ++y2)
+	{
+		for (uint32_t y1 = 0; y1 != 2; ++y1)
+		{
+			uint32_t block = (y1 << 1) | (y2 << 3);
+
+			__m256i left  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src16s + block));
+			__m256i right = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src16s + block + 4));
+
+			__m256i row0 = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(left, right), _MM_SHUFFLE(3, 1, 2, 0));
+			__m256i row1 = _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(left, right), _MM_SHUFFLE(3, 1, 2, 0));
+
+			uint8_t* dest = destBytes + (y1 * 2 + y2 * 4) * destPitchBytes;
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + 0 * destPitchBytes), row0);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + 1 * destPitchBytes), row1);
+		}
+	}
+}
+
+void detile64bppThinAvx2(void* __restrict destTileBase, const void* __restrict srcTileBase, const uint32_t destPitch, const uint32_t destSlicePitch)
+{
+	const __m128i* src16s         = (const __m128i*)srcTileBase;
+	uint8_t* destBytes            = (uint8_t*)destTileBase;
+	const uint32_t destPitchBytes = destPitch * sizeof(uint64_t);
+
+	// 16 byte element pairs are indexed by y0 x1 y1 x2 y2.
+	for (uint32_t y2 = 0; y2 != 2; ++y2)
+	{
+		for (uint32_t y1 = 0; y1 != 2; ++y1)
+		{
+			for (uint32_t x2 = 0; x2 != 2; ++x2)
+			{
+				uint32_t pair = (y1 << 2) | (x2 << 3) | (y2 << 4);
+
+				__m256i left  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src16s + pair));
+				__m256i right = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src16s + pair + 2));
+
+				uint8_t* dest = destBytes + (y1 * 2 + y2 * 4) * destPitchBytes + x2 * 32;
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + 0 * destPitchBytes), _mm256_permute2x128_si256(left, right, 0x20));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + 1 * destPitchBytes), _mm256_permute2x128_si256(left, right, 0x31));
+			}
+		}
+	}
+}
+
+void detile128bppThinAvx2(void* __restrict destTileBase, const void* __restrict srcTileBase, const uint32_t destPitch, const uint32_t destSlicePitch)
+{
+	const __m128i* src16s         = (const __m128i*)srcTileBase;
+	uint8_t* destBytes            = (uint8_t*)destTileBase;
+	const uint32_t destPitchBytes = destPitch * sizeof(__m128i);
+
+	// Element pairs along x are contiguous, copy them as is.
+	for (uint32_t y = 0; y != 8; ++y)
+	{
+		for (uint32_t x = 0; x != 8; x += 2)
+		{
+			uint32_t elem = ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) | ((x & 4) << 2) | ((y & 4) << 3);
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(destBytes + y * destPitchBytes + x * 16),
+								_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src16s + elem)));
+		}
+	}
+}
+
+}  // namespace GpuAddress
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "GnmTilerSSE2.h"
+
+namespace GpuAddress
+{;
+
+// AVX2 versions of the thin micro tile kernels.
+// Defined in a separate translation unit built with AVX2 enabled,
+// only call them after checking CPU support.
+
+void detile8bppThinAvx2(void* __restrict destTileBase, const void* __restrict srcTileBase, const uint32_t destPitch, const uint32_t destSlicePitch);
+
+void detile16bppThinAvx2(void* __restrict destTileBase, const void* __restrict srcTileBase, const uint32_t destPitch, const uint32_t destSlicePitch);
+
+void detile32bppThinAvx2(void* __restrict destTileBase, const void* __restrict srcTileBase, const uint32_t destPitch, const uint32_t destSlicePitch);
+
+void detile64bppThinAvx2(void* __restrict destTileBase, const void* __restrict srcTileBase, const uint32_t destPitch, const uint32_t destSlicePitch);
+
+void detile128bppThinAvx2(void* __restrict destTileBase, const void* __restrict srcTileBase, const uint32_t destPitch, const uint32_t destSlicePitch);
+
+}  // namespace GpuAddress
@@ -21,14 +21,14 @@ GCNAnalyzer::~GCNAnalyzer()
 {
 }
 
-void GCNAnalyzer::processInstruction(GCNInstruction& ins)
+void GCNAnalyzer::processInstruction(const GCNInstruction& ins)
 {
 	analyzeInstruction(ins);
 
 	updateProgramCounter(ins);
 }
 
-void GCNAnalyzer::analyzeInstruction(GCNInstruction& ins)
+void GCNAnalyzer::analyzeInstruction(const GCNInstruction& ins)
 {
 	auto insClass = ins.instruction->GetInstructionClass();
 
@@ -188,7 +188,7 @@ void GCNAnalyzer::analyzeInstruction(GCNInstruction& ins)
 	}
 }
 
-void GCNAnalyzer::getExportInfo(GCNInstruction& ins)
+void GCNAnalyzer::getExportInfo(const GCNInstruction& ins)
 {
 	auto inst = asInst<EXPInstruction>(ins);
 
@@ -224,7 +224,7 @@ void GCNAnalyzer::getExportInfo(GCNInstruction& ins)
 	m_analysis->expParams.push_back(info);
 }
 
-void GCNAnalyzer::getVinterpInfo(GCNInstruction& ins)
+void GCNAnalyzer::getVinterpInfo(const GCNInstruction& ins)
 {
 	auto inst = asInst<SIVINTRPInstruction>(ins);
 
@@ -234,7 +234,7 @@ void GCNAnalyzer::getVinterpInfo(GCNInstruction& ins)
 	m_analysis->vinterpAttrCount = m_vinterpAttrSet.size();
 }
 
-void GCNAnalyzer::collectBranchLabel(GCNInstruction& ins)
+void GCNAnalyzer::collectBranchLabel(const GCNInstruction& ins)
 {
 	// TODO:
 	// Support s_cbranch_i_fork, s_cbranch_g_fork s_cbranch_join and etc..
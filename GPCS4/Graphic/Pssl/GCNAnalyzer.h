@@ -41,14 +41,14 @@ public:
 	GCNAnalyzer(GcnAnalysisInfo& analysis);
 	virtual ~GCNAnalyzer();
 
-	virtual void processInstruction(GCNInstruction& ins);
+	virtual void processInstruction(const GCNInstruction& ins);
 
 private:
-	void analyzeInstruction(GCNInstruction& ins);
+	void analyzeInstruction(const GCNInstruction& ins);
 
-	void getExportInfo(GCNInstruction& ins);
-	void getVinterpInfo(GCNInstruction& ins);
-	void collectBranchLabel(GCNInstruction& ins);
+	void getExportInfo(const GCNInstruction& ins);
+	void getVinterpInfo(const GCNInstruction& ins);
+	void collectBranchLabel(const GCNInstruction& ins);
 private:
 	GcnAnalysisInfo* m_analysis = nullptr;
 
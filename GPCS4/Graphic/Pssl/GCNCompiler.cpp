@@ -47,7 +47,7 @@ GCNCompiler::~GCNCompiler()
 {
 }
 
-void GCNCompiler::processInstruction(GCNInstruction& ins)
+void GCNCompiler::processInstruction(const GCNInstruction& ins)
 {
 	emitBranchLabelTry();
 
@@ -56,7 +56,7 @@ void GCNCompiler::processInstruction(GCNInstruction& ins)
 	updateProgramCounter(ins);
 }
 
-void GCNCompiler::compileInstruction(GCNInstruction& ins)
+void GCNCompiler::compileInstruction(const GCNInstruction& ins)
 {
 	Instruction::InstructionCategory insCategory = ins.instruction->GetInstructionCategory();
 
@@ -121,9 +121,13 @@ RcPtr<vlt::VltShader> GCNCompiler::finalize()
 						   m_entryPointInterfaces.data());
 	m_module.setDebugName(m_entryPointId, "main");
 
+	// Clean up the register loads and stores
+	// before the driver has to deal with them.
+	SpirvOptimizer optimizer(SpirvOptimizer::getDefaultPasses());
+
 	return new vlt::VltShader(
 		m_programInfo.shaderStage(),
-		m_module.compile(),
+		optimizer.optimize(m_module.compile()),
 		m_programInfo.key(),
 		std::move(m_resourceSlots));
 }
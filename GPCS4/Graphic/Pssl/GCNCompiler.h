@@ -29,6 +29,7 @@
 #include "../Violet/VltShader.h"
 #include "../Violet/VltPipelineLayout.h"
 #include "../SpirV/SpirvModule.h"
+#include "../SpirV/SpirvOptimizer.h"
 
 #include <optional>
 #include <map>
@@ -125,13 +126,13 @@ public:
 		const GcnShaderInput& shaderInput);
 	~GCNCompiler();
 
-	virtual void processInstruction(GCNInstruction& ins);
+	virtual void processInstruction(const GCNInstruction& ins);
 
 	RcPtr<vlt::VltShader> finalize();
 
 private:
 
-	void compileInstruction(GCNInstruction& ins);
+	void compileInstruction(const GCNInstruction& ins);
 
 	void emitInit();
 	/////////////////////////////////
@@ -362,114 +363,114 @@ private:
 
 	/////////////////////////////////////////////////////////
 	// Category handlers
-	void emitScalarALU(GCNInstruction& ins);
-	void emitScalarMemory(GCNInstruction& ins);
-	void emitVectorALU(GCNInstruction& ins);
-	void emitVectorMemory(GCNInstruction& ins);
-	void emitFlowControl(GCNInstruction& ins);
-	void emitDataShare(GCNInstruction& ins);
-	void emitVectorInterpolation(GCNInstruction& ins);
-	void emitExport(GCNInstruction& ins);
-	void emitDebugProfile(GCNInstruction& ins);
+	void emitScalarALU(const GCNInstruction& ins);
+	void emitScalarMemory(const GCNInstruction& ins);
+	void emitVectorALU(const GCNInstruction& ins);
+	void emitVectorMemory(const GCNInstruction& ins);
+	void emitFlowControl(const GCNInstruction& ins);
+	void emitDataShare(const GCNInstruction& ins);
+	void emitVectorInterpolation(const GCNInstruction& ins);
+	void emitExport(const GCNInstruction& ins);
+	void emitDebugProfile(const GCNInstruction& ins);
 
 	// ScalarALU
-	void emitScalarArith(GCNInstruction& ins);
-	void emitScalarAbs(GCNInstruction& ins);
-	void emitScalarMov(GCNInstruction& ins);
-	void emitScalarCmp(GCNInstruction& ins);
-	void emitScalarSelect(GCNInstruction& ins);
-	void emitScalarBitLogic(GCNInstruction& ins);
-	void emitScalarBitManip(GCNInstruction& ins);
-	void emitScalarBitField(GCNInstruction& ins);
-	void emitScalarConv(GCNInstruction& ins);
-	void emitScalarExecMask(GCNInstruction& ins);
-	void emitScalarQuadMask(GCNInstruction& ins);
+	void emitScalarArith(const GCNInstruction& ins);
+	void emitScalarAbs(const GCNInstruction& ins);
+	void emitScalarMov(const GCNInstruction& ins);
+	void emitScalarCmp(const GCNInstruction& ins);
+	void emitScalarSelect(const GCNInstruction& ins);
+	void emitScalarBitLogic(const GCNInstruction& ins);
+	void emitScalarBitManip(const GCNInstruction& ins);
+	void emitScalarBitField(const GCNInstruction& ins);
+	void emitScalarConv(const GCNInstruction& ins);
+	void emitScalarExecMask(const GCNInstruction& ins);
+	void emitScalarQuadMask(const GCNInstruction& ins);
 
 	// VectorALU
-	void emitVectorRegMov(GCNInstruction& ins);
-	void emitVectorLane(GCNInstruction& ins);
-	void emitVectorBitLogic(GCNInstruction& ins);
-	void emitVectorBitField32(GCNInstruction& ins);
-	void emitVectorThreadMask(GCNInstruction& ins);
-	void emitVectorBitField64(GCNInstruction& ins);
-	void emitVectorFpArith32(GCNInstruction& ins);
-	void emitVectorFpRound32(GCNInstruction& ins);
-	void emitVectorFpField32(GCNInstruction& ins);
-	void emitVectorFpTran32(GCNInstruction& ins);
-	void emitVectorFpCmp32(GCNInstruction& ins);
-	void emitVectorFpArith64(GCNInstruction& ins);
-	void emitVectorFpRound64(GCNInstruction& ins);
-	void emitVectorFpField64(GCNInstruction& ins);
-	void emitVectorFpTran64(GCNInstruction& ins);
-	void emitVectorFpCmp64(GCNInstruction& ins);
-	void emitVectorIntArith32(GCNInstruction& ins);
-	void emitVectorIntArith64(GCNInstruction& ins);
-	void emitVectorIntCmp32(GCNInstruction& ins);
-	void emitVectorIntCmp64(GCNInstruction& ins);
-	void emitVectorConv(GCNInstruction& ins);
-	void emitVectorFpGraph32(GCNInstruction& ins);
-	void emitVectorIntGraph(GCNInstruction& ins);
-	void emitVectorMisc(GCNInstruction& ins);
+	void emitVectorRegMov(const GCNInstruction& ins);
+	void emitVectorLane(const GCNInstruction& ins);
+	void emitVectorBitLogic(const GCNInstruction& ins);
+	void emitVectorBitField32(const GCNInstruction& ins);
+	void emitVectorThreadMask(const GCNInstruction& ins);
+	void emitVectorBitField64(const GCNInstruction& ins);
+	void emitVectorFpArith32(const GCNInstruction& ins);
+	void emitVectorFpRound32(const GCNInstruction& ins);
+	void emitVectorFpField32(const GCNInstruction& ins);
+	void emitVectorFpTran32(const GCNInstruction& ins);
+	void emitVectorFpCmp32(const GCNInstruction& ins);
+	void emitVectorFpArith64(const GCNInstruction& ins);
+	void emitVectorFpRound64(const GCNInstruction& ins);
+	void emitVectorFpField64(const GCNInstruction& ins);
+	void emitVectorFpTran64(const GCNInstruction& ins);
+	void emitVectorFpCmp64(const GCNInstruction& ins);
+	void emitVectorIntArith32(const GCNInstruction& ins);
+	void emitVectorIntArith64(const GCNInstruction& ins);
+	void emitVectorIntCmp32(const GCNInstruction& ins);
+	void emitVectorIntCmp64(const GCNInstruction& ins);
+	void emitVectorConv(const GCNInstruction& ins);
+	void emitVectorFpGraph32(const GCNInstruction& ins);
+	void emitVectorIntGraph(const GCNInstruction& ins);
+	void emitVectorMisc(const GCNInstruction& ins);
 
 	// FlowControl
-	void emitScalarProgFlow(GCNInstruction& ins);
-	void emitScalarSync(GCNInstruction& ins);
-	void emitScalarWait(GCNInstruction& ins);
-	void emitScalarCache(GCNInstruction& ins);
-	void emitScalarPrior(GCNInstruction& ins);
-	void emitScalarRegAccess(GCNInstruction& ins);
-	void emitScalarMsg(GCNInstruction& ins);
+	void emitScalarProgFlow(const GCNInstruction& ins);
+	void emitScalarSync(const GCNInstruction& ins);
+	void emitScalarWait(const GCNInstruction& ins);
+	void emitScalarCache(const GCNInstruction& ins);
+	void emitScalarPrior(const GCNInstruction& ins);
+	void emitScalarRegAccess(const GCNInstruction& ins);
+	void emitScalarMsg(const GCNInstruction& ins);
 
 	// ScalarMemory
-	void emitScalarMemRd(GCNInstruction& ins);
-	void emitScalarMemUt(GCNInstruction& ins);
+	void emitScalarMemRd(const GCNInstruction& ins);
+	void emitScalarMemUt(const GCNInstruction& ins);
 
 	// VectorMemory
-	void emitVectorMemBufNoFmt(GCNInstruction& ins);
-	void emitVectorMemBufFmt(GCNInstruction& ins);
-	void emitVectorMemImgNoSmp(GCNInstruction& ins);
-	void emitVectorMemImgSmp(GCNInstruction& ins);
-	void emitVectorMemImgUt(GCNInstruction& ins);
-	void emitVectorMemL1Cache(GCNInstruction& ins);
+	void emitVectorMemBufNoFmt(const GCNInstruction& ins);
+	void emitVectorMemBufFmt(const GCNInstruction& ins);
+	void emitVectorMemImgNoSmp(const GCNInstruction& ins);
+	void emitVectorMemImgSmp(const GCNInstruction& ins);
+	void emitVectorMemImgUt(const GCNInstruction& ins);
+	void emitVectorMemL1Cache(const GCNInstruction& ins);
 
 	// DataShare
-	void emitDsIdxRd(GCNInstruction& ins);
-	void emitDsIdxWr(GCNInstruction& ins);
-	void emitDsIdxWrXchg(GCNInstruction& ins);
-	void emitDsIdxCondXchg(GCNInstruction& ins);
-	void emitDsIdxWrap(GCNInstruction& ins);
-	void emitDsAtomicArith32(GCNInstruction& ins);
-	void emitDsAtomicArith64(GCNInstruction& ins);
-	void emitDsAtomicMinMax32(GCNInstruction& ins);
-	void emitDsAtomicMinMax64(GCNInstruction& ins);
-	void emitDsAtomicCmpSt32(GCNInstruction& ins);
-	void emitDsAtomicCmpSt64(GCNInstruction& ins);
-	void emitDsAtomicLogic32(GCNInstruction& ins);
-	void emitDsAtomicLogic64(GCNInstruction& ins);
-	void emitDsAppendCon(GCNInstruction& ins);
-	void emitDsDataShareUt(GCNInstruction& ins);
-	void emitDsDataShareMisc(GCNInstruction& ins);
-	void emitGdsSync(GCNInstruction& ins);
-	void emitGdsOrdCnt(GCNInstruction& ins);
+	void emitDsIdxRd(const GCNInstruction& ins);
+	void emitDsIdxWr(const GCNInstruction& ins);
+	void emitDsIdxWrXchg(const GCNInstruction& ins);
+	void emitDsIdxCondXchg(const GCNInstruction& ins);
+	void emitDsIdxWrap(const GCNInstruction& ins);
+	void emitDsAtomicArith32(const GCNInstruction& ins);
+	void emitDsAtomicArith64(const GCNInstruction& ins);
+	void emitDsAtomicMinMax32(const GCNInstruction& ins);
+	void emitDsAtomicMinMax64(const GCNInstruction& ins);
+	void emitDsAtomicCmpSt32(const GCNInstruction& ins);
+	void emitDsAtomicCmpSt64(const GCNInstruction& ins);
+	void emitDsAtomicLogic32(const GCNInstruction& ins);
+	void emitDsAtomicLogic64(const GCNInstruction& ins);
+	void emitDsAppendCon(const GCNInstruction& ins);
+	void emitDsDataShareUt(const GCNInstruction& ins);
+	void emitDsDataShareMisc(const GCNInstruction& ins);
+	void emitGdsSync(const GCNInstruction& ins);
+	void emitGdsOrdCnt(const GCNInstruction& ins);
 
 	// VectorInterpolation
-	void emitVectorInterpFpCache(GCNInstruction& ins);
+	void emitVectorInterpFpCache(const GCNInstruction& ins);
 
 	// Export
-	void emitExp(GCNInstruction& ins);
+	void emitExp(const GCNInstruction& ins);
 
 	// DebugProfile
-	void emitDbgProf(GCNInstruction& ins);
+	void emitDbgProf(const GCNInstruction& ins);
 
 	// Extra dispatch functions
 
-	void emitScalarProgFlowPC(GCNInstruction& ins);
-	void emitScalarProgFlowBranch(GCNInstruction& ins);
+	void emitScalarProgFlowPC(const GCNInstruction& ins);
+	void emitScalarProgFlowBranch(const GCNInstruction& ins);
 
-	SpirvRegisterValue emitExpSrcLoadCompr(GCNInstruction& ins);
-	SpirvRegisterValue emitExpSrcLoadNoCompr(GCNInstruction& ins);
-	void emitExpVS(GCNInstruction& ins);
-	void emitExpPS(GCNInstruction& ins);
+	SpirvRegisterValue emitExpSrcLoadCompr(const GCNInstruction& ins);
+	SpirvRegisterValue emitExpSrcLoadNoCompr(const GCNInstruction& ins);
+	void emitExpVS(const GCNInstruction& ins);
+	void emitExpPS(const GCNInstruction& ins);
 
 	void emitScalarMemBufferLoad(
 		uint32_t bufferId, 
@@ -507,10 +508,10 @@ private:
 
 	// Convenient when used with opcodes with may have
 	// different encodings. e.g. V_MAC_F32 [VOP2|VOP3]
-	uint32_t getVopOpcode(GCNInstruction& ins);
+	uint32_t getVopOpcode(const GCNInstruction& ins);
 
 	void getVopOperands(
-		GCNInstruction& ins,
+		const GCNInstruction& ins,
 		uint32_t* vdst, uint32_t* vdstRidx,
 		uint32_t* src0, uint32_t* src0Ridx,
 		uint32_t* src1 = nullptr, uint32_t* src1Ridx = nullptr,
@@ -5,98 +5,98 @@ LOG_CHANNEL(Graphic.Pssl.GCNCompilerDataShare);
 namespace pssl
 {;
 
-void GCNCompiler::emitDataShare(GCNInstruction& ins)
+void GCNCompiler::emitDataShare(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
 
-void GCNCompiler::emitDsIdxRd(GCNInstruction& ins)
+void GCNCompiler::emitDsIdxRd(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitDsIdxWr(GCNInstruction& ins)
+void GCNCompiler::emitDsIdxWr(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitDsIdxWrXchg(GCNInstruction& ins)
+void GCNCompiler::emitDsIdxWrXchg(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitDsIdxCondXchg(GCNInstruction& ins)
+void GCNCompiler::emitDsIdxCondXchg(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitDsIdxWrap(GCNInstruction& ins)
+void GCNCompiler::emitDsIdxWrap(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitDsAtomicArith32(GCNInstruction& ins)
+void GCNCompiler::emitDsAtomicArith32(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitDsAtomicArith64(GCNInstruction& ins)
+void GCNCompiler::emitDsAtomicArith64(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitDsAtomicMinMax32(GCNInstruction& ins)
+void GCNCompiler::emitDsAtomicMinMax32(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitDsAtomicMinMax64(GCNInstruction& ins)
+void GCNCompiler::emitDsAtomicMinMax64(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitDsAtomicCmpSt32(GCNInstruction& ins)
+void GCNCompiler::emitDsAtomicCmpSt32(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitDsAtomicCmpSt64(GCNInstruction& ins)
+void GCNCompiler::emitDsAtomicCmpSt64(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitDsAtomicLogic32(GCNInstruction& ins)
+void GCNCompiler::emitDsAtomicLogic32(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitDsAtomicLogic64(GCNInstruction& ins)
+void GCNCompiler::emitDsAtomicLogic64(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitDsAppendCon(GCNInstruction& ins)
+void GCNCompiler::emitDsAppendCon(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitDsDataShareUt(GCNInstruction& ins)
+void GCNCompiler::emitDsDataShareUt(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitDsDataShareMisc(GCNInstruction& ins)
+void GCNCompiler::emitDsDataShareMisc(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitGdsSync(GCNInstruction& ins)
+void GCNCompiler::emitGdsSync(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitGdsOrdCnt(GCNInstruction& ins)
+void GCNCompiler::emitGdsOrdCnt(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
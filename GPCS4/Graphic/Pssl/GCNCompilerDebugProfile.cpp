@@ -6,12 +6,12 @@ namespace pssl
 {;
 
 
-void GCNCompiler::emitDebugProfile(GCNInstruction& ins)
+void GCNCompiler::emitDebugProfile(const GCNInstruction& ins)
 {
 	emitDbgProf(ins);
 }
 
-void GCNCompiler::emitDbgProf(GCNInstruction& ins)
+void GCNCompiler::emitDbgProf(const GCNInstruction& ins)
 {
 	auto inst = asInst<SISOPPInstruction>(ins);
 	auto op = inst->GetOp();
@@ -4,12 +4,12 @@ namespace pssl
 {;
 
 
-void GCNCompiler::emitExport(GCNInstruction& ins)
+void GCNCompiler::emitExport(const GCNInstruction& ins)
 {
 	emitExp(ins);
 }
 
-void GCNCompiler::emitExp(GCNInstruction& ins)
+void GCNCompiler::emitExp(const GCNInstruction& ins)
 {
 	auto shaderType = m_programInfo.shaderType();
 	switch (shaderType)
@@ -25,7 +25,7 @@ void GCNCompiler::emitExp(GCNInstruction& ins)
 	}
 }
 
-SpirvRegisterValue GCNCompiler::emitExpSrcLoadCompr(GCNInstruction& ins)
+SpirvRegisterValue GCNCompiler::emitExpSrcLoadCompr(const GCNInstruction& ins)
 {
 	auto inst = asInst<EXPInstruction>(ins);
 	auto en   = inst->GetEn();
@@ -63,7 +63,7 @@ SpirvRegisterValue GCNCompiler::emitExpSrcLoadCompr(GCNInstruction& ins)
 	return result;
 }
 
-SpirvRegisterValue GCNCompiler::emitExpSrcLoadNoCompr(GCNInstruction& ins)
+SpirvRegisterValue GCNCompiler::emitExpSrcLoadNoCompr(const GCNInstruction& ins)
 {
 	auto inst = asInst<EXPInstruction>(ins);
 	auto en   = inst->GetEn();
@@ -101,7 +101,7 @@ SpirvRegisterValue GCNCompiler::emitExpSrcLoadNoCompr(GCNInstruction& ins)
 	return result;
 }
 
-void GCNCompiler::emitExpVS(GCNInstruction& ins)
+void GCNCompiler::emitExpVS(const GCNInstruction& ins)
 {
 	auto inst = asInst<EXPInstruction>(ins);
 
@@ -143,7 +143,7 @@ void GCNCompiler::emitExpVS(GCNInstruction& ins)
 	emitValueStore(dst, src, en);
 }
 
-void GCNCompiler::emitExpPS(GCNInstruction& ins)
+void GCNCompiler::emitExpPS(const GCNInstruction& ins)
 {
 	auto inst = asInst<EXPInstruction>(ins);
 
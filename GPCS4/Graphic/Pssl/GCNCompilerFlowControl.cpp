@@ -5,7 +5,7 @@ LOG_CHANNEL(Graphic.Pssl.GCNCompilerFlowControl);
 namespace pssl
 {;
 
-void GCNCompiler::emitFlowControl(GCNInstruction& ins)
+void GCNCompiler::emitFlowControl(const GCNInstruction& ins)
 {
 	Instruction::InstructionClass insClass = ins.instruction->GetInstructionClass();
 
@@ -66,7 +66,7 @@ void GCNCompiler::emitBranchLabelTry()
 	} while (false);
 }
 
-void GCNCompiler::emitScalarProgFlow(GCNInstruction& ins)
+void GCNCompiler::emitScalarProgFlow(const GCNInstruction& ins)
 {
 	// Program Flow instructions have many encodings.
 	// We need to determine the encoding first
@@ -135,7 +135,7 @@ void GCNCompiler::emitScalarProgFlow(GCNInstruction& ins)
 	}
 }
 
-void GCNCompiler::emitScalarProgFlowPC(GCNInstruction& ins)
+void GCNCompiler::emitScalarProgFlowPC(const GCNInstruction& ins)
 {
 	auto inst = asInst<SISOP1Instruction>(ins);
 	auto op = inst->GetOp();
@@ -167,7 +167,7 @@ void GCNCompiler::emitScalarProgFlowPC(GCNInstruction& ins)
 	}
 }
 
-void GCNCompiler::emitScalarProgFlowBranch(GCNInstruction& ins)
+void GCNCompiler::emitScalarProgFlowBranch(const GCNInstruction& ins)
 {
 	// This function is paired with emitBranchLabelTry
 
@@ -245,7 +245,7 @@ void GCNCompiler::emitScalarProgFlowBranch(GCNInstruction& ins)
 	}
 }
 
-void GCNCompiler::emitScalarSync(GCNInstruction& ins)
+void GCNCompiler::emitScalarSync(const GCNInstruction& ins)
 {
 	auto inst = asInst<SISOPPInstruction>(ins);
 	auto op = inst->GetOp();
@@ -260,27 +260,27 @@ void GCNCompiler::emitScalarSync(GCNInstruction& ins)
 	}
 }
 
-void GCNCompiler::emitScalarWait(GCNInstruction& ins)
+void GCNCompiler::emitScalarWait(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitScalarCache(GCNInstruction& ins)
+void GCNCompiler::emitScalarCache(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitScalarPrior(GCNInstruction& ins)
+void GCNCompiler::emitScalarPrior(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitScalarRegAccess(GCNInstruction& ins)
+void GCNCompiler::emitScalarRegAccess(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitScalarMsg(GCNInstruction& ins)
+void GCNCompiler::emitScalarMsg(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
@@ -8,7 +8,7 @@ LOG_CHANNEL(Graphic.Pssl.GCNCompilerScalarALU);
 namespace pssl
 {;
 
-void GCNCompiler::emitScalarALU(GCNInstruction& ins)
+void GCNCompiler::emitScalarALU(const GCNInstruction& ins)
 {
 	Instruction::InstructionClass insClass = ins.instruction->GetInstructionClass();
 
@@ -154,7 +154,7 @@ void GCNCompiler::getSopOperands(
 	}
 }
 
-void GCNCompiler::emitScalarMov(GCNInstruction& ins)
+void GCNCompiler::emitScalarMov(const GCNInstruction& ins)
 {
 	auto inst = asInst<SISOP1Instruction>(ins);
 	auto op = inst->GetOp();
@@ -184,7 +184,7 @@ void GCNCompiler::emitScalarMov(GCNInstruction& ins)
 	}
 }
 
-void GCNCompiler::emitScalarArith(GCNInstruction& ins)
+void GCNCompiler::emitScalarArith(const GCNInstruction& ins)
 {
 	uint32_t op = getSopOpcode(ins);
 
@@ -227,22 +227,22 @@ void GCNCompiler::emitScalarArith(GCNInstruction& ins)
 	emitStoreScalarOperand(sdst, sdstRidx, dstVal);
 }
 
-void GCNCompiler::emitScalarAbs(GCNInstruction& ins)
+void GCNCompiler::emitScalarAbs(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitScalarCmp(GCNInstruction& ins)
+void GCNCompiler::emitScalarCmp(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitScalarSelect(GCNInstruction& ins)
+void GCNCompiler::emitScalarSelect(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitScalarBitLogic(GCNInstruction& ins)
+void GCNCompiler::emitScalarBitLogic(const GCNInstruction& ins)
 {
 	
 	uint32_t op = getSopOpcode(ins);
@@ -299,27 +299,27 @@ void GCNCompiler::emitScalarBitLogic(GCNInstruction& ins)
 	emitStoreScalarOperand(sdst, sdstRidx, dstVal);
 }
 
-void GCNCompiler::emitScalarBitManip(GCNInstruction& ins)
+void GCNCompiler::emitScalarBitManip(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitScalarBitField(GCNInstruction& ins)
+void GCNCompiler::emitScalarBitField(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitScalarConv(GCNInstruction& ins)
+void GCNCompiler::emitScalarConv(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitScalarExecMask(GCNInstruction& ins)
+void GCNCompiler::emitScalarExecMask(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitScalarQuadMask(GCNInstruction& ins)
+void GCNCompiler::emitScalarQuadMask(const GCNInstruction& ins)
 {
 	auto inst = asInst<SISOP1Instruction>(ins);
 	auto op = inst->GetOp();
@@ -5,7 +5,7 @@ LOG_CHANNEL(Graphic.Pssl.GCNCompilerScalarMemory);
 namespace pssl
 {;
 
-void GCNCompiler::emitScalarMemory(GCNInstruction& ins)
+void GCNCompiler::emitScalarMemory(const GCNInstruction& ins)
 {
 	Instruction::InstructionClass insClass = ins.instruction->GetInstructionClass();
 
@@ -55,7 +55,7 @@ void GCNCompiler::emitScalarMemBufferLoad(
 	emitSgprArrayStore(dstRegStart, valueArray.data(), valueArray.size());
 }
 
-void GCNCompiler::emitScalarMemRd(GCNInstruction& ins)
+void GCNCompiler::emitScalarMemRd(const GCNInstruction& ins)
 {
 	auto inst = asInst<SISMRDInstruction>(ins);
 
@@ -102,7 +102,7 @@ void GCNCompiler::emitScalarMemRd(GCNInstruction& ins)
 	}
 }
 
-void GCNCompiler::emitScalarMemUt(GCNInstruction& ins)
+void GCNCompiler::emitScalarMemUt(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
@@ -8,7 +8,7 @@ namespace pssl
 {
 ;
 
-void GCNCompiler::emitVectorALU(GCNInstruction& ins)
+void GCNCompiler::emitVectorALU(const GCNInstruction& ins)
 {
 	Instruction::InstructionClass insClass = ins.instruction->GetInstructionClass();
 
@@ -202,7 +202,7 @@ bool GCNCompiler::isVop3Encoding(const GCNInstruction& ins)
 	return ins.instruction->GetInstructionFormat() == Instruction::InstructionSet_VOP3;
 }
 
-uint32_t GCNCompiler::getVopOpcode(GCNInstruction& ins)
+uint32_t GCNCompiler::getVopOpcode(const GCNInstruction& ins)
 {
 	uint32_t op   = 0;
 	auto encoding = ins.instruction->GetInstructionFormat();
@@ -239,7 +239,7 @@ uint32_t GCNCompiler::getVopOpcode(GCNInstruction& ins)
 }
 
 void GCNCompiler::getVopOperands(
-	GCNInstruction& ins,
+	const GCNInstruction& ins,
 	uint32_t* vdst, uint32_t* vdstRidx,
 	uint32_t* src0, uint32_t* src0Ridx,
 	uint32_t* src1 /*= nullptr*/, uint32_t* src1Ridx /*= nullptr*/,
@@ -299,7 +299,7 @@ void GCNCompiler::getVopOperands(
 	}
 }
 
-void GCNCompiler::emitVectorRegMov(GCNInstruction& ins)
+void GCNCompiler::emitVectorRegMov(const GCNInstruction& ins)
 {
 	uint32_t op = getVopOpcode(ins);
 
@@ -339,12 +339,12 @@ void GCNCompiler::emitVectorRegMov(GCNInstruction& ins)
 	emitStoreVectorOperand(didx, dstVal);
 }
 
-void GCNCompiler::emitVectorLane(GCNInstruction& ins)
+void GCNCompiler::emitVectorLane(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitVectorBitLogic(GCNInstruction& ins)
+void GCNCompiler::emitVectorBitLogic(const GCNInstruction& ins)
 {
 	uint32_t op       = getVopOpcode(ins);
 	uint32_t src0     = 0;
@@ -389,7 +389,7 @@ void GCNCompiler::emitVectorBitLogic(GCNInstruction& ins)
 	emitStoreVectorOperand(dstRIdx, dstVal);
 }
 
-void GCNCompiler::emitVectorBitField32(GCNInstruction& ins)
+void GCNCompiler::emitVectorBitField32(const GCNInstruction& ins)
 {
 	uint32_t op       = getVopOpcode(ins);
 	uint32_t src0     = 0;
@@ -442,7 +442,7 @@ void GCNCompiler::emitVectorBitField32(GCNInstruction& ins)
 	emitStoreVectorOperand(dstRIdx, dstVal);
 }
 
-void GCNCompiler::emitVectorThreadMask(GCNInstruction& ins)
+void GCNCompiler::emitVectorThreadMask(const GCNInstruction& ins)
 {
 	uint32_t op       = getVopOpcode(ins);
 	uint32_t src0     = 0;
@@ -499,12 +499,12 @@ void GCNCompiler::emitVectorThreadMask(GCNInstruction& ins)
 	emitStoreVectorOperand(dstRIdx, dstVal);
 }
 
-void GCNCompiler::emitVectorBitField64(GCNInstruction& ins)
+void GCNCompiler::emitVectorBitField64(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitVectorFpArith32(GCNInstruction& ins)
+void GCNCompiler::emitVectorFpArith32(const GCNInstruction& ins)
 {
 	uint32_t op       = getVopOpcode(ins);
 	uint32_t src0     = 0;
@@ -625,12 +625,12 @@ void GCNCompiler::emitVectorFpArith32(GCNInstruction& ins)
 	emitStoreVectorOperand(dstRIdx, dstVal);
 }
 
-void GCNCompiler::emitVectorFpRound32(GCNInstruction& ins)
+void GCNCompiler::emitVectorFpRound32(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitVectorFpField32(GCNInstruction& ins)
+void GCNCompiler::emitVectorFpField32(const GCNInstruction& ins)
 {
 	uint32_t op       = getVopOpcode(ins);
 	uint32_t src0     = 0;
@@ -680,7 +680,7 @@ void GCNCompiler::emitVectorFpField32(GCNInstruction& ins)
 	emitStoreVectorOperand(dstRIdx, dstVal);
 }
 
-void GCNCompiler::emitVectorFpTran32(GCNInstruction& ins)
+void GCNCompiler::emitVectorFpTran32(const GCNInstruction& ins)
 {
 	auto op = getVopOpcode(ins);
 
@@ -741,7 +741,7 @@ void GCNCompiler::emitVectorFpTran32(GCNInstruction& ins)
 	emitStoreVectorOperand(vdstRidx, dstValue);
 }
 
-void GCNCompiler::emitVectorFpCmp32(GCNInstruction& ins)
+void GCNCompiler::emitVectorFpCmp32(const GCNInstruction& ins)
 {
 	auto op = getVopOpcode(ins);
 
@@ -801,32 +801,32 @@ void GCNCompiler::emitVectorFpCmp32(GCNInstruction& ins)
 	emitStoreScalarOperand(vdst, vdstRidx, dstValue);
 }
 
-void GCNCompiler::emitVectorFpArith64(GCNInstruction& ins)
+void GCNCompiler::emitVectorFpArith64(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitVectorFpRound64(GCNInstruction& ins)
+void GCNCompiler::emitVectorFpRound64(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitVectorFpField64(GCNInstruction& ins)
+void GCNCompiler::emitVectorFpField64(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitVectorFpTran64(GCNInstruction& ins)
+void GCNCompiler::emitVectorFpTran64(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitVectorFpCmp64(GCNInstruction& ins)
+void GCNCompiler::emitVectorFpCmp64(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitVectorIntArith32(GCNInstruction& ins)
+void GCNCompiler::emitVectorIntArith32(const GCNInstruction& ins)
 {
 	auto op = getVopOpcode(ins);
 
@@ -862,22 +862,22 @@ void GCNCompiler::emitVectorIntArith32(GCNInstruction& ins)
 	emitStoreVectorOperand(vdstRidx, dstValue);
 }
 
-void GCNCompiler::emitVectorIntArith64(GCNInstruction& ins)
+void GCNCompiler::emitVectorIntArith64(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitVectorIntCmp32(GCNInstruction& ins)
+void GCNCompiler::emitVectorIntCmp32(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitVectorIntCmp64(GCNInstruction& ins)
+void GCNCompiler::emitVectorIntCmp64(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitVectorConv(GCNInstruction& ins)
+void GCNCompiler::emitVectorConv(const GCNInstruction& ins)
 {
 	uint32_t op       = getVopOpcode(ins);
 	uint32_t src0     = 0;
@@ -926,17 +926,17 @@ void GCNCompiler::emitVectorConv(GCNInstruction& ins)
 	emitStoreVectorOperand(dstRIdx, dstValue);
 }
 
-void GCNCompiler::emitVectorFpGraph32(GCNInstruction& ins)
+void GCNCompiler::emitVectorFpGraph32(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitVectorIntGraph(GCNInstruction& ins)
+void GCNCompiler::emitVectorIntGraph(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitVectorMisc(GCNInstruction& ins)
+void GCNCompiler::emitVectorMisc(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
@@ -6,12 +6,12 @@ namespace pssl
 {;
 
 
-void GCNCompiler::emitVectorInterpolation(GCNInstruction& ins)
+void GCNCompiler::emitVectorInterpolation(const GCNInstruction& ins)
 {
 	emitVectorInterpFpCache(ins);
 }
 
-void GCNCompiler::emitVectorInterpFpCache(GCNInstruction& ins)
+void GCNCompiler::emitVectorInterpFpCache(const GCNInstruction& ins)
 {
 	auto inst = asInst<SIVINTRPInstruction>(ins);
 	auto op = inst->GetOp();
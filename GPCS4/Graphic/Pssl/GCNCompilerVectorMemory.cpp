@@ -5,7 +5,7 @@ LOG_CHANNEL(Graphic.Pssl.GCNCompilerVectorMemory);
 namespace pssl
 {;
 
-void GCNCompiler::emitVectorMemory(GCNInstruction& ins)
+void GCNCompiler::emitVectorMemory(const GCNInstruction& ins)
 {
 	Instruction::InstructionClass insClass = ins.instruction->GetInstructionClass();
 
@@ -39,22 +39,22 @@ void GCNCompiler::emitVectorMemory(GCNInstruction& ins)
 	}
 }
 
-void GCNCompiler::emitVectorMemBufNoFmt(GCNInstruction& ins)
+void GCNCompiler::emitVectorMemBufNoFmt(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitVectorMemBufFmt(GCNInstruction& ins)
+void GCNCompiler::emitVectorMemBufFmt(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitVectorMemImgNoSmp(GCNInstruction& ins)
+void GCNCompiler::emitVectorMemImgNoSmp(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitVectorMemImgSmp(GCNInstruction& ins)
+void GCNCompiler::emitVectorMemImgSmp(const GCNInstruction& ins)
 {
 	auto inst = asInst<SIMIMGInstruction>(ins);
 	auto op = inst->GetOp();
@@ -94,12 +94,12 @@ void GCNCompiler::emitVectorMemImgSmp(GCNInstruction& ins)
 	}
 }
 
-void GCNCompiler::emitVectorMemImgUt(GCNInstruction& ins)
+void GCNCompiler::emitVectorMemImgUt(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
 
-void GCNCompiler::emitVectorMemL1Cache(GCNInstruction& ins)
+void GCNCompiler::emitVectorMemL1Cache(const GCNInstruction& ins)
 {
 	LOG_PSSL_UNHANDLED_INST();
 }
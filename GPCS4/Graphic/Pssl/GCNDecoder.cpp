@@ -125,4 +125,24 @@ void GCNDecodeContext::freeInstruction()
 	m_instruction.literalConst = 0;
 }
 
+//////////////////////////////////////////////////////////////////////////
+
+GCNProgram::GCNProgram(GCNCodeSlice slice)
+{
+	// Most instructions are one or two dwords,
+	// reserve enough to avoid reallocating.
+	m_instructions.reserve(slice.sizeDwords() / 2 + 1);
+
+	GCNDecodeContext decoder;
+	while (!slice.atEnd())
+	{
+		decoder.decodeInstruction(slice);
+		m_instructions.emplace_back(std::move(decoder.getInstruction()));
+	}
+}
+
+GCNProgram::~GCNProgram()
+{
+}
+
 } // namespace pssl
\ No newline at end of file
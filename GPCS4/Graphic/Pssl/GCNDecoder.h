@@ -4,6 +4,8 @@
 #include "GCNInstruction.h"
 #include "GCNParser/GCNParser.h"
 
+#include <vector>
+
 
 namespace pssl
 {;
@@ -144,6 +146,11 @@ public:
 		return m_ptr == m_end;
 	}
 
+	uint32_t sizeDwords() const
+	{
+		return static_cast<uint32_t>(m_end - m_ptr);
+	}
+
 private:
 
 	const uint32_t* m_ptr = nullptr;
@@ -173,6 +180,32 @@ private:
 	GCNInstruction m_instruction;
 };
 
+//////////////////////////////////////////////////////////////////////////
+
+/**
+ * \brief Decoded GCN program
+ *
+ * All instructions of a shader, decoded once and stored
+ * contiguously in program order, with literal constants
+ * kept inline in each record. It doesn't depend on the
+ * shader inputs, so the analyzer and compiler passes,
+ * and every compilation of the same binary, share it.
+ */
+class GCNProgram : public RcObject
+{
+public:
+	GCNProgram(GCNCodeSlice slice);
+	~GCNProgram();
+
+	const std::vector<GCNInstruction>& instructions() const
+	{
+		return m_instructions;
+	}
+
+private:
+	std::vector<GCNInstruction> m_instructions;
+};
+
 
 
 } // namespace pssl
\ No newline at end of file
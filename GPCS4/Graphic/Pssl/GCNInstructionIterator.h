@@ -12,7 +12,7 @@ public:
 	GCNInstructionIterator();
 	virtual ~GCNInstructionIterator();
 
-	virtual void processInstruction(GCNInstruction& ins) = 0;
+	virtual void processInstruction(const GCNInstruction& ins) = 0;
 
 protected:
 
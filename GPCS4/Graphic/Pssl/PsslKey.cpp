@@ -42,7 +42,7 @@ PsslKey& PsslKey::operator=(const PsslKey& other)
 	return *this;
 }
 
-bool PsslKey::operator==(const PsslKey& other)
+bool PsslKey::operator==(const PsslKey& other) const
 {
 	return m_key == other.m_key;
 }
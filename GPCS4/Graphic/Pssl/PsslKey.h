@@ -19,7 +19,7 @@ public:
 
 	std::string toString() const;
 
-	bool operator == (const PsslKey& other);
+	bool operator == (const PsslKey& other) const;
 
 	PsslKey& operator = (const PsslKey& other);
 
@@ -33,6 +33,11 @@ uint32_t PsslProgramInfo::codeSizeDwords() const
 	return codeSizeBytes() / sizeof(uint32_t);
 }
 
+uint32_t PsslProgramInfo::binarySizeBytes() const
+{
+	return m_binarySize;
+}
+
 bool PsslProgramInfo::hasFetchShader()
 {
 	bool hasFs = false;
@@ -119,6 +124,7 @@ bool PsslProgramInfo::initBinaryInfo(const uint8_t* code)
 			{
 				info = (ShaderBinaryInfo*)&code[i];
 				memcpy(&m_shaderBinaryInfo, info, sizeof(m_shaderBinaryInfo));
+				m_binarySize = i + sizeof(ShaderBinaryInfo);
 				ret = true;
 				break;
 			}
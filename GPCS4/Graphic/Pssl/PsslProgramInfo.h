@@ -21,6 +21,15 @@ public:
 
 	uint32_t codeSizeDwords() const;
 
+	/**
+	 * \brief Size of the whole shader binary
+	 *
+	 * The code followed by the input usage slots
+	 * and the ShaderBinaryInfo, everything needed
+	 * to construct a PsslProgramInfo again.
+	 */
+	uint32_t binarySizeBytes() const;
+
 	bool hasFetchShader();
 
 	PsslProgramType shaderType() const;
@@ -45,6 +54,7 @@ private:
 	ShaderBinaryInfo m_shaderBinaryInfo;
 	std::vector<InputUsageSlot> m_inputUsageSlots;
 	PsslProgramType m_type;
+	uint32_t m_binarySize = 0;
 };
 
 // return UINT_MAX means no fetch shader
@@ -0,0 +1,465 @@
+#include "PsslShaderArchive.h"
+
+#include "Algorithm/MurmurHash2.h"
+#include "../SpirV/SpirvOptimizer.h"
+#include "../Violet/VltShader.h"
+
+#include <algorithm>
+#include <cstring>
+
+LOG_CHANNEL(Graphic.Pssl.PsslShaderArchive);
+
+namespace pssl
+{;
+
+constexpr char     ArchiveMagic[4]      = { 'G', 'P', 'S', 'A' };
+constexpr uint32_t ArchiveFormatVersion = 1;
+
+// Entries appended during this run have no offset in the mapping.
+constexpr size_t UnmappedEntry = SIZE_MAX;
+
+PsslShaderArchive::PsslShaderArchive()
+{
+}
+
+PsslShaderArchive::~PsslShaderArchive()
+{
+	close();
+}
+
+bool PsslShaderArchive::open(const std::string& path)
+{
+	close();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	bool ret = false;
+	do
+	{
+		m_path = path;
+
+		if (!mapArchive() || !checkHeader())
+		{
+			// Missing, empty or stale archive, start over.
+			if (!resetArchive(0) || !mapArchive())
+			{
+				LOG_ERR("create shader archive %s failed.", path.c_str());
+				break;
+			}
+		}
+
+		size_t validSize = indexEntries();
+		if (validSize != m_size)
+		{
+			// Most likely a write interrupted by a crash,
+			// the entries before it are still good.
+			LOG_WARN("shader archive %s truncated from %zu to %zu bytes.",
+					 path.c_str(), m_size, validSize);
+			if (!resetArchive(validSize) || !mapArchive())
+			{
+				LOG_ERR("truncate shader archive %s failed.", path.c_str());
+				break;
+			}
+		}
+
+		m_file.reset(fopen(path.c_str(), "ab"));
+		if (!m_file)
+		{
+			LOG_ERR("open shader archive %s for append failed.", path.c_str());
+			break;
+		}
+
+		LOG_DEBUG("shader archive %s opened, %zu entries.", path.c_str(), m_entries.size());
+		ret = true;
+	} while (false);
+
+	if (!ret)
+	{
+		unmapArchive();
+		m_entries.clear();
+	}
+
+	return ret;
+}
+
+void PsslShaderArchive::close()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_file.reset();
+	unmapArchive();
+	m_entries.clear();
+	m_prewarmed.clear();
+	m_duplicateCount = 0;
+}
+
+bool PsslShaderArchive::isOpen()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_file != nullptr;
+}
+
+RcPtr<vlt::VltShader> PsslShaderArchive::load(const PsslShaderCacheKey& key)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	RcPtr<vlt::VltShader> shader = nullptr;
+	do
+	{
+		auto prewarmed = m_prewarmed.find(key);
+		if (prewarmed != m_prewarmed.end())
+		{
+			shader = prewarmed->second;
+			break;
+		}
+
+		auto iter = m_entries.find(key);
+		if (iter == m_entries.end() || iter->second == UnmappedEntry)
+		{
+			break;
+		}
+
+		shader = decodeEntry(iter->second);
+	} while (false);
+
+	return shader;
+}
+
+void PsslShaderArchive::store(const PsslShaderCacheKey& key, const RcPtr<vlt::VltShader>& shader)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	do
+	{
+		if (!m_file)
+		{
+			break;
+		}
+
+		if (!m_entries.emplace(key, UnmappedEntry).second)
+		{
+			// Already archived.
+			break;
+		}
+
+		const auto& code  = shader->code();
+		const auto& slots = shader->slots();
+		const auto& mask  = code.maskWords();
+		const auto& words = code.codeWords();
+
+		std::vector<uint32_t> slotWords;
+		slotWords.reserve(slots.size() * 2);
+		for (const auto& slot : slots)
+		{
+			slotWords.push_back(slot.regSlot);
+			slotWords.push_back(uint32_t(slot.type));
+		}
+
+		size_t slotSize = slotWords.size() * sizeof(uint32_t);
+		size_t maskSize = mask.size() * sizeof(uint64_t);
+		size_t codeSize = words.size() * sizeof(uint64_t);
+
+		std::vector<uint8_t> payload(slotSize + maskSize + codeSize);
+		std::memcpy(payload.data(), slotWords.data(), slotSize);
+		std::memcpy(payload.data() + slotSize, mask.data(), maskSize);
+		std::memcpy(payload.data() + slotSize + maskSize, words.data(), codeSize);
+
+		PsslShaderArchiveEntryHeader entry = {};
+		entry.key                          = key.key.toUint64();
+		entry.inputHash                    = key.inputHash;
+		entry.stage                        = uint32_t(shader->stage());
+		entry.slotCount                    = uint32_t(slots.size());
+		entry.codeDwords                   = code.dwords();
+		entry.maskCount                    = uint32_t(mask.size());
+		entry.codeCount                    = uint32_t(words.size());
+		entry.checksum                     = entryChecksum(payload.data(), payload.size());
+
+		FILE* file = m_file.get();
+		if (fwrite(&entry, sizeof(entry), 1, file) != 1 ||
+			fwrite(payload.data(), payload.size(), 1, file) != 1)
+		{
+			// The partial entry will be dropped on next open.
+			LOG_ERR("write shader archive %s failed.", m_path.c_str());
+			m_file.reset();
+			break;
+		}
+
+		fflush(file);
+	} while (false);
+}
+
+uint32_t PsslShaderArchive::prewarm()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (const auto& entry : m_entries)
+	{
+		if (entry.second == UnmappedEntry)
+		{
+			continue;
+		}
+
+		m_prewarmed.emplace(entry.first, decodeEntry(entry.second));
+	}
+
+	LOG_DEBUG("%zu shaders prewarmed from archive.", m_prewarmed.size());
+	return uint32_t(m_prewarmed.size());
+}
+
+std::vector<PsslShaderCacheKey> PsslShaderArchive::keys()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	std::vector<PsslShaderCacheKey> result;
+	result.reserve(m_entries.size());
+
+	for (const auto& entry : m_entries)
+	{
+		if (entry.second != UnmappedEntry)
+		{
+			result.push_back(entry.first);
+		}
+	}
+	return result;
+}
+
+PsslShaderArchiveReport PsslShaderArchive::validate()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	PsslShaderArchiveReport report = {};
+	report.duplicateCount          = m_duplicateCount;
+
+	for (const auto& entry : m_entries)
+	{
+		if (entry.second == UnmappedEntry)
+		{
+			continue;
+		}
+
+		++report.entryCount;
+
+		PsslShaderArchiveEntryHeader header;
+		std::memcpy(&header, m_data + entry.second, sizeof(header));
+
+		const uint8_t* payload = m_data + entry.second + sizeof(header);
+		const uint8_t* masks   = payload + header.slotCount * sizeof(uint32_t) * 2;
+
+		// Make sure the code words match the byte counts in the masks
+		// before decompressing, or we may read out of bounds.
+		uint64_t bitCount = 0;
+		for (uint32_t i = 0; i != header.maskCount; ++i)
+		{
+			uint64_t mask = 0;
+			std::memcpy(&mask, masks + i * sizeof(uint64_t), sizeof(mask));
+
+			uint32_t wordCount = std::min(32u, header.codeDwords - i * 32);
+			for (uint32_t w = 0; w != wordCount; ++w)
+			{
+				bitCount += 8 * (((mask >> (2 * w)) & 3) + 1);
+			}
+		}
+
+		bool valid = (header.codeCount == (bitCount + 63) / 64);
+		if (valid)
+		{
+			SpirvCodeBuffer code = readCode(header, masks).decompress();
+
+			const uint32_t* data = code.data();
+			valid                = code.dwords() >= 5 && data[0] == spv::MagicNumber;
+
+			// Walk the instructions, each must fit in the buffer.
+			for (uint32_t offset = 5; valid && offset < code.dwords();)
+			{
+				uint32_t length = data[offset] >> spv::WordCountShift;
+				valid           = length != 0 && offset + length <= code.dwords();
+				offset += length;
+			}
+		}
+
+		if (!valid)
+		{
+			LOG_WARN("invalid shader %llX in archive, input hash %llX.",
+					 header.key, header.inputHash);
+			++report.invalidCount;
+		}
+	}
+
+	return report;
+}
+
+bool PsslShaderArchive::mapArchive()
+{
+	size_t      size = 0;
+	const void* data = UtilFile::MapFile(m_path, &size);
+
+	m_data = reinterpret_cast<const uint8_t*>(data);
+	m_size = data ? size : 0;
+	return m_data != nullptr;
+}
+
+void PsslShaderArchive::unmapArchive()
+{
+	if (m_data)
+	{
+		UtilFile::UnmapFile(m_data, m_size);
+		m_data = nullptr;
+		m_size = 0;
+	}
+}
+
+bool PsslShaderArchive::resetArchive(size_t validSize)
+{
+	std::vector<uint8_t> data;
+
+	if (validSize != 0)
+	{
+		data.assign(m_data, m_data + validSize);
+	}
+	else
+	{
+		PsslShaderArchiveHeader header = {};
+		std::memcpy(header.magic, ArchiveMagic, sizeof(header.magic));
+		header.formatVersion   = ArchiveFormatVersion;
+		header.compilerVersion = PsslCompilerVersion;
+		header.optimizerPasses = SpirvOptimizer::getDefaultPasses().raw();
+
+		data.resize(sizeof(header));
+		std::memcpy(data.data(), &header, sizeof(header));
+	}
+
+	// Must unmap before rewriting the file.
+	unmapArchive();
+	return UtilFile::StoreFile(m_path, data);
+}
+
+bool PsslShaderArchive::checkHeader()
+{
+	bool ret = false;
+	do
+	{
+		if (m_size < sizeof(PsslShaderArchiveHeader))
+		{
+			break;
+		}
+
+		PsslShaderArchiveHeader header;
+		std::memcpy(&header, m_data, sizeof(header));
+
+		if (std::memcmp(header.magic, ArchiveMagic, sizeof(header.magic)) != 0 ||
+			header.formatVersion != ArchiveFormatVersion)
+		{
+			LOG_WARN("shader archive %s has unknown format, discarded.", m_path.c_str());
+			break;
+		}
+
+		if (header.compilerVersion != PsslCompilerVersion)
+		{
+			LOG_DEBUG("shader archive %s created by compiler version %d, discarded.",
+					  m_path.c_str(), header.compilerVersion);
+			break;
+		}
+
+		if (header.optimizerPasses != SpirvOptimizer::getDefaultPasses().raw())
+		{
+			LOG_DEBUG("shader archive %s created with other optimizer passes, discarded.",
+					  m_path.c_str());
+			break;
+		}
+
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+size_t PsslShaderArchive::indexEntries()
+{
+	m_entries.clear();
+	m_duplicateCount = 0;
+
+	size_t offset = sizeof(PsslShaderArchiveHeader);
+	while (offset + sizeof(PsslShaderArchiveEntryHeader) <= m_size)
+	{
+		PsslShaderArchiveEntryHeader entry;
+		std::memcpy(&entry, m_data + offset, sizeof(entry));
+
+		if (entry.maskCount != (entry.codeDwords + 31) / 32)
+		{
+			break;
+		}
+
+		size_t payloadSize = size_t(entry.slotCount) * sizeof(uint32_t) * 2 +
+							 (size_t(entry.maskCount) + entry.codeCount) * sizeof(uint64_t);
+		size_t entrySize   = sizeof(entry) + payloadSize;
+
+		if (entrySize > m_size - offset ||
+			entryChecksum(m_data + offset + sizeof(entry), payloadSize) != entry.checksum)
+		{
+			break;
+		}
+
+		PsslShaderCacheKey key = {};
+		key.key                = PsslKey(uint32_t(entry.key), uint32_t(entry.key >> 32));
+		key.inputHash          = entry.inputHash;
+
+		// Same shader stored twice by different processes,
+		// the first one wins.
+		if (!m_entries.emplace(key, offset).second)
+		{
+			++m_duplicateCount;
+		}
+
+		offset += entrySize;
+	}
+
+	return offset;
+}
+
+RcPtr<vlt::VltShader> PsslShaderArchive::decodeEntry(size_t offset)
+{
+	PsslShaderArchiveEntryHeader entry;
+	std::memcpy(&entry, m_data + offset, sizeof(entry));
+
+	const uint8_t* payload = m_data + offset + sizeof(entry);
+
+	std::vector<vlt::VltResourceSlot> slots(entry.slotCount);
+	for (auto& slot : slots)
+	{
+		uint32_t words[2];
+		std::memcpy(words, payload, sizeof(words));
+		payload += sizeof(words);
+
+		slot.regSlot = words[0];
+		slot.type    = VkDescriptorType(words[1]);
+	}
+
+	PsslKey key(uint32_t(entry.key), uint32_t(entry.key >> 32));
+
+	return new vlt::VltShader(
+		VkShaderStageFlagBits(entry.stage),
+		readCode(entry, payload),
+		key,
+		std::move(slots));
+}
+
+SpirvCompressedBuffer PsslShaderArchive::readCode(
+	const PsslShaderArchiveEntryHeader& entry,
+	const uint8_t*                      masks)
+{
+	std::vector<uint64_t> mask(entry.maskCount);
+	std::memcpy(mask.data(), masks, mask.size() * sizeof(uint64_t));
+
+	const uint8_t* words = masks + mask.size() * sizeof(uint64_t);
+
+	std::vector<uint64_t> code(entry.codeCount);
+	std::memcpy(code.data(), words, code.size() * sizeof(uint64_t));
+
+	return SpirvCompressedBuffer(entry.codeDwords, std::move(mask), std::move(code));
+}
+
+uint32_t PsslShaderArchive::entryChecksum(const void* payload, size_t size)
+{
+	return uint32_t(algo::MurmurHash(payload, int(size)));
+}
+
+}  // namespace pssl
@@ -0,0 +1,192 @@
+#pragma once
+
+#include "PsslCommon.h"
+#include "PsslShaderCache.h"
+
+#include "../SpirV/SpirvCompression.h"
+
+#include "Platform/UtilFile.h"
+#include "UtilSingleton.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pssl
+{;
+
+/**
+ * \brief Compiler version tag
+ *
+ * Stored in the archive header. Bump this whenever
+ * GCNCompiler changes the SPIR-V it emits, so stale
+ * archives are discarded instead of being loaded.
+ */
+constexpr uint32_t PsslCompilerVersion = 1;
+
+/**
+ * \brief Archive file header
+ */
+struct PsslShaderArchiveHeader
+{
+	char     magic[4];
+	uint32_t formatVersion;
+	uint32_t compilerVersion;
+	uint32_t optimizerPasses;  // SPIR-V optimizer passes the shaders went through
+};
+
+/**
+ * \brief Archive entry header
+ *
+ * Each entry is followed by its payload:
+ * slotCount pairs of (regSlot, descriptor type) dwords,
+ * maskCount mask qwords and codeCount code qwords
+ * of the compressed SPIR-V.
+ */
+struct PsslShaderArchiveEntryHeader
+{
+	uint64_t key;
+	uint64_t inputHash;
+	uint32_t stage;
+	uint32_t slotCount;
+	uint32_t codeDwords;  // Uncompressed SPIR-V size
+	uint32_t maskCount;
+	uint32_t codeCount;
+	uint32_t checksum;    // Payload checksum
+};
+
+/**
+ * \brief Archive validation report
+ */
+struct PsslShaderArchiveReport
+{
+	uint32_t entryCount     = 0;
+	uint32_t invalidCount   = 0;
+	uint32_t duplicateCount = 0;
+};
+
+/**
+ * \brief Persistent on-disk shader cache
+ *
+ * A single append-only archive file holding the compiled
+ * SPIR-V and resource slots of every shader translated so far.
+ * The file is memory-mapped when opened and an index of entries
+ * is built, so a warm run restores shaders straight from the
+ * mapping without invoking GCNCompiler.
+ *
+ * Shaders compiled during the run are appended to the file,
+ * they will be found in the mapping on the next run.
+ * A truncated tail left by an interrupted write is dropped
+ * on open, an archive created by a different compiler version
+ * or with different optimizer passes is discarded entirely.
+ */
+class PsslShaderArchive : public Singleton<PsslShaderArchive>
+{
+	friend class Singleton<PsslShaderArchive>;
+
+public:
+	/**
+	 * \brief Opens the archive
+	 *
+	 * Creates the file if it doesn't exist yet.
+	 * \param [in] path Archive file path
+	 * \returns \c true on success
+	 */
+	bool open(const std::string& path);
+
+	/**
+	 * \brief Closes the archive
+	 */
+	void close();
+
+	/**
+	 * \brief Checks whether the archive is open
+	 */
+	bool isOpen();
+
+	/**
+	 * \brief Restores a shader from the archive
+	 *
+	 * \param [in] key Shader cache key
+	 * \returns The shader, or \c nullptr if not archived
+	 */
+	RcPtr<vlt::VltShader> load(const PsslShaderCacheKey& key);
+
+	/**
+	 * \brief Appends a shader to the archive
+	 *
+	 * Does nothing if the key is already archived.
+	 * \param [in] key Shader cache key
+	 * \param [in] shader Compiled shader
+	 */
+	void store(const PsslShaderCacheKey& key, const RcPtr<vlt::VltShader>& shader);
+
+	/**
+	 * \brief Restores all archived shaders up front
+	 *
+	 * Moves the cost of restoring shaders from the
+	 * first draw using them to startup.
+	 * \returns Number of shaders restored
+	 */
+	uint32_t prewarm();
+
+	/**
+	 * \brief Keys of all archived shaders
+	 * \returns Cache keys of entries found on open
+	 */
+	std::vector<PsslShaderCacheKey> keys();
+
+	/**
+	 * \brief Validates all archived shaders
+	 *
+	 * Restores every entry and checks the SPIR-V header.
+	 * \returns Validation report
+	 */
+	PsslShaderArchiveReport validate();
+
+private:
+	PsslShaderArchive();
+	virtual ~PsslShaderArchive();
+
+	bool mapArchive();
+	void unmapArchive();
+
+	bool resetArchive(size_t validSize);
+
+	bool checkHeader();
+
+	size_t indexEntries();
+
+	RcPtr<vlt::VltShader> decodeEntry(size_t offset);
+
+	static SpirvCompressedBuffer readCode(
+		const PsslShaderArchiveEntryHeader& entry,
+		const uint8_t*                      masks);
+
+	static uint32_t entryChecksum(const void* payload, size_t size);
+
+private:
+	std::mutex m_mutex;
+
+	std::string          m_path;
+	const uint8_t*       m_data = nullptr;
+	size_t               m_size = 0;
+	UtilFile::file_uptr  m_file;
+
+	// Offsets of entries in the mapping,
+	// entries appended during this run are not mapped.
+	std::unordered_map<
+		PsslShaderCacheKey,
+		size_t,
+		vlt::VltHash, vlt::VltEqual> m_entries;
+
+	std::unordered_map<
+		PsslShaderCacheKey,
+		RcPtr<vlt::VltShader>,
+		vlt::VltHash, vlt::VltEqual> m_prewarmed;
+
+	uint32_t m_duplicateCount = 0;
+};
+
+}  // namespace pssl
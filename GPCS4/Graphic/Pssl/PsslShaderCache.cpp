@@ -0,0 +1,184 @@
+#include "PsslShaderCache.h"
+#include "PsslShaderArchive.h"
+#include "PsslShaderCapture.h"
+#include "PsslShaderModule.h"
+
+#include "../Violet/VltShader.h"
+
+#include <chrono>
+
+LOG_CHANNEL(Graphic.Pssl.PsslShaderCache);
+
+namespace pssl
+{;
+
+PsslShaderCache::PsslShaderCache() :
+	m_archive(PsslShaderArchive::GetInstance()),
+	m_workers(vlt::VltWorkerPool::defaultWorkerCount())
+{
+}
+
+PsslShaderCache::~PsslShaderCache()
+{
+}
+
+RcPtr<vlt::VltShader> PsslShaderCache::getShader(PsslShaderModule* module)
+{
+	RcPtr<vlt::VltShader> shader = nullptr;
+
+	do
+	{
+		PsslShaderCacheKey cacheKey = {};
+		cacheKey.key                = module->key();
+		cacheKey.inputHash          = module->inputHash();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			auto iter = m_shaders.find(cacheKey);
+			if (iter != m_shaders.end())
+			{
+				shader = iter->second;
+				++m_stats.hitCount;
+				break;
+			}
+		}
+
+		// Shaders seen in previous runs are restored
+		// from the on-disk archive without compiling.
+		shader = m_archive->load(cacheKey);
+		if (shader != nullptr)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			auto pair = m_shaders.emplace(cacheKey, shader);
+			shader    = pair.first->second;
+
+			++m_stats.archiveHitCount;
+			break;
+		}
+
+#ifdef PSSL_DUMP_SHADER
+		// Compile inputs for the offline shader benchmark.
+		PsslShaderCapture::store(module);
+#endif  // PSSL_DUMP_SHADER
+
+		// Compile outside of the lock,
+		// other threads could still hit the cache meanwhile.
+		auto compileBegin = std::chrono::high_resolution_clock::now();
+		shader            = module->compile(getProgram(module));
+		auto compileEnd   = std::chrono::high_resolution_clock::now();
+
+		auto compileTime = std::chrono::duration_cast<std::chrono::microseconds>(compileEnd - compileBegin);
+
+		LOG_DEBUG("shader %llX compiled in %lld us, input hash %llX",
+				  cacheKey.key.toUint64(), compileTime.count(), cacheKey.inputHash);
+
+		m_archive->store(cacheKey, shader);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// Another thread may have compiled the same shader,
+		// in which case we keep the first one.
+		auto pair = m_shaders.emplace(cacheKey, shader);
+		shader    = pair.first->second;
+
+		++m_stats.missCount;
+		m_stats.compileTimeUs += compileTime.count();
+	} while (false);
+
+	return shader;
+}
+
+PsslShaderFuture PsslShaderCache::getShaderAsync(const RcPtr<PsslShaderModule>& module)
+{
+	PsslShaderFuture future;
+
+	do
+	{
+		PsslShaderCacheKey cacheKey = {};
+		cacheKey.key                = module->key();
+		cacheKey.inputHash          = module->inputHash();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto iter = m_shaders.find(cacheKey);
+		if (iter != m_shaders.end())
+		{
+			std::promise<RcPtr<vlt::VltShader>> promise;
+			promise.set_value(iter->second);
+			future = promise.get_future().share();
+
+			++m_stats.hitCount;
+			break;
+		}
+
+		auto pending = m_pending.find(cacheKey);
+		if (pending != m_pending.end())
+		{
+			future = pending->second;
+			break;
+		}
+
+		// The module is compiled after the command buffer
+		// may have been released by the game.
+		module->detachShaderResources();
+
+		// The job can't remove itself from the pending map
+		// before it's inserted, since we still hold the lock.
+		future = m_workers.submit([this, module, cacheKey]()
+		{
+			auto shader = getShader(module.ptr());
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_pending.erase(cacheKey);
+			return shader;
+		});
+
+		m_pending.emplace(cacheKey, future);
+	} while (false);
+
+	return future;
+}
+
+RcPtr<GCNProgram> PsslShaderCache::getProgram(PsslShaderModule* module)
+{
+	RcPtr<GCNProgram> program = nullptr;
+	uint64_t          key     = module->key().toUint64();
+
+	do
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			auto iter = m_programs.find(key);
+			if (iter != m_programs.end())
+			{
+				program = iter->second;
+				break;
+			}
+		}
+
+		program = module->decode();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto pair = m_programs.emplace(key, program);
+		program   = pair.first->second;
+	} while (false);
+
+	return program;
+}
+
+PsslShaderCacheStats PsslShaderCache::getStats()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
+
+vlt::VltWorkerPoolStats PsslShaderCache::getWorkerStats()
+{
+	return m_workers.getStats();
+}
+
+}  // namespace pssl
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "PsslCommon.h"
+#include "PsslKey.h"
+
+#include "../Violet/VltHash.h"
+#include "../Violet/VltWorkerPool.h"
+
+#include <future>
+#include <mutex>
+#include <unordered_map>
+
+namespace vlt
+{;
+class VltShader;
+}  // namespace vlt
+
+namespace pssl
+{;
+
+class PsslShaderModule;
+class PsslShaderArchive;
+class GCNProgram;
+
+using PsslShaderFuture = std::shared_future<RcPtr<vlt::VltShader>>;
+
+/**
+ * \brief Shader cache key
+ *
+ * PsslKey only identifies the GCN binary,
+ * but the SPIR-V emitted by GCNCompiler also depends on
+ * the resources bound to the shader and the fetch shader,
+ * so a hash of those inputs is part of the key.
+ */
+struct PsslShaderCacheKey
+{
+	PsslKey  key;
+	uint64_t inputHash = 0;
+
+	bool operator==(const PsslShaderCacheKey& other) const
+	{
+		return key == other.key && inputHash == other.inputHash;
+	}
+
+	size_t hash() const
+	{
+		vlt::VltHashState state;
+		state.add(key.toUint64());
+		state.add(inputHash);
+		return state;
+	}
+};
+
+/**
+ * \brief Shader cache statistics
+ */
+struct PsslShaderCacheStats
+{
+	uint64_t hitCount        = 0;
+	uint64_t archiveHitCount = 0;  // Misses restored from the on-disk archive
+	uint64_t missCount       = 0;
+	uint64_t compileTimeUs   = 0;  // Total time spent in compiling, in microseconds
+};
+
+/**
+ * \brief In-memory shader cache
+ *
+ * Sits in front of PsslShaderModule::compile,
+ * so a GCN shader is only translated once per
+ * unique set of inputs, instead of once per draw.
+ * Misses are looked up in the on-disk archive
+ * before falling back to compiling.
+ */
+class PsslShaderCache
+{
+public:
+	PsslShaderCache();
+	~PsslShaderCache();
+
+	/**
+	 * \brief Get the compiled shader of a module
+	 *
+	 * Returns the shader compiled previously for the same
+	 * key and inputs, or compiles the module and caches
+	 * the result on a miss, both in memory and on disk.
+	 * \param [in] module Shader module with inputs defined
+	 * \returns The compiled shader
+	 */
+	RcPtr<vlt::VltShader> getShader(PsslShaderModule* module);
+
+	/**
+	 * \brief Get the compiled shader of a module asynchronously
+	 *
+	 * Same as getShader, but a miss is compiled by the
+	 * background workers instead of the calling thread.
+	 * Requests for a shader which is already being compiled
+	 * share the same future.
+	 * \param [in] module Shader module with inputs defined
+	 * \returns Future holding the compiled shader
+	 */
+	PsslShaderFuture getShaderAsync(const RcPtr<PsslShaderModule>& module);
+
+	/**
+	 * \brief Queries cache statistics
+	 * \returns Hit, miss and compile time counters
+	 */
+	PsslShaderCacheStats getStats();
+
+	/**
+	 * \brief Queries compile worker statistics
+	 * \returns Queue depth and latency counters
+	 */
+	vlt::VltWorkerPoolStats getWorkerStats();
+
+private:
+	RcPtr<GCNProgram> getProgram(PsslShaderModule* module);
+
+private:
+	PsslShaderArchive* m_archive;
+
+	std::mutex m_mutex;
+
+	std::unordered_map<
+		PsslShaderCacheKey,
+		RcPtr<vlt::VltShader>,
+		vlt::VltHash, vlt::VltEqual> m_shaders;
+
+	// Decoded programs, keyed by PsslKey only,
+	// since decoding doesn't depend on shader inputs.
+	std::unordered_map<uint64_t, RcPtr<GCNProgram>> m_programs;
+
+	// Shaders being compiled by the workers
+	std::unordered_map<
+		PsslShaderCacheKey,
+		PsslShaderFuture,
+		vlt::VltHash, vlt::VltEqual> m_pending;
+
+	PsslShaderCacheStats m_stats;
+
+	// Declared last, so the workers are joined
+	// before the maps they write to are destroyed.
+	vlt::VltWorkerPool m_workers;
+};
+
+}  // namespace pssl
@@ -0,0 +1,249 @@
+#include "PsslShaderCapture.h"
+#include "PsslShaderModule.h"
+
+#include "Platform/UtilFile.h"
+
+#include <climits>
+#include <cstring>
+
+LOG_CHANNEL(Graphic.Pssl.PsslShaderCapture);
+
+namespace pssl
+{;
+
+constexpr char     PsslShaderCaptureMagic[4]    = { 'G', 'P', 'S', 'C' };
+constexpr uint32_t PsslShaderCaptureVersion     = 1;
+
+static const char* getStageExtension(PsslProgramType type)
+{
+	const char* ext = "unknown";
+	switch (type)
+	{
+	case PsslProgramType::PixelShader:    ext = "ps"; break;
+	case PsslProgramType::VertexShader:   ext = "vs"; break;
+	case PsslProgramType::GeometryShader: ext = "gs"; break;
+	case PsslProgramType::HullShader:     ext = "hs"; break;
+	case PsslProgramType::DomainShader:   ext = "ds"; break;
+	case PsslProgramType::ComputeShader:  ext = "cs"; break;
+	default:
+		break;
+	}
+	return ext;
+}
+
+static void appendDwords(std::vector<uint8_t>& data, const void* src, uint32_t sizeDwords)
+{
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(src);
+	data.insert(data.end(), bytes, bytes + sizeDwords * sizeof(uint32_t));
+}
+
+static void appendResource(
+	std::vector<uint8_t>&            data,
+	const GcnShaderResourceInstance& res,
+	uint32_t                         eudOffset)
+{
+	PsslShaderCaptureResource record = {};
+	record.usageType                 = res.usageType;
+	record.startRegister             = res.res.startRegister;
+	record.eudOffset                 = eudOffset;
+	record.sizeDwords                = res.res.sizeDwords;
+
+	appendDwords(data, &record, sizeof(record) / sizeof(uint32_t));
+
+	if (res.res.resource)
+	{
+		appendDwords(data, res.res.resource, res.res.sizeDwords);
+	}
+	else
+	{
+		data.resize(data.size() + res.res.sizeDwords * sizeof(uint32_t), 0);
+	}
+}
+
+PsslShaderCapture::PsslShaderCapture()
+{
+}
+
+PsslShaderCapture::~PsslShaderCapture()
+{
+}
+
+bool PsslShaderCapture::store(PsslShaderModule* module)
+{
+	bool ret = false;
+	do
+	{
+		const auto& progInfo  = module->programInfo();
+		const auto& resources = module->getShaderResources();
+
+		PsslShaderCaptureHeader header = {};
+		std::memcpy(header.magic, PsslShaderCaptureMagic, sizeof(header.magic));
+		header.version          = PsslShaderCaptureVersion;
+		header.codeDwords       = (progInfo.binarySizeBytes() + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+		header.fetchDwords      = module->fetchShaderSizeDwords();
+		header.udCount          = uint32_t(resources.ud.size());
+		header.eudCount         = resources.eud.has_value() ? uint32_t(resources.eud->resources.size()) : 0;
+		header.eudStartRegister = resources.eud.has_value() ? resources.eud->startRegister : UINT_MAX;
+
+		std::vector<uint8_t> data;
+		appendDwords(data, &header, sizeof(header) / sizeof(uint32_t));
+		appendDwords(data, module->code(), header.codeDwords);
+
+		if (header.fetchDwords)
+		{
+			appendDwords(data, module->fetchShaderCode(), header.fetchDwords);
+		}
+
+		for (const auto& res : resources.ud)
+		{
+			appendResource(data, res, 0);
+		}
+
+		if (resources.eud.has_value())
+		{
+			for (const auto& eudRes : resources.eud->resources)
+			{
+				appendResource(data, eudRes.second, eudRes.first);
+			}
+		}
+
+		char filename[64] = { 0 };
+		sprintf_s(filename, 64, "%016llX_%016llX.%s.gcn",
+				  module->key().toUint64(), module->inputHash(),
+				  getStageExtension(progInfo.shaderType()));
+
+		if (!UtilFile::StoreFile(filename, data))
+		{
+			LOG_WARN("failed to store shader capture %s.", filename);
+			break;
+		}
+
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+bool PsslShaderCapture::load(const std::string& path)
+{
+	bool ret = false;
+	do
+	{
+		std::vector<uint8_t> data;
+		if (!UtilFile::LoadFile(path, data))
+		{
+			LOG_WARN("failed to load shader capture %s.", path.c_str());
+			break;
+		}
+
+		size_t offset = 0;
+		auto   read   = [&data, &offset](void* dst, size_t size)
+		{
+			if (offset + size > data.size())
+			{
+				return false;
+			}
+
+			std::memcpy(dst, &data[offset], size);
+			offset += size;
+			return true;
+		};
+
+		PsslShaderCaptureHeader header = {};
+		if (!read(&header, sizeof(header)) ||
+			std::memcmp(header.magic, PsslShaderCaptureMagic, sizeof(header.magic)) ||
+			header.version != PsslShaderCaptureVersion)
+		{
+			LOG_WARN("invalid shader capture %s.", path.c_str());
+			break;
+		}
+
+		m_code.resize(header.codeDwords);
+		m_fetchShader.resize(header.fetchDwords);
+
+		bool valid = read(m_code.data(), m_code.size() * sizeof(uint32_t)) &&
+					 read(m_fetchShader.data(), m_fetchShader.size() * sizeof(uint32_t));
+
+		m_resources = GcnShaderResources();
+		m_resourceData.clear();
+
+		if (header.eudStartRegister != UINT_MAX)
+		{
+			m_resources.eud                = std::make_optional<GcnShaderResourceEUD>();
+			m_resources.eud->startRegister = header.eudStartRegister;
+		}
+
+		uint32_t resCount = header.udCount + header.eudCount;
+		for (uint32_t i = 0; i != resCount && valid; ++i)
+		{
+			PsslShaderCaptureResource record = {};
+			if (!read(&record, sizeof(record)))
+			{
+				valid = false;
+				break;
+			}
+
+			std::vector<uint32_t> resData(record.sizeDwords);
+			if (!read(resData.data(), resData.size() * sizeof(uint32_t)))
+			{
+				valid = false;
+				break;
+			}
+
+			m_resourceData.push_back(std::move(resData));
+
+			GcnShaderResourceInstance res = {};
+			res.usageType                 = static_cast<ShaderInputUsageType>(record.usageType);
+			res.res.startRegister         = record.startRegister;
+			res.res.sizeDwords            = record.sizeDwords;
+			res.res.resource              = m_resourceData.back().data();
+
+			if (i < header.udCount)
+			{
+				m_resources.ud.push_back(res);
+			}
+			else if (m_resources.eud.has_value())
+			{
+				m_resources.eud->resources.push_back(std::make_pair(record.eudOffset, res));
+			}
+			else
+			{
+				valid = false;
+			}
+		}
+
+		if (!valid)
+		{
+			LOG_WARN("truncated shader capture %s.", path.c_str());
+			break;
+		}
+
+		// Strip the directory and the .gcn extension
+		size_t nameBegin = path.find_last_of("/\\");
+		nameBegin        = nameBegin == std::string::npos ? 0 : nameBegin + 1;
+		size_t nameEnd   = path.find_last_of('.');
+		m_name           = path.substr(nameBegin, nameEnd > nameBegin ? nameEnd - nameBegin : std::string::npos);
+
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+RcPtr<PsslShaderModule> PsslShaderCapture::createModule() const
+{
+	RcPtr<PsslShaderModule> module = new PsslShaderModule(m_code.data());
+
+	if (!m_fetchShader.empty())
+	{
+		module->defineFetchShader(m_fetchShader.data());
+	}
+
+	module->defineShaderResources(m_resources);
+	return module;
+}
+
+const std::string& PsslShaderCapture::name() const
+{
+	return m_name;
+}
+
+}  // namespace pssl
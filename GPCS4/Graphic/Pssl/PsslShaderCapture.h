@@ -0,0 +1,111 @@
+#pragma once
+
+#include "PsslCommon.h"
+#include "PsslShaderStructure.h"
+
+#include <string>
+#include <vector>
+
+namespace pssl
+{;
+
+class PsslShaderModule;
+
+/**
+ * \brief Capture file header
+ *
+ * Followed by codeDwords dwords of shader binary,
+ * fetchDwords dwords of fetch shader, then udCount
+ * and eudCount resource records.
+ */
+struct PsslShaderCaptureHeader
+{
+	char     magic[4];
+	uint32_t version;
+	uint32_t codeDwords;        // Code up to the end of ShaderBinaryInfo
+	uint32_t fetchDwords;       // 0 if the shader has no fetch shader
+	uint32_t udCount;
+	uint32_t eudCount;
+	uint32_t eudStartRegister;  // UINT_MAX if the shader has no EUD
+	uint32_t reserved;
+};
+
+/**
+ * \brief Capture resource record
+ *
+ * Followed by sizeDwords dwords of resource data.
+ */
+struct PsslShaderCaptureResource
+{
+	uint32_t usageType;
+	uint32_t startRegister;
+	uint32_t eudOffset;   // Offset in EUD, 0 for user data resources
+	uint32_t sizeDwords;
+};
+
+/**
+ * \brief Captured shader compile inputs
+ *
+ * Everything a PsslShaderModule needs to be compiled
+ * without the game running: the shader binary, the
+ * fetch shader and the contents of the shader resources.
+ * Captures are written when PSSL_DUMP_SHADER is defined
+ * and replayed by the offline shader benchmark.
+ */
+class PsslShaderCapture
+{
+public:
+	PsslShaderCapture();
+	~PsslShaderCapture();
+
+	PsslShaderCapture(PsslShaderCapture&& other) = default;
+	PsslShaderCapture& operator = (PsslShaderCapture&& other) = default;
+
+	PsslShaderCapture(const PsslShaderCapture&) = delete;
+	PsslShaderCapture& operator = (const PsslShaderCapture&) = delete;
+
+	/**
+	 * \brief Writes the compile inputs of a module
+	 *
+	 * The file is named after the shader key and
+	 * input hash, e.g. <key>_<inputHash>.vs.gcn.
+	 * \param [in] module Module with its inputs defined
+	 * \returns \c true on success
+	 */
+	static bool store(PsslShaderModule* module);
+
+	/**
+	 * \brief Loads a capture file
+	 *
+	 * \param [in] path Path of the capture
+	 * \returns \c false if the file is missing or invalid
+	 */
+	bool load(const std::string& path);
+
+	/**
+	 * \brief Creates a module from the capture
+	 *
+	 * The module points into the capture,
+	 * which must outlive it.
+	 * \returns Module ready to be compiled
+	 */
+	RcPtr<PsslShaderModule> createModule() const;
+
+	/**
+	 * \brief Capture name
+	 * \returns File name without the extension
+	 */
+	const std::string& name() const;
+
+private:
+	std::string m_name;
+
+	std::vector<uint32_t> m_code;
+	std::vector<uint32_t> m_fetchShader;
+
+	// Resources point to the copies in m_resourceData
+	GcnShaderResources                 m_resources;
+	std::vector<std::vector<uint32_t>> m_resourceData;
+};
+
+}  // namespace pssl
@@ -5,8 +5,12 @@
 #include "GCNCompiler.h"
 
 #include "Platform/UtilFile.h"
+#include "Algorithm/MurmurHash2.h"
+#include "../Gnm/GnmSharpBuffer.h"
 #include "../Violet/VltShader.h"
 
+#include <chrono>
+
 LOG_CHANNEL(Graphic.Pssl.PsslShaderModule);
 
 namespace pssl
@@ -69,15 +73,33 @@ PsslShaderModule::~PsslShaderModule()
 {
 }
 
-RcPtr<vlt::VltShader> PsslShaderModule::compile()
+RcPtr<GCNProgram> PsslShaderModule::decode()
 {
 	const uint32_t* codeEnd = m_code + m_progInfo.codeSizeDwords();
 	GCNCodeSlice codeSlice(m_code, codeEnd);
 
+	return new GCNProgram(codeSlice);
+}
+
+RcPtr<vlt::VltShader> PsslShaderModule::compile()
+{
+	return compile(decode());
+}
+
+RcPtr<vlt::VltShader> PsslShaderModule::compile(
+	const RcPtr<GCNProgram>& program,
+	PsslShaderProfile*       profile)
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	auto t0 = Clock::now();
+
 	// Analyze shader global information
 	GcnAnalysisInfo analysisInfo;
 	GCNAnalyzer analyzer(analysisInfo);
-	runAnalyzer(analyzer, codeSlice);
+	runAnalyzer(analyzer, *program);
+
+	auto t1 = Clock::now();
 
 	// Generate input
 	GcnShaderInput shaderInput;
@@ -89,9 +111,22 @@ RcPtr<vlt::VltShader> PsslShaderModule::compile()
 
 	// Recompile
 	GCNCompiler compiler(m_progInfo, analysisInfo, shaderInput);
-	runCompiler(compiler, codeSlice);
+	runCompiler(compiler, *program);
+
+	auto t2 = Clock::now();
+
+	auto shader = compiler.finalize();
 
-	return compiler.finalize();
+	auto t3 = Clock::now();
+
+	if (profile)
+	{
+		profile->analyzeNs  = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+		profile->compileNs  = std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count();
+		profile->finalizeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(t3 - t2).count();
+	}
+
+	return shader;
 }
 
 std::vector<GcnShaderResourceInstance> 
@@ -126,6 +161,9 @@ void PsslShaderModule::parseFetchShader(const uint32_t* fsCode)
 	decodeFetchShader(fsCodeSlice, fsShader);
 	extractInputSemantic(fsShader);
 
+	m_fsCode       = fsCode;
+	m_fsCodeDwords = fsShader.m_codeLengthDw + 1;
+
 #ifdef PSSL_DUMP_SHADER
 	dumpShader(PsslProgramType::FetchShader, (const uint8_t*)fsCode, fsShader.m_codeLengthDw * sizeof(uint32_t));
 #endif  // GPCS4_DUMP_SHADER
@@ -494,27 +532,19 @@ void PsslShaderModule::dumpShader(PsslProgramType type, const uint8_t* code, uin
 	UtilFile::StoreFile(filename, code, size);
 }
 
-void PsslShaderModule::runAnalyzer(GCNAnalyzer& analyzer, GCNCodeSlice slice)
+void PsslShaderModule::runAnalyzer(GCNAnalyzer& analyzer, const GCNProgram& program)
 {
-	GCNDecodeContext decoder;
-
-	while (!slice.atEnd())
+	for (const auto& ins : program.instructions())
 	{
-		decoder.decodeInstruction(slice);
-
-		analyzer.processInstruction(decoder.getInstruction());
+		analyzer.processInstruction(ins);
 	}
 }
 
-void PsslShaderModule::runCompiler(GCNCompiler& compiler, GCNCodeSlice slice)
+void PsslShaderModule::runCompiler(GCNCompiler& compiler, const GCNProgram& program)
 {
-	GCNDecodeContext decoder;
-
-	while (!slice.atEnd())
+	for (const auto& ins : program.instructions())
 	{
-		decoder.decodeInstruction(slice);
-
-		compiler.processInstruction(decoder.getInstruction());
+		compiler.processInstruction(ins);
 	}
 }
 
@@ -534,6 +564,11 @@ void PsslShaderModule::defineShaderInput(const std::vector<PsslShaderResource>&
 	m_shaderInputTable.assign(shaderInputTab.cbegin(), shaderInputTab.cend());
 }
 
+void PsslShaderModule::defineShaderResources(const GcnShaderResources& resources)
+{
+	m_shaderResources = resources;
+}
+
 const GcnShaderResources& PsslShaderModule::getShaderResources()
 {
 	do
@@ -558,6 +593,109 @@ PsslKey PsslShaderModule::key()
 	return m_progInfo.key();
 }
 
+const PsslProgramInfo& PsslShaderModule::programInfo() const
+{
+	return m_progInfo;
+}
+
+const uint32_t* PsslShaderModule::code() const
+{
+	return m_code;
+}
+
+const uint32_t* PsslShaderModule::fetchShaderCode() const
+{
+	return m_fsCode;
+}
+
+uint32_t PsslShaderModule::fetchShaderSizeDwords() const
+{
+	return m_fsCodeDwords;
+}
+
+uint64_t PsslShaderModule::inputHash()
+{
+	std::vector<uint32_t> inputs;
+
+	for (const auto& semantic : m_vsInputSemantic)
+	{
+		inputs.push_back(semantic.semantic);
+		inputs.push_back(semantic.vgpr);
+		inputs.push_back(semantic.sizeInElements);
+	}
+
+	const auto& resources = getShaderResources();
+	for (const auto& res : resources.ud)
+	{
+		appendResourceHashInput(inputs, res);
+	}
+
+	if (resources.eud.has_value())
+	{
+		inputs.push_back(resources.eud->startRegister);
+		for (const auto& eudRes : resources.eud->resources)
+		{
+			inputs.push_back(eudRes.first);
+			appendResourceHashInput(inputs, eudRes.second);
+		}
+	}
+
+	return algo::MurmurHash(inputs.data(), inputs.size() * sizeof(uint32_t));
+}
+
+void PsslShaderModule::detachShaderResources()
+{
+	getShaderResources();
+
+	for (auto& res : m_shaderResources.ud)
+	{
+		detachShaderResource(res.res);
+	}
+
+	if (m_shaderResources.eud.has_value())
+	{
+		for (auto& eudRes : m_shaderResources.eud->resources)
+		{
+			detachShaderResource(eudRes.second.res);
+		}
+	}
+}
+
+void PsslShaderModule::detachShaderResource(PsslShaderResource& res)
+{
+	do
+	{
+		if (!res.resource || !res.sizeDwords)
+		{
+			break;
+		}
+
+		const uint32_t* data = reinterpret_cast<const uint32_t*>(res.resource);
+		m_detachedResources.emplace_back(data, data + res.sizeDwords);
+
+		// Moving the outer vector doesn't move the copied data,
+		// so the pointer stays valid.
+		res.resource = m_detachedResources.back().data();
+	} while (false);
+}
+
+void PsslShaderModule::appendResourceHashInput(
+	std::vector<uint32_t>&           inputs,
+	const GcnShaderResourceInstance& res)
+{
+	inputs.push_back(res.usageType);
+	inputs.push_back(res.res.startRegister);
+	inputs.push_back(res.res.sizeDwords);
+
+	// The uniform buffer array size is taken from the V# at compile time,
+	// see GCNCompiler::emitDclImmConstBuffer
+	if (res.usageType == kShaderInputUsageImmConstBuffer)
+	{
+		const VSharpBuffer* vsharp = reinterpret_cast<const VSharpBuffer*>(res.res.resource);
+		inputs.push_back(vsharp->stride * vsharp->num_records);
+	}
+}
+
 std::vector<VertexInputSemantic> PsslShaderModule::vsInputSemantic()
 {
 	return m_vsInputSemantic;
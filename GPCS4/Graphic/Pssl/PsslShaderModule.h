@@ -18,6 +18,18 @@ struct PsslFetchShader;
 class GCNCompiler;
 class GCNAnalyzer;
 
+/**
+ * \brief Shader compile profile
+ *
+ * Time spent in each compile stage, in nanoseconds.
+ */
+struct PsslShaderProfile
+{
+	uint64_t analyzeNs  = 0;
+	uint64_t compileNs  = 0;
+	uint64_t finalizeNs = 0;
+};
+
 
 class PsslShaderModule : public RcObject
 {
@@ -30,6 +42,15 @@ public:
 
 	void defineShaderInput(const std::vector<PsslShaderResource>& shaderInputTab);
 
+	/**
+	 * \brief Defines already parsed shader resources
+	 *
+	 * Used to replay captured shaders, instead of
+	 * parsing an input table from the game.
+	 * The resource data must outlive the module.
+	 */
+	void defineShaderResources(const GcnShaderResources& resources);
+
 	const GcnShaderResources& getShaderResources();
 
 	std::vector<VertexInputSemantic> vsInputSemantic();
@@ -38,16 +59,70 @@ public:
 
 	PsslKey key();
 
+	const PsslProgramInfo& programInfo() const;
+
+	const uint32_t* code() const;
+
+	/**
+	 * \brief Fetch shader code
+	 *
+	 * Including the input slot count following the code.
+	 * \returns The code, or \c nullptr if none is defined
+	 */
+	const uint32_t* fetchShaderCode() const;
+
+	uint32_t fetchShaderSizeDwords() const;
+
+	/**
+	 * \brief Hash of compile inputs
+	 *
+	 * Everything besides the GCN code which changes
+	 * the emitted SPIR-V, i.e. the fetch shader semantics
+	 * and the layout of the shader resources.
+	 * Used together with key() to identify a compiled shader.
+	 */
+	uint64_t inputHash();
+
+	/**
+	 * \brief Copies shader resources into the module
+	 *
+	 * Parsed resources point to user data and EUD in guest
+	 * memory, which the game may overwrite once the command
+	 * buffer is processed. This makes the module self-contained,
+	 * so it can be compiled on a background thread.
+	 */
+	void detachShaderResources();
+
+	/**
+	 * \brief Decodes the GCN code
+	 *
+	 * The result only depends on the code, so it
+	 * can be reused by modules with the same key.
+	 * \returns Decoded program
+	 */
+	RcPtr<GCNProgram> decode();
+
 	RcPtr<vlt::VltShader> compile();
 
+	/**
+	 * \brief Compiles a previously decoded program
+	 *
+	 * \param [in] program Program decoded from this module's code
+	 * \param [out] profile Optional compile stage timings
+	 * \returns The compiled shader
+	 */
+	RcPtr<vlt::VltShader> compile(
+		const RcPtr<GCNProgram>& program,
+		PsslShaderProfile*       profile = nullptr);
+
 	static std::vector<GcnShaderResourceInstance>
 	flattenShaderResources(const GcnShaderResources& nestedResources);
 
 private:
 
-	void runAnalyzer(GCNAnalyzer& analyzer, GCNCodeSlice slice);
+	void runAnalyzer(GCNAnalyzer& analyzer, const GCNProgram& program);
 
-	void runCompiler(GCNCompiler& compiler, GCNCodeSlice slice);
+	void runCompiler(GCNCompiler& compiler, const GCNProgram& program);
 
 	// Fetch Shader parsing functions
 	void parseFetchShader(const uint32_t* fsCode);
@@ -64,11 +139,20 @@ private:
 	void parseResPtrTable();
 	bool checkUnhandledRes();
 
+	void detachShaderResource(PsslShaderResource& res);
+
+	void appendResourceHashInput(
+		std::vector<uint32_t>&           inputs,
+		const GcnShaderResourceInstance& res);
+
 	// Debug only
 	void dumpShader(PsslProgramType type, const uint8_t* code, uint32_t size);
 private:
 	const uint32_t* m_code;
 
+	const uint32_t* m_fsCode       = nullptr;
+	uint32_t        m_fsCodeDwords = 0;
+
 	PsslProgramInfo m_progInfo;
 
 	std::vector<VertexInputSemantic> m_vsInputSemantic;
@@ -83,6 +167,9 @@ private:
 
 	const uint32_t* m_eudTable       = nullptr;
 
+	// Resource copies made by detachShaderResources
+	std::vector<std::vector<uint32_t>> m_detachedResources;
+
 	static const uint8_t m_shaderResourceSizeInDwords[kShaderInputUsageImmDispatchDrawInstances + 1];
 };
 
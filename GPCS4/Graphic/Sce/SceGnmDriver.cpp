@@ -4,16 +4,22 @@
 #include "UtilMath.h"
 #include "sce_errors.h"
 
+#include "../Gnm/GnmCmdCapture.h"
 #include "../Gnm/GnmCmdStream.h"
 #include "../Gnm/GnmCommandBufferDraw.h"
 #include "../Gnm/GnmCommandBufferDummy.h"
 #include "../GraphicShared.h"
+#include "../Pssl/PsslShaderArchive.h"
+#include "../Pssl/PsslShaderCache.h"
 #include "../Violet/VltCmdList.h"
+#include "../Violet/VltDevice.h"
 #include "../Violet/VltImage.h"
 #include "../Violet/VltInstance.h"
 #include "../Violet/VltPhysicalDevice.h"
 #include "../Violet/VltPresenter.h"
 
+#include <unordered_map>
+
 LOG_CHANNEL(Graphic.Sce.SceGnmDriver);
 
 using namespace vlt;
@@ -36,6 +42,12 @@ SceGnmDriver::~SceGnmDriver()
 	// e.g. wrap VkSurfaceKHR in a class with reference count
 
 	m_graphicsQueue.reset();
+	// Queued presents and frame status
+	// must be done before they are released.
+	if (m_device)
+	{
+		m_device->syncSubmissions();
+	}
 	// Release Presenter before VideoOut
 	m_presenter = nullptr;
 	// Release VideoOut before GnmDriver.
@@ -74,11 +86,88 @@ bool SceGnmDriver::initGnmDriver()
 			break;
 		}
 
+		m_shaderCache = std::make_shared<pssl::PsslShaderCache>();
+
+		// Before the game submits its first command buffer.
+		prewarmPipelines();
+
 		ret = true;
 	} while (false);
 	return ret;
 }
 
+void SceGnmDriver::createCapture()
+{
+	do
+	{
+		auto path = GnmCmdCapture::getCapturePath();
+		if (path.empty())
+		{
+			break;
+		}
+
+		std::vector<GnmCaptureDisplayBuffer> displayBuffers;
+		for (uint32_t i = 0; i != m_videoOut->numDisplayBuffer(); ++i)
+		{
+			auto buffer = m_videoOut->getDisplayBuffer(i);
+
+			GnmCaptureDisplayBuffer captureBuffer = {};
+			captureBuffer.address                 = reinterpret_cast<uint64_t>(buffer.address);
+			captureBuffer.tile                    = buffer.tile;
+			captureBuffer.format                  = buffer.format;
+			captureBuffer.width                   = buffer.width;
+			captureBuffer.height                  = buffer.height;
+			captureBuffer.size                    = buffer.size;
+			displayBuffers.push_back(captureBuffer);
+		}
+
+		auto capture = std::make_unique<GnmCmdCapture>();
+		if (!capture->open(path, displayBuffers))
+		{
+			break;
+		}
+
+		LOG_DEBUG("capturing command buffers to %s.", path.c_str());
+		m_capture = std::move(capture);
+	} while (false);
+}
+
+void SceGnmDriver::prewarmPipelines()
+{
+	do
+	{
+		auto budget  = VltPipelineManager::getPrewarmBudget();
+		auto archive = pssl::PsslShaderArchive::GetInstance();
+		if (budget.count() == 0 || !archive->isOpen())
+		{
+			break;
+		}
+
+		// Pipelines only know the shader key, not the input hash.
+		// Shaders with the same key are the same shader to the
+		// pipeline manager anyway.
+		std::unordered_map<uint64_t, pssl::PsslShaderCacheKey> shaderKeys;
+		for (const auto& key : archive->keys())
+		{
+			shaderKeys.emplace(key.key.toUint64(), key);
+		}
+
+		auto findShader = [&shaderKeys, archive](uint64_t key)
+		{
+			RcPtr<VltShader> shader = nullptr;
+
+			auto iter = shaderKeys.find(key);
+			if (iter != shaderKeys.end())
+			{
+				shader = archive->load(iter->second);
+			}
+			return shader;
+		};
+
+		m_device->prewarmPipelines(findShader, budget);
+	} while (false);
+}
+
 bool SceGnmDriver::pickPhysicalDevice(
 	const std::vector<RcPtr<vlt::VltPhysicalDevice>>& devices,
 	VkSurfaceKHR                                      surface)
@@ -172,21 +261,23 @@ int SceGnmDriver::submitAndFlipCommandBuffers(uint32_t  count,
 	// There's only one hardware graphics queue for most of modern GPUs, including the one on PS4.
 	// Thus a PS4 game will call submit function to submit command buffers sequentially,
 	// and normally in one same thread.
-	// We just emulate the GPU, parsing and executing one command buffer per call.
-
-	// TODO:
-	// For real PS4 system, the submit call is asynchronous.
-	// Thus future development, we should record vulkan command buffer asynchronously too,
-	// reducing time period of the submit call.
+	// Like on real PS4 system, the submit call is asynchronous: the queue's frontend thread
+	// parses and records the command buffer, so the game thread returns at once.
+	// The game sees the progress through labels written by the command buffer and the flip status.
 
 	LOG_ASSERT(count == 1, "Currently only support 1 cmdbuff at one call.");
 
 	SceGpuCommand cmd = {};
 	cmd.buffer        = dcbGpuAddrs[0];
 	cmd.size          = dcbSizesInBytes[0];
-	auto cmdList      = m_graphicsQueue->record(cmd, displayBufferIndex);
 
-	submitPresent(cmdList);
+	++m_flipSubmitCount;
+	m_graphicsQueue->dispatch(cmd, displayBufferIndex,
+							  [this, displayBufferIndex, flipArg](const RcPtr<VltCmdList>& cmdList)
+							  {
+								  submitPresent(cmdList);
+								  finishFlip(displayBufferIndex, flipArg);
+							  });
 
 	return SCE_OK;
 }
@@ -201,6 +292,16 @@ void SceGnmDriver::submitPresent(const RcPtr<vlt::VltCmdList>& cmdList)
 		}
 
 		PresenterSync presentSync = m_presenter->getSyncObjects();
+		auto&         frameStatus = m_frameStatus[m_presenter->getFrameIndex()];
+
+		// Submission and present run on the submission queue thread.
+		// The semaphores must not be in use when reused, so wait for
+		// the last command list using them, usually long done.
+		m_device->waitForSubmission(&frameStatus);
+
+		// The swap chain must not be used by two threads at once,
+		// so the last present has to finish before acquiring.
+		m_device->waitForSubmission(m_presentStatus.get());
 
 		uint32_t imageIndex = 0;
 		VkResult status     = m_presenter->acquireNextImage(presentSync.acquire, VK_NULL_HANDLE, imageIndex);
@@ -213,16 +314,37 @@ void SceGnmDriver::submitPresent(const RcPtr<vlt::VltCmdList>& cmdList)
 		gpuSubmission.cmdList          = cmdList;
 		gpuSubmission.wait             = presentSync.acquire;
 		gpuSubmission.wake             = presentSync.present;
+		gpuSubmission.status           = &frameStatus;
 		m_graphicsQueue->submit(gpuSubmission);
 
 		VltPresentInfo presentation;
-		presentation.presenter = m_presenter;
-		presentation.waitSync  = gpuSubmission.wake;
-		m_device->presentImage(presentation);
-
+		presentation.presenter  = m_presenter;
+		presentation.waitSync   = gpuSubmission.wake;
+		presentation.imageIndex = imageIndex;
+		m_device->presentImage(presentation, m_presentStatus.get());
+
+		auto stats = m_device->getSubmissionStats();
+		LOG_TRACE("submission queue: depth %u, %u command lists in flight, latency max %llu us.",
+				  stats.queueDepth, stats.pendingCount, stats.maxLatencyUs);
 	} while (false);
 }
 
+void SceGnmDriver::finishFlip(uint32_t displayBufferIndex, int64_t flipArg)
+{
+	m_flipArg    = flipArg;
+	m_flipBuffer = displayBufferIndex;
+	++m_flipCount;
+}
+
+void SceGnmDriver::getFlipStatus(SceFlipStatus& status)
+{
+	status.count         = m_flipCount;
+	status.flipArg       = m_flipArg;
+	status.currentBuffer = m_flipBuffer;
+	status.pendingCount  = uint32_t(m_flipSubmitCount - status.count);
+	status.gpuQueueCount = m_graphicsQueue ? m_graphicsQueue->getStats().pendingCount : 0;
+}
+
 int SceGnmDriver::sceGnmSubmitDone(void)
 {
 	m_videoOut->processEvents();
@@ -259,11 +381,18 @@ bool SceGnmDriver::createGraphicsQueue(uint32_t imageCount)
 			break;
 		}
 
+		m_frameStatus   = std::make_unique<VltSubmitStatus[]>(m_presenter->info().imageCount);
+		m_presentStatus = std::make_unique<VltSubmitStatus>();
+
+		createCapture();
+
 		// Create the only graphics queue.
 		SceGpuQueueDevice gfxDevice = {};
 		gfxDevice.device            = m_device;
 		gfxDevice.presenter         = m_presenter;
 		gfxDevice.videoOut          = m_videoOut;
+		gfxDevice.shaderCache       = m_shaderCache;
+		gfxDevice.capture           = m_capture.get();
 		m_graphicsQueue             = std::make_unique<SceGpuQueue>(gfxDevice, SceQueueType::Graphics);
 
 		ret = true;
@@ -323,6 +452,7 @@ uint32_t SceGnmDriver::mapComputeQueue(uint32_t pipeId,
 		cptDevice.device            = m_device;
 		cptDevice.presenter         = nullptr;
 		cptDevice.videoOut          = nullptr;
+		cptDevice.shaderCache       = m_shaderCache;
 
 		uint32_t vqueueIndex        = vqueueId - VQueueIdBegin;
 		m_computeQueues[vqueueIndex] = std::make_unique<SceGpuQueue>(cptDevice, SceQueueType::Compute);
@@ -6,6 +6,7 @@
 #include "../Violet/VltDeviceInfo.h"
 
 #include <array>
+#include <atomic>
 #include <memory>
 
 namespace vlt
@@ -15,10 +16,17 @@ class VltPhysicalDevice;
 class VltDevice;
 class VltPresenter;
 class VltCmdList;
+struct VltSubmitStatus;
 }  // namespace vlt
 
+namespace pssl
+{;
+class PsslShaderCache;
+}  // namespace pssl
+
 class GnmCmdStream;
 class GnmCommandBuffer;
+class GnmCmdCapture;
 
 namespace sce
 {;
@@ -32,6 +40,15 @@ constexpr uint32_t MaxPipeId            = 7;  // Some docs say it should be 7, o
 constexpr uint32_t MaxQueueId           = 8;
 constexpr uint32_t MaxComputeQueueCount = MaxPipeId * MaxQueueId;
 
+struct SceFlipStatus
+{
+	uint64_t count;          // Flips done
+	int64_t  flipArg;        // Argument of the last flip done
+	uint32_t currentBuffer;  // Display buffer of the last flip done
+	uint32_t pendingCount;   // Flips submitted, not done yet
+	uint32_t gpuQueueCount;  // Command buffers the frontend hasn't processed
+};
+
 class SceGnmDriver
 {
 	friend class SceVideoOut;
@@ -63,6 +80,15 @@ public:
 
 	int sceGnmSubmitDone(void);
 
+	/**
+	 * \brief Flip status
+	 *
+	 * Command buffers are processed asynchronously, a flip is
+	 * done once its command list is queued for presentation.
+	 * \param [out] status Flip counters
+	 */
+	void getFlipStatus(SceFlipStatus& status);
+
 	/// Compute
 
 	uint32_t mapComputeQueue(
@@ -81,6 +107,10 @@ public:
 private:
 	bool initGnmDriver();
 
+	void prewarmPipelines();
+
+	void createCapture();
+
 	bool pickPhysicalDevice(
 		const std::vector<RcPtr<vlt::VltPhysicalDevice>>& devices,
 		VkSurfaceKHR                                      surface);
@@ -98,6 +128,8 @@ private:
 
 	void submitPresent(const RcPtr<vlt::VltCmdList>& cmdList);
 
+	void finishFlip(uint32_t displayBufferIndex, int64_t flipArg);
+
 private:
 	std::shared_ptr<SceVideoOut> m_videoOut;
 
@@ -106,6 +138,23 @@ private:
 	RcPtr<vlt::VltDevice>         m_device;
 	RcPtr<vlt::VltPresenter>      m_presenter;
 
+	// One per presenter frame, the frame's semaphores
+	// can be reused once its command list has executed.
+	std::unique_ptr<vlt::VltSubmitStatus[]> m_frameStatus;
+	// Set once the last queued present is done.
+	std::unique_ptr<vlt::VltSubmitStatus>   m_presentStatus;
+
+	std::atomic<uint64_t> m_flipSubmitCount = { 0 };
+	std::atomic<uint64_t> m_flipCount       = { 0 };
+	std::atomic<int64_t>  m_flipArg         = { 0 };
+	std::atomic<uint32_t> m_flipBuffer      = { 0 };
+
+	// Shared by all queues
+	std::shared_ptr<pssl::PsslShaderCache> m_shaderCache;
+
+	// Graphics queue capture, if enabled
+	std::unique_ptr<GnmCmdCapture> m_capture;
+
 	std::unique_ptr<SceGpuQueue>                                   m_graphicsQueue;
 	std::array<std::unique_ptr<SceGpuQueue>, MaxComputeQueueCount> m_computeQueues;
 };
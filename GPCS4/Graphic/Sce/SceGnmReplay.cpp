@@ -0,0 +1,322 @@
+#include "SceGnmReplay.h"
+#include "SceGnmDriver.h"
+#include "SceGpuQueue.h"
+#include "SceVideoOut.h"
+
+#include "../GraphicShared.h"
+#include "../Gnm/GnmCmdCapture.h"
+#include "../Gnm/GnmCmdStream.h"
+#include "../Gnm/GnmCommandBufferDummy.h"
+#include "../Gnm/GnmCommandBufferDraw.h"
+#include "../Gnm/GnmCommandSinkNull.h"
+#include "../Pssl/PsslShaderCache.h"
+#include "../../SceModules/SceVideoOut/sce_videoout_types.h"
+#include "Platform/UtilMemory.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+LOG_CHANNEL(Graphic.Sce.SceGnmReplay);
+
+namespace sce
+{;
+
+using Clock = std::chrono::high_resolution_clock;
+
+// Address space is reserved in 64 KB blocks.
+constexpr uintptr_t ReplayBlockSize = 0x10000;
+
+/**
+ * \brief Guest memory of a replay
+ *
+ * Maps blocks at the captured addresses on first
+ * use and keeps them until the replay is done.
+ */
+class SceReplayMemory
+{
+public:
+	~SceReplayMemory()
+	{
+		for (auto block : m_blocks)
+		{
+			UtilMemory::VMUnMap(reinterpret_cast<void*>(block), 0);
+		}
+	}
+
+	bool map(uint64_t address, uint64_t size)
+	{
+		bool ret = true;
+
+		uintptr_t begin = uintptr_t(address) & ~(ReplayBlockSize - 1);
+		uintptr_t end   = uintptr_t(address + size);
+		for (uintptr_t block = begin; block < end; block += ReplayBlockSize)
+		{
+			if (m_blocks.count(block))
+			{
+				continue;
+			}
+
+			void* mapped = UtilMemory::VMMapFlexible(
+				reinterpret_cast<void*>(block), ReplayBlockSize, UtilMemory::VMPF_READ_WRITE);
+			if (mapped != reinterpret_cast<void*>(block))
+			{
+				LOG_ERR("guest address %p is in use in this process.", reinterpret_cast<void*>(block));
+				if (mapped)
+				{
+					UtilMemory::VMUnMap(mapped, 0);
+				}
+				ret = false;
+				break;
+			}
+
+			m_blocks.insert(block);
+		}
+		return ret;
+	}
+
+	bool write(uint64_t address, const void* data, uint64_t size)
+	{
+		bool ret = map(address, size);
+		if (ret)
+		{
+			std::memcpy(reinterpret_cast<void*>(address), data, size);
+		}
+		return ret;
+	}
+
+private:
+	std::unordered_set<uintptr_t> m_blocks;
+};
+
+// Executes one command buffer, returns when its frame is done.
+using SceReplayFrameFunc = std::function<void(void* buffer, uint32_t size, uint32_t displayBufferIndex)>;
+
+static bool replayFrames(
+	GnmCmdCaptureReader&      reader,
+	SceReplayMemory&          memory,
+	const SceReplayFrameFunc& runFrame,
+	std::vector<double>&      frameTimes)
+{
+	bool ret = true;
+
+	GnmCaptureRecord record = {};
+	const void*      data   = nullptr;
+	while (ret && reader.next(record, data))
+	{
+		ret = memory.write(record.address, data, record.size);
+		if (!ret || record.type != GnmCaptureRecordType::CommandBuffer)
+		{
+			continue;
+		}
+
+		auto begin = Clock::now();
+		runFrame(reinterpret_cast<void*>(record.address), uint32_t(record.size), record.displayBufferIndex);
+		auto end = Clock::now();
+
+		double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+		printf("frame %5zu: %8.3f ms\n", frameTimes.size(), ms);
+		frameTimes.push_back(ms);
+	}
+	return ret;
+}
+
+static bool replayParse(GnmCmdCaptureReader& reader, SceReplayMemory& memory, std::vector<double>& frameTimes)
+{
+	GnmCommandBufferDummy commandBuffer;
+	GnmCmdStream          cmdStream;
+	cmdStream.attachCommandBuffer(&commandBuffer);
+
+	auto runFrame = [&](void* buffer, uint32_t size, uint32_t displayBufferIndex)
+	{
+		commandBuffer.recordBegin(displayBufferIndex);
+		cmdStream.processCommandBuffer(buffer, size);
+		commandBuffer.recordEnd();
+	};
+
+	return replayFrames(reader, memory, runFrame, frameTimes);
+}
+
+static bool replayNull(GnmCmdCaptureReader& reader, SceReplayMemory& memory, std::vector<double>& frameTimes)
+{
+	SceGpuQueueDevice device = {};
+	device.shaderCache       = std::make_shared<pssl::PsslShaderCache>();
+
+	RcPtr<GnmCommandSinkNull> sink = new GnmCommandSinkNull();
+	GnmCommandBufferDraw      commandBuffer(device, RcPtr<GnmCommandSink>(sink));
+	GnmCmdStream              cmdStream;
+	cmdStream.attachCommandBuffer(&commandBuffer);
+
+	auto runFrame = [&](void* buffer, uint32_t size, uint32_t displayBufferIndex)
+	{
+		commandBuffer.recordBegin(displayBufferIndex);
+		cmdStream.processCommandBuffer(buffer, size);
+		commandBuffer.recordEnd();
+	};
+
+	bool ret = replayFrames(reader, memory, runFrame, frameTimes);
+
+	const auto& stats = sink->getStats();
+	printf("null sink: %u draws, %u dispatches, %u clears, %u states, %u render targets, %u shaders\n",
+		   stats.drawCount, stats.dispatchCount, stats.clearCount,
+		   stats.stateCount, stats.renderTargetCount, stats.shaderCount);
+	printf("null sink: %u buffers with %llu bytes, %u samplers, %u textures, %u uploaded with %llu bytes\n",
+		   stats.bufferCount, stats.bufferBytes, stats.samplerCount,
+		   stats.textureCount, stats.textureUploadCount, stats.textureUploadBytes);
+	return ret;
+}
+
+static bool replayVulkan(GnmCmdCaptureReader& reader, SceReplayMemory& memory, std::vector<double>& frameTimes)
+{
+	bool ret = false;
+	do
+	{
+		auto videoOut = std::make_shared<SceVideoOut>(kVideoOutDefaultWidth, kVideoOutDefaultHeight);
+
+		const auto& displayBuffers = reader.displayBuffers();
+		if (displayBuffers.empty())
+		{
+			LOG_ERR("capture has no display buffer.");
+			break;
+		}
+
+		bool mapped = true;
+		for (uint32_t i = 0; i != displayBuffers.size() && mapped; ++i)
+		{
+			const auto& displayBuffer = displayBuffers[i];
+			mapped                    = memory.map(displayBuffer.address, displayBuffer.size);
+
+			SceVideoOutBufferAttribute attribute = {};
+			attribute.pixelFormat                = displayBuffer.format;
+			attribute.tilingMode                 = displayBuffer.tile;
+			attribute.width                      = displayBuffer.width;
+			attribute.height                     = displayBuffer.height;
+			attribute.pitchInPixel               = displayBuffer.width;
+
+			void* address = reinterpret_cast<void*>(displayBuffer.address);
+			mapped        = mapped && videoOut->registerDisplayrBuffers(i, &address, 1, &attribute);
+		}
+
+		if (!mapped)
+		{
+			break;
+		}
+
+		SceGnmDriver driver(videoOut);
+		if (!driver.createGraphicsQueue(uint32_t(displayBuffers.size())))
+		{
+			break;
+		}
+
+		// A frame is done once its flip is, which
+		// includes the translation of new shaders.
+		uint64_t flipCount = 0;
+		auto     runFrame  = [&](void* buffer, uint32_t size, uint32_t displayBufferIndex)
+		{
+			++flipCount;
+			driver.submitAndFlipCommandBuffers(1, &buffer, &size, nullptr, nullptr,
+											   SCE_VIDEO_HANDLE_MAIN, displayBufferIndex, 0, int64_t(flipCount));
+
+			SceFlipStatus status = {};
+			driver.getFlipStatus(status);
+			while (status.count < flipCount)
+			{
+				std::this_thread::yield();
+				driver.getFlipStatus(status);
+			}
+
+			driver.sceGnmSubmitDone();
+		};
+
+		ret = replayFrames(reader, memory, runFrame, frameTimes);
+	} while (false);
+	return ret;
+}
+
+bool parseReplayBackend(const std::string& name, SceReplayBackend& backend)
+{
+	bool ret = true;
+	if (name == "parse")
+	{
+		backend = SceReplayBackend::Parse;
+	}
+	else if (name == "null")
+	{
+		backend = SceReplayBackend::Null;
+	}
+	else if (name == "vulkan")
+	{
+		backend = SceReplayBackend::Vulkan;
+	}
+	else
+	{
+		LOG_ERR("unknown replay backend %s.", name.c_str());
+		ret = false;
+	}
+	return ret;
+}
+
+bool runCmdReplay(const std::string& path, SceReplayBackend backend)
+{
+	bool ret = false;
+	do
+	{
+		GnmCmdCaptureReader reader;
+		if (!reader.open(path))
+		{
+			break;
+		}
+
+		// Outlives the driver, which may still
+		// read guest memory while shutting down.
+		SceReplayMemory     memory;
+		std::vector<double> frameTimes;
+
+		bool success = false;
+		switch (backend)
+		{
+		case SceReplayBackend::Parse:
+			success = replayParse(reader, memory, frameTimes);
+			break;
+		case SceReplayBackend::Null:
+			success = replayNull(reader, memory, frameTimes);
+			break;
+		case SceReplayBackend::Vulkan:
+			success = replayVulkan(reader, memory, frameTimes);
+			break;
+		}
+
+		if (!success)
+		{
+			break;
+		}
+
+		if (frameTimes.empty())
+		{
+			LOG_ERR("capture %s has no command buffer.", path.c_str());
+			break;
+		}
+
+		std::vector<double> sorted = frameTimes;
+		std::sort(sorted.begin(), sorted.end());
+
+		double total = 0.0;
+		for (double ms : sorted)
+		{
+			total += ms;
+		}
+
+		printf("%zu frames: avg %.3f ms, min %.3f ms, p95 %.3f ms, max %.3f ms\n",
+			   sorted.size(), total / sorted.size(),
+			   sorted.front(), sorted[sorted.size() * 95 / 100], sorted.back());
+
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+}  // namespace sce
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "SceCommon.h"
+
+#include <string>
+
+namespace sce
+{;
+
+enum class SceReplayBackend
+{
+	Parse  = 0,  // Command buffers are parsed, only labels are written
+	Null   = 1,  // The whole frontend without a device, see GnmCommandSinkNull
+	Vulkan = 2,  // The graphics queue of a full driver, flips are presented
+};
+
+/**
+ * \brief Parses a replay backend name
+ *
+ * \param [in] name \c parse, \c null or \c vulkan
+ * \param [out] backend The backend
+ * \returns \c false for an unknown name
+ */
+bool parseReplayBackend(const std::string& name, SceReplayBackend& backend);
+
+/**
+ * \brief Replays a command buffer capture
+ *
+ * Maps the captured guest memory at its original addresses,
+ * since command buffers and descriptors hold absolute pointers,
+ * then executes the command buffers one frame at a time and
+ * prints the CPU time of each frame. Fails if an address is
+ * already in use in this process.
+ * \param [in] path Capture written with \c --pm4-capture
+ * \param [in] backend Backend executing the command buffers
+ * \returns \c false if the capture could not be replayed
+ */
+bool runCmdReplay(const std::string& path, SceReplayBackend backend);
+
+}  // namespace sce
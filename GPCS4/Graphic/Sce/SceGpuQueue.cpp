@@ -1,5 +1,6 @@
 #include "SceGpuQueue.h"
 
+#include "../Gnm/GnmCmdCapture.h"
 #include "../Gnm/GnmCmdStream.h"
 #include "../Gnm/GnmCommandBufferDraw.h"
 #include "../Gnm/GnmCommandBufferDispatch.h"
@@ -22,10 +23,29 @@ SceGpuQueue::SceGpuQueue(
 	m_device(device)
 {
 	createQueue(type);
+
+	m_frontendThread = std::thread(&SceGpuQueue::runFrontend, this);
 }
 
 SceGpuQueue::~SceGpuQueue()
 {
+	// Command buffers already submitted by the game
+	// are still executed, like on real hardware.
+	synchronize();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopped = true;
+	}
+	m_appendCond.notify_all();
+	m_frontendThread.join();
+
+	auto stats = getStats();
+	if (stats.commandCount)
+	{
+		LOG_DEBUG("frontend: %llu command buffers, busy %llu us, game blocked %llu us.",
+				  stats.commandCount, stats.busyUs, stats.blockUs);
+	}
 }
 
 
@@ -38,7 +58,89 @@ RcPtr<vlt::VltCmdList> SceGpuQueue::record(
 	bool result = m_cmdParser->processCommandBuffer(cmd.buffer, cmd.size);
 	LOG_ERR_IF(result == false, "process command buffer failed.");
 
-	return m_cmdProcesser->recordEnd();
+	auto cmdList = m_cmdProcesser->recordEnd();
+
+	if (m_device.capture)
+	{
+		m_device.capture->writeCommandBuffer(cmd.buffer, cmd.size, displayBufferIndex);
+	}
+
+	return cmdList;
+}
+
+void SceGpuQueue::dispatch(
+	const SceGpuCommand&        cmd,
+	uint32_t                    displayBufferIndex,
+	const SceGpuRecordCallback& callback)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	if (m_pending >= MaxQueuedGpuCommands)
+	{
+		auto blockTime = Clock::now();
+		m_finishCond.wait(lock, [this] { return m_pending < MaxQueuedGpuCommands; });
+		m_stats.blockUs += std::chrono::duration_cast<std::chrono::microseconds>(
+			Clock::now() - blockTime).count();
+	}
+
+	++m_pending;
+	m_entries.push(SceGpuFrontendEntry{ cmd, displayBufferIndex, callback });
+	m_appendCond.notify_one();
+}
+
+void SceGpuQueue::synchronize()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_finishCond.wait(lock, [this] { return m_pending == 0; });
+}
+
+SceGpuFrontendStats SceGpuQueue::getStats()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	SceGpuFrontendStats stats = m_stats;
+	stats.pendingCount        = m_pending;
+	return stats;
+}
+
+void SceGpuQueue::runFrontend()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (!m_stopped)
+	{
+		m_appendCond.wait(lock, [this] { return m_stopped || !m_entries.empty(); });
+
+		if (m_stopped)
+		{
+			break;
+		}
+
+		SceGpuFrontendEntry entry = std::move(m_entries.front());
+		m_entries.pop();
+		lock.unlock();
+
+		auto startTime = Clock::now();
+
+		// Guest synchronization, labels written at end of pipe and
+		// waits on memory, is handled while parsing, in submission order.
+		auto cmdList = record(entry.cmd, entry.displayBufferIndex);
+		if (entry.callback)
+		{
+			entry.callback(cmdList);
+		}
+
+		auto busyTime = std::chrono::duration_cast<std::chrono::microseconds>(
+			Clock::now() - startTime).count();
+
+		lock.lock();
+
+		++m_stats.commandCount;
+		m_stats.busyUs += busyTime;
+
+		--m_pending;
+		m_finishCond.notify_all();
+	}
 }
 
 void SceGpuQueue::submit(const SceGpuSubmission& submission)
@@ -48,7 +150,7 @@ void SceGpuQueue::submit(const SceGpuSubmission& submission)
 	submitInfo.waitSync      = submission.wait;
 	submitInfo.wakeSync      = submission.wake;
 
-	m_device.device->submitCommandList(submitInfo);
+	m_device.device->submitCommandList(submitInfo, submission.status);
 }
 
 void SceGpuQueue::createQueue(SceQueueType type)
@@ -69,6 +171,7 @@ void SceGpuQueue::createQueue(SceQueueType type)
 	m_cmdProcesser = std::make_unique<GnmCommandBufferDummy>();
 #endif
 	
+	m_cmdProcesser->setCapture(m_device.capture);
 	m_cmdParser->attachCommandBuffer(m_cmdProcesser.get());
 }
 
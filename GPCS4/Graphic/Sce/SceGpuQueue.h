@@ -2,7 +2,13 @@
 
 #include "SceCommon.h"
 
+#include <chrono>
+#include <condition_variable>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
 
 namespace vlt
 {;
@@ -10,10 +16,17 @@ class VltDevice;
 class VltContext;
 class VltPresenter;
 class VltCmdList;
+struct VltSubmitStatus;
 }  // namespace vlt
 
+namespace pssl
+{;
+class PsslShaderCache;
+}  // namespace pssl
+
 class GnmCmdStream;
 class GnmCommandBuffer;
+class GnmCmdCapture;
 
 namespace sce
 {;
@@ -31,6 +44,11 @@ struct SceGpuQueueDevice
 	RcPtr<vlt::VltDevice>        device;
 	RcPtr<vlt::VltPresenter>     presenter;
 	std::shared_ptr<SceVideoOut> videoOut;
+
+	std::shared_ptr<pssl::PsslShaderCache> shaderCache;
+
+	// Command buffers and the memory they use are written to it, optional
+	GnmCmdCapture* capture = nullptr;
 };
 
 struct SceGpuCommand
@@ -39,11 +57,34 @@ struct SceGpuCommand
 	uint32_t    size   = 0;
 };
 
+/**
+ * \brief Called with a recorded command list
+ *
+ * Runs on the frontend thread of the queue, the
+ * command list is null if nothing was recorded.
+ */
+using SceGpuRecordCallback = std::function<void(const RcPtr<vlt::VltCmdList>&)>;
+
+/**
+ * \brief Frontend statistics
+ */
+struct SceGpuFrontendStats
+{
+	uint64_t commandCount = 0;
+	uint32_t pendingCount = 0;  // Command buffers queued or being processed
+	uint64_t busyUs       = 0;  // Frontend thread processing command buffers
+	uint64_t blockUs      = 0;  // Submitting threads waiting for a free slot
+};
+
+// Command buffers the game may run ahead of the frontend.
+constexpr uint32_t MaxQueuedGpuCommands = 3;
+
 struct SceGpuSubmission
 {
 	RcPtr<vlt::VltCmdList> cmdList;
 	VkSemaphore            wait;
 	VkSemaphore            wake;
+	vlt::VltSubmitStatus*  status;  // Set once the command list has executed, optional
 };
 
 class SceGpuQueue
@@ -67,6 +108,34 @@ public:
 		const SceGpuCommand& cmd,
 		uint32_t             displayBufferIndex);
 
+	/**
+	 * \brief Queue command buffer for the frontend thread.
+	 *
+	 * Returns at once unless \c MaxQueuedGpuCommands command
+	 * buffers are pending already. The frontend thread records
+	 * the command buffer in submission order, then calls
+	 * \c callback with the command list.
+	 * The game owns the command buffer memory and must not
+	 * change it until the GPU is done, as on real hardware.
+	 * \param cmd Gnm command buffer.
+	 * \param displayBufferIndex Current display buffer index.
+	 * \param callback Called with the recorded command list.
+	 */
+	void dispatch(
+		const SceGpuCommand&        cmd,
+		uint32_t                    displayBufferIndex,
+		const SceGpuRecordCallback& callback);
+
+	/**
+	 * \brief Wait until all queued command buffers are processed.
+	 */
+	void synchronize();
+
+	/**
+	 * \brief Frontend statistics.
+	 */
+	SceGpuFrontendStats getStats();
+
 	/**
 	 * \brief Submit vulkan command list.
 	 * 
@@ -75,14 +144,37 @@ public:
 	void submit(const SceGpuSubmission& submission);
 
 private:
+	using Clock = std::chrono::high_resolution_clock;
+
+	struct SceGpuFrontendEntry
+	{
+		SceGpuCommand        cmd;
+		uint32_t             displayBufferIndex;
+		SceGpuRecordCallback callback;
+	};
+
 	void createQueue(SceQueueType type);
 
+	void runFrontend();
+
 private:
 	SceGpuQueueDevice      m_device;
 	RcPtr<vlt::VltContext> m_context;
 
 	std::unique_ptr<GnmCmdStream>     m_cmdParser;
 	std::unique_ptr<GnmCommandBuffer> m_cmdProcesser;
+
+	std::mutex              m_mutex;
+	std::condition_variable m_appendCond;  // Entry queued or stopping
+	std::condition_variable m_finishCond;  // Entry processed
+
+	bool     m_stopped = false;
+	uint32_t m_pending = 0;  // Entries queued or being processed
+
+	std::queue<SceGpuFrontendEntry> m_entries;
+	SceGpuFrontendStats             m_stats;
+
+	std::thread m_frontendThread;
 };
 
 
@@ -62,6 +62,17 @@ namespace pssl {
     m_code.shrink_to_fit();
   }
 
+
+  SpirvCompressedBuffer::SpirvCompressedBuffer(
+    uint32_t                size,
+    std::vector<uint64_t>&& mask,
+    std::vector<uint64_t>&& code)
+  : m_size(size),
+    m_mask(std::move(mask)),
+    m_code(std::move(code)) {
+
+  }
+
     
   SpirvCompressedBuffer::~SpirvCompressedBuffer() {
 
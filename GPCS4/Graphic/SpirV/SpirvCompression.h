@@ -20,11 +20,44 @@ namespace pssl {
 
     SpirvCompressedBuffer(
       const SpirvCodeBuffer&  code);
+
+    SpirvCompressedBuffer(
+      uint32_t                size,
+      std::vector<uint64_t>&& mask,
+      std::vector<uint64_t>&& code);
     
     ~SpirvCompressedBuffer();
     
     SpirvCodeBuffer decompress() const;
 
+    /**
+     * \brief Uncompressed code size
+     * \returns Code size, in dwords
+     */
+    uint32_t dwords() const {
+      return m_size;
+    }
+
+    /**
+     * \brief Compressed byte count masks
+     *
+     * Together with \ref codeWords, this is the raw
+     * compressed representation, which can be stored
+     * as-is and restored without re-compressing.
+     * \returns Mask words
+     */
+    const std::vector<uint64_t>& maskWords() const {
+      return m_mask;
+    }
+
+    /**
+     * \brief Compressed code words
+     * \returns Packed code words
+     */
+    const std::vector<uint64_t>& codeWords() const {
+      return m_code;
+    }
+
   private:
 
     uint32_t              m_size;
@@ -371,9 +371,11 @@ namespace pssl {
       ? spv::OpSpecConstantTrue
       : spv::OpSpecConstantFalse;
     
+    uint32_t offset = m_typeConstDefs.dwords();
     m_typeConstDefs.putIns  (op, 3);
     m_typeConstDefs.putWord (typeId);
     m_typeConstDefs.putWord (resultId);
+    this->indexTypeConst(offset, 2);
     return resultId;
   }
     
@@ -383,10 +385,12 @@ namespace pssl {
           uint32_t                value) {
     uint32_t resultId = this->allocateId();
     
+    uint32_t offset = m_typeConstDefs.dwords();
     m_typeConstDefs.putIns  (spv::OpSpecConstant, 4);
     m_typeConstDefs.putWord (typeId);
     m_typeConstDefs.putWord (resultId);
     m_typeConstDefs.putWord (value);
+    this->indexTypeConst(offset, 2);
     return resultId;
   }
   
@@ -632,10 +636,12 @@ namespace pssl {
           uint32_t                length) {
     uint32_t resultId = this->allocateId();
     
+    uint32_t offset = m_typeConstDefs.dwords();
     m_typeConstDefs.putIns (spv::OpTypeArray, 4);
     m_typeConstDefs.putWord(resultId);
     m_typeConstDefs.putWord(typeId);
     m_typeConstDefs.putWord(length);
+    this->indexTypeConst(offset, 1);
     return resultId;
   }
   
@@ -653,9 +659,11 @@ namespace pssl {
           uint32_t                typeId) {
     uint32_t resultId = this->allocateId();
     
+    uint32_t offset = m_typeConstDefs.dwords();
     m_typeConstDefs.putIns (spv::OpTypeRuntimeArray, 3);
     m_typeConstDefs.putWord(resultId);
     m_typeConstDefs.putWord(typeId);
+    this->indexTypeConst(offset, 1);
     return resultId;
   }
   
@@ -688,11 +696,13 @@ namespace pssl {
     const uint32_t*               memberTypes) {
     uint32_t resultId = this->allocateId();
     
+    uint32_t offset = m_typeConstDefs.dwords();
     m_typeConstDefs.putIns (spv::OpTypeStruct, 2 + memberCount);
     m_typeConstDefs.putWord(resultId);
     
     for (uint32_t i = 0; i < memberCount; i++)
       m_typeConstDefs.putWord(memberTypes[i]);
+    this->indexTypeConst(offset, 1);
     return resultId;
   }
   
@@ -3363,28 +3373,25 @@ void SpirvModule::opReturn()
           spv::Op                 op, 
           uint32_t                argCount,
     const uint32_t*               argIds) {
-    // Since the type info is stored in the code buffer,
-    // we can use the code buffer to look up type IDs as
-    // well. Result IDs are always stored as argument 1.
-    for (auto ins : m_typeConstDefs) 
-	{
-      bool match = ins.opCode() == op
-                && ins.length() == 2 + argCount;
-      
-      for (uint32_t i = 0; i < argCount && match; i++)
-        match &= ins.arg(2 + i) == argIds[i];
-      
-      if (match)
-        return ins.arg(1);
-    }
+    // Look up the type by its opcode and operands.
+    // Result IDs are always stored as argument 1.
+    m_typeConstKey.clear();
+    m_typeConstKey.push_back(op | ((2 + argCount) << spv::WordCountShift));
+    m_typeConstKey.insert(m_typeConstKey.end(), argIds, argIds + argCount);
+
+    uint32_t resultId = this->findTypeConst(1);
+    if (resultId != 0)
+      return resultId;
     
     // Type not yet declared, create a new one.
-    uint32_t resultId = this->allocateId();
+    uint32_t offset = m_typeConstDefs.dwords();
+    resultId = this->allocateId();
     m_typeConstDefs.putIns (op, 2 + argCount);
     m_typeConstDefs.putWord(resultId);
     
     for (uint32_t i = 0; i < argCount; i++)
       m_typeConstDefs.putWord(argIds[i]);
+    this->indexTypeConst(offset, 1);
     return resultId;
   }
   
@@ -3394,31 +3401,88 @@ void SpirvModule::opReturn()
           uint32_t                typeId,
           uint32_t                argCount,
     const uint32_t*               argIds) {
-    // Avoid declaring constants multiple times
-    for (auto ins : m_typeConstDefs) {
-      bool match = ins.opCode() == op
-                && ins.length() == 3 + argCount
-                && ins.arg(1)   == typeId;
-      
-      for (uint32_t i = 0; i < argCount && match; i++)
-        match &= ins.arg(3 + i) == argIds[i];
-      
-      if (match)
-        return ins.arg(2);
-    }
+    // Avoid declaring constants multiple times.
+    // Result IDs are always stored as argument 2.
+    m_typeConstKey.clear();
+    m_typeConstKey.push_back(op | ((3 + argCount) << spv::WordCountShift));
+    m_typeConstKey.push_back(typeId);
+    m_typeConstKey.insert(m_typeConstKey.end(), argIds, argIds + argCount);
+
+    uint32_t resultId = this->findTypeConst(2);
+    if (resultId != 0)
+      return resultId;
     
     // Constant not yet declared, make a new one
-    uint32_t resultId = this->allocateId();
+    uint32_t offset = m_typeConstDefs.dwords();
+    resultId = this->allocateId();
     m_typeConstDefs.putIns (op, 3 + argCount);
     m_typeConstDefs.putWord(typeId);
     m_typeConstDefs.putWord(resultId);
     
     for (uint32_t i = 0; i < argCount; i++)
       m_typeConstDefs.putWord(argIds[i]);
+    this->indexTypeConst(offset, 2);
     return resultId;
   }
   
   
+  uint32_t SpirvModule::findTypeConst(
+          uint32_t                resultArg) const {
+    const uint32_t* code  = m_typeConstDefs.data();
+    uint32_t        found = ~0u;
+    
+    // Several declarations may be identical, e.g. unique
+    // types, in which case the first one is returned.
+    auto range = m_typeConstIndex.equal_range(hashTypeConst(m_typeConstKey));
+    
+    for (auto iter = range.first; iter != range.second; iter++) {
+      const uint32_t* ins = code + iter->second;
+      
+      bool match = iter->second < found
+                && ins[0] == m_typeConstKey[0];
+      
+      for (uint32_t i = 1, k = 1; k < m_typeConstKey.size() && match; i++) {
+        if (i != resultArg)
+          match &= ins[i] == m_typeConstKey[k++];
+      }
+      
+      if (match)
+        found = iter->second;
+    }
+    
+    return found != ~0u
+      ? code[found + resultArg]
+      : 0;
+  }
+  
+  
+  void SpirvModule::indexTypeConst(
+          uint32_t                offset,
+          uint32_t                resultArg) {
+    const uint32_t* ins    = m_typeConstDefs.data() + offset;
+    const uint32_t  length = ins[0] >> spv::WordCountShift;
+    
+    m_typeConstKey.clear();
+    
+    for (uint32_t i = 0; i < length; i++) {
+      if (i != resultArg)
+        m_typeConstKey.push_back(ins[i]);
+    }
+    
+    m_typeConstIndex.emplace(hashTypeConst(m_typeConstKey), offset);
+  }
+  
+  
+  size_t SpirvModule::hashTypeConst(
+    const std::vector<uint32_t>&  key) {
+    size_t hash = 0;
+    
+    for (uint32_t word : key)
+      hash ^= size_t(word) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return hash;
+  }
+  
+  
   void SpirvModule::instImportGlsl450() {
     m_instExtGlsl450 = this->allocateId();
     const char* name = "GLSL.std.450";
@@ -2,6 +2,9 @@
 
 #include "SpirvCodeBuffer.h"
 
+#include <unordered_map>
+#include <vector>
+
 namespace pssl {
 
   struct SpirvPhiLabel {
@@ -1179,6 +1182,12 @@ namespace pssl {
     SpirvCodeBuffer m_variables;
     SpirvCodeBuffer m_code;
     
+    // Maps the hash of a type or constant declaration,
+    // without its result ID, to its offset in m_typeConstDefs,
+    // so that look-ups don't need to scan all declarations.
+    std::unordered_multimap<size_t, uint32_t> m_typeConstIndex;
+    std::vector<uint32_t>                     m_typeConstKey;
+    
     uint32_t defType(
             spv::Op                 op, 
             uint32_t                argCount,
@@ -1190,6 +1199,16 @@ namespace pssl {
             uint32_t                argCount,
       const uint32_t*               argIds);
     
+    uint32_t findTypeConst(
+            uint32_t                resultArg) const;
+    
+    void indexTypeConst(
+            uint32_t                offset,
+            uint32_t                resultArg);
+    
+    static size_t hashTypeConst(
+      const std::vector<uint32_t>&  key);
+    
     void instImportGlsl450();
     
     uint32_t getImageOperandWordCount(
@@ -0,0 +1,1129 @@
+#include "SpirvOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <sstream>
+
+namespace pssl {
+
+  constexpr uint32_t AllIds = ~0u;
+
+  /**
+   * \brief Operand layout of an instruction
+   *
+   * ID operands start at \c idFirst. For image
+   * instructions, the image operand mask follows
+   * the fixed operands and all words after the
+   * mask are IDs again.
+   */
+  struct SpirvOpLayout {
+    bool     known     = false;
+    bool     hasType   = false;
+    bool     hasResult = false;
+    uint32_t idFirst   = 0;
+    uint32_t idCount   = 0;
+    bool     imageMask = false;
+  };
+
+
+  static bool isPure(spv::Op op) {
+    switch (op) {
+      case spv::OpConstantTrue:
+      case spv::OpConstantFalse:
+      case spv::OpConstant:
+      case spv::OpConstantComposite:
+      case spv::OpConstantNull:
+      case spv::OpUndef:
+      case spv::OpAccessChain:
+      case spv::OpInBoundsAccessChain:
+      case spv::OpVectorExtractDynamic:
+      case spv::OpVectorInsertDynamic:
+      case spv::OpVectorShuffle:
+      case spv::OpCompositeConstruct:
+      case spv::OpCompositeExtract:
+      case spv::OpCompositeInsert:
+      case spv::OpCopyObject:
+      case spv::OpTranspose:
+      case spv::OpSampledImage:
+      case spv::OpImage:
+      case spv::OpImageSampleImplicitLod:
+      case spv::OpImageSampleExplicitLod:
+      case spv::OpImageSampleDrefImplicitLod:
+      case spv::OpImageSampleDrefExplicitLod:
+      case spv::OpImageFetch:
+      case spv::OpImageGather:
+      case spv::OpImageDrefGather:
+      case spv::OpImageQuerySizeLod:
+      case spv::OpImageQuerySize:
+      case spv::OpImageQueryLod:
+      case spv::OpImageQueryLevels:
+      case spv::OpImageQuerySamples:
+      case spv::OpConvertFToU:
+      case spv::OpConvertFToS:
+      case spv::OpConvertSToF:
+      case spv::OpConvertUToF:
+      case spv::OpUConvert:
+      case spv::OpSConvert:
+      case spv::OpFConvert:
+      case spv::OpQuantizeToF16:
+      case spv::OpBitcast:
+      case spv::OpSNegate:
+      case spv::OpFNegate:
+      case spv::OpIAdd:
+      case spv::OpFAdd:
+      case spv::OpISub:
+      case spv::OpFSub:
+      case spv::OpIMul:
+      case spv::OpFMul:
+      case spv::OpUDiv:
+      case spv::OpSDiv:
+      case spv::OpFDiv:
+      case spv::OpUMod:
+      case spv::OpSRem:
+      case spv::OpSMod:
+      case spv::OpFRem:
+      case spv::OpFMod:
+      case spv::OpVectorTimesScalar:
+      case spv::OpMatrixTimesScalar:
+      case spv::OpVectorTimesMatrix:
+      case spv::OpMatrixTimesVector:
+      case spv::OpMatrixTimesMatrix:
+      case spv::OpOuterProduct:
+      case spv::OpDot:
+      case spv::OpIAddCarry:
+      case spv::OpISubBorrow:
+      case spv::OpUMulExtended:
+      case spv::OpSMulExtended:
+      case spv::OpAny:
+      case spv::OpAll:
+      case spv::OpIsNan:
+      case spv::OpIsInf:
+      case spv::OpLogicalEqual:
+      case spv::OpLogicalNotEqual:
+      case spv::OpLogicalOr:
+      case spv::OpLogicalAnd:
+      case spv::OpLogicalNot:
+      case spv::OpSelect:
+      case spv::OpIEqual:
+      case spv::OpINotEqual:
+      case spv::OpUGreaterThan:
+      case spv::OpSGreaterThan:
+      case spv::OpUGreaterThanEqual:
+      case spv::OpSGreaterThanEqual:
+      case spv::OpULessThan:
+      case spv::OpSLessThan:
+      case spv::OpULessThanEqual:
+      case spv::OpSLessThanEqual:
+      case spv::OpFOrdEqual:
+      case spv::OpFUnordEqual:
+      case spv::OpFOrdNotEqual:
+      case spv::OpFUnordNotEqual:
+      case spv::OpFOrdLessThan:
+      case spv::OpFUnordLessThan:
+      case spv::OpFOrdGreaterThan:
+      case spv::OpFUnordGreaterThan:
+      case spv::OpFOrdLessThanEqual:
+      case spv::OpFUnordLessThanEqual:
+      case spv::OpFOrdGreaterThanEqual:
+      case spv::OpFUnordGreaterThanEqual:
+      case spv::OpShiftRightLogical:
+      case spv::OpShiftRightArithmetic:
+      case spv::OpShiftLeftLogical:
+      case spv::OpBitwiseOr:
+      case spv::OpBitwiseXor:
+      case spv::OpBitwiseAnd:
+      case spv::OpNot:
+      case spv::OpBitFieldInsert:
+      case spv::OpBitFieldSExtract:
+      case spv::OpBitFieldUExtract:
+      case spv::OpBitReverse:
+      case spv::OpBitCount:
+      case spv::OpDPdx:
+      case spv::OpDPdy:
+      case spv::OpFwidth:
+      case spv::OpDPdxFine:
+      case spv::OpDPdyFine:
+      case spv::OpFwidthFine:
+      case spv::OpDPdxCoarse:
+      case spv::OpDPdyCoarse:
+      case spv::OpFwidthCoarse:
+        return true;
+
+      default:
+        return false;
+    }
+  }
+
+
+  static bool isAnnotation(spv::Op op) {
+    return op == spv::OpName
+        || op == spv::OpMemberName
+        || op == spv::OpDecorate
+        || op == spv::OpMemberDecorate;
+  }
+
+
+  static SpirvOpLayout getOpLayout(spv::Op op) {
+    SpirvOpLayout layout;
+    layout.known = true;
+
+    auto result = [&layout] (uint32_t idFirst, uint32_t idCount) {
+      layout.hasType   = true;
+      layout.hasResult = true;
+      layout.idFirst   = idFirst;
+      layout.idCount   = idCount;
+    };
+
+    auto noResult = [&layout] (uint32_t idFirst, uint32_t idCount) {
+      layout.idFirst = idFirst;
+      layout.idCount = idCount;
+    };
+
+    auto typeDecl = [&layout] (uint32_t idFirst, uint32_t idCount) {
+      layout.hasResult = true;
+      layout.idFirst   = idFirst;
+      layout.idCount   = idCount;
+    };
+
+    auto image = [&layout] (bool hasResult, uint32_t fixedIds) {
+      layout.hasType   = hasResult;
+      layout.hasResult = hasResult;
+      layout.idFirst   = hasResult ? 3 : 1;
+      layout.idCount   = fixedIds;
+      layout.imageMask = true;
+    };
+
+    switch (op) {
+      case spv::OpNop:
+      case spv::OpCapability:
+      case spv::OpExtension:
+      case spv::OpMemoryModel:
+      case spv::OpReturn:
+      case spv::OpKill:
+      case spv::OpUnreachable:
+      case spv::OpFunctionEnd:
+      case spv::OpEmitVertex:
+      case spv::OpEndPrimitive:
+      case spv::OpNoLine:
+        noResult(0, 0); break;
+
+      // Annotation targets are not uses,
+      // the annotation goes away with its target.
+      case spv::OpName:
+      case spv::OpMemberName:
+      case spv::OpDecorate:
+      case spv::OpMemberDecorate:
+        noResult(0, 0); break;
+
+      case spv::OpExtInstImport:
+      case spv::OpLabel:
+      case spv::OpTypeVoid:
+      case spv::OpTypeBool:
+      case spv::OpTypeInt:
+      case spv::OpTypeFloat:
+      case spv::OpTypeSampler:
+        typeDecl(0, 0); break;
+
+      case spv::OpTypeVector:
+      case spv::OpTypeMatrix:
+      case spv::OpTypeImage:
+      case spv::OpTypeSampledImage:
+      case spv::OpTypeRuntimeArray:
+        typeDecl(2, 1); break;
+
+      case spv::OpTypeArray:
+        typeDecl(2, 2); break;
+
+      case spv::OpTypeStruct:
+      case spv::OpTypeFunction:
+        typeDecl(2, AllIds); break;
+
+      case spv::OpTypePointer:
+        typeDecl(3, 1); break;
+
+      case spv::OpLine:
+      case spv::OpExecutionMode:
+      case spv::OpBranch:
+      case spv::OpReturnValue:
+      case spv::OpSelectionMerge:
+        noResult(1, 1); break;
+
+      case spv::OpStore:
+      case spv::OpCopyMemory:
+      case spv::OpLoopMerge:
+      case spv::OpMemoryBarrier:
+        noResult(1, 2); break;
+
+      case spv::OpBranchConditional:
+      case spv::OpControlBarrier:
+        noResult(1, 3); break;
+
+      case spv::OpAtomicStore:
+        noResult(1, AllIds); break;
+
+      case spv::OpConstantTrue:
+      case spv::OpConstantFalse:
+      case spv::OpConstant:
+      case spv::OpConstantNull:
+      case spv::OpSpecConstantTrue:
+      case spv::OpSpecConstantFalse:
+      case spv::OpSpecConstant:
+      case spv::OpUndef:
+      case spv::OpFunctionParameter:
+        result(0, 0); break;
+
+      case spv::OpLoad:
+      case spv::OpCompositeExtract:
+        result(3, 1); break;
+
+      case spv::OpCompositeInsert:
+      case spv::OpVectorShuffle:
+        result(3, 2); break;
+
+      case spv::OpVariable:
+      case spv::OpSpecConstantOp:
+        result(4, AllIds); break;
+
+      case spv::OpFunction:
+        result(4, 1); break;
+
+      case spv::OpImageSampleImplicitLod:
+      case spv::OpImageSampleExplicitLod:
+      case spv::OpImageSampleProjImplicitLod:
+      case spv::OpImageSampleProjExplicitLod:
+      case spv::OpImageFetch:
+      case spv::OpImageRead:
+        image(true, 2); break;
+
+      case spv::OpImageSampleDrefImplicitLod:
+      case spv::OpImageSampleDrefExplicitLod:
+      case spv::OpImageSampleProjDrefImplicitLod:
+      case spv::OpImageSampleProjDrefExplicitLod:
+      case spv::OpImageGather:
+      case spv::OpImageDrefGather:
+        image(true, 3); break;
+
+      case spv::OpImageWrite:
+        image(false, 3); break;
+
+      case spv::OpConstantComposite:
+      case spv::OpSpecConstantComposite:
+      case spv::OpFunctionCall:
+      case spv::OpAccessChain:
+      case spv::OpInBoundsAccessChain:
+      case spv::OpPhi:
+      case spv::OpVectorExtractDynamic:
+      case spv::OpVectorInsertDynamic:
+      case spv::OpSampledImage:
+      case spv::OpImage:
+      case spv::OpImageQuerySizeLod:
+      case spv::OpImageQuerySize:
+      case spv::OpImageQueryLod:
+      case spv::OpImageQueryLevels:
+      case spv::OpImageQuerySamples:
+      case spv::OpAtomicLoad:
+      case spv::OpAtomicExchange:
+      case spv::OpAtomicCompareExchange:
+      case spv::OpAtomicIIncrement:
+      case spv::OpAtomicIDecrement:
+      case spv::OpAtomicIAdd:
+      case spv::OpAtomicISub:
+      case spv::OpAtomicSMin:
+      case spv::OpAtomicUMin:
+      case spv::OpAtomicSMax:
+      case spv::OpAtomicUMax:
+      case spv::OpAtomicAnd:
+      case spv::OpAtomicOr:
+      case spv::OpAtomicXor:
+        result(3, AllIds); break;
+
+      case spv::OpExtInst:
+        result(0, 0); break;
+
+      // Handled separately
+      case spv::OpEntryPoint:
+      case spv::OpSwitch:
+        break;
+
+      default:
+        // Remaining pure instructions only take IDs
+        if (isPure(op))
+          result(3, AllIds);
+        else
+          layout.known = false;
+    }
+
+    return layout;
+  }
+
+
+  static std::atomic<uint32_t> g_defaultPasses = { 0u };
+
+
+  SpirvOptimizer::SpirvOptimizer(SpirvOptimizerPasses passes)
+  : m_passes(passes) {
+
+  }
+
+
+  SpirvOptimizer::~SpirvOptimizer() {
+
+  }
+
+
+  SpirvCodeBuffer SpirvOptimizer::optimize(const SpirvCodeBuffer& code) {
+    if (m_passes.isClear()) {
+      m_stats = SpirvOptimizerStats();
+      m_stats.insCountBefore = countInstructions(code);
+      m_stats.insCountAfter  = m_stats.insCountBefore;
+      return code;
+    }
+
+    this->parseModule(code);
+
+    if (m_passes.any(
+        SpirvOptimizerPass::LoadStoreForwarding,
+        SpirvOptimizerPass::DeadStoreElimination)) {
+      this->findSimpleVars();
+      this->forwardLoadsAndStores();
+    }
+
+    if (m_passes.test(SpirvOptimizerPass::BitcastFolding))
+      this->foldBitcasts();
+
+    if (m_passes.test(SpirvOptimizerPass::ConstantFolding))
+      this->foldConstants();
+
+    this->eliminateDeadCode();
+    return this->emitModule();
+  }
+
+
+  SpirvOptimizerPasses SpirvOptimizer::getDefaultPasses() {
+    return SpirvOptimizerPasses(g_defaultPasses.load());
+  }
+
+
+  void SpirvOptimizer::setDefaultPasses(SpirvOptimizerPasses passes) {
+    g_defaultPasses.store(passes.raw());
+  }
+
+
+  bool SpirvOptimizer::parsePasses(
+    const std::string&      str,
+          SpirvOptimizerPasses& passes) {
+    SpirvOptimizerPasses result;
+
+    std::stringstream stream(str);
+    std::string       name;
+
+    while (std::getline(stream, name, ',')) {
+      if (name == "all") {
+        result = SpirvOptimizerPasses((1u << uint32_t(SpirvOptimizerPass::PassCount)) - 1);
+        continue;
+      }
+
+      if (name == "none" || name.empty())
+        continue;
+
+      bool found = false;
+
+      for (uint32_t i = 0; i < uint32_t(SpirvOptimizerPass::PassCount); i++) {
+        if (name == passName(SpirvOptimizerPass(i))) {
+          result.set(SpirvOptimizerPass(i));
+          found = true;
+        }
+      }
+
+      if (!found)
+        return false;
+    }
+
+    passes = result;
+    return true;
+  }
+
+
+  const char* SpirvOptimizer::passName(SpirvOptimizerPass pass) {
+    switch (pass) {
+      case SpirvOptimizerPass::LoadStoreForwarding:  return "forward";
+      case SpirvOptimizerPass::DeadStoreElimination: return "dse";
+      case SpirvOptimizerPass::BitcastFolding:       return "bitcast";
+      case SpirvOptimizerPass::ConstantFolding:      return "const";
+      default:                                       return "unknown";
+    }
+  }
+
+
+  uint32_t SpirvOptimizer::countInstructions(const SpirvCodeBuffer& code) {
+    const uint32_t* words  = code.data();
+    const uint32_t  length = code.dwords();
+
+    uint32_t count  = 0;
+    uint32_t offset = (length >= 5 && words[0] == spv::MagicNumber) ? 5 : 0;
+
+    while (offset < length) {
+      uint32_t insLength = words[offset] >> spv::WordCountShift;
+
+      if (!insLength)
+        break;
+
+      offset += insLength;
+      count  += 1;
+    }
+
+    return count;
+  }
+
+
+  void SpirvOptimizer::parseModule(const SpirvCodeBuffer& code) {
+    m_code.assign(code.data(), code.data() + code.dwords());
+    m_codeSize = m_code.size();
+    m_bound    = m_code.size() >= 5 ? m_code[3] : 0;
+    m_stats    = SpirvOptimizerStats();
+
+    m_insOffsets.clear();
+    m_removed.assign(m_code.size(), 0);
+
+    m_defs.clear();
+    m_types.clear();
+    m_uses.clear();
+    m_replacements.clear();
+    m_scalarTypes.clear();
+    m_boolTypes.clear();
+    m_constants.clear();
+    m_constantIds.clear();
+    m_simpleVars.clear();
+    m_removedIds.clear();
+
+    for (uint32_t offset = 5; offset < m_codeSize; offset += getLength(offset)) {
+      if (!getLength(offset) || offset + getLength(offset) > m_codeSize)
+        break;
+
+      m_insOffsets.push_back(offset);
+
+      uint32_t resultId = this->getResultId(offset);
+
+      if (resultId)
+        m_defs[resultId] = offset;
+
+      if (resultId && getOpLayout(getOp(offset)).hasType)
+        m_types[resultId] = m_code[offset + 1];
+
+      switch (getOp(offset)) {
+        case spv::OpTypeInt:
+        case spv::OpTypeFloat:
+          if (m_code[offset + 2] == 32)
+            m_scalarTypes.insert(resultId);
+          break;
+
+        case spv::OpTypeBool:
+          m_boolTypes.insert(resultId);
+          break;
+
+        case spv::OpConstant:
+          if (getLength(offset) == 4 && m_scalarTypes.count(m_code[offset + 1])) {
+            m_constants[resultId] = { m_code[offset + 1], m_code[offset + 3] };
+            m_constantIds.emplace((uint64_t(m_code[offset + 1]) << 32) | m_code[offset + 3], resultId);
+          }
+          break;
+
+        case spv::OpConstantTrue:
+        case spv::OpConstantFalse: {
+          uint32_t value = getOp(offset) == spv::OpConstantTrue ? 1 : 0;
+          m_constants[resultId] = { m_code[offset + 1], value };
+          m_constantIds.emplace((uint64_t(m_code[offset + 1]) << 32) | value, resultId);
+        } break;
+
+        default:
+          break;
+      }
+    }
+
+    m_stats.insCountBefore = m_insOffsets.size();
+  }
+
+
+  void SpirvOptimizer::findSimpleVars() {
+    for (uint32_t offset : m_insOffsets) {
+      if (getOp(offset) != spv::OpVariable)
+        continue;
+
+      auto storage = spv::StorageClass(m_code[offset + 3]);
+
+      if (storage == spv::StorageClassPrivate
+       || storage == spv::StorageClassFunction)
+        m_simpleVars.insert({ m_code[offset + 2], storage });
+    }
+
+    // A variable is simple if it is only ever used
+    // as the pointer operand of a plain load or store
+    for (uint32_t offset : m_insOffsets) {
+      spv::Op op = getOp(offset);
+
+      if (isAnnotation(op))
+        continue;
+
+      this->getIdOperands(offset, m_operands);
+
+      for (uint32_t index : m_operands) {
+        bool isLoad  = op == spv::OpLoad  && index == 3 && getLength(offset) == 4;
+        bool isStore = op == spv::OpStore && index == 1 && getLength(offset) == 3;
+
+        if (!isLoad && !isStore)
+          m_simpleVars.erase(m_code[offset + index]);
+      }
+    }
+  }
+
+
+  void SpirvOptimizer::forwardLoadsAndStores() {
+    const bool forward = m_passes.test(SpirvOptimizerPass::LoadStoreForwarding);
+    const bool dse     = m_passes.test(SpirvOptimizerPass::DeadStoreElimination);
+
+    // Current value and last store of
+    // each variable within the block
+    std::unordered_map<uint32_t, uint32_t> values;
+    std::unordered_map<uint32_t, uint32_t> stores;
+
+    for (uint32_t offset : m_insOffsets) {
+      switch (getOp(offset)) {
+        case spv::OpLabel:
+          values.clear();
+          stores.clear();
+          break;
+
+        case spv::OpLoad: {
+          uint32_t varId = m_code[offset + 3];
+
+          if (!m_simpleVars.count(varId))
+            break;
+
+          auto value = values.find(varId);
+
+          if (forward && value != values.end()) {
+            this->replace(offset, value->second);
+            m_stats.forwardedLoads += 1;
+          } else {
+            stores.erase(varId);
+            values[varId] = m_code[offset + 2];
+          }
+        } break;
+
+        case spv::OpStore: {
+          uint32_t varId = m_code[offset + 1];
+
+          if (!m_simpleVars.count(varId))
+            break;
+
+          auto store = stores.find(varId);
+
+          if (dse && store != stores.end()) {
+            this->remove(store->second);
+            m_stats.deadStores += 1;
+          }
+
+          stores[varId] = offset;
+          values[varId] = m_code[offset + 2];
+        } break;
+
+        case spv::OpFunctionCall: {
+          // The callee may access private variables
+          for (const auto& var : m_simpleVars) {
+            if (var.second == spv::StorageClassPrivate) {
+              values.erase(var.first);
+              stores.erase(var.first);
+            }
+          }
+        } break;
+
+        default:
+          if (!getOpLayout(getOp(offset)).known) {
+            values.clear();
+            stores.clear();
+          }
+      }
+    }
+  }
+
+
+  void SpirvOptimizer::foldBitcasts() {
+    for (uint32_t offset : m_insOffsets) {
+      if (getOp(offset) != spv::OpBitcast || getLength(offset) != 4)
+        continue;
+
+      uint32_t typeId   = m_code[offset + 1];
+      uint32_t resultId = m_code[offset + 2];
+      uint32_t operand  = this->resolve(m_code[offset + 3]);
+
+      if (m_replacements.count(resultId))
+        continue;
+
+      // Cast to the operand's own type
+      auto type = m_types.find(operand);
+
+      if (type != m_types.end() && type->second == typeId) {
+        this->replace(offset, operand);
+        m_stats.foldedBitcasts += 1;
+        continue;
+      }
+
+      // Cast of a cast, either cancels out or
+      // the intermediate cast can be skipped
+      auto def = m_defs.find(operand);
+
+      if (def == m_defs.end()
+       || getOp(def->second) != spv::OpBitcast
+       || getLength(def->second) != 4)
+        continue;
+
+      uint32_t inner = this->resolve(m_code[def->second + 3]);
+      type = m_types.find(inner);
+
+      if (type != m_types.end() && type->second == typeId)
+        this->replace(offset, inner);
+      else
+        m_code[offset + 3] = inner;
+
+      m_stats.foldedBitcasts += 1;
+    }
+  }
+
+
+  void SpirvOptimizer::foldConstants() {
+    for (uint32_t offset : m_insOffsets) {
+      uint32_t resultId = this->getResultId(offset);
+
+      if (!resultId || m_replacements.count(resultId))
+        continue;
+
+      if (getOp(offset) == spv::OpSelect) {
+        auto cond = m_constants.find(this->resolve(m_code[offset + 3]));
+
+        if (cond != m_constants.end() && m_boolTypes.count(cond->second.typeId)) {
+          this->replace(offset, this->resolve(m_code[offset + (cond->second.value ? 4 : 5)]));
+          m_stats.foldedConstants += 1;
+        }
+
+        continue;
+      }
+
+      uint32_t value = 0;
+
+      if (this->foldConstantOp(offset, value)) {
+        this->replace(offset, this->getConstant(m_code[offset + 1], value));
+        m_stats.foldedConstants += 1;
+      }
+    }
+  }
+
+
+  void SpirvOptimizer::eliminateDeadCode() {
+    // Substitute replaced IDs in all operands we know
+    for (uint32_t offset : m_insOffsets) {
+      if (m_removed[offset] || isAnnotation(getOp(offset)))
+        continue;
+
+      if (!this->getIdOperands(offset, m_operands))
+        continue;
+
+      for (uint32_t index : m_operands)
+        m_code[offset + index] = this->resolve(m_code[offset + index]);
+    }
+
+    // Replaced instructions still used by an instruction we
+    // could not patch become copies, all others go away.
+    std::unordered_set<uint32_t> keep;
+
+    for (uint32_t offset : m_insOffsets) {
+      if (m_removed[offset] || getOpLayout(getOp(offset)).known)
+        continue;
+
+      this->getIdOperands(offset, m_operands);
+
+      for (uint32_t index : m_operands) {
+        if (m_replacements.count(m_code[offset + index]))
+          keep.insert(m_code[offset + index]);
+      }
+    }
+
+    for (const auto& replacement : m_replacements) {
+      uint32_t offset = m_defs.at(replacement.first);
+
+      if (!keep.count(replacement.first)) {
+        this->remove(offset);
+        continue;
+      }
+
+      m_code[offset + 0] = spv::OpCopyObject | (4 << spv::WordCountShift);
+      m_code[offset + 3] = this->resolve(replacement.first);
+    }
+
+    // Remove variables that are never loaded, and all stores to them
+    if (m_passes.test(SpirvOptimizerPass::DeadStoreElimination)) {
+      std::unordered_set<uint32_t> loaded;
+
+      for (uint32_t offset : m_insOffsets) {
+        if (!m_removed[offset] && getOp(offset) == spv::OpLoad)
+          loaded.insert(m_code[offset + 3]);
+      }
+
+      for (uint32_t offset : m_insOffsets) {
+        if (m_removed[offset])
+          continue;
+
+        spv::Op op = getOp(offset);
+
+        uint32_t varId = 0;
+
+        if (op == spv::OpStore)
+          varId = m_code[offset + 1];
+        if (op == spv::OpVariable)
+          varId = m_code[offset + 2];
+
+        if (!varId || !m_simpleVars.count(varId) || loaded.count(varId))
+          continue;
+
+        this->remove(offset);
+
+        if (op == spv::OpStore)
+          m_stats.deadStores += 1;
+      }
+    }
+
+    // Count uses of every ID
+    m_uses.clear();
+
+    for (uint32_t offset : m_insOffsets) {
+      if (m_removed[offset] || isAnnotation(getOp(offset)))
+        continue;
+
+      this->getIdOperands(offset, m_operands);
+
+      for (uint32_t index : m_operands)
+        m_uses[m_code[offset + index]] += 1;
+    }
+
+    // Remove unused results, which may leave
+    // their operands unused in turn
+    std::vector<uint32_t> worklist;
+
+    for (uint32_t offset : m_insOffsets) {
+      if (this->isRemovable(offset) && !m_uses[this->getResultId(offset)])
+        worklist.push_back(offset);
+    }
+
+    while (!worklist.empty()) {
+      uint32_t offset = worklist.back();
+      worklist.pop_back();
+
+      if (m_removed[offset])
+        continue;
+
+      this->remove(offset);
+      this->getIdOperands(offset, m_operands);
+
+      for (uint32_t index : m_operands) {
+        uint32_t id = m_code[offset + index];
+
+        if (--m_uses[id])
+          continue;
+
+        auto def = m_defs.find(id);
+
+        if (def != m_defs.end() && this->isRemovable(def->second))
+          worklist.push_back(def->second);
+      }
+    }
+  }
+
+
+  SpirvCodeBuffer SpirvOptimizer::emitModule() {
+    std::vector<uint32_t> code(m_code.begin(), m_code.begin() + 5);
+    code[3] = m_bound;
+
+    auto emit = [&] (uint32_t offset) {
+      spv::Op op = getOp(offset);
+
+      if (m_removed[offset])
+        return;
+
+      if (isAnnotation(op) && m_removedIds.count(m_code[offset + 1]))
+        return;
+
+      code.insert(code.end(),
+        m_code.begin() + offset,
+        m_code.begin() + offset + getLength(offset));
+
+      m_stats.insCountAfter += 1;
+    };
+
+    bool declared = false;
+
+    for (uint32_t offset : m_insOffsets) {
+      if (offset >= m_codeSize)
+        continue;
+
+      // Declare folded constants ahead of all functions
+      if (!declared && getOp(offset) == spv::OpFunction) {
+        for (uint32_t decl : m_insOffsets) {
+          if (decl >= m_codeSize)
+            emit(decl);
+        }
+
+        declared = true;
+      }
+
+      emit(offset);
+    }
+
+    return SpirvCodeBuffer(code.size(), code.data());
+  }
+
+
+  bool SpirvOptimizer::foldConstantOp(
+          uint32_t          offset,
+          uint32_t&         value) const {
+    const uint32_t typeId = m_code[offset + 1];
+    const uint32_t length = getLength(offset);
+
+    if (!m_scalarTypes.count(typeId) && !m_boolTypes.count(typeId))
+      return false;
+
+    if (length != 4 && length != 5)
+      return false;
+
+    std::array<SpirvConstant, 2> args = { };
+
+    for (uint32_t i = 3; i < length; i++) {
+      auto constant = m_constants.find(this->resolve(m_code[offset + i]));
+
+      if (constant == m_constants.end())
+        return false;
+
+      args[i - 3] = constant->second;
+    }
+
+    const uint32_t a = args[0].value;
+    const uint32_t b = args[1].value;
+
+    switch (getOp(offset)) {
+      case spv::OpBitcast:
+        if (m_boolTypes.count(args[0].typeId) || m_boolTypes.count(typeId))
+          return false;
+        value = a; break;
+
+      case spv::OpIAdd:                 value = a + b;  break;
+      case spv::OpISub:                 value = a - b;  break;
+      case spv::OpIMul:                 value = a * b;  break;
+      case spv::OpSNegate:              value = 0u - a; break;
+      case spv::OpNot:                  value = ~a;     break;
+      case spv::OpBitwiseAnd:           value = a & b;  break;
+      case spv::OpBitwiseOr:            value = a | b;  break;
+      case spv::OpBitwiseXor:           value = a ^ b;  break;
+
+      case spv::OpUDiv:
+        if (!b) return false;
+        value = a / b; break;
+
+      case spv::OpUMod:
+        if (!b) return false;
+        value = a % b; break;
+
+      // Shifts by 32 or more are undefined
+      case spv::OpShiftLeftLogical:
+        if (b >= 32) return false;
+        value = a << b; break;
+
+      case spv::OpShiftRightLogical:
+        if (b >= 32) return false;
+        value = a >> b; break;
+
+      case spv::OpShiftRightArithmetic:
+        if (b >= 32) return false;
+        value = uint32_t(int32_t(a) >> b); break;
+
+      case spv::OpIEqual:
+      case spv::OpLogicalEqual:         value = a == b; break;
+      case spv::OpINotEqual:
+      case spv::OpLogicalNotEqual:      value = a != b; break;
+      case spv::OpULessThan:            value = a <  b; break;
+      case spv::OpULessThanEqual:       value = a <= b; break;
+      case spv::OpUGreaterThan:         value = a >  b; break;
+      case spv::OpUGreaterThanEqual:    value = a >= b; break;
+      case spv::OpSLessThan:            value = int32_t(a) <  int32_t(b); break;
+      case spv::OpSLessThanEqual:       value = int32_t(a) <= int32_t(b); break;
+      case spv::OpSGreaterThan:         value = int32_t(a) >  int32_t(b); break;
+      case spv::OpSGreaterThanEqual:    value = int32_t(a) >= int32_t(b); break;
+      case spv::OpLogicalAnd:           value = a && b; break;
+      case spv::OpLogicalOr:            value = a || b; break;
+      case spv::OpLogicalNot:           value = !a;     break;
+
+      // Float arithmetic is left alone, the device
+      // may round or flush denormals differently.
+      default:
+        return false;
+    }
+
+    return true;
+  }
+
+
+  uint32_t SpirvOptimizer::getConstant(
+          uint32_t          typeId,
+          uint32_t          value) {
+    const uint64_t key = (uint64_t(typeId) << 32) | value;
+
+    auto entry = m_constantIds.find(key);
+
+    if (entry != m_constantIds.end())
+      return entry->second;
+
+    const uint32_t offset   = m_code.size();
+    const uint32_t resultId = m_bound++;
+
+    if (m_boolTypes.count(typeId)) {
+      m_code.push_back((value ? spv::OpConstantTrue : spv::OpConstantFalse) | (3 << spv::WordCountShift));
+      m_code.push_back(typeId);
+      m_code.push_back(resultId);
+    } else {
+      m_code.push_back(spv::OpConstant | (4 << spv::WordCountShift));
+      m_code.push_back(typeId);
+      m_code.push_back(resultId);
+      m_code.push_back(value);
+    }
+
+    m_removed.resize(m_code.size(), 0);
+    m_insOffsets.push_back(offset);
+
+    m_defs[resultId]       = offset;
+    m_types[resultId]      = typeId;
+    m_constants[resultId]  = { typeId, value };
+    m_constantIds[key]     = resultId;
+    return resultId;
+  }
+
+
+  uint32_t SpirvOptimizer::resolve(uint32_t id) const {
+    auto entry = m_replacements.find(id);
+
+    while (entry != m_replacements.end()) {
+      id    = entry->second;
+      entry = m_replacements.find(id);
+    }
+
+    return id;
+  }
+
+
+  void SpirvOptimizer::replace(
+          uint32_t          offset,
+          uint32_t          id) {
+    m_replacements[this->getResultId(offset)] = id;
+  }
+
+
+  void SpirvOptimizer::remove(uint32_t offset) {
+    uint32_t resultId = this->getResultId(offset);
+
+    if (resultId)
+      m_removedIds.insert(resultId);
+
+    m_removed[offset] = 1;
+  }
+
+
+  bool SpirvOptimizer::isRemovable(uint32_t offset) const {
+    if (m_removed[offset])
+      return false;
+
+    spv::Op op = getOp(offset);
+
+    // Volatile loads have a memory operand
+    if (op == spv::OpLoad)
+      return getLength(offset) == 4;
+
+    if (op == spv::OpVariable)
+      return spv::StorageClass(m_code[offset + 3]) == spv::StorageClassPrivate
+          || spv::StorageClass(m_code[offset + 3]) == spv::StorageClassFunction;
+
+    return isPure(op);
+  }
+
+
+  bool SpirvOptimizer::getIdOperands(
+          uint32_t          offset,
+          std::vector<uint32_t>& operands) const {
+    const spv::Op       op     = getOp(offset);
+    const uint32_t      length = getLength(offset);
+    const SpirvOpLayout layout = getOpLayout(op);
+
+    operands.clear();
+
+    switch (op) {
+      case spv::OpEntryPoint: {
+        // Interface IDs follow the name string
+        uint32_t index = 3;
+
+        while (index < length && (m_code[offset + index] >> 24))
+          index += 1;
+
+        operands.push_back(2);
+
+        for (index += 1; index < length; index++)
+          operands.push_back(index);
+      } return true;
+
+      case spv::OpExtInst: {
+        operands.push_back(3);
+
+        for (uint32_t i = 5; i < length; i++)
+          operands.push_back(i);
+      } return true;
+
+      case spv::OpSwitch: {
+        // 32-bit selector, literals and labels alternate
+        operands.push_back(1);
+        operands.push_back(2);
+
+        for (uint32_t i = 4; i < length; i += 2)
+          operands.push_back(i);
+      } return true;
+
+      default:
+        break;
+    }
+
+    if (!layout.known) {
+      // Any word might be an ID
+      for (uint32_t i = 1; i < length; i++)
+        operands.push_back(i);
+      return false;
+    }
+
+    uint32_t end = layout.idCount == AllIds
+      ? length : std::min(length, layout.idFirst + layout.idCount);
+
+    for (uint32_t i = layout.idFirst; i < end; i++)
+      operands.push_back(i);
+
+    if (layout.imageMask) {
+      for (uint32_t i = end + 1; i < length; i++)
+        operands.push_back(i);
+    }
+
+    return true;
+  }
+
+
+  uint32_t SpirvOptimizer::getResultId(uint32_t offset) const {
+    const SpirvOpLayout layout = getOpLayout(getOp(offset));
+
+    if (!layout.hasResult)
+      return 0;
+
+    return m_code[offset + (layout.hasType ? 2 : 1)];
+  }
+
+}
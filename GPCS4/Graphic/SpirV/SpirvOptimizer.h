@@ -0,0 +1,206 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "SpirvCodeBuffer.h"
+
+#include "UtilFlag.h"
+
+namespace pssl {
+
+  /**
+   * \brief SPIR-V optimizer passes
+   */
+  enum class SpirvOptimizerPass : uint32_t {
+    LoadStoreForwarding   = 0,
+    DeadStoreElimination  = 1,
+    BitcastFolding        = 2,
+    ConstantFolding       = 3,
+
+    PassCount
+  };
+
+  using SpirvOptimizerPasses = Flags<SpirvOptimizerPass>;
+
+
+  /**
+   * \brief SPIR-V optimizer statistics
+   */
+  struct SpirvOptimizerStats {
+    uint32_t insCountBefore   = 0;
+    uint32_t insCountAfter    = 0;
+    uint32_t forwardedLoads   = 0;
+    uint32_t deadStores       = 0;
+    uint32_t foldedBitcasts   = 0;
+    uint32_t foldedConstants  = 0;
+  };
+
+
+  /**
+   * \brief SPIR-V optimizer
+   *
+   * Cleans up the SPIR-V emitted by GCNCompiler, which keeps
+   * every GCN register in a private variable and accesses it
+   * with a load or store around each instruction.
+   *
+   * All passes are local to a block and only deal with
+   * private and function variables which are accessed by
+   * plain loads and stores, so no alias analysis is needed.
+   * Instructions made redundant by any pass are removed
+   * by a dead code sweep at the end.
+   *
+   * Instructions with an unknown operand layout are
+   * left untouched and act as a barrier to all passes.
+   */
+  class SpirvOptimizer {
+
+  public:
+
+    SpirvOptimizer(SpirvOptimizerPasses passes);
+    ~SpirvOptimizer();
+
+    /**
+     * \brief Optimizes a SPIR-V module
+     *
+     * Returns the module unchanged if no pass is enabled.
+     * \param [in] code Complete module, including the header
+     * \returns The optimized module
+     */
+    SpirvCodeBuffer optimize(const SpirvCodeBuffer& code);
+
+    /**
+     * \brief Statistics of the last optimized module
+     * \returns Optimizer statistics
+     */
+    const SpirvOptimizerStats& stats() const {
+      return m_stats;
+    }
+
+    /**
+     * \brief Passes run on compiled shaders
+     * \returns Enabled passes, none by default
+     */
+    static SpirvOptimizerPasses getDefaultPasses();
+
+    /**
+     * \brief Selects passes run on compiled shaders
+     *
+     * Must be called before any shader is compiled.
+     * \param [in] passes Enabled passes
+     */
+    static void setDefaultPasses(SpirvOptimizerPasses passes);
+
+    /**
+     * \brief Parses a pass list
+     *
+     * \param [in] str Comma-separated pass names,
+     *        \c all or \c none
+     * \param [out] passes Parsed passes
+     * \returns \c false if a pass name is unknown
+     */
+    static bool parsePasses(
+      const std::string&      str,
+            SpirvOptimizerPasses& passes);
+
+    /**
+     * \brief Pass name
+     *
+     * \param [in] pass The pass
+     * \returns Name used in pass lists
+     */
+    static const char* passName(SpirvOptimizerPass pass);
+
+    /**
+     * \brief Counts instructions in a module
+     *
+     * \param [in] code Complete module
+     * \returns Number of instructions
+     */
+    static uint32_t countInstructions(const SpirvCodeBuffer& code);
+
+  private:
+
+    struct SpirvConstant {
+      uint32_t typeId;
+      uint32_t value;
+    };
+
+    SpirvOptimizerPasses  m_passes;
+    SpirvOptimizerStats   m_stats;
+
+    // Constants created by folding are appended to
+    // the code, they are emitted before the first function.
+    std::vector<uint32_t> m_code;
+    std::vector<uint32_t> m_insOffsets;
+    std::vector<uint8_t>  m_removed;
+    uint32_t              m_codeSize = 0;
+    uint32_t              m_bound    = 0;
+
+    std::unordered_map<uint32_t, uint32_t> m_defs;
+    std::unordered_map<uint32_t, uint32_t> m_types;
+    std::unordered_map<uint32_t, uint32_t> m_uses;
+    std::unordered_map<uint32_t, uint32_t> m_replacements;
+
+    std::unordered_set<uint32_t> m_scalarTypes;
+    std::unordered_set<uint32_t> m_boolTypes;
+
+    std::unordered_map<uint32_t, SpirvConstant> m_constants;
+    std::unordered_map<uint64_t, uint32_t>      m_constantIds;
+
+    std::unordered_map<uint32_t, spv::StorageClass> m_simpleVars;
+    std::unordered_set<uint32_t>                    m_removedIds;
+
+    std::vector<uint32_t> m_operands;
+
+    void parseModule(const SpirvCodeBuffer& code);
+
+    void findSimpleVars();
+
+    void forwardLoadsAndStores();
+
+    void foldBitcasts();
+
+    void foldConstants();
+
+    void eliminateDeadCode();
+
+    SpirvCodeBuffer emitModule();
+
+    bool foldConstantOp(
+            uint32_t          offset,
+            uint32_t&         value) const;
+
+    uint32_t getConstant(
+            uint32_t          typeId,
+            uint32_t          value);
+
+    uint32_t resolve(uint32_t id) const;
+
+    void replace(
+            uint32_t          offset,
+            uint32_t          id);
+
+    void remove(uint32_t offset);
+
+    bool isRemovable(uint32_t offset) const;
+
+    bool getIdOperands(
+            uint32_t          offset,
+            std::vector<uint32_t>& operands) const;
+
+    uint32_t getResultId(uint32_t offset) const;
+
+    spv::Op getOp(uint32_t offset) const {
+      return spv::Op(m_code[offset] & spv::OpCodeMask);
+    }
+
+    uint32_t getLength(uint32_t offset) const {
+      return m_code[offset] >> spv::WordCountShift;
+    }
+
+  };
+
+}
@@ -176,6 +176,13 @@ VkResult VltCmdList::submit(VkSemaphore wait, VkSemaphore wake)
 {
 	VltQueueSubmission submission = {};
 
+	// Uploads recorded into the init buffer
+	// must complete before any draw reads them.
+	if (m_cmdTypeUsed.test(VltCmdType::InitBuffer))
+	{
+		submission.cmdBuffers[submission.cmdBufferCount++] = m_initBuffer;
+	}
+
 	if (m_cmdTypeUsed.test(VltCmdType::ExecBuffer))
 	{
 		submission.cmdBuffers[submission.cmdBufferCount++] = m_execBuffer;
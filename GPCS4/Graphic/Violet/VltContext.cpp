@@ -13,6 +13,10 @@
 #include "VltShader.h"
 #include "VltStaging.h"
 #include "VltFormat.h"
+#include "VltHash.h"
+#include "VltPipelineLayout.h"
+
+LOG_CHANNEL(Graphic.Violet.VltContext);
 
 namespace vlt
 {
@@ -23,8 +27,34 @@ VltContext::VltContext(const RcPtr<VltDevice>& device) :
 	m_objects(&m_device->m_resObjects),
 	m_cmd(nullptr),
 	m_descPool(nullptr),
-	m_staging(new VltStagingBufferAllocator(device))
+	m_staging(nullptr),
+	m_renames(nullptr)
 {
+	VltBufferCreateInfo stagingInfo = {};
+	stagingInfo.size                = 64 * 1024 * 1024;
+	stagingInfo.usage               = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	stagingInfo.stages              = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	stagingInfo.access              = VK_ACCESS_TRANSFER_READ_BIT;
+	m_staging                       = new VltStagingBufferAllocator(device, stagingInfo,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	// Renamed slices replace guest vertex, index and constant buffers.
+	VltBufferCreateInfo renameInfo = {};
+	renameInfo.size                = 16 * 1024 * 1024;
+	renameInfo.usage               = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+					   VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+					   VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+					   VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	renameInfo.stages              = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+					   VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT;
+	renameInfo.access              = VK_ACCESS_INDEX_READ_BIT |
+					   VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+					   VK_ACCESS_UNIFORM_READ_BIT;
+	m_renames                      = new VltStagingBufferAllocator(device, renameInfo,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	const auto& limits = m_device->physicalDevice()->deviceProperties().limits;
+	m_renameAlignment  = std::max<VkDeviceSize>(limits.minUniformBufferOffsetAlignment, CACHE_LINE_SIZE);
 }
 
 VltContext::~VltContext()
@@ -37,6 +67,21 @@ void VltContext::beginRecording(const RcPtr<VltCmdList>& commandBuffer)
 
 	m_cmd->beginRecording();
 
+	// Staging memory of the frame is reclaimed
+	// once the command list is reset.
+	m_cmd->trackResource(m_staging->beginFrame());
+	m_cmd->trackResource(m_renames->beginFrame());
+
+	m_usedBuffers.clear();
+	m_usedImages.clear();
+	m_usedImageViews.clear();
+
+	// Sets may reference resources destroyed since
+	// the last command list, so none is reused.
+	m_descriptorSets.clear();
+	m_descriptorData.clear();
+	m_stats = VltContextStats();
+
 	// The current state of the internal command buffer is
 	// undefined, so we have to bind and set up everything
 	// before any draw or dispatch command is recorded.
@@ -67,13 +112,52 @@ void VltContext::beginRecording(const RcPtr<VltCmdList>& commandBuffer)
 
 RcPtr<VltCmdList> VltContext::endRecording()
 {
-	renderPassUnbindFramebuffer();
+	if (m_flags.test(VltContextFlag::DirtyPendingUploads))
+	{
+		flushPendingUploads();
+	}
+
+	leaveRenderPassScope();
+
+	if (m_flags.test(VltContextFlag::DirtyInitBarrier))
+	{
+		// The init buffer is submitted ahead of the exec buffer,
+		// one barrier makes all its copies visible to every draw.
+		VkMemoryBarrier barrier = {};
+		barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask   = VK_ACCESS_MEMORY_READ_BIT;
+
+		m_cmd->cmdPipelineBarrier(
+			VltCmdType::InitBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			0,
+			1, &barrier,
+			0, nullptr,
+			0, nullptr);
+
+		m_flags.clr(VltContextFlag::DirtyInitBarrier);
+	}
 
 	m_cmd->endRecording();
 
+	m_staging->endFrame();
+	m_renames->endFrame();
+
+	const auto& stagingStats      = m_staging->getFrameStats();
+	m_stats.stagedBytes           = stagingStats.stagedBytes;
+	m_stats.dedicatedStagingCount = stagingStats.dedicatedCount;
+	m_stats.stagingStallCount     = stagingStats.stallCount;
+	m_frameStats                  = m_stats;
+
 	return std::exchange(m_cmd, nullptr);
 }
 
+const VltContextStats& VltContext::getFrameStats() const
+{
+	return m_frameStats;
+}
+
 void VltContext::setViewports(uint32_t viewportCount, const VkViewport* viewports, const VkRect2D* scissorRects)
 {
 	auto& vp = m_state.dy.vp;
@@ -274,9 +358,11 @@ void VltContext::draw(
 	uint32_t firstVertex,
 	uint32_t firstInstance)
 {
-	commitGraphicsState<false, false>();
-
-	m_cmd->cmdDraw(vertexCount, instanceCount, firstVertex, firstInstance);
+	if (commitGraphicsState<false, false>())
+	{
+		m_cmd->cmdDraw(vertexCount, instanceCount, firstVertex, firstInstance);
+		++m_stats.drawCount;
+	}
 }
 
 void VltContext::drawIndexed(
@@ -286,9 +372,11 @@ void VltContext::drawIndexed(
 	uint32_t vertexOffset,
 	uint32_t firstInstance)
 {
-	commitGraphicsState<true, false>();
-
-	m_cmd->cmdDrawIndexed(indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+	if (commitGraphicsState<true, false>())
+	{
+		m_cmd->cmdDrawIndexed(indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+		++m_stats.drawCount;
+	}
 }
 
 void VltContext::clearRenderTarget(
@@ -478,6 +566,9 @@ void VltContext::copyBuffer(
 	region.size         = numBytes;
 	m_cmd->cmdCopyBuffer(VltCmdType::ExecBuffer, srcSlice.buffer, dstSlice.buffer, 1, &region);
 
+	trackBuffer(dstBuffer);
+	trackBuffer(srcBuffer);
+
 	// Not sure if we need a barrier here....
 	//fullPipelineBarrier();
 }
@@ -493,6 +584,25 @@ void VltContext::copyBufferToImage(
 {
 	leaveRenderPassScope();
 
+	recordBufferToImageCopy(
+		VltCmdType::ExecBuffer,
+		dstImage, dstSubresource, dstOffset, dstExtent,
+		srcBuffer, srcOffset, srcExtent);
+
+	trackImage(dstImage);
+	trackBuffer(srcBuffer);
+}
+
+void VltContext::recordBufferToImageCopy(
+	VltCmdType               cmdType,
+	const RcPtr<VltImage>&   dstImage,
+	VkImageSubresourceLayers dstSubresource,
+	VkOffset3D               dstOffset,
+	VkExtent3D               dstExtent,
+	const RcPtr<VltBuffer>&  srcBuffer,
+	VkDeviceSize             srcOffset,
+	VkExtent2D               srcExtent)
+{
 	VkBufferImageCopy region = {};
 	region.bufferOffset      = srcOffset;
 	region.bufferRowLength   = srcExtent.width;
@@ -503,7 +613,7 @@ void VltContext::copyBufferToImage(
 
 	auto          srcSlice               = srcBuffer->slice();
 	VkImageLayout dstImageLayoutTransfer = dstImage->pickLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-	m_cmd->cmdCopyBufferToImage(VltCmdType::ExecBuffer, srcSlice.buffer, dstImage->handle(), dstImageLayoutTransfer, 1, &region);
+	m_cmd->cmdCopyBufferToImage(cmdType, srcSlice.buffer, dstImage->handle(), dstImageLayoutTransfer, 1, &region);
 }
 
 void VltContext::updateBuffer(const RcPtr<VltBuffer>& buffer,
@@ -511,15 +621,55 @@ void VltContext::updateBuffer(const RcPtr<VltBuffer>& buffer,
 							  VkDeviceSize            size,
 							  const void*             data)
 {
-	leaveRenderPassScope();
+	auto stagingSlice = stageData(data, size);
 
-	auto  stagingSlice = m_staging->alloc(size, CACHE_LINE_SIZE);
-	auto stagingHandle = stagingSlice.getHandle();
-	std::memcpy(stagingHandle.mapPtr, data, size);
+	if (!m_usedBuffers.count(buffer.ptr()))
+	{
+		// Nothing recorded so far uses the buffer,
+		// so the copy can run ahead of all of it.
+		recordInitUpload(buffer->slice(offset, size), stagingSlice, size);
+	}
+	else
+	{
+		VltPendingUpload upload = {};
+		upload.buffer           = buffer;
+		upload.offset           = offset;
+		upload.staging          = stagingSlice;
+		upload.size             = size;
+		m_pendingUploads.push_back(std::move(upload));
+
+		m_flags.set(VltContextFlag::DirtyPendingUploads);
+		++m_stats.batchedUploadCount;
+	}
+}
 
-	copyBuffer(buffer, offset, stagingSlice.buffer(), stagingSlice.offset(), size);
+VltBufferSlice VltContext::updateBufferSlice(
+	const VltBufferSlice& slice,
+	const void*           data)
+{
+	VltBufferSlice result = slice;
+	do
+	{
+		if (!m_usedBuffers.count(slice.buffer().ptr()))
+		{
+			updateBuffer(slice.buffer(), slice.offset(), slice.length(), data);
+			break;
+		}
 
-	m_cmd->trackResource(stagingSlice.buffer());
+		// The ring only hands out memory no recorded command
+		// reads, even though its buffer is used by earlier
+		// renamed slices, so the copy can run ahead of them all.
+		result            = m_renames->alloc(slice.length(), m_renameAlignment);
+		auto stagingSlice = stageData(data, slice.length());
+		recordInitUpload(result.getHandle(), stagingSlice, slice.length());
+
+		// Marks a dedicated buffer busy right away,
+		// so the next rename doesn't reuse it.
+		trackBuffer(result.buffer());
+
+		++m_stats.renamedUploadCount;
+	} while (false);
+	return result;
 }
 
 void VltContext::updateImage(
@@ -531,7 +681,19 @@ void VltContext::updateImage(
 	VkDeviceSize                    pitchPerRow,
 	VkDeviceSize                    pitchPerLayer)
 {
-	leaveRenderPassScope();
+	// Images no recorded command uses are
+	// updated ahead of them in the init buffer.
+	VltCmdType cmdType = VltCmdType::InitBuffer;
+	if (m_usedImages.count(image.ptr()))
+	{
+		leaveRenderPassScope();
+		cmdType = VltCmdType::ExecBuffer;
+	}
+	else
+	{
+		m_flags.set(VltContextFlag::DirtyInitBarrier);
+		++m_stats.initUploadCount;
+	}
 
 	auto imgInfo    = image->info();
 	auto formatInfo = image->formatInfo();
@@ -558,16 +720,16 @@ void VltContext::updateImage(
 	// VK_IMAGE_LAYOUT_UNDEFINED at any chance as long as we don't
 	// care the initial content.
 
-	transitionImageLayout(image->handle(),
+	transitionImageLayout(cmdType, image->handle(),
 						  VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
 						  0, VK_ACCESS_TRANSFER_WRITE_BIT,
 						  VK_IMAGE_LAYOUT_UNDEFINED, transferLayout);
 
 	VkExtent2D copyExtent = { 0, 0 };
-	copyBufferToImage(image, subresources, imageOffset, imageExtent,
-					  stagingSlice.buffer(), stagingSlice.offset(), copyExtent);
+	recordBufferToImageCopy(cmdType, image, subresources, imageOffset, imageExtent,
+							stagingSlice.buffer(), stagingSlice.offset(), copyExtent);
 
-	transitionImageLayout(image->handle(),
+	transitionImageLayout(cmdType, image->handle(),
 						  VK_PIPELINE_STAGE_TRANSFER_BIT, imgInfo.stages,
 						  VK_ACCESS_TRANSFER_WRITE_BIT, imgInfo.access,
 						  transferLayout, imgInfo.layout);
@@ -598,6 +760,7 @@ void VltContext::uploadImage(
 }
 
 void VltContext::transitionImageLayout(
+	VltCmdType           cmdType,
 	VkImage              image,
 	VkPipelineStageFlags srcStage,
 	VkPipelineStageFlags dstStage,
@@ -622,7 +785,7 @@ void VltContext::transitionImageLayout(
 	barrier.dstAccessMask                   = dstAccess;
 
 	m_cmd->cmdPipelineBarrier(
-		VltCmdType::ExecBuffer,
+		cmdType,
 		srcStage, dstStage,
 		0,
 		0, nullptr,
@@ -630,6 +793,35 @@ void VltContext::transitionImageLayout(
 		1, &barrier);
 }
 
+VltBufferSlice VltContext::stageData(
+	const void*  data,
+	VkDeviceSize size)
+{
+	auto stagingSlice = m_staging->alloc(size, CACHE_LINE_SIZE);
+	std::memcpy(stagingSlice.mapPtr(0), data, size);
+
+	m_cmd->trackResource(stagingSlice.buffer());
+	return stagingSlice;
+}
+
+void VltContext::recordInitUpload(
+	const VltBufferSliceHandle& dstHandle,
+	const VltBufferSlice&       staging,
+	VkDeviceSize                size)
+{
+	auto srcHandle = staging.getHandle();
+
+	VkBufferCopy region = {};
+	region.srcOffset    = srcHandle.offset;
+	region.dstOffset    = dstHandle.offset;
+	region.size         = size;
+	m_cmd->cmdCopyBuffer(VltCmdType::InitBuffer,
+						 srcHandle.buffer, dstHandle.buffer, 1, &region);
+
+	m_flags.set(VltContextFlag::DirtyInitBarrier);
+	++m_stats.initUploadCount;
+}
+
 void VltContext::fullPipelineBarrier()
 {
 	// This should be only used for debugging purpose.
@@ -799,6 +991,13 @@ void VltContext::renderPassBindFramebuffer(const RcPtr<VltFrameBuffer>& framebuf
 	renderPassInfo.pClearValues    = clearValues;
 
 	m_cmd->cmdBeginRenderPass(&renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	// Attachments are written by the pass, so later
+	// uploads to them must stay behind it.
+	for (uint32_t i = 0; i != framebuffer->numAttachments(); ++i)
+	{
+		trackImageView(framebuffer->getAttachment(i).view);
+	}
 }
 
 void VltContext::renderPassUnbindFramebuffer()
@@ -822,6 +1021,8 @@ void VltContext::updateVertexBindings()
 		buffers[bindingCount] = buffer.buffer()->slice().buffer;
 		offsets[bindingCount] = buffer.offset();
 		++bindingCount;
+
+		trackBuffer(buffer.buffer());
 	}
 
 	if (bindingCount)
@@ -846,86 +1047,80 @@ void VltContext::updateIndexBinding()
 		VkIndexType  type        = m_state.vi.indexType;
 		m_cmd->cmdBindIndexBuffer(indexBuffer, offset, type);
 
+		trackBuffer(m_state.vi.indexBuffer.buffer());
+
 		m_flags.clr(VltContextFlag::GpDirtyIndexBuffer);
 	} while (false);
 }
 
-template <VkPipelineBindPoint BindPoint>
-void VltContext::updateShaderResources(const VltPipelineLayout* pipelineLayout, VkDescriptorSet& set)
+void VltContext::trackBuffer(const RcPtr<VltBuffer>& buffer)
 {
+	if (m_usedBuffers.insert(buffer.ptr()).second)
+	{
+		m_cmd->trackResource(buffer);
+	}
+}
 
-	uint32_t                          bindingCount = pipelineLayout->bindingCount();
-	std::vector<VkWriteDescriptorSet> descriptorWrites;
-
-	if (bindingCount != 0)
+void VltContext::trackImage(const RcPtr<VltImage>& image)
+{
+	if (m_usedImages.insert(image.ptr()).second)
 	{
-		set = allocateDescriptorSet(pipelineLayout->descriptorSetLayout());
+		m_cmd->trackResource(image);
 	}
-	else
+}
+
+void VltContext::trackImageView(const RcPtr<VltImageView>& imageView)
+{
+	// The image is tracked as well, the residency
+	// manager checks whether the image is busy.
+	if (m_usedImageViews.insert(imageView.ptr()).second)
 	{
-		set = VK_NULL_HANDLE;
+		trackImage(imageView->getImage());
+		m_cmd->trackResource(imageView);
 	}
+}
+
+template <VkPipelineBindPoint BindPoint>
+void VltContext::updateShaderResources(const VltPipelineLayout* pipelineLayout, VkDescriptorSet& set)
+{
+	uint32_t bindingCount = pipelineLayout->bindingCount();
+	LOG_ASSERT(bindingCount <= MaxNumActiveBindings, "too many bindings %d", bindingCount);
+
+	std::array<VltDescriptorInfo, MaxNumActiveBindings> descriptors;
+	// Zeroed so unused bytes don't break the comparison below.
+	std::memset(descriptors.data(), 0, sizeof(VltDescriptorInfo) * bindingCount);
 
 	for (uint32_t i = 0; i != bindingCount; ++i)
 	{
-		auto     binding = pipelineLayout->binding(i);
-		uint32_t regSlot = binding.resSlot.regSlot;
-		auto     res     = m_res[regSlot];
+		auto        binding = pipelineLayout->binding(i);
+		uint32_t    regSlot = binding.resSlot.regSlot;
+		const auto& res     = m_res[regSlot];
 
 		switch (binding.resSlot.type)
 		{
 		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
 		{
-			VkDescriptorBufferInfo bufferInfo = {};
-			bufferInfo.buffer                 = res.buffer.getHandle().buffer;
-			bufferInfo.offset                 = res.buffer.offset();
-			bufferInfo.range                  = res.buffer.length();
-
-			VkWriteDescriptorSet writeSet = {};
-			writeSet.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			writeSet.dstSet               = set;
-			writeSet.dstBinding           = i;
-			writeSet.dstArrayElement      = 0;
-			writeSet.descriptorType       = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			writeSet.descriptorCount      = 1;
-			writeSet.pBufferInfo          = &bufferInfo;
-			descriptorWrites.push_back(writeSet);
+			descriptors[i].buffer.buffer = res.buffer.getHandle().buffer;
+			descriptors[i].buffer.offset = res.buffer.offset();
+			descriptors[i].buffer.range  = res.buffer.length();
+
+			trackBuffer(res.buffer.buffer());
 		}
 		break;
 		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
 		{
-			VkDescriptorImageInfo imageInfo = {};
-			imageInfo.imageLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			imageInfo.imageView             = res.imageView->handle();
-			imageInfo.sampler               = nullptr;
-
-			VkWriteDescriptorSet writeSet = {};
-			writeSet.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			writeSet.dstSet               = set;
-			writeSet.dstBinding           = i;
-			writeSet.dstArrayElement      = 0;
-			writeSet.descriptorType       = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-			writeSet.descriptorCount      = 1;
-			writeSet.pImageInfo           = &imageInfo;
-			descriptorWrites.push_back(writeSet);
+			descriptors[i].image.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			descriptors[i].image.imageView   = res.imageView->handle();
+			descriptors[i].image.sampler     = VK_NULL_HANDLE;
+
+			trackImageView(res.imageView);
 		}
 		break;
 		case VK_DESCRIPTOR_TYPE_SAMPLER:
 		{
-			VkDescriptorImageInfo imageInfo = {};
-			imageInfo.imageLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
-			imageInfo.imageView             = VK_NULL_HANDLE;
-			imageInfo.sampler               = res.sampler->handle();
-
-			VkWriteDescriptorSet writeSet = {};
-			writeSet.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			writeSet.dstSet               = set;
-			writeSet.dstBinding           = i;
-			writeSet.dstArrayElement      = 0;
-			writeSet.descriptorType       = VK_DESCRIPTOR_TYPE_SAMPLER;
-			writeSet.descriptorCount      = 1;
-			writeSet.pImageInfo           = &imageInfo;
-			descriptorWrites.push_back(writeSet);
+			descriptors[i].image.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			descriptors[i].image.imageView   = VK_NULL_HANDLE;
+			descriptors[i].image.sampler     = res.sampler->handle();
 		}
 		break;
 		default:
@@ -933,17 +1128,77 @@ void VltContext::updateShaderResources(const VltPipelineLayout* pipelineLayout,
 		}
 	}
 
-	// TODO:
-	// Use vkUpdateDescriptorSetWithTemplate
-	m_cmd->updateDescriptorSets(descriptorWrites.size(), descriptorWrites.data());
+	do
+	{
+		// No template means no binding has a type
+		// the context writes, so there is no set.
+		if (bindingCount == 0 ||
+			pipelineLayout->descriptorTemplate() == VK_NULL_HANDLE)
+		{
+			set = VK_NULL_HANDLE;
+			break;
+		}
+
+		// Draws often rebind the same resources, then the
+		// set written for the first of them is reused.
+		size_t dataSize = sizeof(VltDescriptorInfo) * bindingCount;
+
+		VltHashState hash;
+		hash.add(reinterpret_cast<size_t>(pipelineLayout));
+		const uint64_t* words = reinterpret_cast<const uint64_t*>(descriptors.data());
+		for (size_t w = 0; w != dataSize / sizeof(uint64_t); ++w)
+		{
+			hash.add(words[w]);
+		}
+
+		auto range = m_descriptorSets.equal_range(hash);
+		auto iter  = range.first;
+		for (; iter != range.second; ++iter)
+		{
+			if (iter->second.layout == pipelineLayout &&
+				std::memcmp(&m_descriptorData[iter->second.descriptorOffset], descriptors.data(), dataSize) == 0)
+			{
+				break;
+			}
+		}
+
+		if (iter != range.second)
+		{
+			set = iter->second.set;
+			++m_stats.descriptorSetReuseCount;
+			break;
+		}
+
+		set = allocateDescriptorSet(pipelineLayout->descriptorSetLayout());
+		m_cmd->updateDescriptorSetWithTemplate(set, pipelineLayout->descriptorTemplate(), descriptors.data());
+		++m_stats.descriptorSetCount;
+
+		VltDescriptorSetEntry entry = {};
+		entry.layout                = pipelineLayout;
+		entry.descriptorOffset      = m_descriptorData.size();
+		entry.set                   = set;
+		m_descriptorSets.emplace(hash, entry);
+
+		m_descriptorData.insert(m_descriptorData.end(),
+								descriptors.begin(), descriptors.begin() + bindingCount);
+	} while (false);
 }
 
 template <VkPipelineBindPoint BindPoint>
 void VltContext::updateShaderDescriptorSetBinding(const VltPipelineLayout* layout, VkDescriptorSet set)
 {
-	VkPipelineLayout pipelineLayout = layout->pipelineLayout();
+	do
+	{
+		// Layouts without a written set have nothing to bind.
+		if (set == VK_NULL_HANDLE)
+		{
+			break;
+		}
+
+		VkPipelineLayout pipelineLayout = layout->pipelineLayout();
 
-	m_cmd->cmdBindDescriptorSet(BindPoint, pipelineLayout, set, 0, nullptr);
+		m_cmd->cmdBindDescriptorSet(BindPoint, pipelineLayout, set, 0, nullptr);
+	} while (false);
 }
 
 VkDescriptorSet VltContext::allocateDescriptorSet(VkDescriptorSetLayout layout)
@@ -958,8 +1213,11 @@ VkDescriptorSet VltContext::allocateDescriptorSet(VkDescriptorSetLayout layout)
 	if (set == VK_NULL_HANDLE)
 	{
 		// The old descriptor pool is full, we trace it
-		// and create a new one.
+		// and create a new one. Its sets are freed once
+		// the command list completes, so forget them.
 		m_cmd->trackDescriptorPool(std::move(m_descPool));
+		m_descriptorSets.clear();
+		m_descriptorData.clear();
 
 		m_descPool = m_device->createDescriptorPool();
 		set        = m_descPool->alloc(layout);
@@ -997,14 +1255,27 @@ void VltContext::updateGraphicsPipeline()
 	m_flags.clr(VltContextFlag::GpDirtyPipeline);
 }
 
-void VltContext::updateGraphicsPipelineStates()
+bool VltContext::updateGraphicsPipelineStates()
 {
-	VltRenderPass* renderPass = m_state.om.framebuffer->getRenderPass();
-	m_gpCtx.pipeline          = m_state.gp.pipeline->getPipelineHandle(m_state.gp.states, *renderPass);
+	bool ready = false;
+	do
+	{
+		VltRenderPass* renderPass = m_state.om.framebuffer->getRenderPass();
+		m_gpCtx.pipeline          = m_state.gp.pipeline->getPipelineHandle(m_state.gp.states, *renderPass);
 
-	m_cmd->cmdBindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, m_gpCtx.pipeline);
+		if (m_gpCtx.pipeline == VK_NULL_HANDLE)
+		{
+			// Still being compiled in the background,
+			// keep the state dirty so the next draw retries.
+			break;
+		}
+
+		m_cmd->cmdBindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, m_gpCtx.pipeline);
 
-	m_flags.clr(VltContextFlag::GpDirtyPipelineState);
+		m_flags.clr(VltContextFlag::GpDirtyPipelineState);
+		ready = true;
+	} while (false);
+	return ready;
 }
 
 void VltContext::updateComputePipeline()
@@ -1035,6 +1306,7 @@ void VltContext::enterRenderPassScope()
 			m_state.om.renderPassOps);
 
 		m_flags.set(VltContextFlag::GpRenderPassBound);
+		++m_stats.renderPassCount;
 	}
 }
 
@@ -1047,6 +1319,55 @@ void VltContext::leaveRenderPassScope()
 	}
 }
 
+void VltContext::flushPendingUploads()
+{
+	leaveRenderPassScope();
+
+	// Draws recorded before may still read what the
+	// copies overwrite, and the next ones read the result.
+	VkMemoryBarrier barrier = {};
+	barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask   = 0;
+	barrier.dstAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+	m_cmd->cmdPipelineBarrier(
+		VltCmdType::ExecBuffer,
+		VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0,
+		1, &barrier,
+		0, nullptr,
+		0, nullptr);
+
+	for (const auto& upload : m_pendingUploads)
+	{
+		auto srcHandle = upload.staging.getHandle();
+		auto dstHandle = upload.buffer->slice(upload.offset, upload.size);
+
+		VkBufferCopy region = {};
+		region.srcOffset    = srcHandle.offset;
+		region.dstOffset    = dstHandle.offset;
+		region.size         = upload.size;
+		m_cmd->cmdCopyBuffer(VltCmdType::ExecBuffer,
+							 srcHandle.buffer, dstHandle.buffer, 1, &region);
+	}
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDEX_READ_BIT |
+							VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+							VK_ACCESS_UNIFORM_READ_BIT |
+							VK_ACCESS_SHADER_READ_BIT;
+	m_cmd->cmdPipelineBarrier(
+		VltCmdType::ExecBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT,
+		0,
+		1, &barrier,
+		0, nullptr,
+		0, nullptr);
+
+	m_pendingUploads.clear();
+	m_flags.clr(VltContextFlag::DirtyPendingUploads);
+	++m_stats.uploadFlushCount;
+}
+
 void VltContext::updateDynamicState()
 {
 	if (m_flags.test(VltContextFlag::GpDirtyViewport))
@@ -1063,8 +1384,13 @@ void VltContext::updateDynamicState()
 }
 
 template <bool Indexed, bool Indirect>
-void VltContext::commitGraphicsState()
+bool VltContext::commitGraphicsState()
 {
+	if (m_flags.test(VltContextFlag::DirtyPendingUploads))
+	{
+		flushPendingUploads();
+	}
+
 	if (m_flags.test(VltContextFlag::GpDirtyFramebuffer))
 	{
 		updateFrameBuffer();
@@ -1106,10 +1432,13 @@ void VltContext::commitGraphicsState()
 		updateGraphicsShaderResources();
 	}
 
+	bool ready = true;
 	if (m_flags.test(VltContextFlag::GpDirtyPipelineState))
 	{
-		updateGraphicsPipelineStates();
+		ready = updateGraphicsPipelineStates();
 	}
+
+	return ready;
 }
 
 void VltContext::commitComputeState()
@@ -6,12 +6,17 @@
 
 #include <array>
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace vlt
 {;
 
 struct VltAttachment;
 
+enum class VltCmdType;
+
 class VltDevice;
 class VltCmdList;
 class VltShader;
@@ -35,6 +40,56 @@ struct VltShaderResourceSlot
 	RcPtr<VltBufferView> bufferView;
 };
 
+/**
+ * \brief Buffer upload waiting for the next draw
+ *
+ * The data is already in the staging buffer,
+ * only the copy is deferred.
+ */
+struct VltPendingUpload
+{
+	RcPtr<VltBuffer> buffer;
+	VkDeviceSize     offset;
+	VltBufferSlice   staging;
+	VkDeviceSize     size;
+};
+
+/**
+ * \brief Context statistics
+ *
+ * Counted per command list, from
+ * beginRecording to endRecording.
+ */
+struct VltContextStats
+{
+	uint32_t drawCount          = 0;
+	uint32_t renderPassCount    = 0;  // Render pass begins
+	uint32_t initUploadCount    = 0;  // Uploads recorded ahead of all draws
+	uint32_t batchedUploadCount = 0;  // Uploads deferred to the next draw
+	uint32_t renamedUploadCount = 0;  // Uploads to in-use slices given fresh memory
+	uint32_t uploadFlushCount   = 0;  // Deferred batches, each ends the render pass once
+
+	uint32_t descriptorSetCount      = 0;  // Sets allocated and written
+	uint32_t descriptorSetReuseCount = 0;  // Draws which reused a written set
+
+	VkDeviceSize stagedBytes           = 0;
+	uint32_t     dedicatedStagingCount = 0;  // Uploads staged outside the ring
+	uint32_t     stagingStallCount     = 0;  // Uploads which found the ring full
+};
+
+/**
+ * \brief Descriptor set cache entry
+ *
+ * A written descriptor set and where the descriptors
+ * written to it are stored in the context's arena.
+ */
+struct VltDescriptorSetEntry
+{
+	const VltPipelineLayout* layout;
+	size_t                   descriptorOffset;
+	VkDescriptorSet          set;
+};
+
 struct VltPipelineContext
 {
 	VkPipeline pipeline = VK_NULL_HANDLE;
@@ -56,6 +111,15 @@ public:
 
 	RcPtr<VltCmdList> endRecording();
 
+	/**
+	 * \brief Statistics of the last command list
+	 *
+	 * Updated by endRecording, so render pass
+	 * begins can be compared frame by frame.
+	 * \returns Counters of the last recording
+	 */
+	const VltContextStats& getFrameStats() const;
+
 	///< Pipeline state setting methods.
 
 	void setViewports(
@@ -194,6 +258,10 @@ public:
      * \brief Updates a buffer
      * 
      * Copies data from the host into a buffer.
+     * If no command recorded so far reads the buffer, the copy
+     * goes to the init command buffer, which runs ahead of all
+     * draws. Otherwise it is deferred to the next draw, where all
+     * deferred copies end the render pass only once.
      * \param [in] buffer Destination buffer
      * \param [in] offset Offset of sub range to update
      * \param [in] size Length of sub range to update
@@ -205,10 +273,29 @@ public:
 		VkDeviceSize            size,
 		const void*             data);
 
+	/**
+     * \brief Updates a buffer slice, renaming it if in use
+     * 
+     * Like \c updateBuffer, but if commands recorded so far
+     * use the buffer, the data goes to a fresh slice which
+     * nothing recorded reads. That copy still goes to the
+     * init command buffer, so the render pass stays open.
+     * The caller binds the returned slice in place of the
+     * old one, which keeps its previous contents.
+     * \param [in] slice Destination slice
+     * \param [in] data Data to upload, the slice's length
+     * \returns The slice holding the data
+     */
+	VltBufferSlice updateBufferSlice(
+		const VltBufferSlice& slice,
+		const void*           data);
+
 	/**
      * \brief Updates an image
      * 
-     * Copies data from the host into an image.
+     * Copies data from the host into an image. Like buffers,
+     * images no command reads yet are updated in the init
+     * command buffer without ending the render pass.
      * \param [in] image Destination image
      * \param [in] subsresources Image subresources to update
      * \param [in] imageOffset Offset of the image area to update
@@ -262,6 +349,12 @@ private:
 
 	void updateIndexBinding();
 
+	void trackBuffer(const RcPtr<VltBuffer>& buffer);
+
+	void trackImage(const RcPtr<VltImage>& image);
+
+	void trackImageView(const RcPtr<VltImageView>& imageView);
+
 	void updateDynamicState();
 
 	void resetRenderPassOps(
@@ -282,10 +375,10 @@ private:
 
 	/// Graphics
 	template <bool Indexed, bool Indirect>
-	void commitGraphicsState();
+	bool commitGraphicsState();
 	void updateGraphicsShaderResources();
 	void updateGraphicsPipeline();
-	void updateGraphicsPipelineStates();
+	bool updateGraphicsPipelineStates();
 	/// Compute
 	void commitComputeState();
 	void updateComputeDescriptorLayout();
@@ -295,6 +388,18 @@ private:
 	void enterRenderPassScope();
 	void leaveRenderPassScope();
 
+	void flushPendingUploads();
+
+	void recordBufferToImageCopy(
+		VltCmdType               cmdType,
+		const RcPtr<VltImage>&   dstImage,
+		VkImageSubresourceLayers dstSubresource,
+		VkOffset3D               dstOffset,
+		VkExtent3D               dstExtent,
+		const RcPtr<VltBuffer>&  srcBuffer,
+		VkDeviceSize             srcOffset,
+		VkExtent2D               srcExtent);
+
 	void renderPassBindFramebuffer(const RcPtr<VltFrameBuffer>& framebuffer,
 								   const VltRenderPassOps&      ops,
 								   uint32_t                     clearValueCount,
@@ -303,6 +408,7 @@ private:
 
 	/// Helpers
 	void transitionImageLayout(
+		VltCmdType           cmdType,
 		VkImage              image,
 		VkPipelineStageFlags srcStage,
 		VkPipelineStageFlags dstStage,
@@ -314,6 +420,15 @@ private:
 	// Should be only used for debugging purpose.
 	void fullPipelineBarrier();
 
+	VltBufferSlice stageData(
+		const void*  data,
+		VkDeviceSize size);
+
+	void recordInitUpload(
+		const VltBufferSliceHandle& dstHandle,
+		const VltBufferSlice&       staging,
+		VkDeviceSize                size);
+
 private:
 	RcPtr<VltDevice>    m_device;
 	VltResourceObjects* m_objects;
@@ -323,6 +438,11 @@ private:
 	RcPtr<VltDescriptorPool>         m_descPool;
 	RcPtr<VltStagingBufferAllocator> m_staging;
 
+	// Device local slices in-use buffers are renamed to,
+	// reclaimed per command list like staging memory.
+	RcPtr<VltStagingBufferAllocator> m_renames;
+	VkDeviceSize                     m_renameAlignment;
+
 	VltContextFlags m_flags;
 	VltContextState m_state;
 
@@ -331,7 +451,23 @@ private:
 
 	std::array<VltShaderResourceSlot, pssl::PsslBindingIndexMax> m_res;
 
-	
+	// Resources read or written by commands recorded in the current
+	// command list, uploads to them must not move into the init buffer.
+	// The command list keeps them alive until it has executed.
+	std::unordered_set<const VltBuffer*>    m_usedBuffers;
+	std::unordered_set<const VltImage*>     m_usedImages;
+	std::unordered_set<const VltImageView*> m_usedImageViews;
+	std::vector<VltPendingUpload>        m_pendingUploads;
+
+	// Descriptor sets written in the current command
+	// list, keyed by a hash of layout and descriptors.
+	// Their descriptors are appended to one arena, which
+	// keeps its capacity across command lists.
+	std::unordered_multimap<size_t, VltDescriptorSetEntry> m_descriptorSets;
+	std::vector<VltDescriptorInfo>                         m_descriptorData;
+
+	VltContextStats m_stats;
+	VltContextStats m_frameStats;
 };
 
 
@@ -48,6 +48,8 @@ enum class VltContextFlag : uint32_t
 
 	DirtyDrawBuffer,            ///< Indirect argument buffer is dirty
 	DirtyPushConstants,         ///< Push constant data has changed
+	DirtyInitBarrier,           ///< Uploads in the init buffer need a barrier
+	DirtyPendingUploads,        ///< Uploads wait to be copied before the next draw
 };
 
 using VltContextFlags = Flags<VltContextFlag>;
@@ -30,6 +30,14 @@ VltDevice::VltDevice(
 
 VltDevice::~VltDevice()
 {
+	// Queued command lists must execute and release
+	// their resources while the device is alive.
+	m_submissionQueue.stop();
+
+	// The pipeline cache can only be read back
+	// while the device is still alive.
+	m_resObjects.pipelineManager().shutdown();
+
 	vkDestroyDevice(m_device, nullptr);
 }
 
@@ -136,14 +144,33 @@ RcPtr<VltSampler> VltDevice::createSampler(const VltSamplerCreateInfo& info)
 	return new VltSampler(this, info);
 }
 
-void VltDevice::submitCommandList(const VltSubmitInfo& submission)
+void VltDevice::submitCommandList(
+	const VltSubmitInfo& submission,
+	VltSubmitStatus*     status)
+{
+	m_submissionQueue.submit(submission, status);
+}
+
+void VltDevice::presentImage(
+	const VltPresentInfo& presentation,
+	VltSubmitStatus*      status)
 {
-	m_submissionQueue.submit(submission);
+	m_submissionQueue.present(presentation, status);
 }
 
-void VltDevice::presentImage(const VltPresentInfo& presentation)
+VkResult VltDevice::waitForSubmission(VltSubmitStatus* status)
 {
-	m_submissionQueue.present(presentation);
+	return m_submissionQueue.synchronizeSubmission(status);
+}
+
+void VltDevice::syncSubmissions()
+{
+	m_submissionQueue.synchronize();
+}
+
+VltSubmissionQueueStats VltDevice::getSubmissionStats()
+{
+	return m_submissionQueue.getStats();
 }
 
 bool VltDevice::hasDedicatedTransferQueue() const
@@ -151,6 +178,18 @@ bool VltDevice::hasDedicatedTransferQueue() const
 	return m_queues.transfer.queueFamily != m_queues.graphics.queueFamily;
 }
 
+VltMemoryBudget VltDevice::getMemoryBudget()
+{
+	return m_memAllocator.getMemoryBudget();
+}
+
+VltPipelinePrewarmStats VltDevice::prewarmPipelines(
+	const std::function<RcPtr<VltShader>(uint64_t)>& findShader,
+	std::chrono::milliseconds                        budget)
+{
+	return m_resObjects.pipelineManager().prewarm(findShader, budget);
+}
+
 void VltDevice::recycleDescriptorPool(const RcPtr<VltDescriptorPool>& pool)
 {
 	m_recycledDescriptorPools.returnObject(pool);
@@ -46,6 +46,7 @@ class VltDevice : public RcObject
 {
 	friend class VltContext;
 	friend class VltDescriptorPoolTracker;
+	friend class VltPipelineManager;
 	friend class VltSubmissionQueue;
 
 public:
@@ -82,12 +83,67 @@ public:
 
 	RcPtr<VltSampler> createSampler(const VltSamplerCreateInfo& info);
 
-	void submitCommandList(const VltSubmitInfo& submission);
-
-	void presentImage(const VltPresentInfo& presentation);
+	/**
+	 * \brief Queues a command list for submission
+	 *
+	 * Returns right away, the command list is submitted
+	 * by the submission queue thread.
+	 * \param [in] submission Command list and semaphores
+	 * \param [in] status Set once the command list has executed
+	 */
+	void submitCommandList(
+		const VltSubmitInfo& submission,
+		VltSubmitStatus*     status = nullptr);
+
+	/**
+	 * \brief Queues an image for presentation
+	 *
+	 * \param [in] presentation Presenter and semaphore
+	 * \param [in] status Set once the image is presented
+	 */
+	void presentImage(
+		const VltPresentInfo& presentation,
+		VltSubmitStatus*      status = nullptr);
+
+	/**
+	 * \brief Waits for a queued submission or present
+	 *
+	 * \param [in] status Status passed when queueing
+	 * \returns Result of the submission or present
+	 */
+	VkResult waitForSubmission(VltSubmitStatus* status);
+
+	/**
+	 * \brief Waits until all queued command lists have executed
+	 */
+	void syncSubmissions();
+
+	/**
+	 * \brief Submission queue statistics
+	 * \returns Queue depth and submit latency
+	 */
+	VltSubmissionQueueStats getSubmissionStats();
 
 	bool hasDedicatedTransferQueue() const;
 
+	/**
+	 * \brief Queries the memory budget
+	 * \returns Budget and usage of each heap
+	 */
+	VltMemoryBudget getMemoryBudget();
+
+	/**
+	 * \brief Creates logged pipelines ahead of time
+	 *
+	 * See \c VltPipelineManager::prewarm.
+	 * \param [in] findShader Looks up a shader by its key
+	 * \param [in] budget Time budget
+	 * \returns Prewarm statistics
+	 */
+	VltPipelinePrewarmStats prewarmPipelines(
+		const std::function<RcPtr<VltShader>(uint64_t)>& findShader,
+		std::chrono::milliseconds                        budget);
+
 private:
 	void recycleDescriptorPool(const RcPtr<VltDescriptorPool>& pool);
 	void recycleCommandList(const RcPtr<VltCmdList>& cmdList);
@@ -3,6 +3,7 @@
 #include "VltPipelineManager.h"
 #include "VltPipelineLayout.h"
 
+#include <algorithm>
 #include <mutex>
 
 LOG_CHANNEL(Graphic.Violet.VltGraphicsPipeline);
@@ -12,10 +13,12 @@ namespace vlt
 
 VltGraphicsPipelineInstance::VltGraphicsPipelineInstance(VkPipeline pipeline,
 	const VltGraphicsPipelineStateInfo& state,
-	const VltRenderPass& rp) :
+	const VltRenderPass& rp,
+	size_t hash) :
 	m_pipeline(pipeline),
 	m_state(state),
-	m_renderPass(&rp)
+	m_renderPass(&rp),
+	m_hash(hash)
 {
 
 }
@@ -29,9 +32,19 @@ VkPipeline VltGraphicsPipelineInstance::pipeline()
 	return m_pipeline;
 }
 
-bool VltGraphicsPipelineInstance::isCompatible(const VltGraphicsPipelineStateInfo& state, const VltRenderPass& rp) const
+size_t VltGraphicsPipelineInstance::hash(const VltGraphicsPipelineStateInfo& state, const VltRenderPass& rp)
 {
-	return (m_state == state) && (m_renderPass == &rp);
+	VltHashState hash;
+	hash.add(state.hash());
+	hash.add(reinterpret_cast<uintptr_t>(&rp));
+	return hash;
+}
+
+bool VltGraphicsPipelineInstance::isCompatible(const VltGraphicsPipelineStateInfo& state, const VltRenderPass& rp, size_t hash) const
+{
+	// The hash rejects almost every other instance
+	// before the full state is compared.
+	return (m_hash == hash) && (m_renderPass == &rp) && (m_state == state);
 }
 
 ///
@@ -49,6 +62,16 @@ VltGraphicsPipeline::VltGraphicsPipeline(VltPipelineManager* pipeMgr, const VltG
 
 VltGraphicsPipeline::~VltGraphicsPipeline()
 {
+	for (auto& bucket : m_buckets)
+	{
+		InstanceNode* node = bucket.load(std::memory_order_relaxed);
+		while (node)
+		{
+			InstanceNode* next = node->next;
+			delete node;
+			node = next;
+		}
+	}
 }
 
 
@@ -58,21 +81,40 @@ VkPipeline VltGraphicsPipeline::getPipelineHandle(const VltGraphicsPipelineState
 	
 	do 
 	{
+		m_lookupCount.fetch_add(1, std::memory_order_relaxed);
+
+		size_t hash = VltGraphicsPipelineInstance::hash(state, rp);
+
+		auto instance = findInstance(state, rp, hash);
+		if (instance)
+		{
+			pipeline = instance->pipeline();
+			break;
+		}
+
+		m_missCount.fetch_add(1, std::memory_order_relaxed);
+
 		std::lock_guard<Spinlock> lock(m_mutex);
 
-		auto instance = findInstance(state, rp);
+		// Another thread may have added it
+		// while we were waiting for the lock.
+		instance = findInstance(state, rp, hash);
 		if (instance)
 		{
 			pipeline = instance->pipeline();
 			break;
 		}
 
-		instance = createInstance(state, rp);
+#ifdef GPCS4_SKIP_DRAW_UNTIL_READY
+		createInstanceAsync(state, rp, hash);
+#else
+		instance = createInstance(state, rp, hash);
 		if (!instance)
 		{
 			break;
 		}
 		pipeline = instance->pipeline();
+#endif  // GPCS4_SKIP_DRAW_UNTIL_READY
 
 	} while (false);
 	return pipeline;
@@ -83,25 +125,148 @@ VltPipelineLayout* VltGraphicsPipeline::getLayout() const
 	return m_layout;
 }
 
-VltGraphicsPipelineInstance* VltGraphicsPipeline::findInstance(const VltGraphicsPipelineStateInfo& state, const VltRenderPass& rp)
+bool VltGraphicsPipeline::compileInstance(const VltGraphicsPipelineStateInfo& state, const VltRenderPass& rp)
+{
+	bool ret = false;
+	do
+	{
+		size_t hash = VltGraphicsPipelineInstance::hash(state, rp);
+		if (findInstance(state, rp, hash))
+		{
+			ret = true;
+			break;
+		}
+
+		VkPipeline pipeline = createPipeline(state, rp);
+		if (pipeline == VK_NULL_HANDLE)
+		{
+			break;
+		}
+
+		std::lock_guard<Spinlock> lock(m_mutex);
+
+		// A draw may have created it in the meantime.
+		if (findInstance(state, rp, hash))
+		{
+			vkDestroyPipeline(*(m_pipelineManager->m_device), pipeline, nullptr);
+		}
+		else
+		{
+			insertInstance(pipeline, state, rp, hash);
+		}
+
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+VltGraphicsPipelineStats VltGraphicsPipeline::getStats() const
+{
+	VltGraphicsPipelineStats stats;
+	stats.instanceCount = m_instanceCount.load(std::memory_order_relaxed);
+	stats.lookupCount   = m_lookupCount.load(std::memory_order_relaxed);
+	stats.probeCount    = m_probeCount.load(std::memory_order_relaxed);
+	stats.missCount     = m_missCount.load(std::memory_order_relaxed);
+	return stats;
+}
+
+VltGraphicsPipelineInstance* VltGraphicsPipeline::findInstance(const VltGraphicsPipelineStateInfo& state, const VltRenderPass& rp, size_t hash)
 {
 	VltGraphicsPipelineInstance* instance = nullptr;
-	for (auto& pipeInst : m_pipelines)
+	uint64_t                     probes   = 0;
+
+	// Pairs with the release store in insertInstance, so the
+	// instance is fully constructed once the node is visible.
+	InstanceNode* node = m_buckets[hash % BucketCount].load(std::memory_order_acquire);
+	for (; node != nullptr; node = node->next)
 	{
-		if (pipeInst.isCompatible(state, rp))
+		++probes;
+		if (node->instance.isCompatible(state, rp, hash))
 		{
-			instance = &pipeInst;
+			instance = &node->instance;
 			break;
 		}
 	}
+
+	m_probeCount.fetch_add(probes, std::memory_order_relaxed);
 	return instance;
 }
 
 
-VltGraphicsPipelineInstance* VltGraphicsPipeline::createInstance(const VltGraphicsPipelineStateInfo& state, const VltRenderPass& rp)
+VltGraphicsPipelineInstance* VltGraphicsPipeline::createInstance(const VltGraphicsPipelineStateInfo& state, const VltRenderPass& rp, size_t hash)
 {
 	VltGraphicsPipelineInstance* instance = nullptr;
 	do 
+	{
+		VkPipeline pipeline = createPipeline(state, rp);
+		if (pipeline == VK_NULL_HANDLE)
+		{
+			break;
+		}
+
+		instance = insertInstance(pipeline, state, rp, hash);
+		
+	} while (false);
+	return instance;
+}
+
+void VltGraphicsPipeline::createInstanceAsync(const VltGraphicsPipelineStateInfo& state, const VltRenderPass& rp, size_t hash)
+{
+	do
+	{
+		auto pred = [&state, &rp](const std::pair<VltGraphicsPipelineStateInfo, const VltRenderPass*>& item) {
+			return item.first == state && item.second == &rp;
+		};
+
+		if (std::find_if(m_pending.begin(), m_pending.end(), pred) != m_pending.end())
+		{
+			// Already queued by a previous draw.
+			break;
+		}
+
+		m_pending.emplace_back(state, &rp);
+
+		const VltRenderPass* renderPass = &rp;
+		m_pipelineManager->m_workers.submit([this, state, renderPass, hash]()
+		{
+			VkPipeline pipeline = createPipeline(state, *renderPass);
+
+			std::lock_guard<Spinlock> lock(m_mutex);
+
+			// On failure, the next draw will queue it again.
+			if (pipeline != VK_NULL_HANDLE)
+			{
+				insertInstance(pipeline, state, *renderPass, hash);
+			}
+
+			auto pred = [&state, renderPass](const std::pair<VltGraphicsPipelineStateInfo, const VltRenderPass*>& item) {
+				return item.first == state && item.second == renderPass;
+			};
+			m_pending.erase(std::find_if(m_pending.begin(), m_pending.end(), pred));
+		});
+	} while (false);
+}
+
+VltGraphicsPipelineInstance* VltGraphicsPipeline::insertInstance(VkPipeline pipeline, const VltGraphicsPipelineStateInfo& state, const VltRenderPass& rp, size_t hash)
+{
+	// Must be called with m_mutex held, readers
+	// only ever see the head of a chain change.
+	auto& bucket = m_buckets[hash % BucketCount];
+
+	InstanceNode* node = new InstanceNode{
+		VltGraphicsPipelineInstance(pipeline, state, rp, hash),
+		bucket.load(std::memory_order_relaxed)
+	};
+	bucket.store(node, std::memory_order_release);
+
+	m_instanceCount.fetch_add(1, std::memory_order_relaxed);
+	return &node->instance;
+}
+
+VkPipeline VltGraphicsPipeline::createPipeline(const VltGraphicsPipelineStateInfo& state, const VltRenderPass& rp) const
+{
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	do 
 	{
 		auto vsModule = m_shaders.vs->createShaderModule(m_pipelineManager->m_device, m_resSlotMap);
 		auto vsStage  = vsModule.stageInfo(nullptr);
@@ -144,19 +309,18 @@ VltGraphicsPipelineInstance* VltGraphicsPipeline::createInstance(const VltGraphi
 		pipelineInfo.subpass                      = 0;
 		pipelineInfo.basePipelineHandle           = VK_NULL_HANDLE;
 
-		VkDevice   device   = *(m_pipelineManager->m_device);
-		VkPipeline pipeline = VK_NULL_HANDLE;
-		if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+		VkDevice        device = *(m_pipelineManager->m_device);
+		VkPipelineCache cache  = m_pipelineManager->m_cache.handle();
+		if (vkCreateGraphicsPipelines(device, cache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
 		{
 			LOG_ERR("failed to create graphics pipeline!");
 			break;
 		}
 
-		m_pipelines.emplace_back(pipeline, state, rp);
-		instance = &m_pipelines.back();
-		
+		m_pipelineManager->notifyPipelineCreated(m_shaders, state, rp);
+
 	} while (false);
-	return instance;
+	return pipeline;
 }
 
 }  // namespace vlt
\ No newline at end of file
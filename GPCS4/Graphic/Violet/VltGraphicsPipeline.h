@@ -6,6 +6,8 @@
 #include "VltPipelineState.h"
 #include "UtilSync.h"
 
+#include <array>
+#include <atomic>
 #include <vector>
 
 namespace vlt
@@ -37,25 +39,55 @@ struct VltGraphicsPipelineShaders
 };
 
 
+/**
+ * \brief Graphics pipeline statistics
+ *
+ * Lookups count every \c getPipelineHandle call,
+ * probes count the instances compared during lookups.
+ */
+struct VltGraphicsPipelineStats
+{
+	uint32_t instanceCount = 0;
+	uint64_t lookupCount   = 0;
+	uint64_t probeCount    = 0;
+	uint64_t missCount     = 0;  // Lookups which found no instance
+};
+
+
 class VltGraphicsPipelineInstance
 {
 public:
 	VltGraphicsPipelineInstance(
 		VkPipeline                          pipeline,
 		const VltGraphicsPipelineStateInfo& state,
-		const VltRenderPass&                rp);
+		const VltRenderPass&                rp,
+		size_t                              hash);
 	~VltGraphicsPipelineInstance();
 
 	VkPipeline pipeline();
 
+	/**
+	 * \brief Instance lookup key
+	 *
+	 * Combines the state hash with the render pass.
+	 * \param [in] state Pipeline state vector
+	 * \param [in] rp Render pass
+	 * \returns Hash of the state and render pass
+	 */
+	static size_t hash(
+		const VltGraphicsPipelineStateInfo& state,
+		const VltRenderPass&                rp);
+
 	bool isCompatible(
 		const VltGraphicsPipelineStateInfo& state,
-		const VltRenderPass&                rp) const;
+		const VltRenderPass&                rp,
+		size_t                              hash) const;
 
 private:
 	VkPipeline                   m_pipeline;
 	VltGraphicsPipelineStateInfo m_state;
 	const VltRenderPass*         m_renderPass;
+	size_t                       m_hash;
 };
 
 ///
@@ -68,19 +100,78 @@ public:
 		const VltGraphicsPipelineShaders& shaders);
 	~VltGraphicsPipeline();
 
+	/**
+	 * \brief Pipeline handle
+	 *
+	 * Compiles the pipeline instance if it doesn't exist yet.
+	 * With GPCS4_SKIP_DRAW_UNTIL_READY, compilation happens
+	 * in the background and \c VK_NULL_HANDLE is returned
+	 * until it is done.
+	 * \param [in] state Pipeline state vector
+	 * \param [in] rp Render pass
+	 * \returns Pipeline handle
+	 */
 	VkPipeline getPipelineHandle(
 		const VltGraphicsPipelineStateInfo& state,
 		const VltRenderPass&                rp);
 
 	VltPipelineLayout* getLayout() const;
 
+	/**
+	 * \brief Compiles a pipeline instance
+	 *
+	 * Used to create pipelines ahead of time. Unlike
+	 * \c getPipelineHandle, the pipeline is always
+	 * compiled on the calling thread, and without
+	 * holding the lock.
+	 * \param [in] state Pipeline state vector
+	 * \param [in] rp Render pass
+	 * \returns \c true if the instance exists
+	 */
+	bool compileInstance(
+		const VltGraphicsPipelineStateInfo& state,
+		const VltRenderPass&                rp);
+
+	/**
+	 * \brief Queries instance lookup statistics
+	 * \returns Instance count and lookup counters
+	 */
+	VltGraphicsPipelineStats getStats() const;
+
 private:
+	// Instances are never removed, so a chain can be
+	// walked without the lock while others are added.
+	struct InstanceNode
+	{
+		VltGraphicsPipelineInstance instance;
+		InstanceNode*               next;
+	};
+
+	static constexpr uint32_t BucketCount = 64;
+
 	VltGraphicsPipelineInstance* findInstance(
 		const VltGraphicsPipelineStateInfo& state,
-		const VltRenderPass&                rp);
+		const VltRenderPass&                rp,
+		size_t                              hash);
 	VltGraphicsPipelineInstance* createInstance(
 		const VltGraphicsPipelineStateInfo& state,
-		const VltRenderPass&                rp);
+		const VltRenderPass&                rp,
+		size_t                              hash);
+
+	void createInstanceAsync(
+		const VltGraphicsPipelineStateInfo& state,
+		const VltRenderPass&                rp,
+		size_t                              hash);
+
+	VltGraphicsPipelineInstance* insertInstance(
+		VkPipeline                          pipeline,
+		const VltGraphicsPipelineStateInfo& state,
+		const VltRenderPass&                rp,
+		size_t                              hash);
+
+	VkPipeline createPipeline(
+		const VltGraphicsPipelineStateInfo& state,
+		const VltRenderPass&                rp) const;
 
 private:
 	VltPipelineManager*        m_pipelineManager;
@@ -89,8 +180,17 @@ private:
 	VltDescriptorSlotMap m_resSlotMap;
 	VltPipelineLayout*   m_layout;
 
-	Spinlock                                 m_mutex;
-	std::vector<VltGraphicsPipelineInstance> m_pipelines;
+	// Guards insertion and m_pending, lookups don't take it.
+	Spinlock                                             m_mutex;
+	std::array<std::atomic<InstanceNode*>, BucketCount> m_buckets = {};
+
+	std::atomic<uint32_t> m_instanceCount = { 0 };
+	std::atomic<uint64_t> m_lookupCount   = { 0 };
+	std::atomic<uint64_t> m_probeCount    = { 0 };
+	std::atomic<uint64_t> m_missCount     = { 0 };
+
+	// Instances being compiled by the pipeline manager workers
+	std::vector<std::pair<VltGraphicsPipelineStateInfo, const VltRenderPass*>> m_pending;
 };
 
 
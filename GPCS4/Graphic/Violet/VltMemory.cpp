@@ -2,6 +2,8 @@
 #include "VltPhysicalDevice.h"
 #include "VltDevice.h"
 
+#include <algorithm>
+
 LOG_CHANNEL(Graphic.Violet.VltMemory);
 
 namespace vlt
@@ -76,17 +78,15 @@ VltMemoryChunk::VltMemoryChunk(
 	VltMemoryAllocator*  alloc,
 	VltMemoryType*       type,
 	VltDeviceMemory      memory)
-	: m_alloc(alloc), m_type(type), m_memory(memory) 
+	: m_alloc(alloc), m_type(type), m_memory(memory), m_allocator(memory.memSize)
 {
-	// Mark the entire chunk as free
-	m_freeList.push_back(FreeSlice{ 0, memory.memSize });
 }
 
 
 VltMemoryChunk::~VltMemoryChunk() 
 {
-	// This call is technically not thread-safe, but it
-	// doesn't need to be since we don't free chunks
+	// Chunks are only freed by the allocator, which
+	// holds its lock while doing so.
 	m_alloc->freeDeviceMemory(m_type, m_memory);
 }
 
@@ -107,58 +107,18 @@ VltMemory VltMemoryChunk::alloc(
 			break;
 		}
 
-		// If the chunk is full, break
-		if (m_freeList.size() == 0)
-		{
-			break;
-		}
-
-		// Select the slice to allocate from in a worst-fit
-		// manner. This may help keep fragmentation low.
-		auto bestSlice = m_freeList.begin();
-
-		for (auto slice = m_freeList.begin(); slice != m_freeList.end(); slice++)
-		{
-			if (slice->length == size)
-			{
-				bestSlice = slice;
-				break;
-			}
-			else if (slice->length > bestSlice->length)
-			{
-				bestSlice = slice;
-			}
-		}
-
-		// We need to align the allocation to the requested alignment
-		const VkDeviceSize sliceStart = bestSlice->offset;
-		const VkDeviceSize sliceEnd = bestSlice->offset + bestSlice->length;
-
-		const VkDeviceSize allocStart = ::util::align(sliceStart, align);
-		const VkDeviceSize allocEnd   = ::util::align(allocStart + size, align);
-
-		if (allocEnd > sliceEnd)
+		const VkDeviceSize allocStart = m_allocator.alloc(size, align);
+		if (allocStart == VltTlsfAllocator::InvalidOffset)
 		{
 			break;
 		}
 
-		// We can use this slice, but we'll have to add
-		// the unused parts of it back to the free list.
-		m_freeList.erase(bestSlice);
-
-		if (allocStart != sliceStart)
-		{
-			m_freeList.push_back({ sliceStart, allocStart - sliceStart });
-		}
-
-		if (allocEnd != sliceEnd)
-		{
-			m_freeList.push_back({ allocEnd, sliceEnd - allocEnd });
-		}
+		// Sizes are rounded up to the allocator's granularity.
+		const VkDeviceSize allocLength = m_allocator.allocSize(allocStart);
 
 		// Create the memory object with the aligned slice
 		memory = VltMemory(m_alloc, this, m_type,
-			m_memory.memHandle, allocStart, allocEnd - allocStart,
+			m_memory.memHandle, allocStart, allocLength,
 			reinterpret_cast<char*>(m_memory.memPointer) + allocStart);
 	} while (false);
 	return memory;
@@ -169,31 +129,21 @@ void VltMemoryChunk::free(
 	VkDeviceSize  offset,
 	VkDeviceSize  length) 
 {
-	// Remove adjacent entries from the free list and then add
-	// a new slice that covers all those entries. Without doing
-	// so, the slice could not be reused for larger allocations.
-	auto curr = m_freeList.begin();
+	// Adjacent free ranges are merged by the allocator.
+	bool freed = m_allocator.free(offset);
+	LOG_ASSERT(freed, "freeing unallocated chunk range at %llu.", offset);
+}
 
-	while (curr != m_freeList.end()) 
-	{
-		if (curr->offset == offset + length) 
-		{
-			length += curr->length;
-			curr = m_freeList.erase(curr);
-		}
-		else if (curr->offset + curr->length == offset)
-		{
-			offset -= curr->length;
-			length += curr->length;
-			curr = m_freeList.erase(curr);
-		}
-		else 
-		{
-			curr++;
-		}
-	}
 
-	m_freeList.push_back({ offset, length });
+VltTlsfStats VltMemoryChunk::getStats() const
+{
+	return m_allocator.getStats();
+}
+
+
+bool VltMemoryChunk::isEmpty() const
+{
+	return m_allocator.isEmpty();
 }
 
 
@@ -221,7 +171,10 @@ VltMemoryAllocator::VltMemoryAllocator(VltDevice* device):
 
 VltMemoryAllocator::~VltMemoryAllocator() 
 {
-
+	auto stats = getChunkStats();
+	LOG_DEBUG("memory chunks: %llu of %llu bytes used, %u free blocks, largest %llu bytes, %.1f%% fragmented.",
+			  stats.usedSize, stats.capacity, stats.freeBlockCount,
+			  stats.largestFreeBlock, stats.fragmentation() * 100.0);
 }
 
 
@@ -303,6 +256,63 @@ VltMemoryStats VltMemoryAllocator::getMemoryStats()
 }
 
 
+VltTlsfStats VltMemoryAllocator::getChunkStats()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	VltTlsfStats totalStats;
+
+	for (size_t i = 0; i < m_memProps.memoryTypeCount; i++)
+	{
+		for (const auto& chunk : m_memTypes[i].chunks)
+		{
+			auto stats = chunk->getStats();
+			totalStats.capacity += stats.capacity;
+			totalStats.usedSize += stats.usedSize;
+			totalStats.freeSize += stats.freeSize;
+			totalStats.allocCount += stats.allocCount;
+			totalStats.freeBlockCount += stats.freeBlockCount;
+			totalStats.largestFreeBlock = std::max(totalStats.largestFreeBlock, stats.largestFreeBlock);
+		}
+	}
+
+	return totalStats;
+}
+
+
+VltMemoryBudget VltMemoryAllocator::getMemoryBudget()
+{
+	VkPhysicalDeviceMemoryBudgetPropertiesEXT driverBudget;
+	bool fromDriver = m_device->physicalDevice()->queryMemoryBudget(driverBudget);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	VltMemoryBudget budget;
+	budget.fromDriver = fromDriver;
+	budget.heapCount  = m_memProps.memoryHeapCount;
+
+	for (uint32_t i = 0; i < m_memProps.memoryHeapCount; i++)
+	{
+		auto& heap     = budget.heaps[i];
+		heap.heapFlags = m_memHeaps[i].properties.flags;
+		heap.stats     = m_memHeaps[i].stats;
+
+		if (fromDriver)
+		{
+			heap.memoryBudget = driverBudget.heapBudget[i];
+			heap.memoryUsage  = driverBudget.heapUsage[i];
+		}
+		else
+		{
+			heap.memoryBudget = m_memHeaps[i].properties.size;
+			heap.memoryUsage  = m_memHeaps[i].stats.memoryAllocated;
+		}
+	}
+
+	return budget;
+}
+
+
 VltMemory VltMemoryAllocator::tryAlloc(
 	const VkMemoryRequirements*             req,
 	const VkMemoryDedicatedAllocateInfoKHR* dedAllocInfo,
@@ -474,6 +484,22 @@ void VltMemoryAllocator::freeChunkMemory(
 	VkDeviceSize          length) 
 {
 	chunk->free(offset, length);
+
+	// Keep one empty chunk per type around, so allocations
+	// near a chunk boundary don't allocate device memory over
+	// and over, and give the others back once evicted
+	// resources have been destroyed.
+	if (chunk->isEmpty())
+	{
+		auto&  chunks     = type->chunks;
+		size_t emptyCount = std::count_if(chunks.begin(), chunks.end(),
+										  [](const RcPtr<VltMemoryChunk>& c) { return c->isEmpty(); });
+		if (emptyCount > 1)
+		{
+			chunks.erase(std::find_if(chunks.begin(), chunks.end(),
+									  [chunk](const RcPtr<VltMemoryChunk>& c) { return c.ptr() == chunk; }));
+		}
+	}
 }
 
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "VltCommon.h"
+#include "VltTlsfAllocator.h"
 
 #include <array>
 #include <vector>
@@ -26,6 +27,36 @@ struct VltMemoryStats
 };
 
 
+/**
+ * \brief Memory heap budget
+ *
+ * Budget and usage of a heap as reported by the
+ * driver through VK_EXT_memory_budget. Without it,
+ * the budget is the heap size and the usage is
+ * what this allocator allocated on the heap.
+ */
+struct VltMemoryHeapBudget
+{
+	VkMemoryHeapFlags heapFlags    = 0;
+	VkDeviceSize      memoryBudget = 0;
+	VkDeviceSize      memoryUsage  = 0;
+	VltMemoryStats    stats;
+};
+
+
+/**
+ * \brief Memory budget
+ *
+ * Budget of all heaps of the device.
+ */
+struct VltMemoryBudget
+{
+	bool                                                 fromDriver = false;
+	uint32_t                                             heapCount  = 0;
+	std::array<VltMemoryHeapBudget, VK_MAX_MEMORY_HEAPS> heaps;
+};
+
+
 /**
  * \brief Device memory object
  *
@@ -189,7 +220,10 @@ private:
  * \brief Memory chunk
  *
  * A single chunk of memory that provides a
- * sub-allocator. This is not thread-safe.
+ * sub-allocator. Ranges are managed by a TLSF
+ * allocator, so allocating and freeing don't
+ * depend on the number of live allocations.
+ * This is not thread-safe.
  */
 class VltMemoryChunk : public RcObject 
 {
@@ -233,19 +267,25 @@ public:
 		VkDeviceSize  offset,
 		VkDeviceSize  length);
 
-private:
+	/**
+	 * \brief Queries sub-allocator statistics
+	 * \returns Used and free space of the chunk
+	 */
+	VltTlsfStats getStats() const;
 
-	struct FreeSlice 
-	{
-		VkDeviceSize offset;
-		VkDeviceSize length;
-	};
+	/**
+	 * \brief Checks whether the chunk is empty
+	 * \returns \c true if no memory is allocated from it
+	 */
+	bool isEmpty() const;
+
+private:
 
 	VltMemoryAllocator*  m_alloc;
 	VltMemoryType*       m_type;
 	VltDeviceMemory      m_memory;
 
-	std::vector<FreeSlice> m_freeList;
+	VltTlsfAllocator     m_allocator;
 
 };
 
@@ -304,6 +344,24 @@ public:
 	 */
 	VltMemoryStats getMemoryStats();
 
+	/**
+	 * \brief Queries chunk statistics
+	 *
+	 * Sums up the sub-allocators of all chunks, the
+	 * largest free block is the largest of any chunk.
+	 * \returns Used and free space of all chunks
+	 */
+	VltTlsfStats getChunkStats();
+
+	/**
+	 * \brief Queries the memory budget
+	 *
+	 * Asks the driver each time, usage changes
+	 * with every allocation of the process.
+	 * \returns Budget and usage of each heap
+	 */
+	VltMemoryBudget getMemoryBudget();
+
 private:
 
 	VltDevice*							   m_device;
@@ -73,6 +73,7 @@ VltPhysicalDeviceQueueFamilies VltPhysicalDevice::findQueueFamilies()
 void VltPhysicalDevice::queryExtensions()
 {
 	m_deviceExtensions = VltNameSet::enumDeviceExtensions(m_device);
+	m_hasMemoryBudget  = m_deviceExtensions.supports(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) != 0;
 }
 
 void VltPhysicalDevice::queryDeviceInfo()
@@ -223,6 +224,29 @@ VkPhysicalDeviceMemoryProperties VltPhysicalDevice::memoryProperties() const
 	return memoryProperties;
 }
 
+bool VltPhysicalDevice::queryMemoryBudget(VkPhysicalDeviceMemoryBudgetPropertiesEXT& budget) const
+{
+	bool ret = false;
+	do
+	{
+		if (!m_hasMemoryBudget)
+		{
+			break;
+		}
+
+		budget       = {};
+		budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+		VkPhysicalDeviceMemoryProperties2 memoryProperties = {};
+		memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+		memoryProperties.pNext = &budget;
+		vkGetPhysicalDeviceMemoryProperties2(m_device, &memoryProperties);
+
+		ret = true;
+	} while (false);
+	return ret;
+}
+
 bool VltPhysicalDevice::checkFeatureSupport(const VltDeviceFeatures& required) const
 {
 	return (m_deviceFeatures.core.features.robustBufferAccess
@@ -54,6 +54,8 @@ public:
 
 	VkPhysicalDeviceMemoryProperties memoryProperties() const;
 
+	bool queryMemoryBudget(VkPhysicalDeviceMemoryBudgetPropertiesEXT& budget) const;
+
 	bool checkFeatureSupport(const VltDeviceFeatures& required) const;
 
 	RcPtr<VltDevice> createLogicalDevice(const VltDeviceFeatures& features);
@@ -78,6 +80,8 @@ private:
 	VltNameSet         m_deviceExtensions;
 	VltDeviceInfo      m_deviceInfo;
 	VltDeviceFeatures  m_deviceFeatures;
+
+	bool m_hasMemoryBudget = false;
 };
 
 } // namespace vlt
@@ -0,0 +1,200 @@
+#include "VltPipelineCache.h"
+#include "VltDevice.h"
+#include "VltPhysicalDevice.h"
+
+#include "Platform/UtilFile.h"
+
+#include <cstring>
+#include <filesystem>
+
+LOG_CHANNEL(Graphic.Violet.VltPipelineCache);
+
+namespace vlt
+{;
+
+// Layout of VK_PIPELINE_CACHE_HEADER_VERSION_ONE,
+// written by the driver in front of the cache data.
+struct VltPipelineCacheHeader
+{
+	uint32_t headerSize;
+	uint32_t headerVersion;
+	uint32_t vendorId;
+	uint32_t deviceId;
+	uint8_t  uuid[VK_UUID_SIZE];
+};
+
+static std::mutex  g_pathMutex;
+static std::string g_defaultPath;
+
+VltPipelineCache::VltPipelineCache(const VltDevice* device) :
+	m_device(device),
+	m_path(getDefaultPath())
+{
+	std::vector<uint8_t> data;
+	if (!loadData(data))
+	{
+		data.clear();
+	}
+
+	VkPipelineCacheCreateInfo info = {};
+	info.sType                     = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	info.initialDataSize           = data.size();
+	info.pInitialData              = data.data();
+
+	if (vkCreatePipelineCache(*m_device, &info, nullptr, &m_cache) != VK_SUCCESS)
+	{
+		// Pipelines are still created, just without a cache.
+		LOG_ERR("create pipeline cache failed.");
+		m_cache = VK_NULL_HANDLE;
+	}
+}
+
+VltPipelineCache::~VltPipelineCache()
+{
+}
+
+void VltPipelineCache::setDefaultPath(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(g_pathMutex);
+	g_defaultPath = path;
+}
+
+std::string VltPipelineCache::getDefaultPath()
+{
+	std::lock_guard<std::mutex> lock(g_pathMutex);
+	return g_defaultPath;
+}
+
+bool VltPipelineCache::notifyPipelineCreated()
+{
+	return !m_path.empty() &&
+		   (m_newPipelineCount.fetch_add(1) + 1) % StoreInterval == 0;
+}
+
+bool VltPipelineCache::store()
+{
+	std::lock_guard<std::mutex> lock(m_storeMutex);
+
+	bool ret = false;
+	do
+	{
+		if (m_cache == VK_NULL_HANDLE || m_path.empty())
+		{
+			break;
+		}
+
+		size_t size = 0;
+		if (vkGetPipelineCacheData(*m_device, m_cache, &size, nullptr) != VK_SUCCESS)
+		{
+			break;
+		}
+
+		std::vector<uint8_t> data(size);
+		if (vkGetPipelineCacheData(*m_device, m_cache, &size, data.data()) != VK_SUCCESS)
+		{
+			break;
+		}
+		data.resize(size);
+
+		// Write aside and swap, so a crash during
+		// the write can't corrupt the old file.
+		std::string tempPath = m_path + ".tmp";
+		if (!UtilFile::StoreFile(tempPath, data))
+		{
+			LOG_ERR("write pipeline cache %s failed.", tempPath.c_str());
+			break;
+		}
+
+		std::error_code ec;
+		std::filesystem::rename(tempPath, m_path, ec);
+		if (ec)
+		{
+			LOG_ERR("replace pipeline cache %s failed.", m_path.c_str());
+			break;
+		}
+
+		LOG_DEBUG("pipeline cache %s stored, %zu bytes.", m_path.c_str(), size);
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+void VltPipelineCache::destroy()
+{
+	do
+	{
+		if (m_cache == VK_NULL_HANDLE)
+		{
+			break;
+		}
+
+		store();
+
+		vkDestroyPipelineCache(*m_device, m_cache, nullptr);
+		m_cache = VK_NULL_HANDLE;
+	} while (false);
+}
+
+bool VltPipelineCache::loadData(std::vector<uint8_t>& data)
+{
+	bool ret = false;
+	do
+	{
+		if (m_path.empty())
+		{
+			break;
+		}
+
+		if (!UtilFile::LoadFile(m_path, data) || data.empty())
+		{
+			LOG_DEBUG("pipeline cache %s not found, starting empty.", m_path.c_str());
+			break;
+		}
+
+		if (!checkHeader(data))
+		{
+			LOG_WARN("pipeline cache %s was written by another device or driver, discarded.",
+					 m_path.c_str());
+			break;
+		}
+
+		LOG_DEBUG("pipeline cache %s loaded, %zu bytes.", m_path.c_str(), data.size());
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+bool VltPipelineCache::checkHeader(const std::vector<uint8_t>& data) const
+{
+	bool ret = false;
+	do
+	{
+		VltPipelineCacheHeader header;
+		if (data.size() < sizeof(header))
+		{
+			break;
+		}
+
+		std::memcpy(&header, data.data(), sizeof(header));
+
+		if (header.headerSize < sizeof(header) ||
+			header.headerSize > data.size() ||
+			header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+		{
+			break;
+		}
+
+		const auto& properties = m_device->physicalDevice()->deviceProperties();
+		if (header.vendorId != properties.vendorID ||
+			header.deviceId != properties.deviceID ||
+			std::memcmp(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		{
+			break;
+		}
+
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+}  // namespace vlt
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "VltCommon.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace vlt
+{;
+
+class VltDevice;
+
+/**
+ * \brief Persistent pipeline cache
+ *
+ * Owns the \c VkPipelineCache every pipeline is created
+ * with. The cache data is loaded from disk when the device
+ * is created and written back when the device is destroyed,
+ * and every \c StoreInterval new pipelines in between, since
+ * the emulator is usually closed without a clean shutdown.
+ *
+ * Data written by another driver or GPU is discarded,
+ * the Vulkan cache header is checked against the device's
+ * vendor ID, device ID and pipeline cache UUID before the
+ * data is handed to the driver.
+ */
+class VltPipelineCache
+{
+	const uint32_t StoreInterval = 32;
+
+public:
+	VltPipelineCache(const VltDevice* device);
+	~VltPipelineCache();
+
+	/**
+	 * \brief Sets the cache file
+	 *
+	 * Must be called before the device is created.
+	 * An empty path disables the on-disk cache.
+	 * \param [in] path Cache file path
+	 */
+	static void setDefaultPath(const std::string& path);
+
+	/**
+	 * \brief Cache file path
+	 * \returns Path set with \c setDefaultPath
+	 */
+	static std::string getDefaultPath();
+
+	/**
+	 * \brief Pipeline cache handle
+	 * \returns Pipeline cache handle
+	 */
+	VkPipelineCache handle() const
+	{
+		return m_cache;
+	}
+
+	/**
+	 * \brief Counts a newly created pipeline
+	 *
+	 * \returns \c true if the cache is due to be stored
+	 */
+	bool notifyPipelineCreated();
+
+	/**
+	 * \brief Writes the cache data to disk
+	 *
+	 * The file is replaced atomically, an interrupted
+	 * write leaves the previous cache file intact.
+	 * \returns \c true on success
+	 */
+	bool store();
+
+	/**
+	 * \brief Stores and destroys the cache
+	 *
+	 * Must be called before the device is destroyed,
+	 * with no pipeline being created concurrently.
+	 */
+	void destroy();
+
+private:
+	bool loadData(std::vector<uint8_t>& data);
+
+	bool checkHeader(const std::vector<uint8_t>& data) const;
+
+private:
+	const VltDevice* m_device;
+	VkPipelineCache  m_cache = VK_NULL_HANDLE;
+	std::string      m_path;
+
+	std::mutex            m_storeMutex;
+	std::atomic<uint32_t> m_newPipelineCount = { 0 };
+};
+
+}  // namespace vlt
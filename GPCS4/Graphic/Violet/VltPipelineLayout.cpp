@@ -1,5 +1,6 @@
 #include "VltPipelineLayout.h"
 #include "VltDevice.h"
+#include "VltDescriptor.h"
 
 LOG_CHANNEL(Graphic.Violet.VltPipelineLayout);
 
@@ -112,11 +113,57 @@ VltPipelineLayout::VltPipelineLayout(
 		vkDestroyDescriptorSetLayout(*m_device, m_descriptorSetLayout, nullptr);
 		LOG_ERR("Failed to create pipeline layout");
 	}
+
+	// Create descriptor update template, the context fills
+	// descriptors in binding order into a packed array.
+	// Types the context doesn't fill yet are left out,
+	// like it skips them when writing descriptors one by one.
+	std::vector<VkDescriptorUpdateTemplateEntry> templateEntries;
+	for (uint32_t i = 0; i < bindingCount; i++)
+	{
+		VkDescriptorType type = bindingInfos[i].resSlot.type;
+		if (type != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER &&
+			type != VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE &&
+			type != VK_DESCRIPTOR_TYPE_SAMPLER)
+		{
+			continue;
+		}
+
+		VkDescriptorUpdateTemplateEntry entry;
+		entry.dstBinding      = i;
+		entry.dstArrayElement = 0;
+		entry.descriptorCount = 1;
+		entry.descriptorType  = type;
+		entry.offset          = sizeof(VltDescriptorInfo) * i;
+		entry.stride          = sizeof(VltDescriptorInfo);
+		templateEntries.push_back(entry);
+	}
+
+	if (!templateEntries.empty())
+	{
+		VkDescriptorUpdateTemplateCreateInfo templateInfo;
+		templateInfo.sType                      = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+		templateInfo.pNext                      = nullptr;
+		templateInfo.flags                      = 0;
+		templateInfo.descriptorUpdateEntryCount = templateEntries.size();
+		templateInfo.pDescriptorUpdateEntries   = templateEntries.data();
+		templateInfo.templateType               = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+		templateInfo.descriptorSetLayout        = m_descriptorSetLayout;
+		templateInfo.pipelineBindPoint          = pipelineBindPoint;
+		templateInfo.pipelineLayout             = m_pipelineLayout;
+		templateInfo.set                        = 0;
+
+		if (vkCreateDescriptorUpdateTemplate(*m_device, &templateInfo, nullptr, &m_descriptorTemplate) != VK_SUCCESS)
+		{
+			LOG_ERR("Failed to create descriptor update template");
+		}
+	}
 }
 
 
 VltPipelineLayout::~VltPipelineLayout() 
 {
+	vkDestroyDescriptorUpdateTemplate(*m_device, m_descriptorTemplate, nullptr);
 	vkDestroyPipelineLayout(*m_device, m_pipelineLayout, nullptr);
 	vkDestroyDescriptorSetLayout(*m_device, m_descriptorSetLayout, nullptr);
 }
@@ -113,6 +113,18 @@ public:
 		return m_pipelineLayout;
 	}
 
+	/**
+	 * \brief Descriptor update template
+	 *
+	 * Reads one \c VltDescriptorInfo per binding, in
+	 * binding order. Null if there are no bindings.
+	 * \returns Descriptor update template handle
+	 */
+	VkDescriptorUpdateTemplate descriptorTemplate() const
+	{
+		return m_descriptorTemplate;
+	}
+
 
 private:
 
@@ -120,6 +132,7 @@ private:
 
 	VkDescriptorSetLayout           m_descriptorSetLayout = VK_NULL_HANDLE;
 	VkPipelineLayout                m_pipelineLayout = VK_NULL_HANDLE;
+	VkDescriptorUpdateTemplate      m_descriptorTemplate = VK_NULL_HANDLE;
 
 	std::vector<VltDescriptorSlot>  m_bindingSlots;
 };
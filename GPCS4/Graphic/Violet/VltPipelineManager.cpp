@@ -1,16 +1,36 @@
 #include "VltPipelineManager.h"
+#include "VltDevice.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+LOG_CHANNEL(Graphic.Violet.VltPipelineManager);
 
 namespace vlt
 {;
 
+static std::atomic<int64_t> g_prewarmBudget = { 0 };
+
 VltPipelineManager::VltPipelineManager(VltDevice* device) :
-	m_device(device)
+	m_device(device),
+	m_cache(device),
+	m_workers(VltWorkerPool::defaultWorkerCount())
 {
-
+	auto path = VltPipelineCache::getDefaultPath();
+	if (!path.empty() && !m_stateLog.open(path + ".states"))
+	{
+		// Not fatal, pipelines just won't be logged.
+		LOG_WARN("pipeline state log for %s not available.", path.c_str());
+	}
 }
 
 VltPipelineManager::~VltPipelineManager()
 {
+	auto stats = getStats();
+	LOG_DEBUG("graphics pipelines %d instances %d (max %d per pipeline) lookups %llu probes %llu misses %llu",
+			  stats.pipelineCount, stats.instanceCount, stats.maxInstanceCount,
+			  stats.lookupCount, stats.probeCount, stats.missCount);
 }
 
 
@@ -35,4 +55,153 @@ VltGraphicsPipeline* VltPipelineManager::getGraphicsPipeline(const VltGraphicsPi
 	return pipeline;
 }
 
+VltWorkerPoolStats VltPipelineManager::getWorkerStats()
+{
+	return m_workers.getStats();
+}
+
+void VltPipelineManager::shutdown()
+{
+	m_workers.stop();
+	m_cache.destroy();
+}
+
+void VltPipelineManager::notifyPipelineCreated(
+	const VltGraphicsPipelineShaders&   shaders,
+	const VltGraphicsPipelineStateInfo& state,
+	const VltRenderPass&                rp)
+{
+	m_stateLog.record(shaders, state, rp);
+
+	if (m_cache.notifyPipelineCreated())
+	{
+		// Off the calling thread, the cache
+		// data can be several megabytes.
+		m_workers.submit([this]() { m_cache.store(); });
+	}
+}
+
+VltPipelinePrewarmStats VltPipelineManager::prewarm(
+	const std::function<RcPtr<VltShader>(uint64_t)>& findShader,
+	std::chrono::milliseconds                        budget)
+{
+	using Clock = std::chrono::steady_clock;
+
+	auto startTime = Clock::now();
+	auto deadline  = startTime + budget;
+	auto entries   = m_stateLog.entries();
+
+	VltPipelinePrewarmStats stats;
+	stats.entryCount = uint32_t(entries.size());
+
+	// The game isn't running yet, so all cores can be used.
+	VltWorkerPool workers(std::max(1u, std::thread::hardware_concurrency()));
+
+	std::atomic<uint32_t> doneCount    = { 0 };
+	std::atomic<uint32_t> failedCount  = { 0 };
+	std::atomic<uint32_t> skippedCount = { 0 };
+
+	std::vector<std::shared_future<void>> jobs;
+	jobs.reserve(entries.size());
+
+	for (const auto& entry : entries)
+	{
+		VltGraphicsPipelineShaders shaders;
+		shaders.vs = findShader(entry.vsKey);
+		shaders.fs = findShader(entry.fsKey);
+		if (shaders.vs == nullptr || shaders.fs == nullptr)
+		{
+			++stats.missingCount;
+			continue;
+		}
+
+		// Pipelines and render passes are looked up here,
+		// neither pool can be used from the workers.
+		auto pipeline   = getGraphicsPipeline(shaders);
+		auto renderPass = m_device->m_resObjects.renderPassPool().getRenderPass(entry.rpFormat);
+		auto state      = entry.state;
+
+		jobs.push_back(workers.submit([pipeline, renderPass, state, deadline,
+									   &doneCount, &failedCount, &skippedCount]()
+		{
+			do
+			{
+				if (Clock::now() >= deadline)
+				{
+					++skippedCount;
+					break;
+				}
+
+				if (!pipeline->compileInstance(state, *renderPass))
+				{
+					++failedCount;
+				}
+			} while (false);
+
+			++doneCount;
+		}));
+	}
+
+	// Progress is reported in steps of about a tenth.
+	uint32_t reportStep    = std::max(1u, uint32_t(jobs.size()) / 10);
+	uint32_t reportedCount = 0;
+	for (const auto& job : jobs)
+	{
+		if (job.wait_until(deadline) != std::future_status::ready)
+		{
+			LOG_WARN("pipeline prewarm: time budget of %lld ms used up.", budget.count());
+			break;
+		}
+
+		uint32_t count = doneCount.load();
+		if (count - reportedCount >= reportStep)
+		{
+			LOG_DEBUG("pipeline prewarm: %u of %zu compiled.", count, jobs.size());
+			reportedCount = count;
+		}
+	}
+
+	// Jobs still queued see the deadline
+	// has passed and return right away.
+	workers.stop();
+
+	stats.failedCount   = failedCount.load();
+	stats.skippedCount  = skippedCount.load();
+	stats.compiledCount = doneCount.load() - stats.failedCount - stats.skippedCount;
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - startTime);
+	LOG_DEBUG("pipeline prewarm: %u of %u compiled in %lld ms, %u missing shaders, %u failed, %u over budget.",
+			  stats.compiledCount, stats.entryCount, elapsed.count(),
+			  stats.missingCount, stats.failedCount, stats.skippedCount);
+
+	return stats;
+}
+
+void VltPipelineManager::setPrewarmBudget(std::chrono::milliseconds budget)
+{
+	g_prewarmBudget.store(budget.count());
+}
+
+std::chrono::milliseconds VltPipelineManager::getPrewarmBudget()
+{
+	return std::chrono::milliseconds(g_prewarmBudget.load());
+}
+
+VltPipelineManagerStats VltPipelineManager::getStats()
+{
+	VltPipelineManagerStats stats;
+	for (const auto& pair : m_graphicsPipelines)
+	{
+		auto pipeStats = pair.second.getStats();
+
+		++stats.pipelineCount;
+		stats.instanceCount += pipeStats.instanceCount;
+		stats.maxInstanceCount = std::max(stats.maxInstanceCount, pipeStats.instanceCount);
+		stats.lookupCount += pipeStats.lookupCount;
+		stats.probeCount += pipeStats.probeCount;
+		stats.missCount += pipeStats.missCount;
+	}
+	return stats;
+}
+
 }  // namespace vlt
\ No newline at end of file
@@ -2,12 +2,45 @@
 #include "VltCommon.h"
 #include "VltGraphicsPipeline.h"
 #include "VltHash.h"
+#include "VltPipelineCache.h"
+#include "VltPipelineStateLog.h"
+#include "VltWorkerPool.h"
 
+#include <chrono>
+#include <functional>
 #include <unordered_map>
 
 namespace vlt
 {;
 
+/**
+ * \brief Pipeline manager statistics
+ *
+ * Instance lookup counters summed
+ * over all graphics pipelines.
+ */
+struct VltPipelineManagerStats
+{
+	uint32_t pipelineCount    = 0;
+	uint32_t instanceCount    = 0;
+	uint32_t maxInstanceCount = 0;  // Instances of the most varied pipeline
+	uint64_t lookupCount      = 0;
+	uint64_t probeCount       = 0;
+	uint64_t missCount        = 0;
+};
+
+/**
+ * \brief Pipeline prewarm statistics
+ */
+struct VltPipelinePrewarmStats
+{
+	uint32_t entryCount    = 0;
+	uint32_t compiledCount = 0;
+	uint32_t missingCount  = 0;  // Entries whose shaders are not available
+	uint32_t failedCount   = 0;
+	uint32_t skippedCount  = 0;  // Entries not compiled within the time budget
+};
+
 class VltPipelineManager
 {
 	friend class VltGraphicsPipeline;
@@ -17,10 +50,75 @@ public:
 
 	VltGraphicsPipeline* getGraphicsPipeline(const VltGraphicsPipelineShaders& shaders);
 
+	/**
+	 * \brief Queries pipeline compile worker statistics
+	 * \returns Queue depth and latency counters
+	 */
+	VltWorkerPoolStats getWorkerStats();
+
+	/**
+	 * \brief Queries pipeline instance statistics
+	 * \returns Instance and lookup counters
+	 */
+	VltPipelineManagerStats getStats();
+
+	/**
+	 * \brief Stops pipeline compilation
+	 *
+	 * Joins the compile workers and writes the pipeline
+	 * cache back to disk. Must be called before the
+	 * Vulkan device is destroyed.
+	 */
+	void shutdown();
+
+	/**
+	 * \brief Creates logged pipelines ahead of time
+	 *
+	 * Compiles the pipelines recorded in the pipeline state
+	 * log on a pool using all cores, before the game starts
+	 * drawing. Jobs which start after the time budget is
+	 * used up return without compiling their pipeline.
+	 * \param [in] findShader Looks up a shader by its key,
+	 *        returns \c nullptr if it isn't available
+	 * \param [in] budget Time budget
+	 * \returns Prewarm statistics
+	 */
+	VltPipelinePrewarmStats prewarm(
+		const std::function<RcPtr<VltShader>(uint64_t)>& findShader,
+		std::chrono::milliseconds                        budget);
+
+	/**
+	 * \brief Sets the prewarm time budget
+	 *
+	 * Zero disables prewarming.
+	 * \param [in] budget Time budget
+	 */
+	static void setPrewarmBudget(std::chrono::milliseconds budget);
+
+	/**
+	 * \brief Prewarm time budget
+	 * \returns Budget set with \c setPrewarmBudget
+	 */
+	static std::chrono::milliseconds getPrewarmBudget();
+
+private:
+	void notifyPipelineCreated(
+		const VltGraphicsPipelineShaders&   shaders,
+		const VltGraphicsPipelineStateInfo& state,
+		const VltRenderPass&                rp);
+
 private:
 	VltDevice* m_device;
+
+	VltPipelineCache    m_cache;
+	VltPipelineStateLog m_stateLog;
+
 	std::unordered_map<VltGraphicsPipelineShaders, VltGraphicsPipeline,
 		VltHash, VltEqual> m_graphicsPipelines;
+
+	// Background pipeline compilation,
+	// joined before the pipelines are destroyed.
+	VltWorkerPool m_workers;
 };
 
 
@@ -3,6 +3,7 @@
 #include "UtilFlag.h"
 #include "VltBuffer.h"
 #include "VltCommon.h"
+#include "VltHash.h"
 #include "VltLimit.h"
 #include "VltUtil.h"
 
@@ -835,6 +836,27 @@ struct PS4ALIGN(32) VltGraphicsPipelineStateInfo
 		return !bit::bcmpeq(this, &other);
 	}
 
+	/**
+	 * \brief Hashes the state
+	 *
+	 * States are compared bitwise,
+	 * so they are hashed bitwise too.
+	 * \returns Hash of all state bytes
+	 */
+	size_t hash() const
+	{
+		static_assert(sizeof(VltGraphicsPipelineStateInfo) % sizeof(uint64_t) == 0);
+
+		const uint64_t* words = reinterpret_cast<const uint64_t*>(this);
+
+		VltHashState hash;
+		for (size_t i = 0; i != sizeof(*this) / sizeof(uint64_t); ++i)
+		{
+			hash.add(words[i]);
+		}
+		return hash;
+	}
+
 	friend std::ostream& operator<<(std::ostream& out, const VltGraphicsPipelineStateInfo& state);
 	friend std::istream& operator>>(std::istream& in, VltGraphicsPipelineStateInfo& state);
 };
@@ -0,0 +1,212 @@
+#include "VltPipelineStateLog.h"
+#include "VltGraphicsPipeline.h"
+
+#include <cstring>
+
+LOG_CHANNEL(Graphic.Violet.VltPipelineStateLog);
+
+namespace vlt
+{;
+
+constexpr char     LogMagic[4]      = { 'G', 'P', 'S', 'L' };
+constexpr uint32_t LogFormatVersion = 2;
+
+struct VltPipelineStateLogHeader
+{
+	char     magic[4];
+	uint32_t formatVersion;
+	uint32_t stateSize;  // Entries are invalid once the state layout changes
+	uint32_t formatSize;
+};
+
+// Fields are written separately, so the
+// entry's padding never reaches the file.
+constexpr size_t LogEntrySize =
+	sizeof(uint64_t) * 2 +
+	sizeof(VltGraphicsPipelineStateInfo) +
+	sizeof(VltRenderPassFormat);
+
+VltPipelineStateLog::VltPipelineStateLog()
+{
+}
+
+VltPipelineStateLog::~VltPipelineStateLog()
+{
+}
+
+bool VltPipelineStateLog::open(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	bool ret = false;
+	do
+	{
+		m_path = path;
+
+		if (!readEntries(path))
+		{
+			// Missing, stale or truncated log, rewrite
+			// it with whatever entries were still good.
+			if (!writeLog(path))
+			{
+				LOG_ERR("create pipeline state log %s failed.", path.c_str());
+				break;
+			}
+		}
+
+		m_file.reset(fopen(path.c_str(), "ab"));
+		if (!m_file)
+		{
+			LOG_ERR("open pipeline state log %s for append failed.", path.c_str());
+			break;
+		}
+
+		LOG_DEBUG("pipeline state log %s opened, %zu entries.", path.c_str(), m_loaded.size());
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+void VltPipelineStateLog::record(
+	const VltGraphicsPipelineShaders&   shaders,
+	const VltGraphicsPipelineStateInfo& state,
+	const VltRenderPass&                rp)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	do
+	{
+		if (!m_file)
+		{
+			break;
+		}
+
+		VltPipelineStateLogEntry entry;
+		entry.vsKey    = shaders.vs->key().toUint64();
+		entry.fsKey    = shaders.fs->key().toUint64();
+		entry.state    = state;
+		entry.rpFormat = rp.format();
+
+		if (!m_entries.insert(entry).second)
+		{
+			break;
+		}
+
+		if (!writeEntry(m_file.get(), entry))
+		{
+			// The partial entry will be dropped on next open.
+			LOG_ERR("write pipeline state log %s failed.", m_path.c_str());
+			m_file.reset();
+			break;
+		}
+
+		fflush(m_file.get());
+	} while (false);
+}
+
+std::vector<VltPipelineStateLogEntry> VltPipelineStateLog::entries()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_loaded;
+}
+
+bool VltPipelineStateLog::readEntries(const std::string& path)
+{
+	bool ret = false;
+	do
+	{
+		std::vector<uint8_t> data;
+		if (!UtilFile::LoadFile(path, data))
+		{
+			break;
+		}
+
+		VltPipelineStateLogHeader header;
+		if (data.size() < sizeof(header))
+		{
+			break;
+		}
+
+		std::memcpy(&header, data.data(), sizeof(header));
+		if (std::memcmp(header.magic, LogMagic, sizeof(LogMagic)) != 0 ||
+			header.formatVersion != LogFormatVersion ||
+			header.stateSize != sizeof(VltGraphicsPipelineStateInfo) ||
+			header.formatSize != sizeof(VltRenderPassFormat))
+		{
+			LOG_WARN("pipeline state log %s is stale, discarded.", path.c_str());
+			break;
+		}
+
+		size_t payloadSize = data.size() - sizeof(header);
+		size_t entryCount  = payloadSize / LogEntrySize;
+
+		const uint8_t* ptr = data.data() + sizeof(header);
+		for (size_t i = 0; i != entryCount; ++i, ptr += LogEntrySize)
+		{
+			VltPipelineStateLogEntry entry;
+			std::memcpy(&entry.vsKey, ptr, sizeof(uint64_t));
+			std::memcpy(&entry.fsKey, ptr + sizeof(uint64_t), sizeof(uint64_t));
+			std::memcpy(&entry.state, ptr + sizeof(uint64_t) * 2, sizeof(entry.state));
+			std::memcpy(&entry.rpFormat, ptr + sizeof(uint64_t) * 2 + sizeof(entry.state), sizeof(entry.rpFormat));
+
+			if (m_entries.insert(entry).second)
+			{
+				m_loaded.push_back(entry);
+			}
+		}
+
+		if (payloadSize % LogEntrySize != 0)
+		{
+			LOG_WARN("pipeline state log %s has a truncated entry, dropped.", path.c_str());
+			break;
+		}
+
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+bool VltPipelineStateLog::writeLog(const std::string& path)
+{
+	bool ret = false;
+	do
+	{
+		UtilFile::file_uptr file(fopen(path.c_str(), "wb"));
+		if (!file)
+		{
+			break;
+		}
+
+		VltPipelineStateLogHeader header = {};
+		std::memcpy(header.magic, LogMagic, sizeof(LogMagic));
+		header.formatVersion = LogFormatVersion;
+		header.stateSize     = sizeof(VltGraphicsPipelineStateInfo);
+		header.formatSize    = sizeof(VltRenderPassFormat);
+
+		if (fwrite(&header, sizeof(header), 1, file.get()) != 1)
+		{
+			break;
+		}
+
+		ret = true;
+		for (const auto& entry : m_loaded)
+		{
+			if (!writeEntry(file.get(), entry))
+			{
+				ret = false;
+				break;
+			}
+		}
+	} while (false);
+	return ret;
+}
+
+bool VltPipelineStateLog::writeEntry(FILE* file, const VltPipelineStateLogEntry& entry)
+{
+	return fwrite(&entry.vsKey, sizeof(entry.vsKey), 1, file) == 1 &&
+		   fwrite(&entry.fsKey, sizeof(entry.fsKey), 1, file) == 1 &&
+		   fwrite(&entry.state, sizeof(entry.state), 1, file) == 1 &&
+		   fwrite(&entry.rpFormat, sizeof(entry.rpFormat), 1, file) == 1;
+}
+
+}  // namespace vlt
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "VltCommon.h"
+#include "VltHash.h"
+#include "VltPipelineState.h"
+#include "VltRenderPass.h"
+
+#include "Platform/UtilFile.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace vlt
+{;
+
+struct VltGraphicsPipelineShaders;
+
+/**
+ * \brief Pipeline state log entry
+ *
+ * Shader keys, state and render pass
+ * format of one pipeline instance.
+ */
+struct VltPipelineStateLogEntry
+{
+	uint64_t                     vsKey = 0;
+	uint64_t                     fsKey = 0;
+	VltGraphicsPipelineStateInfo state;
+	VltRenderPassFormat          rpFormat;
+
+	bool operator==(const VltPipelineStateLogEntry& other) const
+	{
+		return vsKey == other.vsKey &&
+			   fsKey == other.fsKey &&
+			   state == other.state &&
+			   rpFormat == other.rpFormat;
+	}
+
+	size_t hash() const
+	{
+		VltHashState hash;
+		hash.add(vsKey);
+		hash.add(fsKey);
+		hash.add(state.hash());
+		hash.add(rpFormat.hash());
+		return hash;
+	}
+};
+
+/**
+ * \brief Pipeline state log
+ *
+ * Append-only file next to the pipeline cache, holding
+ * the shader keys, state and render pass format of every
+ * pipeline created so far, so they can be created ahead of
+ * time on the next run. The driver cache alone only makes creation cheaper,
+ * it doesn't tell which pipelines the game is going to use.
+ *
+ * Entries are fixed-size, a log written with another
+ * state layout is discarded and a truncated tail left
+ * by an interrupted write is dropped on open.
+ */
+class VltPipelineStateLog
+{
+public:
+	VltPipelineStateLog();
+	~VltPipelineStateLog();
+
+	/**
+	 * \brief Opens the log
+	 *
+	 * Creates the file if it doesn't exist yet.
+	 * \param [in] path Log file path
+	 * \returns \c true on success
+	 */
+	bool open(const std::string& path);
+
+	/**
+	 * \brief Records a pipeline
+	 *
+	 * Does nothing if it is already logged.
+	 * \param [in] shaders Pipeline shaders
+	 * \param [in] state Pipeline state vector
+	 * \param [in] rp Render pass
+	 */
+	void record(
+		const VltGraphicsPipelineShaders&   shaders,
+		const VltGraphicsPipelineStateInfo& state,
+		const VltRenderPass&                rp);
+
+	/**
+	 * \brief Logged pipelines
+	 * \returns Entries read when the log was opened
+	 */
+	std::vector<VltPipelineStateLogEntry> entries();
+
+private:
+	bool readEntries(const std::string& path);
+
+	bool writeLog(const std::string& path);
+
+	bool writeEntry(FILE* file, const VltPipelineStateLogEntry& entry);
+
+private:
+	std::mutex           m_mutex;
+	std::string          m_path;
+	UtilFile::file_uptr  m_file;
+
+	std::vector<VltPipelineStateLogEntry> m_loaded;
+	std::unordered_set<VltPipelineStateLogEntry,
+					   VltHash, VltEqual> m_entries;
+};
+
+}  // namespace vlt
@@ -37,6 +37,11 @@ PresenterSync VltPresenter::getSyncObjects() const
 	return m_syncObjects[m_frameIndex];
 }
 
+uint32_t VltPresenter::getFrameIndex() const
+{
+	return m_frameIndex;
+}
+
 PresenterImage VltPresenter::getImage(uint32_t index) const
 {
 	return m_images[index];
@@ -62,7 +67,7 @@ VkResult VltPresenter::acquireNextImage(VkSemaphore signal, VkFence fence, uint3
 			std::numeric_limits<uint64_t>::max(),
 			signal,
 			fence,
-			&m_imageIndex);
+			&index);
 
 		if (status != VK_SUCCESS && status != VK_SUBOPTIMAL_KHR)
 		{
@@ -72,8 +77,6 @@ VkResult VltPresenter::acquireNextImage(VkSemaphore signal, VkFence fence, uint3
 		m_frameIndex += 1;
 		m_frameIndex %= m_info.imageCount;
 
-		index = m_imageIndex;
-
 	} while (false);
 	return status;
 }
@@ -83,7 +86,7 @@ VkResult VltPresenter::waitForFence(VkFence fence)
 	vkWaitForFences(*m_device, 1, &fence, VK_FALSE, UINT64_MAX);
 }
 
-VkResult VltPresenter::presentImage(VkSemaphore wait)
+VkResult VltPresenter::presentImage(VkSemaphore wait, uint32_t imageIndex)
 {
 	VkPresentInfoKHR info;
 	info.sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -92,7 +95,7 @@ VkResult VltPresenter::presentImage(VkSemaphore wait)
 	info.pWaitSemaphores    = &wait;
 	info.swapchainCount     = 1;
 	info.pSwapchains        = &m_swapchain;
-	info.pImageIndices      = &m_imageIndex;
+	info.pImageIndices      = &imageIndex;
 	info.pResults           = nullptr;
 
 	return vkQueuePresentKHR(m_presentQueue, &info);
@@ -162,7 +165,6 @@ VkResult VltPresenter::recreateSwapChain(const PresenterDesc& desc)
 		initSyncObjects();
 
 		// Invalidate indices
-		m_imageIndex = 0;
 		m_frameIndex = 0;
 
 		// Update present queue
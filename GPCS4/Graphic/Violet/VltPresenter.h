@@ -81,6 +81,7 @@ struct VltPresentInfo
 {
 	RcPtr<VltPresenter> presenter;
 	VkSemaphore         waitSync;
+	uint32_t            imageIndex;  // Returned by acquireNextImage
 };
 
 
@@ -107,6 +108,15 @@ public:
      */
 	PresenterSync getSyncObjects() const;
 
+	/**
+	 * \brief Retrieves the current frame index
+	 *
+	 * Index of the semaphores returned
+	 * by \ref getSyncObjects.
+	 * \returns Frame index
+	 */
+	uint32_t getFrameIndex() const;
+
 	/**
      * \brief Retrieves image by index
      * 
@@ -146,23 +156,29 @@ public:
 		VkFence fence);
 
 	/**
-     * \brief Presents current image
+     * \brief Presents an acquired image
      * 
-     * Presents the current image. If this returns
+     * Presents the given image. If this returns
      * an error, the swap chain must be recreated,
      * but do not present before acquiring an image.
+     * Called on the submission thread, so the index
+     * is passed in rather than read back from the
+     * presenter, which may be acquiring the next one.
      * \param [in] wait Semaphore to wait on
+     * \param [in] imageIndex Index returned by \ref acquireNextImage
      * \returns Status of the operation
      */
 	VkResult presentImage(
-		VkSemaphore wait);
+		VkSemaphore wait,
+		uint32_t    imageIndex);
 
 	/**
      * \brief Changes presenter properties
      * 
      * Recreates the swap chain immediately. Note that
      * no swap chain resources must be in use by the
-     * GPU at the time this is called.
+     * GPU at the time this is called, and no present
+     * may be pending on the submission thread.
      * \param [in] desc Swap chain description
      */
 	VkResult recreateSwapChain(
@@ -201,7 +217,6 @@ private:
 	std::vector<PresenterSync>  m_syncObjects;
 
 	uint32_t m_frameIndex = 0;
-	uint32_t m_imageIndex = 0;
 };
 
 }  // namespace vlt
\ No newline at end of file
@@ -19,6 +19,19 @@ VltShader::VltShader(VkShaderStageFlagBits          stage,
 	generateBindingIdOffsets(code);
 }
 
+VltShader::VltShader(VkShaderStageFlagBits          stage,
+					 SpirvCompressedBuffer&&        code,
+					 const PsslKey&                 key,
+					 std::vector<VltResourceSlot>&& resSlots) :
+	m_stage(stage),
+	m_code(std::move(code)),
+	m_key(key),
+	m_slots(std::move(resSlots))
+{
+	SpirvCodeBuffer spirvCode = m_code.decompress();
+	generateBindingIdOffsets(spirvCode);
+}
+
 VltShader::~VltShader()
 {
 }
@@ -63,6 +76,16 @@ VltShader::PsslKey VltShader::key()
 	return m_key;
 }
 
+const VltShader::SpirvCompressedBuffer& VltShader::code() const
+{
+	return m_code;
+}
+
+const std::vector<VltResourceSlot>& VltShader::slots() const
+{
+	return m_slots;
+}
+
 bool VltShader::operator==(const VltShader& other)
 {
 	return m_key == other.m_key;
@@ -25,6 +25,18 @@ public:
 			  const PsslKey&                 key,
 			  std::vector<VltResourceSlot>&& resSlots);
 
+	/**
+	 * \brief Creates a shader from compressed code
+	 *
+	 * Used when restoring a shader from the on-disk
+	 * shader cache, so the code doesn't need to be
+	 * compressed a second time.
+	 */
+	VltShader(VkShaderStageFlagBits          stage,
+			  SpirvCompressedBuffer&&        code,
+			  const PsslKey&                 key,
+			  std::vector<VltResourceSlot>&& resSlots);
+
 	virtual ~VltShader();
 
 	VkShaderStageFlagBits stage() const;
@@ -36,6 +48,18 @@ public:
 
 	PsslKey key();
 
+	/**
+	 * \brief Compressed SPIR-V code
+	 * \returns Code, with binding IDs not yet remapped
+	 */
+	const SpirvCompressedBuffer& code() const;
+
+	/**
+	 * \brief Resource slots used by the shader
+	 * \returns Resource slot list
+	 */
+	const std::vector<VltResourceSlot>& slots() const;
+
 	void dumpShader() const;
 
 	bool operator==(const VltShader& other);
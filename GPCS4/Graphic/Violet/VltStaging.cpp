@@ -1,13 +1,20 @@
 #include "VltStaging.h"
 #include "VltDevice.h"
 
-
+#include "UtilMath.h"
 
 namespace vlt
 {;
 
-VltStagingBufferAllocator::VltStagingBufferAllocator(const RcPtr<VltDevice>& device):
-	m_device(device)
+VltStagingBufferAllocator::VltStagingBufferAllocator(
+	const RcPtr<VltDevice>&    device,
+	const VltBufferCreateInfo& info,
+	VkMemoryPropertyFlags      memFlags) :
+	m_device(device),
+	m_info(info),
+	m_memFlags(memFlags),
+	m_ringSize(info.size),
+	m_dedicatedSize(info.size / 4)
 {
 
 }
@@ -16,82 +23,136 @@ VltStagingBufferAllocator::~VltStagingBufferAllocator()
 {
 }
 
+RcPtr<VltGpuResource> VltStagingBufferAllocator::beginFrame()
+{
+	m_frameToken = new VltGpuResource();
+	m_frameBegin = m_head;
+	m_stats      = VltStagingStats();
+	return m_frameToken;
+}
 
-VltBufferSlice VltStagingBufferAllocator::alloc(VkDeviceSize size, VkDeviceSize align)
+void VltStagingBufferAllocator::endFrame()
 {
-	VltBufferSlice slice;
-	do 
+	do
 	{
-		if (size > MaxBufferSize)
+		if (m_frameToken == nullptr)
 		{
-			slice = VltBufferSlice(createBuffer(size));
 			break;
 		}
 
-		if (m_buffer == nullptr)
+		// Frames which didn't allocate from the ring
+		// don't hold anything back.
+		if (m_head != m_frameBegin)
+		{
+			Frame frame = {};
+			frame.token = std::move(m_frameToken);
+			frame.begin = m_frameBegin;
+			frame.end   = m_head;
+			m_frames.push_back(std::move(frame));
+		}
+
+		m_frameToken = nullptr;
+		m_frameStats = m_stats;
+	} while (false);
+}
+
+VltBufferSlice VltStagingBufferAllocator::alloc(VkDeviceSize size, VkDeviceSize align)
+{
+	m_stats.stagedBytes += size;
+	++m_stats.allocCount;
+
+	VltBufferSlice slice;
+	do
+	{
+		// Ring memory is only reclaimed through the frame
+		// token, so allocations outside a frame can't use it.
+		if (size > m_dedicatedSize || m_frameToken == nullptr)
 		{
-			m_buffer = createBuffer(MaxBufferSize);
+			slice = allocDedicated(size);
+			break;
 		}
 
-		if (!m_buffer->busy())
+		if (m_ring == nullptr)
 		{
-			// If buffer not in use, we can safely go to start.
-			m_offset = 0;
+			m_ring = createBuffer(m_ringSize);
 		}
 
-		m_offset = ::util::align(m_offset, align);
+		reclaimFrames();
 
-		// If this is true, m_buffer must be in use,
-		// we need to find another buffer, either in cache or a new one
-		if (m_offset + size > MaxBufferSize)  
+		VkDeviceSize tail   = m_frames.empty() ? m_frameBegin : m_frames.front().begin;
+		VkDeviceSize offset = ::util::align(m_head, align);
+
+		// Allocations don't wrap, the rest of
+		// the ring is skipped instead.
+		if (offset % m_ringSize + size > m_ringSize)
 		{
-			m_offset = 0;
-
-			if (m_bufferCache.size() < MaxBufferCount)
-			{
-				// Save the buffer being used, for future use.
-				m_bufferCache.push(std::move(m_buffer));
-			}
-
-			if (!m_bufferCache.front()->busy())
-			{
-				m_buffer = std::move(m_bufferCache.front());
-				m_bufferCache.pop();
-			}
-			else
-			{
-				m_buffer = createBuffer(size);
-			}
+			offset = ::util::align(offset, m_ringSize);
 		}
 
-		slice = VltBufferSlice(m_buffer, m_offset, size);
-		m_offset = ::util::align(m_offset + size, align);
+		if (offset + size - tail > m_ringSize)
+		{
+			++m_stats.stallCount;
+			slice = allocDedicated(size);
+			break;
+		}
 
+		slice  = VltBufferSlice(m_ring, offset % m_ringSize, size);
+		m_head = offset + size;
 	} while (false);
 	return slice;
 }
 
+const VltStagingStats& VltStagingBufferAllocator::getFrameStats() const
+{
+	return m_frameStats;
+}
+
 void VltStagingBufferAllocator::trim()
 {
-	m_buffer = nullptr;
+	m_dedicatedCache.clear();
+}
+
+VltBufferSlice VltStagingBufferAllocator::allocDedicated(VkDeviceSize size)
+{
+	++m_stats.dedicatedCount;
 
-	while (!m_bufferCache.empty())
+	RcPtr<VltBuffer> buffer;
+	for (const auto& cached : m_dedicatedCache)
 	{
-		m_bufferCache.pop();
+		if (!cached->busy() && cached->length() >= size)
+		{
+			buffer = cached;
+			break;
+		}
+	}
+
+	if (buffer == nullptr)
+	{
+		buffer = createBuffer(size);
+
+		if (m_dedicatedCache.size() < MaxCachedCount)
+		{
+			m_dedicatedCache.push_back(buffer);
+		}
+	}
+
+	return VltBufferSlice(buffer, 0, size);
+}
+
+void VltStagingBufferAllocator::reclaimFrames()
+{
+	while (!m_frames.empty() && !m_frames.front().token->busy())
+	{
+		m_frames.pop_front();
 	}
 }
 
 RcPtr<VltBuffer> VltStagingBufferAllocator::createBuffer(VkDeviceSize size)
 {
-	VltBufferCreateInfo info;
-	info.size   = size;
-	info.usage  = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-	info.stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
-	info.access = VK_ACCESS_TRANSFER_READ_BIT;
-
-	return m_device->createBuffer(
-		info,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	VltBufferCreateInfo info = m_info;
+	info.size                = size;
+
+	return m_device->createBuffer(info, m_memFlags);
 }
 
-}  // namespace vlt
\ No newline at end of file
+}  // namespace vlt
@@ -2,38 +2,124 @@
 
 #include "VltCommon.h"
 #include "VltBuffer.h"
-#include <queue>
+#include <deque>
+#include <vector>
 
 namespace vlt
 {;
 
 class VltDevice;
 
+/**
+ * \brief Staging statistics
+ *
+ * Counted per frame, from beginFrame to endFrame.
+ */
+struct VltStagingStats
+{
+	VkDeviceSize stagedBytes    = 0;
+	uint32_t     allocCount     = 0;
+	uint32_t     dedicatedCount = 0;  // Uploads too large for the ring
+	uint32_t     stallCount     = 0;  // Uploads which found the ring full
+};
 
+/**
+ * \brief Staging buffer allocator
+ *
+ * Hands out slices of one persistently mapped ring
+ * buffer. Every frame owns the part of the ring it
+ * allocated from, and a frame token tracked by the
+ * frame's command list keeps it alive until the list
+ * is reset after its fence signaled. Completed frames
+ * are reclaimed in order on the next allocation.
+ *
+ * Uploads larger than a quarter of the ring get a
+ * dedicated buffer, and so do uploads which find the
+ * ring full. The frame being recorded can't be waited
+ * for, so a full ring counts as a stall instead.
+ *
+ * The ring's size, usage and memory type are chosen by
+ * the owner, so the same allocator also hands out device
+ * local slices which in-use buffers are renamed to.
+ */
 class VltStagingBufferAllocator : public RcObject
 {
-	const VkDeviceSize MaxBufferSize  = 1024 * 1024 * 32;  // 32MB
-	const uint32_t     MaxBufferCount = 2;
+	const uint32_t MaxCachedCount = 2;
 
 public:
+	/**
+	 * \brief Creates the allocator
+	 *
+	 * \param [in] device The device
+	 * \param [in] info Ring size and usage of its buffers
+	 * \param [in] memFlags Memory type of its buffers
+	 */
 	VltStagingBufferAllocator(
-		const RcPtr<VltDevice>& device);
+		const RcPtr<VltDevice>&    device,
+		const VltBufferCreateInfo& info,
+		VkMemoryPropertyFlags      memFlags);
 	~VltStagingBufferAllocator();
 
+	/**
+	 * \brief Starts a frame
+	 *
+	 * The returned token must be tracked by the
+	 * command list the frame's uploads are recorded to.
+	 * \returns Frame token
+	 */
+	RcPtr<VltGpuResource> beginFrame();
+
+	/**
+	 * \brief Ends the current frame
+	 *
+	 * Its part of the ring is reclaimed
+	 * once the frame token is released.
+	 */
+	void endFrame();
+
 	VltBufferSlice alloc(VkDeviceSize size, VkDeviceSize align);
 
+	/**
+	 * \brief Statistics of the last frame
+	 * \returns Counters of the last ended frame
+	 */
+	const VltStagingStats& getFrameStats() const;
+
 	void trim();
 
 private:
+	struct Frame
+	{
+		RcPtr<VltGpuResource> token;
+		VkDeviceSize          begin;
+		VkDeviceSize          end;
+	};
+
 	RcPtr<VltBuffer> createBuffer(VkDeviceSize size);
 
+	VltBufferSlice allocDedicated(VkDeviceSize size);
+
+	void reclaimFrames();
+
 private:
-	RcPtr<VltDevice> m_device;
+	RcPtr<VltDevice>      m_device;
+	VltBufferCreateInfo   m_info;
+	VkMemoryPropertyFlags m_memFlags;
+	VkDeviceSize          m_ringSize;
+	VkDeviceSize          m_dedicatedSize;
+
+	// Ring positions only grow, the offset in the
+	// buffer is the position modulo the ring size.
+	RcPtr<VltBuffer>      m_ring;
+	VkDeviceSize          m_head       = 0;
+	VkDeviceSize          m_frameBegin = 0;
+	RcPtr<VltGpuResource> m_frameToken;
+	std::deque<Frame>     m_frames;
 
-	RcPtr<VltBuffer> m_buffer;
-	VkDeviceSize     m_offset = 0;
+	std::vector<RcPtr<VltBuffer>> m_dedicatedCache;
 
-	std::queue<RcPtr<VltBuffer>> m_bufferCache;
+	VltStagingStats m_stats;
+	VltStagingStats m_frameStats;
 };
 
-}  // namespace vlt
\ No newline at end of file
+}  // namespace vlt
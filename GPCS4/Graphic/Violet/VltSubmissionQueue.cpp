@@ -2,57 +2,287 @@
 
 #include "VltDevice.h"
 #include "VltCmdList.h"
-#include "VltPresenter.h"
+#include "VltLimit.h"
+
+#include <algorithm>
+#include <utility>
+
+LOG_CHANNEL(Graphic.Violet.VltSubmissionQueue);
 
 namespace vlt
 {;
 
 
 VltSubmissionQueue::VltSubmissionQueue(VltDevice* device):
-	m_device(device)
+	m_device(device),
+	m_submitThread(&VltSubmissionQueue::submitCmdLists, this),
+	m_finishThread(&VltSubmissionQueue::finishCmdLists, this)
 {
 }
 
 VltSubmissionQueue::~VltSubmissionQueue()
 {
+	stop();
+}
+
+void VltSubmissionQueue::submit(
+	const VltSubmitInfo& submission,
+	VltSubmitStatus*     status)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	if (m_pending >= MaxNumQueuedCommandBuffers)
+	{
+		++m_stats.blockCount;
+		m_finishCond.wait(lock, [this] { return m_pending < MaxNumQueuedCommandBuffers; });
+	}
+
+	VltSubmitEntry entry = {};
+	entry.cmdList        = submission.cmdList;
+	entry.waitSync       = submission.waitSync;
+	entry.wakeSync       = submission.wakeSync;
+	entry.status         = status;
+	entry.queueTime      = Clock::now();
+
+	if (status)
+	{
+		status->result = VK_NOT_READY;
+	}
+
+	++m_pending;
+	m_submitQueue.push(std::move(entry));
+
+	m_stats.maxQueueDepth = std::max(m_stats.maxQueueDepth, uint32_t(m_submitQueue.size()));
+	m_appendCond.notify_all();
+}
+
+void VltSubmissionQueue::present(
+	const VltPresentInfo& presentation,
+	VltSubmitStatus*      status)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	VltSubmitEntry entry = {};
+	entry.present        = presentation;
+	entry.status         = status;
+	entry.queueTime      = Clock::now();
+
+	if (status)
+	{
+		status->result = VK_NOT_READY;
+	}
+
+	m_submitQueue.push(std::move(entry));
+
+	m_stats.maxQueueDepth = std::max(m_stats.maxQueueDepth, uint32_t(m_submitQueue.size()));
+	m_appendCond.notify_all();
+}
+
+VkResult VltSubmissionQueue::synchronizeSubmission(VltSubmitStatus* status)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_submitCond.wait(lock, [status] { return status->result.load() != VK_NOT_READY; });
+	return status->result.load();
 }
 
-void VltSubmissionQueue::submit(const VltSubmitInfo& submission)
+void VltSubmissionQueue::synchronize()
 {
-	auto& cmdList = submission.cmdList;
-	cmdList->submit(submission.waitSync, submission.wakeSync);
-	m_submitQueue.push(std::move(cmdList));
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_finishCond.wait(lock, [this] { return m_submitQueue.empty() && m_pending == 0; });
 }
 
-void VltSubmissionQueue::present(const VltPresentInfo& presentation)
+void VltSubmissionQueue::stop()
 {
 	do
 	{
-		auto& presenter = presentation.presenter;
-		VkResult status = presenter->presentImage(presentation.waitSync);
-		if (status != VK_SUCCESS)
+		if (!m_submitThread.joinable())
 		{
 			break;
 		}
 
-		auto cmdList = m_submitQueue.front();
+		// Command lists hold resources which
+		// must be released before the device.
+		synchronize();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopped = true;
+		}
+
+		m_appendCond.notify_all();
+		m_submitCond.notify_all();
+
+		m_submitThread.join();
+		m_finishThread.join();
+
+		auto stats = getStats();
+		if (stats.submitCount)
+		{
+			LOG_DEBUG("submission queue: %llu submits, %llu presents, max depth %u, %llu blocked, "
+					  "latency avg %llu us max %llu us.",
+					  stats.submitCount, stats.presentCount, stats.maxQueueDepth, stats.blockCount,
+					  stats.totalLatencyUs / (stats.submitCount + stats.presentCount), stats.maxLatencyUs);
+		}
+	} while (false);
+}
+
+VltSubmissionQueueStats VltSubmissionQueue::getStats()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	VltSubmissionQueueStats stats = m_stats;
+	stats.queueDepth              = uint32_t(m_submitQueue.size());
+	stats.pendingCount            = m_pending;
+	return stats;
+}
+
+void VltSubmissionQueue::submitCmdLists()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (!m_stopped)
+	{
+		m_appendCond.wait(lock, [this] { return m_stopped || !m_submitQueue.empty(); });
+
+		if (m_stopped)
+		{
+			break;
+		}
+
+		// The entry stays queued until it is submitted,
+		// so synchronize doesn't miss it.
+		VltSubmitEntry entry = std::move(m_submitQueue.front());
+		lock.unlock();
+
+		VkResult status = m_lastError.load();
+		if (status != VK_ERROR_DEVICE_LOST)
+		{
+			if (entry.cmdList != nullptr)
+			{
+				status = entry.cmdList->submit(entry.waitSync, entry.wakeSync);
+			}
+			else if (entry.present.waitSync != VK_NULL_HANDLE &&
+					 entry.present.waitSync == m_unsignaledSync)
+			{
+				// The command list rendering the image was not
+				// submitted, waiting on its semaphore would hang.
+				status = m_lastError.load();
+			}
+			else
+			{
+				status = entry.present.presenter->presentImage(entry.present.waitSync,
+																	entry.present.imageIndex);
+			}
+		}
+
+		auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+			Clock::now() - entry.queueTime).count();
+
+		lock.lock();
+
+		m_stats.totalLatencyUs += latency;
+		m_stats.maxLatencyUs = std::max(m_stats.maxLatencyUs, uint64_t(latency));
+
+		if (entry.cmdList != nullptr)
+		{
+			++m_stats.submitCount;
+
+			if (entry.wakeSync != VK_NULL_HANDLE)
+			{
+				m_unsignaledSync = status == VK_SUCCESS ? VK_NULL_HANDLE : entry.wakeSync;
+			}
+
+			if (status == VK_SUCCESS)
+			{
+				// Status is set once the command list has executed.
+				m_finishQueue.push(std::move(entry));
+			}
+			else
+			{
+				LOG_ERR("command list submission failed %d.", status);
+				m_lastError = status;
+
+				// Not in flight, release it right away.
+				entry.cmdList->reset();
+				--m_pending;
+				if (entry.status)
+				{
+					entry.status->result = status;
+				}
+				m_finishCond.notify_all();
+			}
+		}
+		else
+		{
+			++m_stats.presentCount;
+
+			if (entry.present.waitSync == m_unsignaledSync)
+			{
+				m_unsignaledSync = VK_NULL_HANDLE;
+			}
+
+			if (status != VK_SUCCESS && status != VK_SUBOPTIMAL_KHR)
+			{
+				LOG_WARN("present failed %d.", status);
+			}
+
+			if (entry.status)
+			{
+				entry.status->result = status;
+			}
+		}
+
 		m_submitQueue.pop();
+		m_submitCond.notify_all();
+		m_finishCond.notify_all();
+	}
+}
 
-		// Wait for command buffer submit finish.
-		status = cmdList->synchronize();
-		if (status != VK_SUCCESS)
+void VltSubmissionQueue::finishCmdLists()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (!m_stopped)
+	{
+		m_submitCond.wait(lock, [this] { return m_stopped || !m_finishQueue.empty(); });
+
+		if (m_stopped)
 		{
 			break;
 		}
 
-		// After submit done, reset cmdlist to release resource.
-		cmdList->reset();
+		VltSubmitEntry entry = std::move(m_finishQueue.front());
+		m_finishQueue.pop();
+		lock.unlock();
+
+		VkResult status = m_lastError.load();
+		if (status != VK_ERROR_DEVICE_LOST)
+		{
+			status = entry.cmdList->synchronize();
+		}
+
+		if (status != VK_SUCCESS)
+		{
+			LOG_ERR("waiting for command list failed %d.", status);
+			m_lastError = status;
+		}
+
+		// After submit done, reset cmdlist to release resource,
+		// then recycle the cmdlist for next use.
+		entry.cmdList->reset();
+		m_device->recycleCommandList(std::exchange(entry.cmdList, nullptr));
 
-		// Finally, recycle the cmdlist for next use.
-		// Here we release the ownership of m_cmdList to emulate item poped from queue.
-		m_device->recycleCommandList(std::exchange(cmdList, nullptr));
+		lock.lock();
 
-	} while (false);
+		--m_pending;
+		if (entry.status)
+		{
+			entry.status->result = status;
+		}
+
+		m_finishCond.notify_all();
+		m_submitCond.notify_all();
+	}
 }
 
-}  // namespace vlt
\ No newline at end of file
+}  // namespace vlt
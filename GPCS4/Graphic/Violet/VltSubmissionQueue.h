@@ -1,41 +1,159 @@
 #pragma once
 
 #include "VltCommon.h"
+#include "VltPresenter.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <queue>
+#include <thread>
 
 namespace vlt
 {;
 
 struct VltSubmitInfo;
-struct VltPresentInfo;
 
 class VltDevice;
 class VltCmdList;
 
-// A submission queue to submit cmdlist asynchronously.
+/**
+ * \brief Submission status
+ *
+ * \c VK_NOT_READY while the entry is queued. Set once the
+ * entry is done: when a command list has executed on the
+ * GPU, or when an image has been presented.
+ */
+struct VltSubmitStatus
+{
+	std::atomic<VkResult> result = { VK_SUCCESS };
+};
 
-// TODO:
-// Currently this is a dummy queue, which uses synchronous submit.
-// This exists just for future compatibility when we really need a asynchronous queue. 
-// Actually it's easy to implement a simple version,
-// just use lambda to pack the cmdlist, and then push to std::async
-// I didn't do that because synchronous queue is more easy to debug.
+/**
+ * \brief Submission queue statistics
+ */
+struct VltSubmissionQueueStats
+{
+	uint64_t submitCount    = 0;
+	uint64_t presentCount   = 0;
+	uint32_t queueDepth     = 0;  // Entries waiting for the submit thread
+	uint32_t maxQueueDepth  = 0;
+	uint32_t pendingCount   = 0;  // Command lists not yet executed
+	uint64_t totalLatencyUs = 0;  // Queued to submitted, summed over all entries
+	uint64_t maxLatencyUs   = 0;
+	uint64_t blockCount     = 0;  // Submits which waited for a free slot
+};
 
+/**
+ * \brief Submission queue
+ *
+ * Submits command lists and presents images on a
+ * dedicated thread, so the threads parsing the game's
+ * command buffers never block inside the driver.
+ *
+ * A second thread waits for the fences of submitted command
+ * lists, then releases their resources, recycles them and
+ * signals their status. At most \c MaxNumQueuedCommandBuffers
+ * command lists are in flight, \c submit blocks beyond that.
+ */
 class VltSubmissionQueue
 {
+	using Clock = std::chrono::high_resolution_clock;
+
 public:
 	VltSubmissionQueue(VltDevice* device);
 	~VltSubmissionQueue();
 
-	void submit(const VltSubmitInfo& submission);
+	/**
+	 * \brief Queues a command list for submission
+	 *
+	 * \param [in] submission Command list and semaphores
+	 * \param [in] status Set once the command list has executed
+	 */
+	void submit(
+		const VltSubmitInfo& submission,
+		VltSubmitStatus*     status = nullptr);
+
+	/**
+	 * \brief Queues an image for presentation
+	 *
+	 * Skipped when the command list signaling the wait
+	 * semaphore failed to submit, \c status gets its error.
+	 * \param [in] presentation Presenter and semaphore
+	 * \param [in] status Set once the image is presented
+	 */
+	void present(
+		const VltPresentInfo& presentation,
+		VltSubmitStatus*      status = nullptr);
+
+	/**
+	 * \brief Waits for an entry to be done
+	 *
+	 * \param [in] status Status passed to \c submit or \c present
+	 * \returns Result of the entry
+	 */
+	VkResult synchronizeSubmission(VltSubmitStatus* status);
+
+	/**
+	 * \brief Waits until all command lists have executed
+	 */
+	void synchronize();
+
+	/**
+	 * \brief Executes everything queued and stops the threads
+	 *
+	 * Must be called before the device is destroyed.
+	 * Later calls do nothing.
+	 */
+	void stop();
+
+	/**
+	 * \brief Queue statistics
+	 * \returns Counters since creation
+	 */
+	VltSubmissionQueueStats getStats();
 
-	void present(const VltPresentInfo& presentation);
+private:
+	struct VltSubmitEntry
+	{
+		RcPtr<VltCmdList> cmdList;
+		VkSemaphore       waitSync = VK_NULL_HANDLE;
+		VkSemaphore       wakeSync = VK_NULL_HANDLE;
+		VltPresentInfo    present;
+		VltSubmitStatus*  status = nullptr;
+		Clock::time_point queueTime;
+	};
+
+	void submitCmdLists();
+
+	void finishCmdLists();
 
 private:
-	VltDevice*                    m_device;
-	std::queue<RcPtr<VltCmdList>> m_submitQueue;
+	VltDevice* m_device;
+
+	std::atomic<VkResult> m_lastError = { VK_SUCCESS };
+
+	// Signal semaphore of the last command list which failed
+	// to submit, only used by the submit thread.
+	VkSemaphore m_unsignaledSync = VK_NULL_HANDLE;
+
+	std::mutex              m_mutex;
+	std::condition_variable m_appendCond;  // Entry queued or stopping
+	std::condition_variable m_submitCond;  // Entry submitted or status set
+	std::condition_variable m_finishCond;  // Command list retired or entry submitted
+
+	bool     m_stopped = false;
+	uint32_t m_pending = 0;  // Command lists queued or in flight
+
+	std::queue<VltSubmitEntry> m_submitQueue;
+	std::queue<VltSubmitEntry> m_finishQueue;
+
+	VltSubmissionQueueStats m_stats;
+
+	std::thread m_submitThread;
+	std::thread m_finishThread;
 };
 
 
-}  // namespace vlt
\ No newline at end of file
+}  // namespace vlt
@@ -0,0 +1,341 @@
+#include "VltTlsfAllocator.h"
+
+#include "UtilBit.h"
+#include "UtilMath.h"
+
+#include <algorithm>
+
+namespace vlt
+{;
+
+VltTlsfAllocator::VltTlsfAllocator(uint64_t capacity) :
+	m_capacity(std::min(capacity & ~(Granularity - 1), uint64_t(~0u) << GranularityShift))
+{
+	m_slBitmaps.fill(0);
+	for (auto& lists : m_freeLists)
+	{
+		lists.fill(InvalidBlock);
+	}
+
+	if (m_capacity != 0)
+	{
+		uint32_t index = createBlock();
+
+		Block& block   = m_blocks[index];
+		block.offset   = 0;
+		block.size     = m_capacity;
+		block.prevPhys = InvalidBlock;
+		block.nextPhys = InvalidBlock;
+
+		insertFreeBlock(index);
+	}
+}
+
+VltTlsfAllocator::~VltTlsfAllocator()
+{
+}
+
+uint64_t VltTlsfAllocator::alloc(uint64_t size, uint64_t align)
+{
+	uint64_t offset = InvalidOffset;
+	do
+	{
+		size  = ::util::align(std::max(size, uint64_t(1)), Granularity);
+		align = std::max(align, Granularity);
+
+		// Worst case padding needed to align
+		// the start of whatever block is found.
+		uint64_t searchSize = size + align - Granularity;
+		if (size > m_capacity || searchSize > m_capacity)
+		{
+			break;
+		}
+
+		uint32_t index = findFreeBlock(searchSize);
+		if (index == InvalidBlock)
+		{
+			break;
+		}
+
+		removeFreeBlock(index);
+
+		// Leading padding goes back to the free lists,
+		// its previous neighbour can't be free.
+		uint64_t blockOffset = m_blocks[index].offset;
+		uint64_t padding     = ::util::align(blockOffset, align) - blockOffset;
+		if (padding != 0)
+		{
+			uint32_t front = index;
+			index          = splitBlock(front, padding);
+			insertFreeBlock(front);
+		}
+
+		if (m_blocks[index].size != size)
+		{
+			uint32_t rest = splitBlock(index, size);
+			insertFreeBlock(rest);
+		}
+
+		Block& block = m_blocks[index];
+		block.isFree = false;
+
+		m_usedSize += block.size;
+		m_allocated.emplace(block.offset, index);
+
+		offset = block.offset;
+	} while (false);
+	return offset;
+}
+
+bool VltTlsfAllocator::free(uint64_t offset)
+{
+	bool ret = false;
+	do
+	{
+		auto iter = m_allocated.find(offset);
+		if (iter == m_allocated.end())
+		{
+			break;
+		}
+
+		uint32_t index = iter->second;
+		m_allocated.erase(iter);
+
+		m_usedSize -= m_blocks[index].size;
+
+		uint32_t next = m_blocks[index].nextPhys;
+		if (next != InvalidBlock && m_blocks[next].isFree)
+		{
+			removeFreeBlock(next);
+			mergeBlocks(index, next);
+		}
+
+		uint32_t prev = m_blocks[index].prevPhys;
+		if (prev != InvalidBlock && m_blocks[prev].isFree)
+		{
+			removeFreeBlock(prev);
+			mergeBlocks(prev, index);
+			index = prev;
+		}
+
+		insertFreeBlock(index);
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+uint64_t VltTlsfAllocator::allocSize(uint64_t offset) const
+{
+	auto iter = m_allocated.find(offset);
+	return iter != m_allocated.end() ? m_blocks[iter->second].size : 0;
+}
+
+VltTlsfStats VltTlsfAllocator::getStats() const
+{
+	VltTlsfStats stats;
+	stats.capacity       = m_capacity;
+	stats.usedSize       = m_usedSize;
+	stats.freeSize       = m_capacity - m_usedSize;
+	stats.allocCount     = uint32_t(m_allocated.size());
+	stats.freeBlockCount = m_freeBlockCount;
+
+	// The largest block is in the highest non-empty list,
+	// but blocks within a list differ in size.
+	if (m_flBitmap != 0)
+	{
+		uint32_t fl = 31 - bit::lzcnt(m_flBitmap);
+		uint32_t sl = 31 - bit::lzcnt(m_slBitmaps[fl]);
+
+		for (uint32_t index = m_freeLists[fl][sl]; index != InvalidBlock; index = m_blocks[index].nextFree)
+		{
+			stats.largestFreeBlock = std::max(stats.largestFreeBlock, m_blocks[index].size);
+		}
+	}
+
+	return stats;
+}
+
+void VltTlsfAllocator::mapping(uint64_t size, uint32_t& fl, uint32_t& sl)
+{
+	uint32_t units = uint32_t(size >> GranularityShift);
+
+	fl = 31 - bit::lzcnt(units);
+	sl = fl >= SlBits
+			 ? (units >> (fl - SlBits)) ^ SlCount
+			 : (units << (SlBits - fl)) ^ SlCount;
+}
+
+uint32_t VltTlsfAllocator::findFreeBlock(uint64_t size)
+{
+	uint32_t index = InvalidBlock;
+	do
+	{
+		uint32_t fl, sl;
+		mapping(size, fl, sl);
+
+		// Round up to the next list, so any block
+		// found there is large enough.
+		uint64_t units = size >> GranularityShift;
+		if (fl >= SlBits)
+		{
+			units += (1ull << (fl - SlBits)) - 1;
+		}
+
+		if (units <= (m_capacity >> GranularityShift))
+		{
+			uint32_t searchFl, searchSl;
+			mapping(units << GranularityShift, searchFl, searchSl);
+
+			uint32_t slMap = m_slBitmaps[searchFl] & (~0u << searchSl);
+			if (slMap == 0)
+			{
+				uint32_t flMap = searchFl + 1 < FlCount ? m_flBitmap & (~0u << (searchFl + 1)) : 0;
+				if (flMap != 0)
+				{
+					searchFl = bit::tzcnt(flMap);
+					slMap    = m_slBitmaps[searchFl];
+				}
+			}
+
+			if (slMap != 0)
+			{
+				index = m_freeLists[searchFl][bit::tzcnt(slMap)];
+				break;
+			}
+		}
+
+		// Only the list the size falls into may still hold
+		// a fitting block, e.g. one spanning the whole range.
+		for (uint32_t block = m_freeLists[fl][sl]; block != InvalidBlock; block = m_blocks[block].nextFree)
+		{
+			if (m_blocks[block].size >= size)
+			{
+				index = block;
+				break;
+			}
+		}
+	} while (false);
+	return index;
+}
+
+void VltTlsfAllocator::insertFreeBlock(uint32_t index)
+{
+	Block& block = m_blocks[index];
+
+	uint32_t fl, sl;
+	mapping(block.size, fl, sl);
+
+	uint32_t head  = m_freeLists[fl][sl];
+	block.isFree   = true;
+	block.prevFree = InvalidBlock;
+	block.nextFree = head;
+
+	if (head != InvalidBlock)
+	{
+		m_blocks[head].prevFree = index;
+	}
+
+	m_freeLists[fl][sl] = index;
+	m_slBitmaps[fl] |= 1u << sl;
+	m_flBitmap |= 1u << fl;
+
+	++m_freeBlockCount;
+}
+
+void VltTlsfAllocator::removeFreeBlock(uint32_t index)
+{
+	Block& block = m_blocks[index];
+
+	uint32_t fl, sl;
+	mapping(block.size, fl, sl);
+
+	if (block.prevFree != InvalidBlock)
+	{
+		m_blocks[block.prevFree].nextFree = block.nextFree;
+	}
+	else
+	{
+		m_freeLists[fl][sl] = block.nextFree;
+	}
+
+	if (block.nextFree != InvalidBlock)
+	{
+		m_blocks[block.nextFree].prevFree = block.prevFree;
+	}
+
+	if (m_freeLists[fl][sl] == InvalidBlock)
+	{
+		m_slBitmaps[fl] &= ~(1u << sl);
+		if (m_slBitmaps[fl] == 0)
+		{
+			m_flBitmap &= ~(1u << fl);
+		}
+	}
+
+	block.isFree = false;
+	--m_freeBlockCount;
+}
+
+uint32_t VltTlsfAllocator::splitBlock(uint32_t index, uint64_t size)
+{
+	// May reallocate the block array.
+	uint32_t rest = createBlock();
+
+	Block& block = m_blocks[index];
+	Block& tail  = m_blocks[rest];
+
+	tail.offset   = block.offset + size;
+	tail.size     = block.size - size;
+	tail.prevPhys = index;
+	tail.nextPhys = block.nextPhys;
+
+	if (block.nextPhys != InvalidBlock)
+	{
+		m_blocks[block.nextPhys].prevPhys = rest;
+	}
+
+	block.size     = size;
+	block.nextPhys = rest;
+	return rest;
+}
+
+void VltTlsfAllocator::mergeBlocks(uint32_t index, uint32_t next)
+{
+	Block& block = m_blocks[index];
+	Block& tail  = m_blocks[next];
+
+	block.size    += tail.size;
+	block.nextPhys = tail.nextPhys;
+
+	if (tail.nextPhys != InvalidBlock)
+	{
+		m_blocks[tail.nextPhys].prevPhys = index;
+	}
+
+	destroyBlock(next);
+}
+
+uint32_t VltTlsfAllocator::createBlock()
+{
+	uint32_t index;
+	if (!m_unusedBlocks.empty())
+	{
+		index = m_unusedBlocks.back();
+		m_unusedBlocks.pop_back();
+	}
+	else
+	{
+		index = uint32_t(m_blocks.size());
+		m_blocks.emplace_back();
+	}
+
+	m_blocks[index] = Block{ 0, 0, InvalidBlock, InvalidBlock, InvalidBlock, InvalidBlock, false };
+	return index;
+}
+
+void VltTlsfAllocator::destroyBlock(uint32_t index)
+{
+	m_unusedBlocks.push_back(index);
+}
+
+}  // namespace vlt
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "GPCS4Common.h"
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace vlt
+{;
+
+/**
+ * \brief TLSF allocator statistics
+ */
+struct VltTlsfStats
+{
+	uint64_t capacity         = 0;
+	uint64_t usedSize         = 0;
+	uint64_t freeSize         = 0;
+	uint64_t largestFreeBlock = 0;
+	uint32_t allocCount       = 0;  // Live allocations
+	uint32_t freeBlockCount   = 0;
+
+	/**
+	 * \brief External fragmentation
+	 *
+	 * Share of free space outside the largest free
+	 * block, 0 if all free space is contiguous.
+	 * \returns Fragmentation between 0 and 1
+	 */
+	double fragmentation() const
+	{
+		return freeSize ? 1.0 - double(largestFreeBlock) / double(freeSize) : 0.0;
+	}
+};
+
+/**
+ * \brief Two-level segregated fit allocator
+ *
+ * Manages offsets into a range of \c capacity bytes,
+ * without touching the memory itself, so it has no
+ * dependency on Vulkan and runs anywhere.
+ *
+ * Free blocks are kept in lists indexed by the highest
+ * set bit of their size (first level) and the next
+ * \c SlBits bits (second level). Bitmaps of non-empty
+ * lists make finding a fitting block and freeing with
+ * coalescing O(1), independent of the allocation count.
+ *
+ * All sizes and offsets are multiples of \c Granularity.
+ * This is not thread-safe.
+ */
+class VltTlsfAllocator
+{
+	static constexpr uint32_t GranularityShift = 4;
+	static constexpr uint32_t SlBits           = 4;
+	static constexpr uint32_t SlCount          = 1u << SlBits;
+	static constexpr uint32_t FlCount          = 32;
+	static constexpr uint32_t InvalidBlock     = ~0u;
+
+public:
+	static constexpr uint64_t Granularity   = 1ull << GranularityShift;
+	static constexpr uint64_t InvalidOffset = ~0ull;
+
+	/**
+	 * \brief Creates the allocator
+	 *
+	 * \param [in] capacity Size of the managed range,
+	 *        rounded down to the granularity. At most
+	 *        4G times the granularity.
+	 */
+	VltTlsfAllocator(uint64_t capacity);
+	~VltTlsfAllocator();
+
+	/**
+	 * \brief Allocates a range
+	 *
+	 * \param [in] size Number of bytes to allocate,
+	 *        rounded up to the granularity
+	 * \param [in] align Required alignment, a power of two
+	 * \returns Offset of the range, or \c InvalidOffset
+	 *          if there is no free block large enough
+	 */
+	uint64_t alloc(uint64_t size, uint64_t align);
+
+	/**
+	 * \brief Frees a range
+	 *
+	 * Merges the range with free neighbours.
+	 * \param [in] offset Offset returned by \c alloc
+	 * \returns \c false if nothing is allocated at \c offset
+	 */
+	bool free(uint64_t offset);
+
+	/**
+	 * \brief Size of an allocated range
+	 *
+	 * \param [in] offset Offset returned by \c alloc
+	 * \returns Size in bytes, 0 if nothing is allocated there
+	 */
+	uint64_t allocSize(uint64_t offset) const;
+
+	/**
+	 * \brief Queries allocator statistics
+	 *
+	 * Finding the largest free block walks
+	 * one free list, the rest is counted.
+	 * \returns Current statistics
+	 */
+	VltTlsfStats getStats() const;
+
+	/**
+	 * \brief Checks whether nothing is allocated
+	 * \returns \c true if the whole range is free
+	 */
+	bool isEmpty() const
+	{
+		return m_usedSize == 0;
+	}
+
+private:
+	struct Block
+	{
+		uint64_t offset;
+		uint64_t size;
+		uint32_t prevPhys;
+		uint32_t nextPhys;
+		uint32_t prevFree;
+		uint32_t nextFree;
+		bool     isFree;
+	};
+
+	static void mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+
+	uint32_t findFreeBlock(uint64_t size);
+
+	void insertFreeBlock(uint32_t index);
+
+	void removeFreeBlock(uint32_t index);
+
+	uint32_t splitBlock(uint32_t index, uint64_t size);
+
+	void mergeBlocks(uint32_t index, uint32_t next);
+
+	uint32_t createBlock();
+
+	void destroyBlock(uint32_t index);
+
+private:
+	uint64_t m_capacity;
+	uint64_t m_usedSize       = 0;
+	uint32_t m_freeBlockCount = 0;
+
+	std::vector<Block>    m_blocks;
+	std::vector<uint32_t> m_unusedBlocks;
+
+	// Allocated blocks by offset
+	std::unordered_map<uint64_t, uint32_t> m_allocated;
+
+	uint32_t                                          m_flBitmap = 0;
+	std::array<uint32_t, FlCount>                     m_slBitmaps;
+	std::array<std::array<uint32_t, SlCount>, FlCount> m_freeLists;
+};
+
+}  // namespace vlt
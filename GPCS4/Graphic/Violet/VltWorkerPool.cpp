@@ -0,0 +1,115 @@
+#include "VltWorkerPool.h"
+
+#include <algorithm>
+
+LOG_CHANNEL(Graphic.Violet.VltWorkerPool);
+
+namespace vlt
+{;
+
+VltWorkerPool::VltWorkerPool(uint32_t workerCount)
+{
+	for (uint32_t i = 0; i != workerCount; ++i)
+	{
+		m_workers.emplace_back(&VltWorkerPool::runWorker, this);
+	}
+}
+
+VltWorkerPool::~VltWorkerPool()
+{
+	stop();
+}
+
+VltWorkerPoolStats VltWorkerPool::getStats()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
+
+void VltWorkerPool::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopped = true;
+	}
+
+	m_cond.notify_all();
+
+	for (auto& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+}
+
+uint32_t VltWorkerPool::defaultWorkerCount()
+{
+	return std::max(2u, std::thread::hardware_concurrency() / 4);
+}
+
+void VltWorkerPool::enqueue(std::function<void()>&& func)
+{
+	bool stopped = false;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		stopped = m_stopped;
+		if (!stopped)
+		{
+			m_jobs.push({ std::move(func), Clock::now() });
+
+			++m_stats.submitCount;
+			m_stats.queueDepth    = uint32_t(m_jobs.size());
+			m_stats.maxQueueDepth = std::max(m_stats.maxQueueDepth, m_stats.queueDepth);
+		}
+	}
+
+	if (stopped)
+	{
+		// No worker left to run it.
+		func();
+	}
+	else
+	{
+		m_cond.notify_one();
+	}
+}
+
+void VltWorkerPool::runWorker()
+{
+	while (true)
+	{
+		Job job;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cond.wait(lock, [this]() { return m_stopped || !m_jobs.empty(); });
+
+			// Queued jobs are still run on shutdown, so
+			// nobody waits on a future which is never set.
+			if (m_jobs.empty())
+			{
+				break;
+			}
+
+			job = std::move(m_jobs.front());
+			m_jobs.pop();
+
+			m_stats.queueDepth = uint32_t(m_jobs.size());
+		}
+
+		job.func();
+
+		auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+			Clock::now() - job.submitTime);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		++m_stats.completeCount;
+		m_stats.totalLatencyUs += latency.count();
+		m_stats.maxLatencyUs = std::max<uint64_t>(m_stats.maxLatencyUs, latency.count());
+	}
+}
+
+}  // namespace vlt
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "VltCommon.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace vlt
+{;
+
+/**
+ * \brief Worker pool statistics
+ */
+struct VltWorkerPoolStats
+{
+	uint64_t submitCount    = 0;
+	uint64_t completeCount  = 0;
+	uint32_t queueDepth     = 0;  // Jobs waiting for a worker
+	uint32_t maxQueueDepth  = 0;
+	uint64_t totalLatencyUs = 0;  // Submit to completion, summed over all jobs
+	uint64_t maxLatencyUs   = 0;
+};
+
+/**
+ * \brief Background worker pool
+ *
+ * Runs compile jobs off the thread which replays
+ * command buffers. Every submitted job returns a
+ * future the caller can either wait on or poll.
+ */
+class VltWorkerPool
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+public:
+	VltWorkerPool(uint32_t workerCount);
+	~VltWorkerPool();
+
+	/**
+	 * \brief Submits a job
+	 *
+	 * \param [in] fn The job to run on a worker
+	 * \returns Future holding the job's result
+	 */
+	template <typename Fn>
+	auto submit(Fn&& fn) -> std::shared_future<decltype(fn())>
+	{
+		using Result = decltype(fn());
+
+		auto task   = std::make_shared<std::packaged_task<Result()>>(std::forward<Fn>(fn));
+		auto future = task->get_future().share();
+
+		enqueue([task]() { (*task)(); });
+		return future;
+	}
+
+	/**
+	 * \brief Queries pool statistics
+	 * \returns Queue depth and latency counters
+	 */
+	VltWorkerPoolStats getStats();
+
+	/**
+	 * \brief Stops the workers
+	 *
+	 * Runs the jobs still queued, then joins the workers.
+	 * Jobs submitted after that run on the calling thread.
+	 * Called by the destructor.
+	 */
+	void stop();
+
+	/**
+	 * \brief Default worker count
+	 *
+	 * Leaves most cores to the game and
+	 * the command buffer replay threads.
+	 */
+	static uint32_t defaultWorkerCount();
+
+private:
+	struct Job
+	{
+		std::function<void()> func;
+		Clock::time_point     submitTime;
+	};
+
+	void enqueue(std::function<void()>&& func);
+
+	void runWorker();
+
+private:
+	std::mutex              m_mutex;
+	std::condition_variable m_cond;
+	std::queue<Job>         m_jobs;
+	bool                    m_stopped = false;
+
+	VltWorkerPoolStats m_stats;
+
+	std::vector<std::thread> m_workers;
+};
+
+}  // namespace vlt
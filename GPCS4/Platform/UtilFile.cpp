@@ -76,11 +76,125 @@ bool StoreFile(const std::string& strFilename, const std::vector<uint8_t>& vtDat
 #include <Windows.h>
 #undef WIN32_LEAN_AND_MEAN
 
+const void* MapFile(const std::string& strFilename, size_t* pSize)
+{
+	const void* pData    = nullptr;
+	HANDLE      hFile    = INVALID_HANDLE_VALUE;
+	HANDLE      hMapping = NULL;
+	do
+	{
+		if (strFilename.empty() || !pSize)
+		{
+			break;
+		}
+
+		hFile = CreateFileA(strFilename.c_str(), GENERIC_READ,
+							FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+							OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (hFile == INVALID_HANDLE_VALUE)
+		{
+			break;
+		}
 
+		LARGE_INTEGER fileSize = {};
+		if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart == 0)
+		{
+			break;
+		}
 
+		hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (hMapping == NULL)
+		{
+			break;
+		}
+
+		pData = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+		if (!pData)
+		{
+			break;
+		}
+
+		*pSize = (size_t)fileSize.QuadPart;
+	} while (false);
+
+	// The view keeps a reference to the file,
+	// so the handles are no longer needed.
+	if (hMapping != NULL)
+	{
+		CloseHandle(hMapping);
+	}
+
+	if (hFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(hFile);
+	}
+
+	return pData;
+}
+
+void UnmapFile(const void* pData, size_t nSize)
+{
+	if (pData)
+	{
+		UnmapViewOfFile(pData);
+	}
+}
 
 #else
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const void* MapFile(const std::string& strFilename, size_t* pSize)
+{
+	const void* pData = nullptr;
+	int fd            = -1;
+	do
+	{
+		if (strFilename.empty() || !pSize)
+		{
+			break;
+		}
+
+		fd = open(strFilename.c_str(), O_RDONLY);
+		if (fd == -1)
+		{
+			break;
+		}
+
+		struct stat st = {};
+		if (fstat(fd, &st) != 0 || st.st_size == 0)
+		{
+			break;
+		}
+
+		void* pMapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (pMapped == MAP_FAILED)
+		{
+			break;
+		}
+
+		pData  = pMapped;
+		*pSize = (size_t)st.st_size;
+	} while (false);
+
+	if (fd != -1)
+	{
+		close(fd);
+	}
+
+	return pData;
+}
+
+void UnmapFile(const void* pData, size_t nSize)
+{
+	if (pData)
+	{
+		munmap(const_cast<void*>(pData), nSize);
+	}
+}
 
 #endif  //GPCS4_WINDOWS
 
@@ -17,6 +17,12 @@ bool StoreFile(const std::string& strFilename, const std::vector<uint8_t>& vtDat
 
 bool StoreFile(const std::string& strFilename, const void* pBuffer, uint32_t nSize);
 
+// Map the whole file into memory, read only.
+// Returns nullptr if the file doesn't exist or is empty.
+const void* MapFile(const std::string& strFilename, size_t* pSize);
+
+void UnmapFile(const void* pData, size_t nSize);
+
 struct FileCloser
 {
 	void operator()(FILE *fp) const noexcept
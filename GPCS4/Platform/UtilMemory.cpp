@@ -4,6 +4,10 @@
 #include <vector>
 #include <algorithm>
 
+#ifdef GPCS4_LINUX
+#include <sys/mman.h>
+#endif  // GPCS4_LINUX
+
 LOG_CHANNEL(Platform.UtilMemory);
 
 namespace UtilMemory
@@ -209,8 +213,8 @@ void VMUnMap(void* pAddr, size_t nSize)
 
 bool VMProtect(void* pAddr, size_t nSize, uint32_t nProtectFlag)
 {
-	LOG_FIXME("Not Implemented.");
-	return  true;
+	DWORD oldProtect = 0;
+	return VirtualProtect(pAddr, nSize, GetProtectFlag(nProtectFlag), &oldProtect) != FALSE;
 }
 
 int VMQueryProtection(void* addr, void** start, void** end, uint32_t* prot)
@@ -238,5 +242,32 @@ int VMQueryProtection(void* addr, void** start, void** end, uint32_t* prot)
 
 //TODO: Other platform implementation 
 
+inline int GetProtectFlag(uint32_t nOldFlag)
+{
+	int nNewFlag = PROT_NONE;
+
+	if ((nOldFlag & VMPF_CPU_READ) || (nOldFlag & VMPF_GPU_READ))
+	{
+		nNewFlag |= PROT_READ;
+	}
+
+	if ((nOldFlag & VMPF_CPU_WRITE) || (nOldFlag & VMPF_GPU_WRITE))
+	{
+		nNewFlag |= PROT_READ | PROT_WRITE;
+	}
+
+	if (nOldFlag & VMPF_CPU_EXEC)
+	{
+		nNewFlag |= PROT_EXEC;
+	}
+
+	return nNewFlag;
+}
+
+bool VMProtect(void* pAddr, size_t nSize, uint32_t nProtectFlag)
+{
+	return mprotect(pAddr, nSize, GetProtectFlag(nProtectFlag)) == 0;
+}
+
 #endif  //GPCS4_WINDOWS
 }
\ No newline at end of file
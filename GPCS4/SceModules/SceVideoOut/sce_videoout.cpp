@@ -219,14 +219,29 @@ int PS4API sceVideoOutGetEventData(void)
 
 int PS4API sceVideoOutGetFlipStatus(int32_t handle, SceVideoOutFlipStatus *status)
 {
-	LOG_SCE_GRAPHIC("Dummy Implementation");
+	LOG_SCE_GRAPHIC("handle %d", handle);
+	int ret = SCE_VIDEO_OUT_ERROR_INVALID_HANDLE;
+	do
+	{
+		std::shared_ptr<sce::SceGnmDriver> gnmDriver = getGnmDriver(handle);
+		if (!gnmDriver)
+		{
+			break;
+		}
 
-	static uint64_t sCount = 1;
+		sce::SceFlipStatus flipStatus = {};
+		gnmDriver->getFlipStatus(flipStatus);
 
-	*status = {};
-	status->count = sCount++;
+		*status                = {};
+		status->count          = flipStatus.count;
+		status->flipArg        = flipStatus.flipArg;
+		status->currentBuffer  = flipStatus.currentBuffer;
+		status->flipPendingNum = flipStatus.pendingCount;
+		status->gcQueueNum     = flipStatus.gpuQueueCount;
 
-	return SCE_OK;
+		ret = SCE_OK;
+	} while (false);
+	return ret;
 }
 
 
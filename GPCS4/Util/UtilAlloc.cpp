@@ -0,0 +1,70 @@
+#include "UtilAlloc.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifdef GPCS4_COUNT_ALLOCATIONS
+
+static thread_local uint64_t g_threadAllocCount = 0;
+
+void* operator new(size_t nSize)
+{
+	++g_threadAllocCount;
+
+	void* pData = std::malloc(nSize ? nSize : 1);
+	if (!pData)
+	{
+		throw std::bad_alloc();
+	}
+	return pData;
+}
+
+void* operator new[](size_t nSize)
+{
+	return operator new(nSize);
+}
+
+void operator delete(void* pData) noexcept
+{
+	std::free(pData);
+}
+
+void operator delete[](void* pData) noexcept
+{
+	std::free(pData);
+}
+
+void operator delete(void* pData, size_t) noexcept
+{
+	std::free(pData);
+}
+
+void operator delete[](void* pData, size_t) noexcept
+{
+	std::free(pData);
+}
+
+#endif  // GPCS4_COUNT_ALLOCATIONS
+
+namespace UtilAlloc
+{;
+
+uint64_t GetThreadAllocCount()
+{
+#ifdef GPCS4_COUNT_ALLOCATIONS
+	return g_threadAllocCount;
+#else
+	return 0;
+#endif  // GPCS4_COUNT_ALLOCATIONS
+}
+
+bool IsAllocCountEnabled()
+{
+#ifdef GPCS4_COUNT_ALLOCATIONS
+	return true;
+#else
+	return false;
+#endif  // GPCS4_COUNT_ALLOCATIONS
+}
+
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "GPCS4Config.h"
+
+#include <cstdint>
+
+namespace UtilAlloc
+{;
+
+// Number of heap allocations made by the calling thread so far.
+// Only counted when GPCS4_COUNT_ALLOCATIONS is defined, otherwise always 0.
+uint64_t GetThreadAllocCount();
+
+// Whether allocations are counted in this build.
+bool IsAllocCountEnabled();
+
+}
@@ -0,0 +1,145 @@
+#include "GnmCmdStreamBench.h"
+#include "GnmDetileBench.h"
+#include "GnmMemoryTrackerBench.h"
+#include "PsslShaderBench.h"
+#include "SpirvModuleBench.h"
+#include "SpirvOptimizerReport.h"
+#include "VltTlsfBench.h"
+#include "Graphic/SpirV/SpirvOptimizer.h"
+
+#include <cxxopts/cxxopts.hpp>
+
+LOG_CHANNEL(Bench);
+
+cxxopts::ParseResult processCommandLine(int argc, char* argv[])
+{
+	cxxopts::Options opts("GPCS4Bench", "GPCS4 offline checks and benchmarks. Each one runs on the CPU only and exits with 1 if its check fails.");
+	opts.add_options()
+		("D,debug-channel", "Enable debug channel. 'ALL' for all channels.", cxxopts::value<std::vector<std::string>>())
+		("L,list-channels", "List debug channels.")
+		("detile-bench", "Check and benchmark surface detiling on 1080p and 4K surfaces.")
+		("write-tracker-bench", "Check and benchmark guest memory write tracking.")
+		("tlsf-bench", "Check and benchmark the memory chunk sub-allocator.")
+		("spirv-module-bench", "Check and benchmark SPIR-V type and constant lookup.")
+		("pm4-bench", "Check and benchmark PM4 command buffer decoding. Uses a folder of raw .pm4 command buffers if given, generated ones otherwise.", cxxopts::value<std::string>()->implicit_value(""))
+		("spirv-opt", "Set SPIR-V optimizer passes for --shader-bench, 'all', 'none' or a list of forward,dse,bitcast,const.", cxxopts::value<std::string>()->default_value("none"))
+		("spirv-opt-report", "Report instruction count reduction of each SPIR-V optimizer pass on a folder of .spv shaders dumped without optimizer passes.", cxxopts::value<std::string>())
+		("shader-bench", "Compile a folder of .gcn shader captures and report per-stage timings.", cxxopts::value<std::string>())
+		("shader-bench-iterations", "Set compile iterations per shader, the fastest one is reported.", cxxopts::value<uint32_t>()->default_value("5"))
+		("shader-bench-output", "Write shader benchmark results to a JSON file.", cxxopts::value<std::string>())
+		("shader-bench-baseline", "Compare shader benchmark results against a JSON file, fail on regressions.", cxxopts::value<std::string>())
+		("shader-bench-tolerance", "Set allowed growth against the baseline, in percent.", cxxopts::value<double>()->default_value("10"))
+		("H,help", "Print help message.")
+		;
+
+	const uint32_t argCount = argc;
+
+	auto optResult = opts.parse(argc, argv);
+	if (optResult.count("H") || argCount < 2)
+	{
+		auto helpString = opts.help();
+		printf("%s\n", helpString.c_str());
+		exit(-1);
+	}
+
+	return optResult;
+}
+
+bool runShaderBench(const cxxopts::ParseResult& optResult)
+{
+	bool ret = false;
+	do
+	{
+		auto passList = optResult["spirv-opt"].as<std::string>();
+
+		pssl::SpirvOptimizerPasses passes;
+		if (!pssl::SpirvOptimizer::parsePasses(passList, passes))
+		{
+			LOG_ERR("unknown SPIR-V optimizer pass in %s.", passList.c_str());
+			break;
+		}
+
+		pssl::SpirvOptimizer::setDefaultPasses(passes);
+
+		auto path       = optResult["shader-bench"].as<std::string>();
+		auto iterations = optResult["shader-bench-iterations"].as<uint32_t>();
+
+		pssl::PsslShaderBench bench(iterations);
+		if (!bench.loadCorpus(path))
+		{
+			LOG_ERR("no shader captures found in %s.", path.c_str());
+			break;
+		}
+
+		bench.run();
+		bench.printReport();
+
+		if (optResult.count("shader-bench-output") &&
+			!bench.storeResults(optResult["shader-bench-output"].as<std::string>()))
+		{
+			break;
+		}
+
+		if (optResult.count("shader-bench-baseline"))
+		{
+			auto baseline  = optResult["shader-bench-baseline"].as<std::string>();
+			auto tolerance = optResult["shader-bench-tolerance"].as<double>() / 100.0;
+
+			if (!bench.compareBaseline(baseline, tolerance))
+			{
+				break;
+			}
+		}
+
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+int main(int argc, char* argv[])
+{
+	auto optResult = processCommandLine(argc, argv);
+
+	logsys::init(optResult);
+
+	const uint32_t iterations = 10;
+	bool           passed     = true;
+
+	if (optResult.count("detile-bench"))
+	{
+		passed &= GpuAddress::runDetileBench(iterations);
+	}
+
+	if (optResult.count("write-tracker-bench"))
+	{
+		passed &= runMemoryTrackerBench(iterations);
+	}
+
+	if (optResult.count("tlsf-bench"))
+	{
+		passed &= vlt::runTlsfBench(iterations);
+	}
+
+	if (optResult.count("spirv-module-bench"))
+	{
+		passed &= pssl::runSpirvModuleBench(iterations);
+	}
+
+	if (optResult.count("pm4-bench"))
+	{
+		passed &= runCmdStreamBench(optResult["pm4-bench"].as<std::string>(), iterations);
+	}
+
+	if (optResult.count("spirv-opt-report"))
+	{
+		pssl::reportSpirvOptimizer(optResult["spirv-opt-report"].as<std::string>());
+	}
+
+	if (optResult.count("shader-bench"))
+	{
+		// The exit code tells CI whether it regressed.
+		passed &= runShaderBench(optResult);
+	}
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,421 @@
+#include "GnmCmdStreamBench.h"
+#include "Graphic/Gnm/GnmCmdStream.h"
+#include "Graphic/Gnm/GnmCommandBufferDummy.h"
+#include "Graphic/Gnm/GnmGfx9MePm4Packets.h"
+#include "Graphic/Gnm/GnmStructure.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+LOG_CHANNEL(Graphic.Gnm.GnmCmdStreamBench);
+
+namespace fs = std::filesystem;
+
+using GnmCmdBufferData = std::vector<uint32_t>;
+
+/**
+ * \brief Recording command buffer
+ *
+ * Logs the arguments of common Gnm calls and never
+ * touches guest memory, so dumped command buffers
+ * can be executed without the game.
+ */
+class GnmCommandBufferRecorder : public GnmCommandBufferDummy
+{
+public:
+	void clear()
+	{
+		m_calls.clear();
+	}
+
+	const std::vector<uint64_t>& calls() const
+	{
+		return m_calls;
+	}
+
+	virtual void setVsShader(const pssl::VsStageRegisters* vsRegs, uint32_t shaderModifier) override
+	{
+		log(1, shaderModifier);
+	}
+
+	virtual void setVsharpInUserData(ShaderStage stage, uint32_t startUserDataSlot, const GnmBuffer* buffer) override
+	{
+		log(2, (uint64_t(stage) << 32) | startUserDataSlot, uint64_t(buffer));
+	}
+
+	virtual void setPointerInUserData(ShaderStage stage, uint32_t startUserDataSlot, void* gpuAddr) override
+	{
+		log(3, (uint64_t(stage) << 32) | startUserDataSlot, uint64_t(gpuAddr));
+	}
+
+	virtual void setRenderTargetMask(uint32_t mask) override
+	{
+		log(4, mask);
+	}
+
+	virtual void setBlendControl(uint32_t rtSlot, BlendControl blendControl) override
+	{
+		log(5, rtSlot, blendControl.m_reg);
+	}
+
+	virtual void drawIndexAuto(uint32_t indexCount, DrawModifier modifier) override
+	{
+		log(6, indexCount);
+	}
+
+	virtual void drawIndexAuto(uint32_t indexCount) override
+	{
+		log(6, indexCount);
+	}
+
+	virtual void writeAtEndOfPipe(EndOfPipeEventType eventType, EventWriteDest dstSelector, void* dstGpuAddr, EventWriteSource srcSelector, uint64_t immValue, CacheAction cacheAction, CachePolicy cachePolicy) override
+	{
+		log(7, eventType, immValue);
+	}
+
+	virtual void writeAtEndOfPipeWithInterrupt(EndOfPipeEventType eventType, EventWriteDest dstSelector, void* dstGpuAddr, EventWriteSource srcSelector, uint64_t immValue, CacheAction cacheAction, CachePolicy cachePolicy) override
+	{
+		log(7, eventType, immValue);
+	}
+
+	virtual void writeReleaseMemEventWithInterrupt(ReleaseMemEventType eventType, EventWriteDest dstSelector, void* dstGpuAddr, EventWriteSource srcSelector, uint64_t immValue, CacheAction cacheAction, CachePolicy writePolicy) override
+	{
+		log(8, eventType, immValue);
+	}
+
+	virtual void writeReleaseMemEvent(ReleaseMemEventType eventType, EventWriteDest dstSelector, void* dstGpuAddr, EventWriteSource srcSelector, uint64_t immValue, CacheAction cacheAction, CachePolicy writePolicy) override
+	{
+		log(8, eventType, immValue);
+	}
+
+	virtual void prepareFlip(void* labelAddr, uint32_t value) override
+	{
+		log(9, value);
+	}
+
+	virtual void prepareFlipWithEopInterrupt(EndOfPipeEventType eventType, void* labelAddr, uint32_t value, CacheAction cacheAction) override
+	{
+		log(9, value);
+	}
+
+private:
+	void log(uint64_t call, uint64_t arg0, uint64_t arg1 = 0)
+	{
+		m_calls.push_back(call);
+		m_calls.push_back(arg0);
+		m_calls.push_back(arg1);
+	}
+
+private:
+	std::vector<uint64_t> m_calls;
+};
+
+// Writes packets the way libSceGnmDriver and our private packets lay them out.
+class GnmCmdBufferWriter
+{
+public:
+	GnmCmdBufferWriter(GnmCmdBufferData& data) :
+		m_data(data)
+	{
+	}
+
+	void nopHint(uint32_t hint)
+	{
+		m_data.push_back(PM4_HEADER_BUILD(2, IT_NOP, 0));
+		m_data.push_back(hint);
+	}
+
+	void setShRegPointer(uint32_t regOffset, uint64_t pointer)
+	{
+		m_data.push_back(PM4_HEADER_BUILD(4, IT_SET_SH_REG, 0));
+		m_data.push_back(regOffset);
+		m_data.push_back(uint32_t(pointer));
+		m_data.push_back(uint32_t(pointer >> 32));
+	}
+
+	void setContextReg(uint32_t regOffset, uint32_t value)
+	{
+		m_data.push_back(PM4_HEADER_BUILD(3, IT_SET_CONTEXT_REG, 0));
+		m_data.push_back(regOffset);
+		m_data.push_back(value);
+	}
+
+	template <typename T>
+	T* privatePacket(IT_OpCodePriv priv)
+	{
+		const uint32_t paramSize = sizeof(T) / sizeof(uint32_t);
+
+		size_t offset = m_data.size();
+		m_data.resize(offset + paramSize, 0);
+		m_data[offset] = PM4_HEADER_BUILD(paramSize, IT_GNM_PRIVATE, priv);
+		return reinterpret_cast<T*>(&m_data[offset]);
+	}
+
+	void type2Nop()
+	{
+		m_data.push_back(0x80000000);
+	}
+
+	void eop(uint32_t value)
+	{
+		PM4_ME_EVENT_WRITE_EOP packet = {};
+		packet.ordinal1               = PM4_HEADER_BUILD(sizeof(packet) / sizeof(uint32_t), IT_EVENT_WRITE_EOP, 0);
+		packet.ordinal2               = kEopFlushCbDbCaches + 0x500;
+		packet.dataSel                = kEventWriteSource32BitsImmediate;
+		packet.dataLo                 = value;
+
+		const uint32_t* dwords = reinterpret_cast<const uint32_t*>(&packet);
+		m_data.insert(m_data.end(), dwords, dwords + sizeof(packet) / sizeof(uint32_t));
+	}
+
+	void prepareFlip(uint32_t value)
+	{
+		m_data.push_back(PM4_HEADER_BUILD(7, IT_NOP, 0));
+		m_data.push_back(OP_HINT_PREPARE_FLIP_LABEL);
+		m_data.push_back(0x1000);
+		m_data.push_back(0);
+		m_data.push_back(value);
+		m_data.push_back(0);
+		m_data.push_back(0);
+	}
+
+private:
+	GnmCmdBufferData& m_data;
+};
+
+// A frame of draws, each setting shader, resources and state like games do.
+static GnmCmdBufferData generateCmdBuffer(uint32_t frame, uint32_t drawCount)
+{
+	GnmCmdBufferData   data;
+	GnmCmdBufferWriter writer(data);
+
+	for (uint32_t draw = 0; draw != drawCount; ++draw)
+	{
+		auto vsShader      = writer.privatePacket<GnmCmdVSShader>(OP_PRIV_SET_VS_SHADER);
+		vsShader->modifier = draw % 7;
+
+		writer.nopHint(OP_HINT_SET_VSHARP_IN_USER_DATA);
+		writer.setShRegPointer(0x4C + draw % 4, 0x100000000ull + draw * 0x40);
+		writer.setShRegPointer(0x4C + 8, 0x200000000ull + frame * 0x1000 + draw);
+
+		writer.setContextReg(OP_HINT_SET_RENDER_TARGET_MASK, 0xF);
+		writer.setContextReg(0x1E0 + draw % 8, draw);
+		// Registers the parser ignores, common in real command buffers.
+		writer.setContextReg(OP_HINT_SET_CLIP_CONTROL, 0);
+		writer.setContextReg(OP_HINT_SET_LINE_WIDTH, 8);
+		writer.type2Nop();
+
+		auto drawPacket        = writer.privatePacket<GnmCmdDrawIndexAuto>(OP_PRIV_DRAW_INDEX_AUTO);
+		drawPacket->indexCount = 3 * (draw + 1);
+	}
+
+	writer.eop(frame);
+	writer.prepareFlip(frame);
+	return data;
+}
+
+static bool loadCmdBuffers(const std::string& path, std::vector<GnmCmdBufferData>& cmdBuffers)
+{
+	bool ret = false;
+	do
+	{
+		std::error_code ec;
+		if (!fs::is_directory(path, ec))
+		{
+			printf("%s is not a folder.\n", path.c_str());
+			break;
+		}
+
+		for (const auto& entry : fs::directory_iterator(path, ec))
+		{
+			if (entry.path().extension() != ".pm4")
+			{
+				continue;
+			}
+
+			std::ifstream    file(entry.path(), std::ios::binary);
+			GnmCmdBufferData data(entry.file_size() / sizeof(uint32_t));
+			if (data.empty() || !file.read(reinterpret_cast<char*>(data.data()), data.size() * sizeof(uint32_t)))
+			{
+				LOG_WARN("skip unreadable command buffer %s", entry.path().string().c_str());
+				continue;
+			}
+			cmdBuffers.push_back(std::move(data));
+		}
+
+		if (cmdBuffers.empty())
+		{
+			printf("No .pm4 command buffers in %s.\n", path.c_str());
+			break;
+		}
+
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+// Executes all command buffers a number of frames, like a game cycling through them.
+static void runFrames(
+	GnmCmdStream&                        stream,
+	GnmCommandBufferRecorder&            recorder,
+	const std::vector<GnmCmdBufferData>& cmdBuffers,
+	uint32_t                             frameCount)
+{
+	for (uint32_t frame = 0; frame != frameCount; ++frame)
+	{
+		const auto& data = cmdBuffers[frame % cmdBuffers.size()];
+		recorder.clear();
+		stream.processCommandBuffer(data.data(), uint32_t(data.size() * sizeof(uint32_t)));
+	}
+}
+
+constexpr uint32_t GeneratedCmdBufferCount = 3;  // Ring of command buffers a game cycles
+constexpr uint32_t GeneratedDrawCount      = 2000;
+
+static bool runCorrectnessCheck(const std::vector<GnmCmdBufferData>& cmdBuffers, bool generated)
+{
+	bool ret = false;
+	do
+	{
+		GnmCommandBufferRecorder recorder;
+		GnmCmdStream             stream;
+		stream.attachCommandBuffer(&recorder);
+
+		// Own copy, it is changed below.
+		std::vector<GnmCmdBufferData> copies = cmdBuffers;
+
+		bool callsMatch = true;
+		for (auto& data : copies)
+		{
+			uint32_t size     = uint32_t(data.size() * sizeof(uint32_t));
+			auto     original = data;
+
+			recorder.clear();
+			stream.processCommandBuffer(data.data(), size);
+			auto expected = recorder.calls();
+
+			recorder.clear();
+			stream.processCommandBuffer(data.data(), size);
+			callsMatch &= recorder.calls() == expected;
+
+			// Executing must leave the command buffer unchanged.
+			callsMatch &= data == original;
+		}
+
+		if (!callsMatch)
+		{
+			printf("MISMATCH: Gnm calls differ when executing a command buffer again.\n");
+			break;
+		}
+
+		if (generated)
+		{
+			auto&    data = copies.front();
+			uint32_t size = uint32_t(data.size() * sizeof(uint32_t));
+
+			const uint32_t drawHeader = PM4_HEADER_BUILD(sizeof(GnmCmdDrawIndexAuto) / sizeof(uint32_t),
+														 IT_GNM_PRIVATE, OP_PRIV_DRAW_INDEX_AUTO);
+			auto drawPacket = std::find(data.begin(), data.end(), drawHeader);
+			drawPacket[1]   = 12345;
+
+			recorder.clear();
+			stream.processCommandBuffer(data.data(), size);
+
+			const auto& calls = recorder.calls();
+			if (std::find(calls.begin(), calls.end(), 12345) == calls.end())
+			{
+				printf("MISMATCH: changed draw argument was not seen.\n");
+				break;
+			}
+
+			// A 1 dword NOP replaced by the first dword of
+			// a 2 dword NOP swallowing the draw packet header.
+			auto nopPacket = std::find(data.begin(), data.end(), 0x80000000u);
+			*nopPacket     = PM4_HEADER_BUILD(2, IT_NOP, 0);
+
+			recorder.clear();
+			stream.processCommandBuffer(data.data(), size);
+
+			uint32_t drawCount = 0;
+			for (size_t i = 0; i < recorder.calls().size(); i += 3)
+			{
+				drawCount += recorder.calls()[i] == 6;
+			}
+
+			if (drawCount != GeneratedDrawCount - 1)
+			{
+				printf("MISMATCH: changed packets were not decoded again.\n");
+				break;
+			}
+		}
+
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+bool runCmdStreamBench(const std::string& path, uint32_t iterations)
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	constexpr uint32_t FrameCount = 60;
+
+	bool ret = false;
+	do
+	{
+		std::vector<GnmCmdBufferData> cmdBuffers;
+		bool                          generated = path.empty();
+		if (generated)
+		{
+			for (uint32_t i = 0; i != GeneratedCmdBufferCount; ++i)
+			{
+				cmdBuffers.push_back(generateCmdBuffer(i, GeneratedDrawCount));
+			}
+		}
+		else if (!loadCmdBuffers(path, cmdBuffers))
+		{
+			break;
+		}
+
+		if (!runCorrectnessCheck(cmdBuffers, generated))
+		{
+			break;
+		}
+
+		size_t totalSize = 0;
+		for (const auto& data : cmdBuffers)
+		{
+			totalSize += data.size() * sizeof(uint32_t);
+		}
+
+		printf("Gnm calls match, %zu command buffers, %zu KB, best of %u iterations over %u frames.\n",
+			   cmdBuffers.size(), totalSize >> 10, iterations, FrameCount);
+
+		double   bestTime    = 1e30;
+		uint64_t packetCount = 0;
+		for (uint32_t i = 0; i != iterations; ++i)
+		{
+			GnmCommandBufferRecorder recorder;
+			GnmCmdStream             stream;
+			stream.attachCommandBuffer(&recorder);
+
+			auto begin = Clock::now();
+			runFrames(stream, recorder, cmdBuffers, FrameCount);
+			auto end = Clock::now();
+
+			bestTime    = std::min(bestTime, std::chrono::duration<double, std::milli>(end - begin).count());
+			packetCount = stream.getStats().packetCount;
+		}
+
+		printf("decode and execute: %8.3f ms (%6.2f ns/packet, %.2f ms/frame)\n",
+			   bestTime,
+			   bestTime * 1e6 / double(packetCount),
+			   bestTime / FrameCount);
+
+		ret = true;
+	} while (false);
+	return ret;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Graphic/Gnm/GnmCommon.h"
+
+#include <string>
+
+/**
+ * \brief PM4 command stream benchmark
+ *
+ * Checks that command buffers make the same Gnm calls
+ * every time they are executed, and that changed content
+ * is seen. Then measures time per packet of decoding and
+ * executing them. Runs on the CPU only.
+ * \param [in] path Folder of raw .pm4 command buffer dumps,
+ *                  generated command buffers are used if empty
+ * \param [in] iterations Runs per case, the fastest is reported
+ * \returns \c false if the Gnm calls differ
+ */
+bool runCmdStreamBench(const std::string& path, uint32_t iterations);
@@ -0,0 +1,148 @@
+#include "GnmDetileBench.h"
+#include "Graphic/Gnm/GpuAddress/GnmDetileEngine.h"
+#include "Graphic/Gnm/GpuAddress/GnmGpuAddress.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+
+LOG_CHANNEL(Graphic.Gnm.GpuAddress);
+
+namespace GpuAddress
+{;
+
+struct DetileBenchCase
+{
+	const char*  name;
+	DetileKernel kernel;
+	uint32_t     threadCount;  // 0 for all detile threads
+};
+
+static const DetileBenchCase g_benchCases[] =
+{
+	{ "scalar",  DetileKernel::Scalar, 1 },
+	{ "sse2",    DetileKernel::Sse2,   1 },
+	{ "avx2",    DetileKernel::Avx2,   1 },
+	{ "auto-mt", DetileKernel::Auto,   0 },
+};
+
+static const char* getKernelName(DetileKernel kernel)
+{
+	const char* name = "auto";
+	switch (kernel)
+	{
+	case DetileKernel::Scalar: name = "scalar"; break;
+	case DetileKernel::Sse2:   name = "sse2";   break;
+	case DetileKernel::Avx2:   name = "avx2";   break;
+	default:
+		break;
+	}
+	return name;
+}
+
+// Tiled data must be 16 byte aligned for the kernels to be used.
+static uint8_t* alignPointer(std::vector<uint8_t>& buffer)
+{
+	return reinterpret_cast<uint8_t*>((uintptr_t(buffer.data()) + 63) & ~uintptr_t(63));
+}
+
+bool runDetileBench(uint32_t iterations)
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	const uint32_t sizes[][2]         = { { 1920, 1080 }, { 3840, 2160 } };
+	const uint32_t bitsPerElements[] = { 8, 16, 32, 64, 128 };
+	const TileMode tileModes[]       = { kTileModeThin_1dThin, kTileModeThin_2dThin };
+
+	auto engine = DetileEngine::GetInstance();
+	iterations  = std::max(iterations, 1u);
+
+	printf("best of %u iterations, %u detile threads.\n", iterations, engine->getThreadCount());
+
+	bool match = true;
+	for (TileMode tileMode : tileModes)
+	{
+		for (const auto& size : sizes)
+		{
+			for (uint32_t bitsPerElement : bitsPerElements)
+			{
+				TilingParameters tp       = {};
+				tp.m_tileMode             = tileMode;
+				tp.m_minGpuMode           = kGpuModeBase;
+				tp.m_linearWidth          = size[0];
+				tp.m_linearHeight         = size[1];
+				tp.m_linearDepth          = 1;
+				tp.m_numFragmentsPerPixel = 1;
+				tp.m_bitsPerFragment      = bitsPerElement;
+				tp.m_surfaceFlags.m_value = 0;
+				tp.m_surfaceFlags.m_texture = 1;
+
+				SurfaceInfo surfInfo = {};
+				if (computeSurfaceInfo(&surfInfo, &tp) != kStatusSuccess)
+				{
+					LOG_ERR("failed to compute surface info of %ux%u %ubpp.", size[0], size[1], bitsPerElement);
+					match = false;
+					continue;
+				}
+
+				uint64_t linearSize = uint64_t(size[0]) * size[1] * bitsPerElement / 8;
+
+				std::vector<uint8_t> tiledBuffer(surfInfo.m_surfaceSize + 64);
+				std::vector<uint8_t> refBuffer(linearSize + 64);
+				std::vector<uint8_t> outBuffer(linearSize + 64);
+
+				uint8_t* tiled = alignPointer(tiledBuffer);
+				uint8_t* ref   = alignPointer(refBuffer);
+				uint8_t* out   = alignPointer(outBuffer);
+
+				std::mt19937 random(bitsPerElement);
+				std::generate(tiled, tiled + surfInfo.m_surfaceSize, [&random]() { return uint8_t(random()); });
+
+				printf("%s %ux%u %3ubpp:", tileMode == kTileModeThin_1dThin ? "1d" : "2d",
+					   size[0], size[1], bitsPerElement);
+
+				for (const auto& benchCase : g_benchCases)
+				{
+					setDetileKernel(benchCase.kernel);
+					engine->setThreadCount(benchCase.threadCount);
+
+					uint8_t* dest     = benchCase.kernel == DetileKernel::Scalar ? ref : out;
+					uint64_t bestTime = UINT64_MAX;
+					int32_t  status   = kStatusSuccess;
+
+					std::memset(dest, 0, linearSize);
+
+					for (uint32_t i = 0; i != iterations && status == kStatusSuccess; ++i)
+					{
+						auto begin = Clock::now();
+						status     = detileSurface(dest, tiled, &tp);
+						auto end   = Clock::now();
+
+						bestTime = std::min<uint64_t>(bestTime,
+							std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+					}
+
+					// The scalar path comes first and is the reference,
+					// it looks up every element with getTiledElementByteOffset.
+					bool caseMatch = status == kStatusSuccess &&
+									 (dest == ref || !std::memcmp(ref, out, linearSize));
+					match &= caseMatch;
+
+					printf("  %s(%s) %7.2f GB/s%s", benchCase.name, getKernelName(getDetileKernel()),
+						   double(linearSize) / double(std::max<uint64_t>(bestTime, 1)),
+						   caseMatch ? "" : " MISMATCH");
+				}
+
+				printf("\n");
+			}
+		}
+	}
+
+	setDetileKernel(DetileKernel::Auto);
+	engine->setThreadCount(0);
+	return match;
+}
+
+}  // namespace GpuAddress
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Graphic/Gnm/GnmCommon.h"
+
+namespace GpuAddress
+{;
+
+/**
+ * \brief Surface detile benchmark
+ *
+ * Detiles 1D and 2D thin surfaces of 1080p and 4K size
+ * in every supported element size, with the scalar path,
+ * each micro tile kernel and all detile threads, and
+ * prints the throughput of each.
+ * \param [in] iterations Runs per case, the fastest is reported
+ * \returns \c false if any path doesn't match the scalar path
+ */
+bool runDetileBench(uint32_t iterations);
+
+}  // namespace GpuAddress
@@ -0,0 +1,244 @@
+#include "GnmMemoryTrackerBench.h"
+#include "Graphic/Gnm/GnmMemoryTracker.h"
+
+#include "Platform/UtilMemory.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+
+LOG_CHANNEL(Graphic.Gnm.GnmMemoryTrackerBench);
+
+using UtilMemory::VM_PAGE_SIZE;
+
+// Marks written pages of a watch, then checks the synced ranges.
+static bool checkSync(
+	GnmMemoryTracker*            tracker,
+	uint32_t                     watchId,
+	const uint8_t*               memory,
+	size_t                       size,
+	const std::vector<uint32_t>& writtenPages)
+{
+	std::vector<uint8_t> expected(size, 0);
+	for (uint32_t page : writtenPages)
+	{
+		size_t pageBegin = page * VM_PAGE_SIZE;
+		size_t pageEnd   = pageBegin + VM_PAGE_SIZE;
+
+		uintptr_t watchBegin = uintptr_t(memory);
+		uintptr_t base       = watchBegin & ~uintptr_t(VM_PAGE_SIZE - 1);
+
+		// Pages are counted from the first page of the watch.
+		size_t begin = std::max(base + pageBegin, watchBegin) - watchBegin;
+		size_t end   = std::min(base + pageEnd, watchBegin + size) - watchBegin;
+		if (begin < end)
+		{
+			std::fill(expected.begin() + begin, expected.begin() + end, 1);
+		}
+	}
+
+	std::vector<GnmMemoryRange> ranges;
+	if (!tracker->sync(watchId, ranges))
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> actual(size, 0);
+	for (const auto& range : ranges)
+	{
+		if (range.offset + range.size > size)
+		{
+			return false;
+		}
+		std::fill(actual.begin() + range.offset, actual.begin() + range.offset + range.size, 1);
+	}
+
+	return actual == expected;
+}
+
+static bool runCorrectnessCheck(GnmMemoryTracker* tracker, uint8_t* memory)
+{
+	bool ret = false;
+	do
+	{
+		// Two watches starting and ending inside pages,
+		// sharing pages 4 to 8.
+		uint8_t* memoryA = memory + 100;
+		size_t   sizeA   = 9 * VM_PAGE_SIZE - 200;
+		uint8_t* memoryB = memory + 4 * VM_PAGE_SIZE + 200;
+		size_t   sizeB   = 8 * VM_PAGE_SIZE;
+
+		uint32_t watchA = tracker->watch(memoryA, sizeA);
+		uint32_t watchB = tracker->watch(memoryB, sizeB);
+		if (watchA == GnmMemoryTracker::InvalidWatch || watchB == GnmMemoryTracker::InvalidWatch)
+		{
+			break;
+		}
+
+		// Nothing written yet.
+		if (!checkSync(tracker, watchA, memoryA, sizeA, {}) ||
+			!checkSync(tracker, watchB, memoryB, sizeB, {}))
+		{
+			break;
+		}
+
+		// Pages 0, 5, 6 and 9 relative to memory,
+		// page 9 only belongs to B.
+		memory[0]                     = 1;
+		memory[5 * VM_PAGE_SIZE + 1]  = 1;
+		memory[6 * VM_PAGE_SIZE + 2]  = 1;
+		memory[9 * VM_PAGE_SIZE + 3]  = 1;
+		memory[9 * VM_PAGE_SIZE + 10] = 1;
+
+		// A syncing first must not hide the shared pages from B.
+		if (!checkSync(tracker, watchA, memoryA, sizeA, { 0, 5, 6 }) ||
+			!checkSync(tracker, watchA, memoryA, sizeA, {}) ||
+			!checkSync(tracker, watchB, memoryB, sizeB, { 1, 2, 5 }))
+		{
+			break;
+		}
+
+		// Written again after both synced.
+		memory[6 * VM_PAGE_SIZE] = 2;
+		if (!checkSync(tracker, watchB, memoryB, sizeB, { 2 }) ||
+			!checkSync(tracker, watchA, memoryA, sizeA, { 6 }))
+		{
+			break;
+		}
+
+		tracker->unwatch(watchA);
+		tracker->unwatch(watchB);
+
+		// Unwatched memory must not fault any more.
+		uint64_t faultCount = tracker->getFaultCount();
+		std::memset(memory, 3, 16 * VM_PAGE_SIZE);
+		if (tracker->getFaultCount() != faultCount)
+		{
+			break;
+		}
+
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+bool runMemoryTrackerBench(uint32_t iterations)
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	const size_t memorySize   = 64 * 1024 * 1024;
+	const size_t pageCount    = memorySize / VM_PAGE_SIZE;
+	const double dirtyRates[] = { 0.0, 0.01, 0.1, 0.5, 1.0 };
+
+	auto tracker   = GnmMemoryTracker::GetInstance();
+	bool installed = tracker->isInstalled();
+	iterations     = std::max(iterations, 1u);
+
+	bool ret = false;
+
+	uint8_t* memory = reinterpret_cast<uint8_t*>(UtilMemory::VMMapFlexible(nullptr, memorySize, UtilMemory::VMPF_READ_WRITE));
+	uint8_t* upload = reinterpret_cast<uint8_t*>(UtilMemory::VMMapFlexible(nullptr, memorySize, UtilMemory::VMPF_READ_WRITE));
+	do
+	{
+		if (!memory || !upload)
+		{
+			LOG_ERR("failed to allocate benchmark memory.");
+			break;
+		}
+
+		if (!installed && !tracker->install())
+		{
+			break;
+		}
+
+		if (!runCorrectnessCheck(tracker, memory))
+		{
+			printf("MISMATCH: write tracker reported wrong dirty ranges.\n");
+			break;
+		}
+
+		printf("write tracker ranges match, best of %u iterations on %zu MB.\n",
+			   iterations, memorySize / (1024 * 1024));
+
+		// Copying everything is what the draw path does without tracking.
+		double fullMs = 1e9;
+		for (uint32_t i = 0; i != iterations; ++i)
+		{
+			auto t0 = Clock::now();
+			std::memcpy(upload, memory, memorySize);
+			auto t1 = Clock::now();
+			fullMs  = std::min(fullMs, std::chrono::duration<double, std::milli>(t1 - t0).count());
+		}
+		printf("full copy: %8.3f ms\n", fullMs);
+
+		uint32_t watchId = tracker->watch(memory, memorySize);
+
+		std::mt19937          random(0x7A5C);
+		std::vector<uint32_t> pages(pageCount);
+		std::vector<GnmMemoryRange> ranges;
+		for (double dirtyRate : dirtyRates)
+		{
+			double writeMs  = 1e9;
+			double syncMs   = 1e9;
+			double uploadMs = 1e9;
+
+			size_t dirtyCount = size_t(dirtyRate * pageCount);
+			for (uint32_t i = 0; i != iterations; ++i)
+			{
+				for (size_t p = 0; p != pageCount; ++p)
+				{
+					pages[p] = uint32_t(p);
+				}
+				std::shuffle(pages.begin(), pages.end(), random);
+				std::sort(pages.begin(), pages.begin() + dirtyCount);
+
+				// One fault per dirty page.
+				auto t0 = Clock::now();
+				for (size_t p = 0; p != dirtyCount; ++p)
+				{
+					memory[pages[p] * VM_PAGE_SIZE] = uint8_t(i);
+				}
+				auto t1 = Clock::now();
+				tracker->sync(watchId, ranges);
+				auto t2 = Clock::now();
+				for (const auto& range : ranges)
+				{
+					std::memcpy(upload + range.offset, memory + range.offset, range.size);
+				}
+				auto t3 = Clock::now();
+
+				writeMs  = std::min(writeMs, std::chrono::duration<double, std::milli>(t1 - t0).count());
+				syncMs   = std::min(syncMs, std::chrono::duration<double, std::milli>(t2 - t1).count());
+				uploadMs = std::min(uploadMs, std::chrono::duration<double, std::milli>(t3 - t2).count());
+			}
+
+			double totalMs = writeMs + syncMs + uploadMs;
+			printf("%5.1f%% dirty: faults %8.3f ms (%6.2f us/page)  sync %8.3f ms  copy %8.3f ms  total %8.3f ms  %6.2fx full copy\n",
+				   dirtyRate * 100.0, writeMs, dirtyCount ? writeMs * 1000.0 / dirtyCount : 0.0,
+				   syncMs, uploadMs, totalMs, fullMs / totalMs);
+		}
+
+		tracker->unwatch(watchId);
+
+		ret = true;
+	} while (false);
+
+	if (!installed)
+	{
+		tracker->uninstall();
+	}
+
+	// Released with a size of 0, like UtilMemory::MemoryUnMapper does.
+	if (memory)
+	{
+		UtilMemory::VMUnMap(memory, 0);
+	}
+	if (upload)
+	{
+		UtilMemory::VMUnMap(upload, 0);
+	}
+
+	return ret;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Graphic/Gnm/GnmCommon.h"
+
+/**
+ * \brief Guest memory write tracker benchmark
+ *
+ * Checks that the tracker reports exactly the pages
+ * written, including watches sharing pages, then measures
+ * the cost of write faults and syncs and compares uploading
+ * only dirty pages of a 64 MB buffer with copying it whole.
+ * Runs on the CPU only.
+ * \param [in] iterations Runs per case, the fastest is reported
+ * \returns \c false if the tracker reports wrong ranges
+ */
+bool runMemoryTrackerBench(uint32_t iterations);
@@ -0,0 +1,382 @@
+#include "PsslShaderBench.h"
+#include "Graphic/Pssl/PsslShaderModule.h"
+
+#include "Graphic/Violet/VltShader.h"
+
+#include "Algorithm/MurmurHash2.h"
+#include "Platform/UtilFile.h"
+#include "UtilAlloc.h"
+#include "UtilString.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <unordered_map>
+
+LOG_CHANNEL(Graphic.Pssl.PsslShaderBench);
+
+namespace pssl
+{;
+
+using Clock = std::chrono::high_resolution_clock;
+
+/**
+ * \brief Counters compared against the baseline
+ */
+struct PsslShaderBenchField
+{
+	const char* name;
+	uint64_t PsslShaderBenchResult::*member;
+};
+
+static const PsslShaderBenchField g_benchFields[] =
+{
+	{ "parseNs",    &PsslShaderBenchResult::parseNs    },
+	{ "decodeNs",   &PsslShaderBenchResult::decodeNs   },
+	{ "analyzeNs",  &PsslShaderBenchResult::analyzeNs  },
+	{ "compileNs",  &PsslShaderBenchResult::compileNs  },
+	{ "finalizeNs", &PsslShaderBenchResult::finalizeNs },
+	{ "allocCount", &PsslShaderBenchResult::allocCount },
+	{ "spirvBytes", &PsslShaderBenchResult::spirvBytes },
+};
+
+static uint64_t elapsedNs(Clock::time_point begin, Clock::time_point end)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+}
+
+// Strips whitespace and quotes around a JSON token
+static std::string trimJsonToken(const std::string& token)
+{
+	size_t begin = token.find_first_not_of(" \t\r\n\"");
+	size_t end   = token.find_last_not_of(" \t\r\n\"");
+	return begin == std::string::npos ? std::string() : token.substr(begin, end - begin + 1);
+}
+
+PsslShaderBench::PsslShaderBench(uint32_t iterations) :
+	m_iterations(std::max(iterations, 1u))
+{
+}
+
+PsslShaderBench::~PsslShaderBench()
+{
+}
+
+uint32_t PsslShaderBench::loadCorpus(const std::string& path)
+{
+	std::vector<std::string> files;
+
+	std::error_code ec;
+	for (const auto& entry : std::filesystem::directory_iterator(path, ec))
+	{
+		if (entry.path().extension() != ".gcn")
+		{
+			continue;
+		}
+
+		files.push_back(entry.path().string());
+	}
+
+	// Keep the report order stable between runs.
+	std::sort(files.begin(), files.end());
+
+	for (const auto& file : files)
+	{
+		PsslShaderCapture capture;
+		if (!capture.load(file))
+		{
+			continue;
+		}
+
+		m_corpus.push_back(std::move(capture));
+	}
+
+	return uint32_t(m_corpus.size());
+}
+
+void PsslShaderBench::run()
+{
+	m_results.clear();
+
+	for (const auto& capture : m_corpus)
+	{
+		m_results.push_back(runShader(capture));
+	}
+}
+
+PsslShaderBenchResult PsslShaderBench::runShader(const PsslShaderCapture& capture) const
+{
+	PsslShaderBenchResult result;
+	result.name = capture.name();
+
+	for (uint32_t i = 0; i != m_iterations; ++i)
+	{
+		uint64_t allocBegin = UtilAlloc::GetThreadAllocCount();
+
+		auto t0 = Clock::now();
+
+		auto module = capture.createModule();
+
+		auto t1 = Clock::now();
+
+		auto program = module->decode();
+
+		auto t2 = Clock::now();
+
+		PsslShaderProfile profile;
+		auto shader = module->compile(program, &profile);
+
+		uint64_t allocCount = UtilAlloc::GetThreadAllocCount() - allocBegin;
+
+		PsslShaderBenchResult sample;
+		sample.parseNs    = elapsedNs(t0, t1);
+		sample.decodeNs   = elapsedNs(t1, t2);
+		sample.analyzeNs  = profile.analyzeNs;
+		sample.compileNs  = profile.compileNs;
+		sample.finalizeNs = profile.finalizeNs;
+		sample.allocCount = allocCount;
+
+		if (i == 0)
+		{
+			// The output doesn't change between iterations.
+			auto code         = shader->code().decompress();
+			result.spirvBytes = code.size();
+			result.spirvHash  = algo::MurmurHash(code.data(), int(code.size()));
+
+			result.parseNs    = sample.parseNs;
+			result.decodeNs   = sample.decodeNs;
+			result.analyzeNs  = sample.analyzeNs;
+			result.compileNs  = sample.compileNs;
+			result.finalizeNs = sample.finalizeNs;
+			result.allocCount = sample.allocCount;
+		}
+		else
+		{
+			// Take the fastest run of each stage,
+			// which is the least disturbed by the system.
+			result.parseNs    = std::min(result.parseNs, sample.parseNs);
+			result.decodeNs   = std::min(result.decodeNs, sample.decodeNs);
+			result.analyzeNs  = std::min(result.analyzeNs, sample.analyzeNs);
+			result.compileNs  = std::min(result.compileNs, sample.compileNs);
+			result.finalizeNs = std::min(result.finalizeNs, sample.finalizeNs);
+			result.allocCount = std::min(result.allocCount, sample.allocCount);
+		}
+	}
+
+	return result;
+}
+
+void PsslShaderBench::printReport() const
+{
+	printf("%zu shaders, best of %u iterations.\n", m_results.size(), m_iterations);
+
+	for (const auto& field : g_benchFields)
+	{
+		uint64_t total = 0;
+		for (const auto& result : m_results)
+		{
+			total += result.*field.member;
+		}
+
+		if (field.member == &PsslShaderBenchResult::allocCount && !UtilAlloc::IsAllocCountEnabled())
+		{
+			printf("%-12s %16s\n", field.name, "n/a");
+			continue;
+		}
+
+		printf("%-12s %16llu\n", field.name, total);
+	}
+}
+
+bool PsslShaderBench::storeResults(const std::string& path) const
+{
+	std::string json;
+	json += UtilString::Format("{\n  \"iterations\": %u,\n  \"shaders\": [\n", m_iterations);
+
+	for (size_t i = 0; i != m_results.size(); ++i)
+	{
+		const auto& result = m_results[i];
+
+		json += UtilString::Format("    { \"name\": \"%s\"", result.name.c_str());
+		for (const auto& field : g_benchFields)
+		{
+			json += UtilString::Format(", \"%s\": %llu", field.name, result.*field.member);
+		}
+		json += UtilString::Format(", \"spirvHash\": \"%016llX\" }%s\n",
+								   result.spirvHash, i + 1 != m_results.size() ? "," : "");
+	}
+
+	json += "  ]\n}\n";
+
+	bool ret = UtilFile::StoreFile(path, json.data(), uint32_t(json.size()));
+	if (!ret)
+	{
+		LOG_ERR("failed to store benchmark results %s.", path.c_str());
+	}
+	return ret;
+}
+
+bool PsslShaderBench::loadResults(
+	const std::string&                  path,
+	std::vector<PsslShaderBenchResult>& results)
+{
+	bool ret = false;
+	do
+	{
+		std::vector<uint8_t> data;
+		if (!UtilFile::LoadFile(path, data))
+		{
+			break;
+		}
+
+		// Only reads the flat layout written by storeResults.
+		std::string json(data.begin(), data.end());
+
+		size_t pos = json.find("\"shaders\"");
+		if (pos == std::string::npos)
+		{
+			break;
+		}
+
+		bool valid = true;
+		while (true)
+		{
+			pos = json.find_first_of("{]", pos);
+			if (pos == std::string::npos || json[pos] == ']')
+			{
+				valid = pos != std::string::npos;
+				break;
+			}
+
+			size_t end = json.find('}', pos);
+			if (end == std::string::npos)
+			{
+				valid = false;
+				break;
+			}
+
+			PsslShaderBenchResult result;
+
+			auto members = UtilString::Split(json.substr(pos + 1, end - pos - 1), ',');
+			for (const auto& member : members)
+			{
+				size_t colon = member.find(':');
+				if (colon == std::string::npos)
+				{
+					continue;
+				}
+
+				auto key   = trimJsonToken(member.substr(0, colon));
+				auto value = trimJsonToken(member.substr(colon + 1));
+
+				if (key == "name")
+				{
+					result.name = value;
+				}
+				else if (key == "spirvHash")
+				{
+					result.spirvHash = std::strtoull(value.c_str(), nullptr, 16);
+				}
+
+				for (const auto& field : g_benchFields)
+				{
+					if (key == field.name)
+					{
+						result.*field.member = std::strtoull(value.c_str(), nullptr, 10);
+						break;
+					}
+				}
+			}
+
+			results.push_back(result);
+			pos = end + 1;
+		}
+
+		ret = valid;
+	} while (false);
+	return ret;
+}
+
+bool PsslShaderBench::compareBaseline(const std::string& path, double tolerance) const
+{
+	bool ret = false;
+	do
+	{
+		std::vector<PsslShaderBenchResult> baseline;
+		if (!loadResults(path, baseline))
+		{
+			LOG_ERR("failed to load benchmark baseline %s.", path.c_str());
+			break;
+		}
+
+		std::unordered_map<std::string, const PsslShaderBenchResult*> baselineMap;
+		for (const auto& result : baseline)
+		{
+			baselineMap.emplace(result.name, &result);
+		}
+
+		// Only shaders present in both runs are summed up,
+		// so adding captures to the corpus isn't a regression.
+		std::vector<std::pair<uint64_t, uint64_t>> totals(std::size(g_benchFields));
+
+		uint32_t matchCount   = 0;
+		uint32_t newCount     = 0;
+		uint32_t changedCount = 0;
+
+		for (const auto& result : m_results)
+		{
+			auto iter = baselineMap.find(result.name);
+			if (iter == baselineMap.end())
+			{
+				++newCount;
+				continue;
+			}
+
+			const auto& base = *iter->second;
+
+			if (base.spirvHash != result.spirvHash)
+			{
+				printf("SPIR-V changed: %s\n", result.name.c_str());
+				++changedCount;
+			}
+
+			for (size_t i = 0; i != std::size(g_benchFields); ++i)
+			{
+				totals[i].first += base.*g_benchFields[i].member;
+				totals[i].second += result.*g_benchFields[i].member;
+			}
+
+			++matchCount;
+		}
+
+		printf("baseline %s: %u shaders matched, %u new, %zu missing, %u with changed SPIR-V.\n",
+			   path.c_str(), matchCount, newCount, baseline.size() - matchCount, changedCount);
+
+		bool regression = false;
+		for (size_t i = 0; i != std::size(g_benchFields); ++i)
+		{
+			uint64_t before = totals[i].first;
+			uint64_t after  = totals[i].second;
+
+			// Allocations are not counted in every build.
+			if (!before || !after)
+			{
+				continue;
+			}
+
+			double change = double(after) / double(before) - 1.0;
+			bool   failed = change > tolerance;
+
+			printf("%-12s %16llu -> %16llu %+7.1f%%%s\n",
+				   g_benchFields[i].name, before, after, change * 100.0,
+				   failed ? "  REGRESSION" : "");
+
+			regression |= failed;
+		}
+
+		ret = !regression;
+	} while (false);
+	return ret;
+}
+
+}  // namespace pssl
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Graphic/Pssl/PsslCommon.h"
+#include "Graphic/Pssl/PsslShaderCapture.h"
+
+#include <string>
+#include <vector>
+
+namespace pssl
+{;
+
+/**
+ * \brief Benchmark result of a single shader
+ *
+ * Timings are the minimum over all iterations,
+ * in nanoseconds.
+ */
+struct PsslShaderBenchResult
+{
+	std::string name;
+	uint64_t    parseNs     = 0;  // Module creation and fetch shader decoding
+	uint64_t    decodeNs    = 0;
+	uint64_t    analyzeNs   = 0;
+	uint64_t    compileNs   = 0;
+	uint64_t    finalizeNs  = 0;  // Includes SPIR-V optimization
+	uint64_t    allocCount  = 0;  // Heap allocations of one iteration
+	uint64_t    spirvBytes  = 0;
+	uint64_t    spirvHash   = 0;
+};
+
+/**
+ * \brief Offline shader compiler benchmark
+ *
+ * Compiles a corpus of shader captures without a
+ * Vulkan device, so compiler performance can be
+ * tracked headless. Results can be stored as JSON
+ * and compared against a previous run.
+ */
+class PsslShaderBench
+{
+public:
+	PsslShaderBench(uint32_t iterations);
+	~PsslShaderBench();
+
+	/**
+	 * \brief Loads all captures in a directory
+	 *
+	 * \param [in] path Directory of .gcn captures
+	 * \returns Number of captures loaded
+	 */
+	uint32_t loadCorpus(const std::string& path);
+
+	/**
+	 * \brief Compiles every capture
+	 */
+	void run();
+
+	/**
+	 * \brief Prints per-stage totals
+	 */
+	void printReport() const;
+
+	/**
+	 * \brief Stores results as JSON
+	 *
+	 * \param [in] path Output file
+	 * \returns \c true on success
+	 */
+	bool storeResults(const std::string& path) const;
+
+	/**
+	 * \brief Compares results against a baseline
+	 *
+	 * Stage timings, allocation counts and SPIR-V size,
+	 * summed over shaders present in both runs, must not
+	 * grow by more than the tolerance. Shaders whose
+	 * SPIR-V changed are listed but don't fail.
+	 * \param [in] path Baseline JSON written by storeResults
+	 * \param [in] tolerance Allowed growth, e.g. 0.1 for 10%
+	 * \returns \c false on a regression or missing baseline
+	 */
+	bool compareBaseline(const std::string& path, double tolerance) const;
+
+private:
+	PsslShaderBenchResult runShader(const PsslShaderCapture& capture) const;
+
+	static bool loadResults(
+		const std::string&                  path,
+		std::vector<PsslShaderBenchResult>& results);
+
+private:
+	uint32_t m_iterations;
+
+	std::vector<PsslShaderCapture>     m_corpus;
+	std::vector<PsslShaderBenchResult> m_results;
+};
+
+}  // namespace pssl
@@ -0,0 +1,251 @@
+#include "SpirvModuleBench.h"
+#include "Graphic/SpirV/SpirvModule.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace pssl {
+
+  /**
+   * \brief Linear type and constant table
+   * 
+   * The type and constant lookup \ref SpirvModule
+   * used before, scanning every declaration made
+   * so far. Allocates IDs in the same order, after
+   * the GLSL.std.450 import every module starts with.
+   */
+  class SpirvLinearTypeConstTable {
+    
+  public:
+    
+    uint32_t defIntType(uint32_t width, uint32_t isSigned) {
+      std::array<uint32_t, 2> args = {{ width, isSigned }};
+      return this->defType(spv::OpTypeInt, args.size(), args.data());
+    }
+    
+    uint32_t defFloatType(uint32_t width) {
+      std::array<uint32_t, 1> args = {{ width }};
+      return this->defType(spv::OpTypeFloat, args.size(), args.data());
+    }
+    
+    uint32_t defVectorType(uint32_t elementType, uint32_t elementCount) {
+      std::array<uint32_t, 2> args = {{ elementType, elementCount }};
+      return this->defType(spv::OpTypeVector, args.size(), args.data());
+    }
+    
+    uint32_t constu32(uint32_t v) {
+      return this->defConst(spv::OpConstant,
+        this->defIntType(32, 0), 1, &v);
+    }
+    
+    uint32_t consti32(int32_t v) {
+      uint32_t data;
+      std::memcpy(&data, &v, sizeof(v));
+      return this->defConst(spv::OpConstant,
+        this->defIntType(32, 1), 1, &data);
+    }
+    
+    uint32_t constf32(float v) {
+      uint32_t data;
+      std::memcpy(&data, &v, sizeof(v));
+      return this->defConst(spv::OpConstant,
+        this->defFloatType(32), 1, &data);
+    }
+    
+    uint32_t constvec4f32(float x, float y, float z, float w) {
+      std::array<uint32_t, 4> args = {{
+        this->constf32(x), this->constf32(y),
+        this->constf32(z), this->constf32(w),
+      }};
+      
+      uint32_t scalarTypeId = this->defFloatType(32);
+      uint32_t vectorTypeId = this->defVectorType(scalarTypeId, 4);
+      
+      return this->defConst(spv::OpConstantComposite,
+        vectorTypeId, args.size(), args.data());
+    }
+    
+  private:
+    
+    SpirvCodeBuffer m_typeConstDefs;
+    uint32_t        m_id = 2;
+    
+    uint32_t defType(
+            spv::Op                 op,
+            uint32_t                argCount,
+      const uint32_t*               argIds) {
+      for (auto ins : m_typeConstDefs) {
+        bool match = ins.opCode() == op
+                  && ins.length() == 2 + argCount;
+        
+        for (uint32_t i = 0; i < argCount && match; i++)
+          match &= ins.arg(2 + i) == argIds[i];
+        
+        if (match)
+          return ins.arg(1);
+      }
+      
+      uint32_t resultId = m_id++;
+      m_typeConstDefs.putIns (op, 2 + argCount);
+      m_typeConstDefs.putWord(resultId);
+      
+      for (uint32_t i = 0; i < argCount; i++)
+        m_typeConstDefs.putWord(argIds[i]);
+      return resultId;
+    }
+    
+    uint32_t defConst(
+            spv::Op                 op,
+            uint32_t                typeId,
+            uint32_t                argCount,
+      const uint32_t*               argIds) {
+      for (auto ins : m_typeConstDefs) {
+        bool match = ins.opCode() == op
+                  && ins.length() == 3 + argCount
+                  && ins.arg(1)   == typeId;
+        
+        for (uint32_t i = 0; i < argCount && match; i++)
+          match &= ins.arg(3 + i) == argIds[i];
+        
+        if (match)
+          return ins.arg(2);
+      }
+      
+      uint32_t resultId = m_id++;
+      m_typeConstDefs.putIns (op, 3 + argCount);
+      m_typeConstDefs.putWord(typeId);
+      m_typeConstDefs.putWord(resultId);
+      
+      for (uint32_t i = 0; i < argCount; i++)
+        m_typeConstDefs.putWord(argIds[i]);
+      return resultId;
+    }
+    
+  };
+  
+  
+  enum class SpirvBenchDeclType : uint32_t {
+    U32,
+    I32,
+    F32,
+    Vec4F32,
+  };
+  
+  
+  struct SpirvBenchDecl {
+    SpirvBenchDeclType type;
+    uint32_t           value[4];
+  };
+  
+  
+  static std::vector<SpirvBenchDecl> generateDecls(
+          uint32_t                count,
+          uint32_t                valueRange,
+          uint32_t                seed) {
+    std::mt19937                            random(seed);
+    std::uniform_int_distribution<uint32_t> type(0, 3);
+    std::uniform_int_distribution<uint32_t> value(0, valueRange - 1);
+    
+    std::vector<SpirvBenchDecl> decls(count);
+    for (auto& decl : decls) {
+      decl.type = SpirvBenchDeclType(type(random));
+      for (auto& v : decl.value)
+        v = value(random);
+    }
+    return decls;
+  }
+  
+  
+  template<typename Module>
+  static uint32_t declare(
+          Module&                 module,
+    const SpirvBenchDecl&         decl) {
+    switch (decl.type) {
+      case SpirvBenchDeclType::U32:
+        return module.constu32(decl.value[0]);
+      case SpirvBenchDeclType::I32:
+        return module.consti32(int32_t(decl.value[0]) - 1024);
+      case SpirvBenchDeclType::F32:
+        return module.constf32(float(decl.value[0]) * 0.25f);
+      case SpirvBenchDeclType::Vec4F32:
+        return module.constvec4f32(
+          float(decl.value[0] % 16), float(decl.value[1] % 16),
+          float(decl.value[2] % 16), float(decl.value[3] % 16));
+    }
+    return 0;
+  }
+  
+  
+  template<typename Module>
+  static std::vector<uint32_t> declareAll(
+    const std::vector<SpirvBenchDecl>& decls) {
+    Module                module;
+    std::vector<uint32_t> ids;
+    ids.reserve(decls.size());
+    
+    for (const auto& decl : decls)
+      ids.push_back(declare(module, decl));
+    return ids;
+  }
+  
+  
+  template<typename Fn>
+  static double measure(uint32_t iterations, Fn&& fn) {
+    using Clock = std::chrono::high_resolution_clock;
+    
+    double bestMs = 1e9;
+    for (uint32_t i = 0; i != iterations; ++i) {
+      auto t0 = Clock::now();
+      fn();
+      auto t1 = Clock::now();
+      bestMs  = std::min(bestMs, std::chrono::duration<double, std::milli>(t1 - t0).count());
+    }
+    return bestMs;
+  }
+  
+  
+  bool runSpirvModuleBench(uint32_t iterations) {
+    // Roughly what large shaders declare, from few
+    // distinct constants to mostly distinct ones.
+    const uint32_t declCount     = 4096;
+    const uint32_t valueRanges[] = { 64, 512, 4096 };
+    
+    iterations = std::max(iterations, 1u);
+    
+    bool ret = true;
+    for (uint32_t valueRange : valueRanges) {
+      auto decls = generateDecls(declCount, valueRange, valueRange);
+      
+      auto indexIds  = declareAll<SpirvModule>(decls);
+      auto linearIds = declareAll<SpirvLinearTypeConstTable>(decls);
+      
+      if (indexIds != linearIds) {
+        std::printf("MISMATCH: SPIR-V type and constant IDs differ with %u distinct values.\n", valueRange);
+        ret = false;
+        break;
+      }
+      
+      // IDs are allocated in order, ID 1 is the GLSL.std.450 import
+      uint32_t uniqueCount = *std::max_element(indexIds.begin(), indexIds.end()) - 1;
+      
+      double indexMs  = measure(iterations, [&]() { declareAll<SpirvModule>(decls); });
+      double linearMs = measure(iterations, [&]() { declareAll<SpirvLinearTypeConstTable>(decls); });
+      
+      std::printf("%u declarations, %5u unique: index %8.3f ms (%7.1f ns/decl)  linear %8.3f ms (%7.1f ns/decl)  %.1fx\n",
+        declCount, uniqueCount,
+        indexMs,  indexMs  * 1e6 / declCount,
+        linearMs, linearMs * 1e6 / declCount,
+        linearMs / std::max(indexMs, 1e-6));
+    }
+    
+    if (ret)
+      std::printf("SPIR-V type and constant IDs match, best of %u iterations.\n", iterations);
+    return ret;
+  }
+
+}
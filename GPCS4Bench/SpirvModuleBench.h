@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+namespace pssl {
+
+  /**
+   * \brief SPIR-V module declaration benchmark
+   * 
+   * Declares a few thousand types and constants, many
+   * of them repeated, through the hashed lookup of
+   * \ref SpirvModule and through the linear scan over
+   * all declarations it used before. Checks that both
+   * return the same IDs, then reports time per
+   * declaration. Runs on the CPU only.
+   * \param [in] iterations Runs per case, the fastest is reported
+   * \returns \c false if the returned IDs differ
+   */
+  bool runSpirvModuleBench(uint32_t iterations);
+
+}
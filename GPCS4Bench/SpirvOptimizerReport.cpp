@@ -0,0 +1,60 @@
+#include "SpirvOptimizerReport.h"
+#include "Graphic/SpirV/SpirvOptimizer.h"
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace pssl
+{;
+
+void reportSpirvOptimizer(const std::string& path)
+{
+	std::vector<SpirvCodeBuffer> corpus;
+
+	std::error_code ec;
+	for (const auto& entry : std::filesystem::directory_iterator(path, ec))
+	{
+		if (entry.path().extension() != ".spv")
+		{
+			continue;
+		}
+
+		std::ifstream stream(entry.path(), std::ios::binary);
+		corpus.emplace_back(stream);
+	}
+
+	printf("%zu shaders in %s.\n", corpus.size(), path.c_str());
+
+	auto runPasses = [&corpus](const char* name, SpirvOptimizerPasses passes)
+	{
+		uint64_t countBefore = 0;
+		uint64_t countAfter  = 0;
+
+		for (const auto& code : corpus)
+		{
+			SpirvOptimizer optimizer(passes);
+			optimizer.optimize(code);
+
+			countBefore += optimizer.stats().insCountBefore;
+			countAfter += optimizer.stats().insCountAfter;
+		}
+
+		double reduction = countBefore ? 100.0 * (countBefore - countAfter) / countBefore : 0.0;
+		printf("%-8s %10llu -> %10llu instructions, %5.1f%% removed.\n",
+			   name, countBefore, countAfter, reduction);
+	};
+
+	// Each pass on its own, then all of them together.
+	SpirvOptimizerPasses allPasses;
+	for (uint32_t i = 0; i != uint32_t(SpirvOptimizerPass::PassCount); ++i)
+	{
+		auto pass = SpirvOptimizerPass(i);
+		runPasses(SpirvOptimizer::passName(pass), pass);
+		allPasses.set(pass);
+	}
+
+	runPasses("all", allPasses);
+}
+
+}  // namespace pssl
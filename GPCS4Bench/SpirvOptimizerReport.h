@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+
+namespace pssl
+{;
+
+/**
+ * \brief SPIR-V optimizer report
+ *
+ * Runs each optimizer pass on its own, then all of them
+ * together, on a folder of .spv shaders and prints the
+ * instruction count before and after each. Runs on the
+ * CPU only.
+ * \param [in] path Folder of .spv shaders
+ */
+void reportSpirvOptimizer(const std::string& path);
+
+}  // namespace pssl
@@ -0,0 +1,358 @@
+#include "VltTlsfBench.h"
+#include "Graphic/Violet/VltTlsfAllocator.h"
+
+#include "UtilMath.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+LOG_CHANNEL(Graphic.Violet.VltTlsfBench);
+
+namespace vlt
+{;
+
+constexpr uint64_t BenchCapacity = 128ull << 20;  // Default memory chunk size
+
+/**
+ * \brief Linear free list
+ *
+ * The sub-allocator memory chunks used before,
+ * worst-fit with coalescing by scanning all free slices.
+ */
+class LinearFreeList
+{
+	struct FreeSlice
+	{
+		uint64_t offset;
+		uint64_t length;
+	};
+
+public:
+	LinearFreeList(uint64_t capacity)
+	{
+		m_freeList.push_back({ 0, capacity });
+	}
+
+	uint64_t alloc(uint64_t size, uint64_t align, uint64_t& length)
+	{
+		uint64_t offset = VltTlsfAllocator::InvalidOffset;
+		do
+		{
+			if (m_freeList.empty())
+			{
+				break;
+			}
+
+			auto bestSlice = m_freeList.begin();
+			for (auto slice = m_freeList.begin(); slice != m_freeList.end(); slice++)
+			{
+				if (slice->length == size)
+				{
+					bestSlice = slice;
+					break;
+				}
+				else if (slice->length > bestSlice->length)
+				{
+					bestSlice = slice;
+				}
+			}
+
+			const uint64_t sliceStart = bestSlice->offset;
+			const uint64_t sliceEnd   = bestSlice->offset + bestSlice->length;
+			const uint64_t allocStart = ::util::align(sliceStart, align);
+			const uint64_t allocEnd   = ::util::align(allocStart + size, align);
+			if (allocEnd > sliceEnd)
+			{
+				break;
+			}
+
+			m_freeList.erase(bestSlice);
+			if (allocStart != sliceStart)
+			{
+				m_freeList.push_back({ sliceStart, allocStart - sliceStart });
+			}
+			if (allocEnd != sliceEnd)
+			{
+				m_freeList.push_back({ allocEnd, sliceEnd - allocEnd });
+			}
+
+			length = allocEnd - allocStart;
+			offset = allocStart;
+		} while (false);
+		return offset;
+	}
+
+	void free(uint64_t offset, uint64_t length)
+	{
+		auto curr = m_freeList.begin();
+		while (curr != m_freeList.end())
+		{
+			if (curr->offset == offset + length)
+			{
+				length += curr->length;
+				curr = m_freeList.erase(curr);
+			}
+			else if (curr->offset + curr->length == offset)
+			{
+				offset -= curr->length;
+				length += curr->length;
+				curr = m_freeList.erase(curr);
+			}
+			else
+			{
+				curr++;
+			}
+		}
+		m_freeList.push_back({ offset, length });
+	}
+
+	double fragmentation() const
+	{
+		uint64_t freeSize = 0;
+		uint64_t largest  = 0;
+		for (const auto& slice : m_freeList)
+		{
+			freeSize += slice.length;
+			largest = std::max(largest, slice.length);
+		}
+		return freeSize ? 1.0 - double(largest) / double(freeSize) : 0.0;
+	}
+
+private:
+	std::vector<FreeSlice> m_freeList;
+};
+
+struct BenchOp
+{
+	bool     isAlloc;
+	uint64_t size;
+	uint64_t align;
+	uint32_t pick;  // Live allocation to free, modulo the live count
+};
+
+struct BenchAlloc
+{
+	uint64_t offset;
+	uint64_t length;
+};
+
+// Many small buffers and a few large images,
+// with up to liveLimit allocations alive.
+static std::vector<BenchOp> generateOps(uint32_t count, uint32_t liveLimit, uint32_t seed)
+{
+	std::mt19937                            random(seed);
+	std::uniform_real_distribution<double>  sizeLog(8.0, 18.0);
+	std::uniform_int_distribution<uint32_t> alignLog(4, 16);
+	std::uniform_int_distribution<uint32_t> pick;
+
+	std::vector<BenchOp> ops;
+	ops.reserve(count);
+
+	uint32_t live = 0;
+	for (uint32_t i = 0; i != count; ++i)
+	{
+		bool isAlloc = live == 0 || (live < liveLimit && (random() % 100) < 55);
+
+		BenchOp op;
+		op.isAlloc = isAlloc;
+		op.size    = uint64_t(std::pow(2.0, sizeLog(random)));
+		op.align   = 1ull << alignLog(random);
+		op.pick    = pick(random);
+		ops.push_back(op);
+
+		live = isAlloc ? live + 1 : live - 1;
+	}
+	return ops;
+}
+
+static bool runCorrectnessCheck(const std::vector<BenchOp>& ops)
+{
+	const uint64_t unit = VltTlsfAllocator::Granularity;
+
+	VltTlsfAllocator     allocator(BenchCapacity);
+	std::vector<uint8_t> used(BenchCapacity / unit, 0);
+	std::vector<BenchAlloc> live;
+
+	auto mark = [&used, unit](const BenchAlloc& alloc, uint8_t value)
+	{
+		bool ok = true;
+		for (uint64_t i = alloc.offset / unit; i != (alloc.offset + alloc.length) / unit; ++i)
+		{
+			ok &= used[i] != value;
+			used[i] = value;
+		}
+		return ok;
+	};
+
+	bool ret = true;
+	for (const auto& op : ops)
+	{
+		if (op.isAlloc)
+		{
+			uint64_t offset = allocator.alloc(op.size, op.align);
+			if (offset == VltTlsfAllocator::InvalidOffset)
+			{
+				continue;
+			}
+
+			BenchAlloc alloc = { offset, allocator.allocSize(offset) };
+			ret &= alloc.offset % op.align == 0;
+			ret &= alloc.length >= op.size;
+			ret &= alloc.offset + alloc.length <= BenchCapacity;
+			ret &= mark(alloc, 1);
+			live.push_back(alloc);
+		}
+		else if (!live.empty())
+		{
+			size_t index = op.pick % live.size();
+			ret &= allocator.free(live[index].offset);
+			ret &= mark(live[index], 0);
+			live[index] = live.back();
+			live.pop_back();
+		}
+
+		if (!ret)
+		{
+			break;
+		}
+	}
+
+	for (const auto& alloc : live)
+	{
+		ret &= allocator.free(alloc.offset);
+	}
+
+	// Everything must have coalesced back into one block.
+	auto stats = allocator.getStats();
+	ret &= stats.freeBlockCount == 1 &&
+		   stats.largestFreeBlock == BenchCapacity &&
+		   stats.usedSize == 0;
+
+	// Freeing twice must be caught.
+	ret &= !allocator.free(0);
+	return ret;
+}
+
+template <typename Fn>
+static double measure(uint32_t iterations, Fn&& fn)
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	double bestMs = 1e9;
+	for (uint32_t i = 0; i != iterations; ++i)
+	{
+		auto t0 = Clock::now();
+		fn();
+		auto t1 = Clock::now();
+		bestMs  = std::min(bestMs, std::chrono::duration<double, std::milli>(t1 - t0).count());
+	}
+	return bestMs;
+}
+
+bool runTlsfBench(uint32_t iterations)
+{
+	const uint32_t opCount      = 200000;
+	const uint32_t liveLimits[] = { 256, 1024, 4096 };
+
+	iterations = std::max(iterations, 1u);
+
+	bool ret = false;
+	do
+	{
+		if (!runCorrectnessCheck(generateOps(opCount, 4096, 0x7153)))
+		{
+			printf("MISMATCH: TLSF allocator handed out a bad range.\n");
+			break;
+		}
+
+		printf("TLSF allocator ranges match, best of %u iterations, %u ops on a %llu MB chunk.\n",
+			   iterations, opCount, BenchCapacity >> 20);
+
+		for (uint32_t liveLimit : liveLimits)
+		{
+			auto ops = generateOps(opCount, liveLimit, liveLimit);
+
+			double   tlsfFrag  = 0.0;
+			uint32_t tlsfFails = 0;
+			double   tlsfMs    = measure(iterations, [&]()
+			{
+				VltTlsfAllocator      allocator(BenchCapacity);
+				std::vector<uint64_t> live;
+				tlsfFails = 0;
+
+				for (const auto& op : ops)
+				{
+					if (op.isAlloc)
+					{
+						uint64_t offset = allocator.alloc(op.size, op.align);
+						if (offset != VltTlsfAllocator::InvalidOffset)
+						{
+							live.push_back(offset);
+						}
+						else
+						{
+							++tlsfFails;
+						}
+					}
+					else if (!live.empty())
+					{
+						size_t index = op.pick % live.size();
+						allocator.free(live[index]);
+						live[index] = live.back();
+						live.pop_back();
+					}
+				}
+				tlsfFrag = allocator.getStats().fragmentation();
+			});
+
+			double   linearFrag  = 0.0;
+			uint32_t linearFails = 0;
+			double   linearMs    = measure(iterations, [&]()
+			{
+				LinearFreeList          allocator(BenchCapacity);
+				std::vector<BenchAlloc> live;
+				linearFails = 0;
+
+				for (const auto& op : ops)
+				{
+					if (op.isAlloc)
+					{
+						BenchAlloc alloc;
+						alloc.offset = allocator.alloc(op.size, op.align, alloc.length);
+						if (alloc.offset != VltTlsfAllocator::InvalidOffset)
+						{
+							live.push_back(alloc);
+						}
+						else
+						{
+							++linearFails;
+						}
+					}
+					else if (!live.empty())
+					{
+						size_t index = op.pick % live.size();
+						allocator.free(live[index].offset, live[index].length);
+						live[index] = live.back();
+						live.pop_back();
+					}
+				}
+				linearFrag = allocator.fragmentation();
+			});
+
+			printf("%5u live: tlsf %8.3f ms (%6.1f ns/op, %5u failed, %5.1f%% fragmented)  "
+				   "linear %8.3f ms (%6.1f ns/op, %5u failed, %5.1f%% fragmented)  %6.2fx\n",
+				   liveLimit,
+				   tlsfMs, tlsfMs * 1e6 / opCount, tlsfFails, tlsfFrag * 100.0,
+				   linearMs, linearMs * 1e6 / opCount, linearFails, linearFrag * 100.0,
+				   linearMs / tlsfMs);
+		}
+
+		ret = true;
+	} while (false);
+	return ret;
+}
+
+}  // namespace vlt
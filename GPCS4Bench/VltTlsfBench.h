@@ -0,0 +1,21 @@
+#pragma once
+
+#include "GPCS4Common.h"
+
+namespace vlt
+{;
+
+/**
+ * \brief Memory chunk sub-allocator benchmark
+ *
+ * Checks the TLSF allocator against a byte map of
+ * the managed range under random allocations and frees,
+ * then replays the same workload on it and on the linear
+ * free list memory chunks used before, and reports time
+ * per operation and fragmentation. Runs on the CPU only.
+ * \param [in] iterations Runs per case, the fastest is reported
+ * \returns \c false if the allocator hands out bad ranges
+ */
+bool runTlsfBench(uint32_t iterations);
+
+}  // namespace vlt